@@ -0,0 +1,188 @@
+/**
+ * Merges ROOT files with PEC trees into a single file.
+ *
+ * Usage:
+ *   mergePECFiles [-n maxOpenFiles] output.root input1.root [input2.root ...]
+ *
+ * Merging is done with TFileMerger in the fast mode, i.e. baskets of trees are copied without
+ * decompressing and recompressing them. For this to happen, the output file is created with the
+ * compression settings of the first input file. All input files are merged in a single pass;
+ * option -n limits the number of input files that are kept open simultaneously. Histograms and
+ * other objects are merged as usual.
+ *
+ * All input files must contain the same set of trees. Since trees from each input file are
+ * appended in the same order, trees that are aligned in every input file (i.e. describe the same
+ * events entry by entry) stay aligned in the output. The result is validated by comparing the
+ * number of entries in each tree in the output file to the sum over the input files. This only
+ * reads the headers of the trees, not their data.
+ *
+ * The program exits with a non-zero code if merging or validation fails.
+ */
+
+#include <TFile.h>
+#include <TFileMerger.h>
+#include <TKey.h>
+#include <TTree.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/// Number of entries in each tree in a file, indexed with full paths of the trees
+using TreeSizes = std::map<std::string, Long64_t>;
+
+
+/**
+ * \brief Finds all trees in the given directory and its subdirectories and records their sizes
+ *
+ * Only the highest cycle of each tree is considered.
+ */
+void CollectTreeSizes(TDirectory *directory, std::string const &path, TreeSizes &sizes)
+{
+    for (TObject *obj: *directory->GetListOfKeys())
+    {
+        TKey *key = static_cast<TKey *>(obj);
+        std::string const name(path + key->GetName());
+        std::string const className(key->GetClassName());
+
+        if (className == "TTree")
+        {
+            if (sizes.count(name) > 0)
+                continue;
+
+            std::unique_ptr<TTree> tree(dynamic_cast<TTree *>(key->ReadObj()));
+            sizes[name] = tree->GetEntries();
+        }
+        else if (className == "TDirectoryFile" or className == "TDirectory")
+            CollectTreeSizes(static_cast<TDirectory *>(key->ReadObj()), name + "/", sizes);
+    }
+}
+
+
+/// Returns sizes of all trees in the file with the given name
+TreeSizes GetTreeSizes(std::string const &fileName, int *compression = nullptr)
+{
+    std::unique_ptr<TFile> file(TFile::Open(fileName.c_str()));
+
+    if (not file or file->IsZombie())
+        throw std::runtime_error("Failed to open file \"" + fileName + "\".");
+
+    if (compression)
+        *compression = file->GetCompressionSettings();
+
+    TreeSizes sizes;
+    CollectTreeSizes(file.get(), "", sizes);
+    file->Close();
+
+    return sizes;
+}
+
+
+int main(int argc, char **argv)
+{
+    // Parse the arguments
+    std::vector<std::string> args(argv + 1, argv + argc);
+    int maxOpenFiles = 100;
+
+    if (args.size() >= 2 and args[0] == "-n")
+    {
+        maxOpenFiles = std::atoi(args[1].c_str());
+        args.erase(args.begin(), args.begin() + 2);
+    }
+
+    if (args.size() < 2 or maxOpenFiles < 2)
+    {
+        std::cerr << "Usage: mergePECFiles [-n maxOpenFiles] output.root input1.root "
+          "[input2.root ...]\n";
+        return 2;
+    }
+
+    std::string const outputFileName(args[0]);
+    std::vector<std::string> const inputFileNames(args.begin() + 1, args.end());
+
+
+    try
+    {
+        // Read sizes of trees in the input files. Make sure that all of them contain the same
+        //set of trees.
+        int compression = 0;
+        TreeSizes expectedSizes;
+
+        for (unsigned i = 0; i < inputFileNames.size(); ++i)
+        {
+            TreeSizes const sizes = GetTreeSizes(inputFileNames[i], (i == 0) ? &compression :
+              nullptr);
+
+            if (i == 0)
+            {
+                expectedSizes = sizes;
+                continue;
+            }
+
+            if (sizes.size() != expectedSizes.size())
+                throw std::runtime_error("File \"" + inputFileNames[i] + "\" contains a "
+                  "different number of trees than file \"" + inputFileNames[0] + "\".");
+
+            for (auto const &s: sizes)
+            {
+                auto res = expectedSizes.find(s.first);
+
+                if (res == expectedSizes.end())
+                    throw std::runtime_error("Tree \"" + s.first + "\" from file \"" +
+                      inputFileNames[i] + "\" is not found in file \"" + inputFileNames[0] +
+                      "\".");
+
+                res->second += s.second;
+            }
+        }
+
+
+        // Merge the files
+        TFileMerger merger(false, false);
+        merger.SetFastMethod(true);
+        merger.SetMaxOpenedFiles(maxOpenFiles);
+        merger.SetPrintLevel(0);
+
+        if (not merger.OutputFile(outputFileName.c_str(), "RECREATE", compression))
+            throw std::runtime_error("Failed to create output file \"" + outputFileName + "\".");
+
+        for (auto const &fileName: inputFileNames)
+        {
+            if (not merger.AddFile(fileName.c_str(), false))
+                throw std::runtime_error("Failed to add file \"" + fileName + "\".");
+        }
+
+        if (not merger.Merge())
+            throw std::runtime_error("TFileMerger failed to merge the files.");
+
+
+        // Validate the result
+        TreeSizes const mergedSizes = GetTreeSizes(outputFileName);
+
+        for (auto const &s: expectedSizes)
+        {
+            auto res = mergedSizes.find(s.first);
+
+            if (res == mergedSizes.end())
+                throw std::runtime_error("Tree \"" + s.first + "\" is missing in the output "
+                  "file.");
+
+            if (res->second != s.second)
+                throw std::runtime_error("Tree \"" + s.first + "\" contains " +
+                  std::to_string(res->second) + " entries in the output file while " +
+                  std::to_string(s.second) + " are expected.");
+        }
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
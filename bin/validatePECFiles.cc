@@ -0,0 +1,750 @@
+/**
+ * Histogram-based validation of PEC files.
+ *
+ * Usage:
+ *   validatePECFiles fill [-s sampleModulo] [-n maxEvents] output.root input1.root ...
+ *   validatePECFiles compare [-p minPValue] reference.root target.root
+ *
+ * In mode "fill", trees with event ID, muons, electrons, jets, and MET are read from the given PEC
+ * files, and fixed-binning histograms are filled for a number of properties of the objects and
+ * for the multiplicities of the collections. MET can be stored either as vectors of
+ * pec::Candidate or in the compact form pec::MET, and the same histograms are filled in both
+ * cases, so that the two formats can be compared. Only the required branches are read. The
+ * histograms account for under- and overflows in their statistics, so that their means and
+ * standard deviations reproduce exactly the moments of the unbinned distributions. In addition,
+ * properties of all objects in events whose number is divisible by the sample modulo are stored
+ * in tree "Sample", so that the same events can be compared exactly between two productions.
+ *
+ * In mode "compare", histograms from two files produced in mode "fill" are compared with the
+ * chi2 test, and distributions whose p-value is smaller than the given threshold are reported,
+ * together with relative differences in the mean and the number of entries. Events present in
+ * the sampled subsets of both files are then compared object by object, with a relative and
+ * absolute tolerance slightly looser than the precision of float. The program exits with code 1
+ * if differences are found.
+ *
+ * The set of properties matches the one in script validationConvert.py, which can still be used
+ * to inspect individual events.
+ */
+
+#include <Analysis/PECTuples/interface/Candidate.h>
+#include <Analysis/PECTuples/interface/Electron.h>
+#include <Analysis/PECTuples/interface/EventID.h>
+#include <Analysis/PECTuples/interface/Jet.h>
+#include <Analysis/PECTuples/interface/MET.h>
+#include <Analysis/PECTuples/interface/Muon.h>
+
+#include <TFile.h>
+#include <TH1D.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+/**
+ * \class CollectionBase
+ * \brief Histograms and sampled values for properties of objects in a collection
+ *
+ * The collection is read from a branch in the event tree. Each property is identified by its
+ * name and described by a binning. Derived classes know the type of the objects and evaluate
+ * the properties.
+ */
+class CollectionBase
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * Only the first maxObjects objects in each event are considered.
+     */
+    CollectionBase(std::string const &name, std::string const &branchName,
+      unsigned maxObjects = -1);
+
+    virtual ~CollectionBase() = default;
+
+public:
+    /// Creates histograms in the current directory and branches in the given sample tree
+    void Book(TTree *sampleTree);
+
+    /// Returns the name of the collection
+    std::string const &GetName() const;
+
+    /// Returns names of all properties
+    std::vector<std::string> const &GetQuantityNames() const;
+
+    /// Sets up reading of the collection from the given tree
+    virtual void SetBranch(TTree *tree) = 0;
+
+    /**
+     * \brief Fills histograms with properties of objects in the current event
+     *
+     * If the flag is true, values are also stored in buffers for the sample tree.
+     */
+    virtual void Fill(bool sample) = 0;
+
+protected:
+    /// Registers a new property
+    void AddQuantity(std::string const &name, unsigned numBins, double min, double max);
+
+    /// Fills histograms and buffers with values of all properties of one object
+    void FillObject(std::vector<double> const &values, bool sample);
+
+    /// Fills the histogram with the multiplicity and resets buffers for a new event
+    void StartEvent(unsigned size, bool sample);
+
+protected:
+    /// Name of the collection, used as a prefix for histograms and branches
+    std::string const name;
+
+    /// Name of the branch in the event tree
+    std::string const branchName;
+
+    /// Maximal number of objects to consider in an event
+    unsigned const maxObjects;
+
+private:
+    /// Binning for a property
+    struct Binning
+    {
+        unsigned numBins;
+        double min, max;
+    };
+
+    std::vector<std::string> quantityNames;
+    std::vector<Binning> binnings;
+
+    /// Histograms for all properties; owned by the output file
+    std::vector<TH1D *> histograms;
+
+    /// Histogram with the multiplicity; owned by the output file
+    TH1D *sizeHistogram;
+
+    /// Buffers for the sample tree, one per property
+    std::vector<std::vector<float>> sampleBuffers;
+};
+
+
+CollectionBase::CollectionBase(std::string const &name_, std::string const &branchName_,
+  unsigned maxObjects_):
+    name(name_), branchName(branchName_),
+    maxObjects(maxObjects_),
+    sizeHistogram(nullptr)
+{}
+
+
+void CollectionBase::Book(TTree *sampleTree)
+{
+    sizeHistogram = new TH1D((name + "_size").c_str(), "", 20, -0.5, 19.5);
+
+    for (unsigned i = 0; i < quantityNames.size(); ++i)
+        histograms.emplace_back(new TH1D((name + "_" + quantityNames[i]).c_str(), "",
+          binnings[i].numBins, binnings[i].min, binnings[i].max));
+
+    sampleBuffers.resize(quantityNames.size());
+
+    for (unsigned i = 0; i < quantityNames.size(); ++i)
+        sampleTree->Branch((name + "_" + quantityNames[i]).c_str(), &sampleBuffers[i]);
+}
+
+
+std::string const &CollectionBase::GetName() const
+{
+    return name;
+}
+
+
+std::vector<std::string> const &CollectionBase::GetQuantityNames() const
+{
+    return quantityNames;
+}
+
+
+void CollectionBase::AddQuantity(std::string const &name, unsigned numBins, double min,
+  double max)
+{
+    quantityNames.emplace_back(name);
+    binnings.push_back({numBins, min, max});
+}
+
+
+void CollectionBase::FillObject(std::vector<double> const &values, bool sample)
+{
+    for (unsigned i = 0; i < values.size(); ++i)
+    {
+        histograms[i]->Fill(values[i]);
+
+        if (sample)
+            sampleBuffers[i].emplace_back(values[i]);
+    }
+}
+
+
+void CollectionBase::StartEvent(unsigned size, bool sample)
+{
+    sizeHistogram->Fill(size);
+
+    if (sample)
+    {
+        for (auto &buffer: sampleBuffers)
+            buffer.clear();
+    }
+}
+
+
+/**
+ * \class Collection
+ * \brief Implementation of CollectionBase for objects of the given type
+ */
+template<typename T>
+class Collection: public CollectionBase
+{
+public:
+    using CollectionBase::CollectionBase;
+
+public:
+    /// Registers a new property computed with the given function
+    void Add(std::string const &name, unsigned numBins, double min, double max,
+      std::function<double(T const &)> getter);
+
+    virtual void SetBranch(TTree *tree) override;
+
+    virtual void Fill(bool sample) override;
+
+private:
+    std::vector<std::function<double(T const &)>> getters;
+
+    /// Buffer to read the collection
+    std::vector<T> *objects = nullptr;
+
+    /// Values of all properties for the current object
+    std::vector<double> values;
+};
+
+
+template<typename T>
+void Collection<T>::Add(std::string const &name, unsigned numBins, double min, double max,
+  std::function<double(T const &)> getter)
+{
+    AddQuantity(name, numBins, min, max);
+    getters.emplace_back(getter);
+}
+
+
+template<typename T>
+void Collection<T>::SetBranch(TTree *tree)
+{
+    tree->SetBranchStatus((branchName + "*").c_str(), true);
+
+    if (tree->SetBranchAddress(branchName.c_str(), &objects) < 0)
+        throw std::runtime_error("Failed to read branch \"" + branchName + "\".");
+}
+
+
+template<typename T>
+void Collection<T>::Fill(bool sample)
+{
+    unsigned const size = std::min<unsigned>(objects->size(), maxObjects);
+    StartEvent(size, sample);
+    values.resize(getters.size());
+
+    for (unsigned iObj = 0; iObj < size; ++iObj)
+    {
+        T const &obj = (*objects)[iObj];
+
+        for (unsigned i = 0; i < getters.size(); ++i)
+            values[i] = getters[i](obj);
+
+        FillObject(values, sample);
+    }
+}
+
+
+/**
+ * \class METCollection
+ * \brief Nominal MET or its version given by a variation, read in either of the supported formats
+ *
+ * If the tree contains a branch with a vector of pec::Candidate with the given name, the first
+ * element is used. Otherwise MET is read from branch "MET" in the compact form pec::MET, and the
+ * given variation is used, or the nominal MET if no variation is given. Properties "pt" and "phi"
+ * are evaluated.
+ *
+ * A branch can only be read into a single buffer. For this reason the buffer for the compact form
+ * is shared among all instances of this class, which all bind branch "MET" to the same address.
+ */
+class METCollection: public CollectionBase
+{
+public:
+    /// Constructor
+    METCollection(std::string const &name, std::string const &branchName,
+      int variation = -1);
+
+public:
+    virtual void SetBranch(TTree *tree) override;
+
+    virtual void Fill(bool sample) override;
+
+private:
+    /// Variation used with the compact form; negative for the nominal MET
+    int const variation;
+
+    /// Indicates whether MET is read in the compact form
+    bool compactFormat = false;
+    
+    /// Buffer to read MET stored as a vector
+    std::vector<pec::Candidate> *candidates = nullptr;
+    
+    /// Buffer to read MET in the compact form, shared by all instances
+    static pec::MET *compactMET;
+
+    /// Values of all properties
+    std::vector<double> values;
+};
+
+
+METCollection::METCollection(std::string const &name, std::string const &branchName,
+  int variation_):
+    CollectionBase(name, branchName, 1),
+    variation(variation_),
+    values(2)
+{
+    AddQuantity("pt", 100, 0., 500.);
+    AddQuantity("phi", 64, -3.2, 3.2);
+}
+
+
+pec::MET *METCollection::compactMET = nullptr;
+
+
+void METCollection::SetBranch(TTree *tree)
+{
+    std::string const compactBranchName("MET");
+    compactFormat = not tree->GetBranch(branchName.c_str());
+
+    if (not compactFormat)
+    {
+        tree->SetBranchStatus((branchName + "*").c_str(), true);
+
+        if (tree->SetBranchAddress(branchName.c_str(), &candidates) < 0)
+            throw std::runtime_error("Failed to read branch \"" + branchName + "\".");
+    }
+    else
+    {
+        tree->SetBranchStatus((compactBranchName + "*").c_str(), true);
+
+        if (tree->SetBranchAddress(compactBranchName.c_str(), &compactMET) < 0)
+            throw std::runtime_error("Failed to read branch \"" + branchName + "\" or \"" +
+              compactBranchName + "\".");
+    }
+}
+
+
+void METCollection::Fill(bool sample)
+{
+    if (compactFormat)
+    {
+        StartEvent(1, sample);
+
+        if (variation < 0)
+        {
+            values[0] = compactMET->Pt();
+            values[1] = compactMET->Phi();
+        }
+        else
+        {
+            auto const var = pec::MET::Variation(variation);
+            values[0] = compactMET->Pt(var);
+            values[1] = compactMET->Phi(var);
+        }
+
+        FillObject(values, sample);
+    }
+    else
+    {
+        unsigned const size = std::min<unsigned>(candidates->size(), maxObjects);
+        StartEvent(size, sample);
+
+        if (size > 0)
+        {
+            values[0] = candidates->front().Pt();
+            values[1] = candidates->front().Phi();
+            FillObject(values, sample);
+        }
+    }
+}
+
+
+/// Creates descriptions of all validated collections
+std::vector<std::unique_ptr<CollectionBase>> DefineCollections()
+{
+    std::vector<std::unique_ptr<CollectionBase>> collections;
+
+    auto muons = new Collection<pec::Muon>("muon", "muons");
+    muons->Add("pt", 100, 0., 500., [](pec::Muon const &m){return m.Pt();});
+    muons->Add("eta", 60, -3., 3., [](pec::Muon const &m){return m.Eta();});
+    muons->Add("phi", 64, -3.2, 3.2, [](pec::Muon const &m){return m.Phi();});
+    muons->Add("relIso", 100, 0., 1., [](pec::Muon const &m){return m.RelIso();});
+    muons->Add("passTight", 2, -0.5, 1.5, [](pec::Muon const &m){return m.TestBit(2);});
+    collections.emplace_back(muons);
+
+    auto electrons = new Collection<pec::Electron>("electron", "electrons");
+    electrons->Add("pt", 100, 0., 500., [](pec::Electron const &e){return e.Pt();});
+    electrons->Add("eta", 60, -3., 3., [](pec::Electron const &e){return e.Eta();});
+    electrons->Add("etaSC", 60, -3., 3., [](pec::Electron const &e){return e.EtaSC();});
+    electrons->Add("phi", 64, -3.2, 3.2, [](pec::Electron const &e){return e.Phi();});
+    electrons->Add("relIso", 100, 0., 1., [](pec::Electron const &e){return e.RelIso();});
+    electrons->Add("passVeto", 2, -0.5, 1.5,
+      [](pec::Electron const &e){return e.BooleanID(0);});
+    electrons->Add("passTight", 2, -0.5, 1.5,
+      [](pec::Electron const &e){return e.BooleanID(3);});
+    collections.emplace_back(electrons);
+
+    auto jets = new Collection<pec::Jet>("jet", "jets");
+    jets->Add("rawPt", 100, 0., 500., [](pec::Jet const &j){return j.Pt();});
+    jets->Add("corrPt", 100, 0., 500., [](pec::Jet const &j){return j.Pt() * j.CorrFactor();});
+    jets->Add("eta", 100, -5., 5., [](pec::Jet const &j){return j.Eta();});
+    jets->Add("phi", 64, -3.2, 3.2, [](pec::Jet const &j){return j.Phi();});
+    jets->Add("uncJEC", 100, 0., 0.2, [](pec::Jet const &j){return j.JECUncertainty();});
+    jets->Add("uncJER", 100, 0., 0.5, [](pec::Jet const &j){return j.JERUncertainty();});
+    jets->Add("passPFID", 2, -0.5, 1.5, [](pec::Jet const &j){return j.TestBit(1);});
+    jets->Add("hasGenMatch", 2, -0.5, 1.5, [](pec::Jet const &j){return j.TestBit(0);});
+    jets->Add("CSV", 110, -0.1, 1., [](pec::Jet const &j)
+      {return j.BTag(pec::Jet::BTagAlgo::CSV);});
+    collections.emplace_back(jets);
+
+    // Only the nominal MET is considered. Raw MET is the first element of uncorrMETs
+    collections.emplace_back(new METCollection("METs", "METs"));
+    collections.emplace_back(new METCollection("uncorrMETs", "uncorrMETs",
+      int(pec::MET::Variation::Raw)));
+
+    return collections;
+}
+
+
+/// Fills histograms and the sample tree from the given input files
+void Fill(std::string const &outputFileName, std::vector<std::string> const &inputFileNames,
+  unsigned sampleModulo, Long64_t maxEvents)
+{
+    // Histograms include under- and overflows in their statistics, which makes the moments exact
+    TH1::StatOverflows(true);
+    TH1::AddDirectory(true);
+
+    TFile outputFile(outputFileName.c_str(), "RECREATE");
+
+    if (outputFile.IsZombie())
+        throw std::runtime_error("Failed to create file \"" + outputFileName + "\".");
+
+    auto collections = DefineCollections();
+
+    UInt_t run, lumi;
+    ULong64_t event;
+    TTree *sampleTree = new TTree("Sample", "Properties of objects in sampled events");
+    sampleTree->Branch("run", &run);
+    sampleTree->Branch("lumi", &lumi);
+    sampleTree->Branch("event", &event);
+
+    for (auto &collection: collections)
+        collection->Book(sampleTree);
+
+
+    Long64_t numEventsProcessed = 0;
+
+    for (auto const &inputFileName: inputFileNames)
+    {
+        std::unique_ptr<TFile> inputFile(TFile::Open(inputFileName.c_str()));
+
+        if (not inputFile or inputFile->IsZombie())
+            throw std::runtime_error("Failed to open file \"" + inputFileName + "\".");
+
+        TTree *tree = dynamic_cast<TTree *>(inputFile->Get("pecEventID/EventID"));
+
+        if (not tree)
+            throw std::runtime_error("File \"" + inputFileName + "\" does not contain tree "
+              "\"pecEventID/EventID\".");
+
+        tree->AddFriend("pecMuons/Muons");
+        tree->AddFriend("pecElectrons/Electrons");
+        tree->AddFriend("pecJetMET/JetMET");
+
+        // Only read the needed branches
+        tree->SetBranchStatus("*", false);
+        tree->SetBranchStatus("eventId*", true);
+        pec::EventID *eventID = nullptr;
+
+        if (not tree->GetBranch("eventId"))
+            throw std::runtime_error("File \"" + inputFileName + "\" does not contain branch "
+              "\"eventId\". Event IDs stored in the compact form are not supported.");
+
+        tree->SetBranchAddress("eventId", &eventID);
+
+        for (auto &collection: collections)
+            collection->SetBranch(tree);
+
+        for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry)
+        {
+            if (maxEvents >= 0 and numEventsProcessed == maxEvents)
+                break;
+
+            tree->GetEntry(entry);
+            ++numEventsProcessed;
+            bool const sample = (eventID->EventNumber() % sampleModulo == 0);
+
+            for (auto &collection: collections)
+                collection->Fill(sample);
+
+            if (sample)
+            {
+                run = eventID->RunNumber();
+                lumi = eventID->LumiSectionNumber();
+                event = eventID->EventNumber();
+                sampleTree->Fill();
+            }
+        }
+
+        // The friend trees are owned by the input file, which is about to be closed
+        tree->ResetBranchAddresses();
+        delete eventID;
+    }
+
+    outputFile.Write();
+    outputFile.Close();
+
+    std::cout << numEventsProcessed << " events processed\n";
+}
+
+
+/**
+ * \brief Reads values of all branches with floating-point vectors in the sample tree
+ *
+ * The values are indexed with event ID and name of the branch.
+ */
+std::map<std::tuple<UInt_t, UInt_t, ULong64_t>, std::map<std::string, std::vector<float>>>
+  ReadSample(TFile &file, std::vector<std::string> const &branchNames)
+{
+    TTree *tree = dynamic_cast<TTree *>(file.Get("Sample"));
+
+    if (not tree)
+        throw std::runtime_error("File \"" + std::string(file.GetName()) + "\" does not contain "
+          "tree \"Sample\".");
+
+    UInt_t run, lumi;
+    ULong64_t event;
+    tree->SetBranchAddress("run", &run);
+    tree->SetBranchAddress("lumi", &lumi);
+    tree->SetBranchAddress("event", &event);
+
+    std::vector<std::vector<float> *> buffers(branchNames.size(), nullptr);
+
+    for (unsigned i = 0; i < branchNames.size(); ++i)
+        tree->SetBranchAddress(branchNames[i].c_str(), &buffers[i]);
+
+    std::map<std::tuple<UInt_t, UInt_t, ULong64_t>, std::map<std::string, std::vector<float>>>
+      sample;
+
+    for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry)
+    {
+        tree->GetEntry(entry);
+        auto &values = sample[std::make_tuple(run, lumi, event)];
+
+        for (unsigned i = 0; i < branchNames.size(); ++i)
+            values[branchNames[i]] = *buffers[i];
+    }
+
+    tree->ResetBranchAddresses();
+
+    for (auto buffer: buffers)
+        delete buffer;
+
+    return sample;
+}
+
+
+/// Compares two files produced with function Fill; returns the number of found differences
+unsigned Compare(std::string const &referenceFileName, std::string const &targetFileName,
+  double minPValue)
+{
+    TH1::AddDirectory(false);
+
+    std::unique_ptr<TFile> files[2];
+    std::string const fileNames[2] = {referenceFileName, targetFileName};
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        files[i].reset(TFile::Open(fileNames[i].c_str()));
+
+        if (not files[i] or files[i]->IsZombie())
+            throw std::runtime_error("Failed to open file \"" + fileNames[i] + "\".");
+    }
+
+    unsigned numDifferences = 0;
+
+
+    // Compare distributions
+    std::vector<std::string> branchNames;
+
+    for (auto const &collection: DefineCollections())
+    {
+        std::vector<std::string> names{collection->GetName() + "_size"};
+
+        for (auto const &quantityName: collection->GetQuantityNames())
+        {
+            names.emplace_back(collection->GetName() + "_" + quantityName);
+            branchNames.emplace_back(names.back());
+        }
+
+        for (auto const &name: names)
+        {
+            TH1 *hists[2];
+
+            for (unsigned i = 0; i < 2; ++i)
+            {
+                hists[i] = dynamic_cast<TH1 *>(files[i]->Get(name.c_str()));
+
+                if (not hists[i])
+                    throw std::runtime_error("File \"" + fileNames[i] + "\" does not contain "
+                      "histogram \"" + name + "\".");
+            }
+
+            if (hists[0]->GetEntries() == 0. and hists[1]->GetEntries() == 0.)
+                continue;
+
+            double const pValue = hists[0]->Chi2Test(hists[1], "UU");
+            double const refMean = hists[0]->GetMean();
+            double const relDiffMean = (hists[1]->GetMean() - refMean) /
+              std::max(std::abs(refMean), 1e-7);
+
+            if (pValue < minPValue or hists[0]->GetEntries() != hists[1]->GetEntries())
+            {
+                std::cout << "Distribution " << name << " differs: p-value " << pValue <<
+                  ", entries " << hists[0]->GetEntries() << " vs " << hists[1]->GetEntries() <<
+                  ", relative difference in mean " << relDiffMean << '\n';
+                ++numDifferences;
+            }
+        }
+    }
+
+
+    // Compare the sampled events exactly
+    auto const refSample = ReadSample(*files[0], branchNames);
+    auto const targetSample = ReadSample(*files[1], branchNames);
+    unsigned numCommonEvents = 0, numMissingEvents = 0;
+
+    for (auto const &refEvent: refSample)
+    {
+        auto const res = targetSample.find(refEvent.first);
+
+        if (res == targetSample.end())
+        {
+            ++numMissingEvents;
+            continue;
+        }
+
+        ++numCommonEvents;
+
+        for (auto const &branchName: branchNames)
+        {
+            auto const &refValues = refEvent.second.at(branchName);
+            auto const &targetValues = res->second.at(branchName);
+            bool match = (refValues.size() == targetValues.size());
+
+            for (unsigned i = 0; match and i < refValues.size(); ++i)
+            {
+                double const v1 = refValues[i], v2 = targetValues[i];
+
+                if (std::abs(v1 - v2) > std::max(1e-7 * std::max(std::abs(v1), std::abs(v2)),
+                  1e-7))
+                    match = false;
+            }
+
+            if (not match)
+            {
+                std::cout << "Event " << std::get<0>(refEvent.first) << ":" <<
+                  std::get<1>(refEvent.first) << ":" << std::get<2>(refEvent.first) <<
+                  ": mismatch in " << branchName << '\n';
+                ++numDifferences;
+            }
+        }
+    }
+
+    unsigned const numExtraEvents = targetSample.size() - numCommonEvents;
+    std::cout << numCommonEvents << " sampled events compared exactly, " << numMissingEvents <<
+      " only in the reference, " << numExtraEvents << " only in the target\n";
+    numDifferences += numMissingEvents + numExtraEvents;
+
+    return numDifferences;
+}
+
+
+int main(int argc, char **argv)
+{
+    std::string const usage("Usage:\n"
+      "  validatePECFiles fill [-s sampleModulo] [-n maxEvents] output.root input1.root ...\n"
+      "  validatePECFiles compare [-p minPValue] reference.root target.root\n");
+
+    if (argc < 2)
+    {
+        std::cerr << usage;
+        return 2;
+    }
+
+    std::string const mode(argv[1]);
+    std::vector<std::string> args(argv + 2, argv + argc);
+
+    // Parse options, which are given before positional arguments
+    std::map<std::string, std::string> options;
+
+    while (args.size() >= 2 and args[0].size() == 2 and args[0][0] == '-')
+    {
+        options[args[0]] = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    }
+
+    try
+    {
+        if (mode == "fill" and args.size() >= 2)
+        {
+            unsigned const sampleModulo = (options.count("-s") > 0) ?
+              std::stoul(options["-s"]) : 1000;
+            Long64_t const maxEvents = (options.count("-n") > 0) ? std::stoll(options["-n"]) : -1;
+
+            if (sampleModulo == 0)
+                throw std::runtime_error("Sample modulo must be positive.");
+
+            Fill(args[0], std::vector<std::string>(args.begin() + 1, args.end()), sampleModulo,
+              maxEvents);
+        }
+        else if (mode == "compare" and args.size() == 2)
+        {
+            double const minPValue = (options.count("-p") > 0) ? std::stod(options["-p"]) : 0.01;
+            unsigned const numDifferences = Compare(args[0], args[1], minPValue);
+
+            if (numDifferences > 0)
+            {
+                std::cout << numDifferences << " differences found\n";
+                return 1;
+            }
+
+            std::cout << "No differences found\n";
+        }
+        else
+        {
+            std::cerr << usage;
+            return 2;
+        }
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,6 +2,8 @@
 
 #include <Rtypes.h>
 
+#include <type_traits>
+
 
 namespace pec
 {
@@ -9,7 +11,25 @@ namespace pec
  * \class Candidate
  * \brief Stores four-momentum
  * 
- * Components of the four-momentum are compressed using minifloat functions.
+ * Components of the four-momentum are compressed using minifloat functions. Mantissas of
+ * transverse momentum and mass are rounded to ptMantissaBits and massMantissaBits bits
+ * respectively, so that they are compressed efficiently by ROOT. Pseudorapidity and azimuthal
+ * angle are rounded to uniform grids of 2^etaBits and 2^phiBits points in ranges
+ * [-maxAbsEta, maxAbsEta) and [-pi, pi) and stored as integer codes (see
+ * pec::minifloat::QuantizeGrid). Zero is represented exactly, so that a default-initialised object
+ * has a null four-momentum. Pseudorapidities outside of the range are mapped to its boundaries.
+ * The precision can be changed at compile time only. The compression is inherited by all derived
+ * classes.
+ * 
+ * The codes are stored in members etaCode and phiCode. Files written before their introduction,
+ * which store pseudorapidity and azimuthal angle as floats in members eta and phi, are read with
+ * the help of an I/O rule defined in classes_def.xml.
+ * 
+ * This class and all classes derived from it have no virtual methods and are trivially copyable,
+ * which is enforced at compile time. Objects thus carry no pointer to a virtual table, vectors of
+ * them can be copied as plain memory, and ROOT streams them member-wise. Method Reset of a derived
+ * class hides the one of its base class and calls it explicitly. Objects must not be destroyed
+ * through pointers to base classes.
  */
 class Candidate
 {
@@ -30,12 +50,9 @@ public:
     /// Default assignment operator
     Candidate &operator=(Candidate const &) = default;
     
-    /// Default virtual destructor
-    virtual ~Candidate() = default;
-    
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset();
+    void Reset();
     
     /// Sets transverse momentum (GeV/c)
     void SetPt(float pt);
@@ -70,16 +87,35 @@ public:
     float M() const;
     
 private:
-    /// Transverse momentum, GeV/c
+    /// Number of bits kept in the mantissa of transverse momentum
+    static unsigned const ptMantissaBits = 10;
+    
+    /// Number of bits kept in the mantissa of mass
+    static unsigned const massMantissaBits = 10;
+    
+    /// Number of bits used to encode pseudorapidity
+    static unsigned const etaBits = 16;
+    
+    /// Boundary of the range in which pseudorapidity is encoded
+    static constexpr float maxAbsEta = 10.f;
+    
+    /// Number of bits used to encode azimuthal angle
+    static unsigned const phiBits = 16;
+    
+    /// Transverse momentum, GeV/c, with a rounded mantissa
     Float_t pt;
     
-    /// Pseudorapidity
-    Float_t eta;
+    /// Encoded pseudorapidity
+    UShort_t etaCode;
     
-    /// Azimuthal angle, [-pi, pi)
-    Float_t phi;
+    /// Encoded azimuthal angle
+    UShort_t phiCode;
     
-    /// Mass, GeV/c^2
+    /// Mass, GeV/c^2, with a rounded mantissa
     Float_t mass;
 };
+
+
+static_assert(std::is_trivially_copyable<Candidate>::value,
+  "pec::Candidate must be trivially copyable.");
 }  // end of namespace pec
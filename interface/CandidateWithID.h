@@ -9,18 +9,34 @@ namespace pec
  * \class CandidateWithID
  * \brief Adds a set of user-defined booleand IDs to the class Candidate
  * 
- * The ID flags are accessed by index, up to 8 flags are supported. If a flag is set to true, the
- * candidate is supposed to be "good" in what concerns the corresponding ID.
+ * The ID flags are accessed by index. If a flag is set to true, the candidate is supposed to be
+ * "good" in what concerns the corresponding ID. The flags are packed into an unsigned integer of
+ * type IdBits_t, so up to maxIdBits flags are supported. The width can be changed at compile time
+ * only, by choosing IdBits_t among UChar_t, UShort_t, UInt_t, and ULong64_t. Since unused bits
+ * are always zero, they cost very little after compression of the output files. Names of the
+ * flags are not stored in the objects but saved in the output files by PECWriter, in tree
+ * "IDBits" (see its documentation).
+ * 
+ * In addition, the class stores a bit mask of trigger filters whose objects are matched to the
+ * candidate. Meaning of the bits is defined by the configuration of the job that has produced the
+ * candidate. Up to 32 filters are supported.
  */
 class CandidateWithID: public Candidate
 {
+public:
+    /// Type used to store the ID flags
+    typedef UInt_t IdBits_t;
+    
+    /// Maximal number of ID flags
+    static unsigned const maxIdBits = 8 * sizeof(IdBits_t);
+    
 public:
     /// Constructor with no parameters
     CandidateWithID() noexcept;
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
     
     /**
      * \brief Sets or unsets an ID bit
@@ -36,8 +52,36 @@ public:
      */
     bool TestBit(unsigned index) const;
     
+    /**
+     * \brief Returns all ID flags packed into an integer
+     * 
+     * The flag with index i corresponds to bit i. This allows to test several flags at once by
+     * comparing the result with a mask.
+     */
+    IdBits_t IdBits() const;
+    
+    /// Sets the bit mask of matched trigger filters
+    void SetTriggerMatches(unsigned mask);
+    
+    /// Returns the bit mask of matched trigger filters
+    unsigned TriggerMatches() const;
+    
+    /**
+     * \brief Checks if the candidate is matched to an object of the trigger filter with given index
+     * 
+     * Throws an exception if the index exceeds the maximal allowed number of filters.
+     */
+    bool TestTriggerMatch(unsigned index) const;
+    
 private:
     /// Variable to hold ID flags
-    UChar_t id;
+    IdBits_t id;
+    
+    /// Bit mask of matched trigger filters
+    UInt_t triggerMatches;
 };
+
+
+static_assert(std::is_trivially_copyable<CandidateWithID>::value,
+  "pec::CandidateWithID must be trivially copyable.");
 }  // end of namespace pec
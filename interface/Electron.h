@@ -12,7 +12,9 @@ namespace pec
  * Extends class Lepton by adding sets of boolean and real-valued identification decisions. They are
  * intended to be used to store results of cut-based and MVA algorithms, respectively. Up to eight
  * boolean flags can be stored. The maximal number of MVA-based decisions is given by contIdSize,
- * which can be changed at compile time only.
+ * which can be changed at compile time only. Plugin PECElectrons can alternatively store any
+ * number of real-valued decisions outside of this class, with the number fixed by the
+ * configuration.
  */
 class Electron: public Lepton
 {
@@ -22,7 +24,7 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
     
     /**
      * \brief Sets a decision of a cut-based ID
@@ -82,4 +84,8 @@ private:
      */
     Float_t mvaId[contIdSize];
 };
+
+
+static_assert(std::is_trivially_copyable<Electron>::value,
+  "pec::Electron must be trivially copyable.");
 }  // end of namespace pec
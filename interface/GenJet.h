@@ -20,7 +20,7 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
     
     /**
      * \brief Sets multiplicity of B hadrons
@@ -50,4 +50,8 @@ private:
      */
     UChar_t bcMult;
 };
+
+
+static_assert(std::is_trivially_copyable<GenJet>::value,
+  "pec::GenJet must be trivially copyable.");
 }  // end of namespace pec
@@ -20,7 +20,7 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
     
     /// Sets PDG ID
     void SetPdgId(int pdgId);
@@ -77,4 +77,8 @@ private:
      */
     UChar_t firstMotherIndex, lastMotherIndex;
 };
+
+
+static_assert(std::is_trivially_copyable<GenParticle>::value,
+  "pec::GenParticle must be trivially copyable.");
 }  // end of namespace pec
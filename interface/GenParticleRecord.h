@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Analysis/PECTuples/interface/Candidate.h>
+
+#include <Rtypes.h>
+
+#include <vector>
+
+
+namespace pec
+{
+/**
+ * \class GenParticleRecord
+ * \brief Compact record of all generator-level particles in an event
+ * 
+ * Unlike collections of pec::GenParticle, which are limited to a small subset of particles, this
+ * class is meant to store full (pruned) generator history. Properties of all particles are kept in
+ * parallel arrays. PDG IDs are replaced by short codes that index a table of distinct PDG IDs
+ * found in the event. Mothers are stored in a compressed sparse row layout: for each particle the
+ * end of its range of mothers is saved, and each mother is encoded by its offset with respect to
+ * the daughter, i.e. (daughter index - mother index) modulo 2^16. Mothers usually precede their
+ * daughters closely, so the offsets are small numbers and are compressed efficiently by ROOT.
+ * Four-momenta are stored as pec::Candidate and inherit its compression.
+ * 
+ * The number of particles and the total number of mother references in an event must not exceed
+ * maxSize.
+ */
+class GenParticleRecord
+{
+public:
+    /// Constructor without parameters
+    GenParticleRecord() noexcept;
+    
+    /// Default copy constructor
+    GenParticleRecord(GenParticleRecord const &) = default;
+    
+    /// Default assignment operator
+    GenParticleRecord &operator=(GenParticleRecord const &) = default;
+    
+public:
+    /// Resets the object to a state right after the default initialisation
+    void Reset();
+    
+    /**
+     * \brief Adds a new particle to the end of the record
+     * 
+     * Returns the index of the particle. Throws an exception if the record is full. The status is
+     * truncated to the range [0, 255].
+     */
+    unsigned AddParticle(int pdgId, int status, float pt, float eta, float phi, float mass);
+    
+    /**
+     * \brief Adds a mother to the particle added last
+     * 
+     * The mother is identified by its index in the record. It is allowed to add a mother that
+     * will only be added to the record later. Throws an exception if the index is not smaller than
+     * maxSize, or if the record contains no particles or is full.
+     */
+    void AddMother(unsigned motherIndex);
+    
+    /// Returns the number of particles
+    unsigned Size() const;
+    
+    /// Returns PDG ID of the particle with the given index
+    int PdgId(unsigned index) const;
+    
+    /// Returns status of the particle with the given index
+    int Status(unsigned index) const;
+    
+    /// Returns four-momentum of the particle with the given index
+    Candidate const &Momentum(unsigned index) const;
+    
+    /// Returns the number of mothers of the particle with the given index
+    unsigned NumMothers(unsigned index) const;
+    
+    /**
+     * \brief Returns index of a mother of the particle with the given index
+     * 
+     * The mothers are numbered in the order in which they have been added. The index iMother must
+     * be smaller than NumMothers(index).
+     */
+    unsigned MotherIndex(unsigned index, unsigned iMother) const;
+    
+public:
+    /// Maximal number of particles or references to mothers in an event
+    static unsigned const maxSize = 65535;
+    
+private:
+    /// Distinct PDG IDs of particles in the event, in the order of their first appearance
+    std::vector<Int_t> pdgIdTable;
+    
+    /// Codes of PDG IDs of all particles, which are indices in pdgIdTable
+    std::vector<UShort_t> pdgIdCodes;
+    
+    /// Statuses of all particles
+    std::vector<UChar_t> statuses;
+    
+    /// Four-momenta of all particles
+    std::vector<Candidate> momenta;
+    
+    /**
+     * \brief Ends of ranges of mothers of all particles
+     * 
+     * Mothers of particle i are stored in motherOffsets at positions [motherEnds[i - 1],
+     * motherEnds[i]), where motherEnds[-1] is understood as zero.
+     */
+    std::vector<UShort_t> motherEnds;
+    
+    /// Offsets of mothers with respect to their daughters, modulo 2^16
+    std::vector<UShort_t> motherOffsets;
+};
+}  // end of namespace pec
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <Rtypes.h>
+
+#include <vector>
+
+
+namespace pec
+{
+/**
+ * \class GeneratorContext
+ * \brief Generator-level information for an event, shared by several plugins
+ * 
+ * This class aggregates quantities derived from GenEventInfoProduct and LHEEventProduct that are
+ * needed by different plugins: process ID, the nominal weight, alternative LHE weights rescaled
+ * to the nominal weight, alternative parton shower weights, and PDF information. The object is
+ * filled once per event by plugin GeneratorContextProducer and read by other plugins; it is not
+ * meant to be stored in output trees.
+ */
+class GeneratorContext
+{
+public:
+    /// Constructor without parameters
+    GeneratorContext() noexcept;
+    
+    /// Default copy constructor
+    GeneratorContext(GeneratorContext const &) = default;
+    
+    /// Default assignment operator
+    GeneratorContext &operator=(GeneratorContext const &) = default;
+    
+public:
+    /// Sets process ID
+    void SetProcessId(int processId);
+    
+    /// Sets the nominal weight, as given by GenEventInfoProduct
+    void SetNominalWeight(double weight);
+    
+    /**
+     * \brief Sets the nominal LHE weight and the factor used to rescale LHE weights
+     * 
+     * The given weight must already include the factor.
+     */
+    void SetLheNominalWeight(double weight, double rescaleFactor);
+    
+    /**
+     * \brief Provides access to the vector of alternative LHE weights
+     * 
+     * The weights are expected to be rescaled with the factor given to SetLheNominalWeight.
+     */
+    std::vector<double> &AltLheWeights();
+    
+    /// Provides access to the vector of alternative PS weights
+    std::vector<double> &AltPsWeights();
+    
+    /**
+     * \brief Sets PDF information
+     * 
+     * Parton IDs are PDG ID codes.
+     */
+    void SetPdf(float x1, float x2, int id1, int id2, float qScale);
+    
+    /**
+     * \brief Returns process ID
+     * 
+     * Normally, it is read from the LHE event record. If it is not available, the process ID from
+     * GenEventInfoProduct is returned instead.
+     */
+    int ProcessId() const;
+    
+    /// Returns the nominal weight, as given by GenEventInfoProduct
+    double NominalWeight() const;
+    
+    /// Checks if LHE information is available for the event
+    bool HasLhe() const;
+    
+    /// Returns the nominal LHE weight, rescaled with the factor returned by LheRescaleFactor
+    double LheNominalWeight() const;
+    
+    /**
+     * \brief Returns the factor used to rescale LHE weights
+     * 
+     * Normally, this is the ratio between the nominal weight and the original nominal LHE weight.
+     */
+    double LheRescaleFactor() const;
+    
+    /**
+     * \brief Returns alternative LHE weights
+     * 
+     * The vector is empty if LHE information is not available or if the alternative weights have
+     * not been requested.
+     */
+    std::vector<double> const &AltLheWeights() const;
+    
+    /**
+     * \brief Returns alternative PS weights
+     * 
+     * The vector contains all weights given by GenEventInfoProduct, including the nominal one.
+     */
+    std::vector<double> const &AltPsWeights() const;
+    
+    /// Checks if PDF information is available for the event
+    bool HasPdf() const;
+    
+    /**
+     * \brief Returns momentum fraction carried by an initial parton
+     * 
+     * Throws an exception if the index is larger than 1.
+     */
+    float PdfX(unsigned index) const;
+    
+    /**
+     * \brief Returns ID of an initial parton
+     * 
+     * Throws an exception if the index is larger than 1.
+     */
+    int PdfId(unsigned index) const;
+    
+    /// Returns energy scale used to evaluate PDF, GeV
+    float PdfQScale() const;
+    
+private:
+    /// Process ID
+    Int_t processId;
+    
+    /// Nominal weight
+    Double_t nominalWeight;
+    
+    /// Indicates whether LHE information is available
+    Bool_t hasLhe;
+    
+    /// Rescaled nominal LHE weight
+    Double_t lheNominalWeight;
+    
+    /// Factor used to rescale LHE weights
+    Double_t lheRescaleFactor;
+    
+    /// Rescaled alternative LHE weights
+    std::vector<Double_t> altLheWeights;
+    
+    /// Alternative PS weights
+    std::vector<Double_t> altPsWeights;
+    
+    /// Indicates whether PDF information is available
+    Bool_t hasPdf;
+    
+    /// Momentum fractions carried by initial partons
+    Float_t pdfX[2];
+    
+    /// IDs of initial partons
+    Int_t pdfId[2];
+    
+    /// Energy scale to evaluate PDF, GeV
+    Float_t pdfQScale;
+};
+}  // end of namespace pec
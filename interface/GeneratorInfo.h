@@ -10,6 +10,12 @@ namespace pec
 /**
  * \class GeneratorInfo
  * \brief Aggregates basic generator-level information
+ * 
+ * Alternative LHE weights can be stored in a compact form. If a range of ratios has been set
+ * with method SetAltLheWeightRatioRange, each alternative weight is stored as its ratio to the
+ * nominal weight, quantized uniformly in the given range with 16 bits. Ratios outside of the range
+ * are mapped to its boundaries. Getters reconstruct absolute values of the weights regardless of
+ * the storage mode.
  */
 class GeneratorInfo
 {
@@ -37,12 +43,40 @@ public:
     /// Sets the nominal generator-level weight
     void SetNominalWeight(float weight);
     
-    /// Adds an alternative LHE event weight to the end of the collection
+    /**
+     * \brief Requests that alternative LHE weights are stored as quantized ratios to the nominal
+     * weight
+     * 
+     * The ratios are encoded in the range [min, max). Throws an exception if the range is empty
+     * or if some alternative LHE weights have already been added.
+     */
+    void SetAltLheWeightRatioRange(float min, float max);
+    
+    /**
+     * \brief Adds an alternative LHE event weight to the end of the collection
+     * 
+     * If the weight is stored as a ratio, the nominal weight must be set beforehand, and it must
+     * not be zero. Otherwise an exception is thrown.
+     */
     void AddAltLheWeight(float weight);
     
+    /**
+     * \brief Sets all alternative LHE event weights at once
+     * 
+     * Replaces weights added before. Requirements of method AddAltLheWeight apply.
+     */
+    void SetAltLheWeights(float const *weights, unsigned size);
+    
     /// Adds an alternative PS event weight to the end of the collection
     void AddAltPsWeight(float weight);
     
+    /**
+     * \brief Sets all alternative PS event weights at once
+     * 
+     * Replaces weights added before.
+     */
+    void SetAltPsWeights(float const *weights, unsigned size);
+    
     /**
      * \brief Sets momentum fraction carried by an initial parton
      * 
@@ -86,8 +120,21 @@ public:
     /// Returns the nominal generator-level weight
     float NominalWeight() const;
     
-    /// Returns alternative LHE weights
-    std::vector<Float_t> const &AltLheWeights() const;
+    /**
+     * \brief Returns alternative LHE weights
+     * 
+     * If the weights are stored as ratios, absolute values are reconstructed.
+     */
+    std::vector<Float_t> AltLheWeights() const;
+    
+    /// Returns alternative LHE weight with the given index
+    float AltLheWeight(unsigned index) const;
+    
+    /// Returns the number of alternative LHE weights
+    unsigned NumAltLheWeights() const;
+    
+    /// Checks if alternative LHE weights are stored as quantized ratios to the nominal weight
+    bool AltLheWeightsAsRatios() const;
 
     /// Returns alternative PS weights
     std::vector<Float_t> const &AltPsWeights() const;
@@ -117,8 +164,21 @@ private:
     /// Nominal generator-level weight
     Float_t nominalWeight;
     
-    /// Alternative LHE weights
+    /// Number of bits used to encode ratios of alternative LHE weights to the nominal one
+    static unsigned const altLheRatioBits = 16;
+    
+    /// Alternative LHE weights, filled if they are not stored as ratios
     std::vector<Float_t> altLheWeights;
+    
+    /**
+     * \brief Range in which ratios of alternative LHE weights to the nominal one are encoded
+     * 
+     * If the range is empty, the weights are stored as is.
+     */
+    Float_t altLheRatioMin, altLheRatioMax;
+    
+    /// Encoded ratios of alternative LHE weights to the nominal one
+    std::vector<UShort_t> altLheRatioCodes;
 
     /// Alternative PS weights
     std::vector<Float_t> altPsWeights;
@@ -65,7 +65,7 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset();
+    void Reset();
     
     /// Sets full jet energy correction factor
     void SetCorrFactor(float jecFactor);
@@ -76,6 +76,13 @@ public:
     /// Sets relative uncertainty of the JER smearing factor
     void SetJERUncertainty(float jecUncertainty);
     
+    /**
+     * \brief Sets indices of the bin in the tables of JEC uncertainty sources
+     * 
+     * See documentation for methods JECEtaBin and JECPtNode. Indices must be smaller than 256.
+     */
+    void SetJECUncBins(unsigned etaBin, unsigned ptNode);
+    
     /// Sets value of the given b-tagging discriminator
     void SetBTag(BTagAlgo algo, float value);
     
@@ -143,6 +150,24 @@ public:
      */
     float JERUncertainty() const;
     
+    /**
+     * \brief Returns index of the pseudorapidity bin in the tables of JEC uncertainty sources
+     * 
+     * If the tables are stored (see plugin JECUncertaintyTables), the uncertainty due to each
+     * source is computed by a linear interpolation in the corrected jet pt between nodes
+     * JECPtNode() and JECPtNode() + 1 of this bin, which reproduces JetCorrectionUncertainty.
+     * Otherwise the index is zero.
+     */
+    unsigned JECEtaBin() const;
+    
+    /**
+     * \brief Returns index of the node in pt in the tables of JEC uncertainty sources
+     * 
+     * This is the last node below the corrected jet pt, or zero if the pt is below all nodes. See
+     * also documentation for method JECEtaBin.
+     */
+    unsigned JECPtNode() const;
+    
     /// Returns value of the requested b-tagging discriminator
     float BTag(BTagAlgo algo) const;
     
@@ -249,5 +274,16 @@ private:
      * parton, and ME parton flavour. They are described in enumeration FlavourType.
      */
     UShort_t flavours;
+    
+    /**
+     * \brief Indices of the bin in the tables of JEC uncertainty sources
+     * 
+     * See documentation for methods JECEtaBin and JECPtNode.
+     */
+    UChar_t jecEtaBin, jecPtNode;
 };
+
+
+static_assert(std::is_trivially_copyable<Jet>::value,
+  "pec::Jet must be trivially copyable.");
 }  // end of namespace pec
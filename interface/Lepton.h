@@ -17,7 +17,7 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
     
     /**
      * \brief Sets lepton charge
@@ -50,4 +50,8 @@ private:
     /// Relative isolation
     Float_t relIso;
 };
+
+
+static_assert(std::is_trivially_copyable<Lepton>::value,
+  "pec::Lepton must be trivially copyable.");
 }  // end of namespace pec
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Rtypes.h>
+
+#include <type_traits>
+
+
+namespace pec
+{
+/**
+ * \class MET
+ * \brief Compact representation of missing pt and its variations
+ * 
+ * The class stores components of the nominal missing pt and a fixed number of shifts of them,
+ * which describe systematic variations and partly uncorrected versions of MET. Nominal components
+ * are stored as floats with mantissas rounded to mantissaBits bits. Shifts are quantized with the
+ * step shiftUnit, in GeV, and stored as 16-bit integers, which covers shifts up to about 650 GeV.
+ * Larger shifts are clipped. Shifts that have not been set are zero, which is the case, e.g., for
+ * systematic variations in real data.
+ * 
+ * The class has no virtual methods and is trivially copyable, which is enforced at compile time.
+ * All members have fixed sizes, and reading an object amounts to a fixed-size load.
+ */
+class MET
+{
+public:
+    /// Supported variations of MET, used as indices of the shifts
+    enum class Variation
+    {
+        JetEnUp,
+        JetEnDown,
+        JetResUp,
+        JetResDown,
+        UnclusteredEnUp,
+        UnclusteredEnDown,
+        
+        /// Raw MET
+        Raw,
+        
+        /// MET from which T1 corrections induced by stored jets are removed
+        UncorrT1
+    };
+    
+    /// Number of variations
+    static unsigned const numVariations = 8;
+    
+    /// Number of bits kept in mantissas of the nominal components
+    static unsigned const mantissaBits = 12;
+    
+    /// Quantization step for shifts, GeV
+    static constexpr float shiftUnit = 0.02f;
+    
+public:
+    /// Constructor with no parameters
+    MET() noexcept;
+    
+    /// Default copy constructor
+    MET(MET const &) = default;
+    
+    /// Default assignment operator
+    MET &operator=(MET const &) = default;
+    
+public:
+    /// Resets the object to a state right after the default initialisation
+    void Reset();
+    
+    /// Sets components of the nominal missing pt, GeV/c
+    void SetP(float px, float py);
+    
+    /**
+     * \brief Sets components of the missing pt for the given variation, GeV/c
+     * 
+     * The shifts with respect to the nominal values are stored. Therefore, the nominal components
+     * must be set before this method is called.
+     */
+    void SetShiftedP(Variation var, float px, float py);
+    
+    /// Returns x component of the nominal missing pt, GeV/c
+    float Px() const;
+    
+    /// Returns y component of the nominal missing pt, GeV/c
+    float Py() const;
+    
+    /// Returns magnitude of the nominal missing pt, GeV/c
+    float Pt() const;
+    
+    /**
+     * \brief Returns azimuthal angle of the nominal missing pt
+     * 
+     * The range is [-pi, pi].
+     */
+    float Phi() const;
+    
+    /// Returns x component of the missing pt for the given variation, GeV/c
+    float Px(Variation var) const;
+    
+    /// Returns y component of the missing pt for the given variation, GeV/c
+    float Py(Variation var) const;
+    
+    /// Returns magnitude of the missing pt for the given variation, GeV/c
+    float Pt(Variation var) const;
+    
+    /// Returns azimuthal angle of the missing pt for the given variation
+    float Phi(Variation var) const;
+    
+private:
+    /// Encodes a shift with an integer code
+    static Short_t EncodeShift(float shift);
+    
+private:
+    /// Components of the nominal missing pt, GeV/c, with rounded mantissas
+    Float_t px, py;
+    
+    /// Encoded shifts of x and y components for all variations
+    Short_t shifts[numVariations][2];
+};
+
+
+static_assert(std::is_trivially_copyable<MET>::value, "pec::MET must be trivially copyable.");
+}  // end of namespace pec
@@ -0,0 +1,55 @@
+#pragma once
+
+
+namespace pec
+{
+/**
+ * \brief Functions to reduce precision of floating-point numbers
+ *
+ * They are used to implement lossy compression of properties of PEC objects. Numbers with a
+ * reduced precision are stored either as floats with a truncated mantissa, which are compressed
+ * efficiently by ROOT since the lower bits of the mantissa are set to zero, or as integer codes
+ * obtained from a uniform quantization of a fixed range.
+ */
+namespace minifloat
+{
+/**
+ * \brief Rounds the mantissa of the given number to the given number of bits
+ *
+ * The rounding is done to the nearest representable value, with ties rounded to the value with an
+ * even mantissa. Infinities and NaN are returned unchanged. If the number of bits is at least the
+ * full length of the mantissa of a float (23 bits), the number is not changed.
+ */
+float RoundMantissa(float x, unsigned nBits);
+
+/**
+ * \brief Encodes the given number with an integer code
+ *
+ * The range [min, max) is split into 2^nBits bins of equal size, and the index of the bin that
+ * contains the number is returned. Numbers outside of the range are mapped to the first or the
+ * last bin. The number of bits must not exceed 16.
+ */
+unsigned Quantize(float x, float min, float max, unsigned nBits);
+
+/**
+ * \brief Decodes a code produced by function Quantize
+ *
+ * Returns the centre of the corresponding bin.
+ */
+float Dequantize(unsigned code, float min, float max, unsigned nBits);
+
+/**
+ * \brief Encodes the given number with the index of the nearest point of a uniform grid
+ *
+ * The grid consists of 2^nBits points min + i * (max - min) / 2^nBits. Unlike with function
+ * Quantize, the lower boundary of the range is represented exactly, and so is zero if the range is
+ * symmetric. Numbers outside of the range are mapped to the first or the last point. If periodic
+ * is true, the range is treated as a period, and numbers closer to max than to the last point are
+ * mapped to the first point. The number of bits must not exceed 16.
+ */
+unsigned QuantizeGrid(float x, float min, float max, unsigned nBits, bool periodic = false);
+
+/// Decodes a code produced by function QuantizeGrid
+float DequantizeGrid(unsigned code, float min, float max, unsigned nBits);
+}  // end of namespace minifloat
+}  // end of namespace pec
@@ -19,6 +19,10 @@ public:
     
 public:
     /// Resets the object to a state right after the default initialisation
-    virtual void Reset() override;
+    void Reset();
 };
+
+
+static_assert(std::is_trivially_copyable<Muon>::value,
+  "pec::Muon must be trivially copyable.");
 }  // end of namespace pec
@@ -8,6 +8,10 @@ namespace pec
 /**
  * \class PileUpInfo
  * \brief Combines information related to pile-up
+ * 
+ * In simulation, the object can also contain pileup weights for the nominal data profile and its
+ * up and down variations. They are typically computed by plugin PECPileUp. If not set, all weights
+ * are equal to unity.
  */
 class PileUpInfo
 {
@@ -56,6 +60,13 @@ public:
      */
     void SetMaxPtHat(float maxPtHat);
     
+    /**
+     * \brief Sets pileup weights for the nominal data profile and its up and down variations
+     * 
+     * The method must be used for simulation only.
+     */
+    void SetWeights(float nominal, float up, float down);
+    
     /// Returns the number of good reconstructed primary vertices
     unsigned NumPV() const;
     
@@ -88,6 +99,15 @@ public:
      */
     float MaxPtHat() const;
     
+    /// Returns pileup weight for the nominal data profile
+    float Weight() const;
+    
+    /// Returns pileup weight for the down variation of the data profile
+    float WeightDown() const;
+    
+    /// Returns pileup weight for the up variation of the data profile
+    float WeightUp() const;
+    
 private:
     /// Number of good reconstructed primary vertices
     UChar_t numPV;
@@ -111,5 +131,8 @@ private:
     
     /// Largest ptHat of admixed in-time pileup interactions
     Float_t maxPtHat;
+    
+    /// Pileup weights for the nominal data profile and its up and down variations
+    Float_t weight, weightUp, weightDown;
 };
 }  // end of namespace pec
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <Rtypes.h>
+
+
+namespace pec
+{
+/**
+ * \class RecoContext
+ * \brief Event-level reconstructed quantities, shared by several plugins
+ * 
+ * This class aggregates properties of primary vertices and pileup densities that are needed by
+ * different plugins: the number of all and of good primary vertices, the position of the first
+ * primary vertex and the result of the selection applied to it, and two versions of rho. The
+ * object is filled once per event by plugin RecoContextProducer and read by other plugins; it is
+ * not meant to be stored in output trees.
+ */
+class RecoContext
+{
+public:
+    /// Constructor without parameters
+    RecoContext() noexcept;
+    
+    /// Default copy constructor
+    RecoContext(RecoContext const &) = default;
+    
+    /// Default assignment operator
+    RecoContext &operator=(RecoContext const &) = default;
+    
+public:
+    /// Sets numbers of all primary vertices and of those that pass the selection
+    void SetNumPV(unsigned numPV, unsigned numGoodPV);
+    
+    /// Sets position of the first primary vertex and the result of its selection
+    void SetFirstPV(double x, double y, double z, bool isGood);
+    
+    /// Sets rho (mean angular pt density)
+    void SetRho(double rho);
+    
+    /// Sets rho computed in the central region
+    void SetRhoCentral(double rhoCentral);
+    
+    /// Returns number of all reconstructed primary vertices
+    unsigned NumPV() const;
+    
+    /// Returns number of primary vertices that pass the selection
+    unsigned NumGoodPV() const;
+    
+    /// Checks if the first primary vertex passes the selection
+    bool IsFirstPVGood() const;
+    
+    /**
+     * \brief Returns a coordinate of the first primary vertex, cm
+     * 
+     * Coordinates x, y, and z are given by indices 0, 1, and 2. Throws an exception if the index
+     * is larger than 2.
+     */
+    double FirstPVPosition(unsigned index) const;
+    
+    /// Returns rho (mean angular pt density)
+    double Rho() const;
+    
+    /// Returns rho computed in the central region
+    double RhoCentral() const;
+    
+private:
+    /// Number of all reconstructed primary vertices
+    UInt_t numPV;
+    
+    /// Number of primary vertices that pass the selection
+    UInt_t numGoodPV;
+    
+    /// Indicates whether the first primary vertex passes the selection
+    Bool_t firstPVGood;
+    
+    /// Position of the first primary vertex, cm
+    Double_t firstPVPosition[3];
+    
+    /// Rho
+    Double_t rho;
+    
+    /// Rho in the central region
+    Double_t rhoCentral;
+};
+}  // end of namespace pec
@@ -0,0 +1,172 @@
+#include "ChannelPreselection.h"
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/Exception.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+
+#include <algorithm>
+#include <memory>
+
+
+ChannelPreselection::ChannelPreselection(edm::ParameterSet const &cfg):
+    jetSelector(cfg.getParameter<std::string>("jetCut")),
+    stopAtFirstPass(cfg.getParameter<bool>("stopAtFirstPass"))
+{
+    auto const &channelConfigs = cfg.getParameter<std::vector<edm::ParameterSet>>("channels");
+
+    if (channelConfigs.size() > maxChannels)
+    {
+        cms::Exception excp("Configuration");
+        excp << "At most " << maxChannels << " channels are supported while " <<
+          channelConfigs.size() << " are given.";
+        excp.raise();
+    }
+
+
+    // Register distinct collections of leptons and requirements for all channels
+    std::vector<edm::InputTag> leptonTags;
+    bool jetsNeeded = false;
+
+    for (auto const &channelConfig: channelConfigs)
+    {
+        edm::InputTag const tag = channelConfig.getParameter<edm::InputTag>("leptons");
+        auto const res = std::find(leptonTags.begin(), leptonTags.end(), tag);
+
+        Channel channel;
+        channel.leptonSource = res - leptonTags.begin();
+
+        if (res == leptonTags.end())
+        {
+            leptonTags.emplace_back(tag);
+            leptonTokens.emplace_back(consumes<edm::View<reco::Candidate>>(tag));
+        }
+
+        channel.minLeptons = channelConfig.getParameter<unsigned>("minLeptons");
+        channel.maxLeptons = channelConfig.getParameter<unsigned>("maxLeptons");
+        channel.minJets = channelConfig.getParameter<unsigned>("minJets");
+
+        if (channel.minJets > 0)
+            jetsNeeded = true;
+
+        channels.emplace_back(channel);
+    }
+
+
+    if (jetsNeeded)
+    {
+        edm::InputTag const jetTag = cfg.getParameter<edm::InputTag>("jets");
+
+        if (jetTag.label().empty())
+        {
+            cms::Exception excp("Configuration");
+            excp << "A collection of jets must be given since some channels require jets.";
+            excp.raise();
+        }
+
+        jetToken = consumes<edm::View<reco::Candidate>>(jetTag);
+    }
+
+
+    produces<unsigned>();
+}
+
+
+void ChannelPreselection::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription channelDesc;
+    channelDesc.add<edm::InputTag>("leptons")->
+      setComment("Collection of selected leptons.");
+    channelDesc.add<unsigned>("minLeptons", 1)->
+      setComment("Minimal allowed number of leptons.");
+    channelDesc.add<unsigned>("maxLeptons", 999)->
+      setComment("Maximal allowed number of leptons.");
+    channelDesc.add<unsigned>("minJets", 0)->
+      setComment("Minimal number of jets that pass the selection.");
+
+    edm::ParameterSetDescription desc;
+    desc.addVPSet("channels", channelDesc)->
+      setComment("Requirements for all channels. Their order defines bits in the output.");
+    desc.add<edm::InputTag>("jets", edm::InputTag())->
+      setComment("Collection of jets. Only read if some channel requires jets.");
+    desc.add<std::string>("jetCut", "")->
+      setComment("Selection applied to jets before counting them.");
+    desc.add<bool>("stopAtFirstPass", false)->
+      setComment("Indicates whether channels following the first passing one should be "
+      "skipped.");
+
+    descriptions.add("channelPreselection", desc);
+}
+
+
+bool ChannelPreselection::filter(edm::StreamID, edm::Event &event, edm::EventSetup const &) const
+{
+    // Check requirements on leptons in all channels. Numbers of leptons are read lazily, and each
+    //collection is read at most once.
+    std::vector<int> numLeptons(leptonTokens.size(), -1);
+    std::vector<unsigned> candidates;
+    unsigned maxJetsNeeded = 0;
+
+    for (unsigned iChannel = 0; iChannel < channels.size(); ++iChannel)
+    {
+        Channel const &channel = channels[iChannel];
+        int &n = numLeptons[channel.leptonSource];
+
+        if (n < 0)
+        {
+            edm::Handle<edm::View<reco::Candidate>> leptons;
+            event.getByToken(leptonTokens[channel.leptonSource], leptons);
+            n = leptons->size();
+        }
+
+        if (unsigned(n) < channel.minLeptons or unsigned(n) > channel.maxLeptons)
+            continue;
+
+        candidates.emplace_back(iChannel);
+        maxJetsNeeded = std::max(maxJetsNeeded, channel.minJets);
+
+        // If the channel passes without jets, the decision for the event is settled
+        if (stopAtFirstPass and channel.minJets == 0)
+            break;
+    }
+
+
+    // Count jets, stopping as soon as the largest required number is reached
+    unsigned numJets = 0;
+
+    if (maxJetsNeeded > 0)
+    {
+        edm::Handle<edm::View<reco::Candidate>> jets;
+        event.getByToken(jetToken, jets);
+
+        for (auto const &jet: *jets)
+        {
+            if (jetSelector(jet))
+                ++numJets;
+
+            if (numJets >= maxJetsNeeded)
+                break;
+        }
+    }
+
+
+    // Combine the decisions
+    unsigned decisions = 0;
+
+    for (unsigned const iChannel: candidates)
+    {
+        if (numJets >= channels[iChannel].minJets)
+        {
+            decisions |= (1u << iChannel);
+
+            if (stopAtFirstPass)
+                break;
+        }
+    }
+
+    event.put(std::make_unique<unsigned>(decisions));
+
+    return (decisions != 0);
+}
+
+
+DEFINE_FWK_MODULE(ChannelPreselection);
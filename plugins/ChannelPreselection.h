@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CompiledCut.h"
+
+#include <FWCore/Framework/interface/global/EDFilter.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <DataFormats/Candidate/interface/Candidate.h>
+
+#include <string>
+#include <vector>
+
+
+/**
+ * \class ChannelPreselection
+ * \brief Evaluates loose selections for several analysis channels in a single pass
+ *
+ * Each channel is described by a collection of leptons, an allowed range for their number, and
+ * the minimal number of jets. Collections of leptons are expected to have been selected already,
+ * so only their sizes are checked. Each distinct collection is read once even if it is shared by
+ * several channels. Jets are read from a single collection, common to all channels, and counted
+ * once after applying the given cut. They are only read if at least one channel that passes its
+ * requirement on leptons also requires jets, and the loop over jets stops as soon as the largest
+ * required number is reached.
+ *
+ * Per-channel decisions are put into the event as an unsigned integer, in which bit i is set if
+ * channel i (in the order of the configuration) passes. The event is accepted if at least one
+ * channel passes. If flag "stopAtFirstPass" is true, channels following the first passing one are
+ * not evaluated, and their bits are left unset. Names of the channels are not known to the plugin;
+ * they can be saved together with the decisions as names of the bits with PECWriter.
+ *
+ * This plugin replaces chains of count filters that are run in separate paths for each channel.
+ */
+class ChannelPreselection: public edm::global::EDFilter<>
+{
+private:
+    /// Requirements for a single channel
+    struct Channel
+    {
+        /// Index of the collection of leptons in leptonTokens
+        unsigned leptonSource;
+
+        /// Allowed range of numbers of leptons; the boundaries are included
+        unsigned minLeptons, maxLeptons;
+
+        /// Minimal number of jets
+        unsigned minJets;
+    };
+
+public:
+    /// Constructor
+    ChannelPreselection(edm::ParameterSet const &cfg);
+
+public:
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+    /// Evaluates decisions for all channels and puts them into the event
+    virtual bool filter(edm::StreamID, edm::Event &event, edm::EventSetup const &) const override;
+
+private:
+    /// Maximal number of channels, given by the size of the bit mask
+    static unsigned const maxChannels = 32;
+
+    /// Distinct collections of leptons
+    std::vector<edm::EDGetTokenT<edm::View<reco::Candidate>>> leptonTokens;
+
+    /// Requirements for all channels
+    std::vector<Channel> channels;
+
+    /// Collection of jets; only initialized if some channel requires jets
+    edm::EDGetTokenT<edm::View<reco::Candidate>> jetToken;
+
+    /// Selection applied to jets before counting them
+    CompiledCut<reco::Candidate> const jetSelector;
+
+    /// Indicates whether evaluation should stop after the first passing channel
+    bool const stopAtFirstPass;
+};
@@ -0,0 +1,78 @@
+#include "CompensatedSums.h"
+
+#include <FWCore/Utilities/interface/EDMException.h>
+
+
+CompensatedSums::CompensatedSums(unsigned size)
+{
+    Resize(size);
+}
+
+
+void CompensatedSums::Fill(double const *x)
+{
+    unsigned const n = posSums.size();
+    double *posSum = posSums.data(), *negSum = negSums.data();
+    double *posCompensation = posCompensations.data(), *negCompensation = negCompensations.data();
+
+    for (unsigned i = 0; i < n; ++i)
+    {
+        // Split the number into positive and negative parts, one of which is zero. Adding a zero
+        //does not change a sum or its compensation, so both sums can be updated unconditionally.
+        double const pos = (x[i] >= 0.) ? x[i] : 0.;
+        double const neg = (x[i] >= 0.) ? 0. : -x[i];
+
+        Add(posSum[i], posCompensation[i], pos);
+        Add(negSum[i], negCompensation[i], neg);
+    }
+}
+
+
+double CompensatedSums::GetSum(unsigned index) const
+{
+    // Since there might be a catastrophic cancellation between the positive and negative sums,
+    //apply the compensations before subtracting them
+    return (posSums[index] + posCompensations[index]) -
+      (negSums[index] + negCompensations[index]);
+}
+
+
+void CompensatedSums::Merge(CompensatedSums const &other)
+{
+    if (Size() == 0)
+        Resize(other.Size());
+
+    if (Size() != other.Size())
+    {
+        edm::Exception excp(edm::errors::LogicError);
+        excp << "Cannot merge " << other.Size() << " sums into " << Size() << " sums.";
+        excp.raise();
+    }
+
+    for (unsigned i = 0; i < Size(); ++i)
+    {
+        Add(posSums[i], posCompensations[i], other.posSums[i]);
+        posCompensations[i] += other.posCompensations[i];
+
+        Add(negSums[i], negCompensations[i], other.negSums[i]);
+        negCompensations[i] += other.negCompensations[i];
+    }
+}
+
+
+void CompensatedSums::Resize(unsigned size)
+{
+    posSums.assign(size, 0.);
+    negSums.assign(size, 0.);
+    posCompensations.assign(size, 0.);
+    negCompensations.assign(size, 0.);
+}
+
+
+void CompensatedSums::Add(double &sum, double &compensation, double x)
+{
+    // Both the sum and the number are non-negative, so their magnitudes are compared directly
+    double const newSum = sum + x;
+    compensation += (sum >= x) ? (sum - newSum) + x : (x - newSum) + sum;
+    sum = newSum;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+
+/**
+ * \class CompensatedSums
+ * \brief Computes sums of several sequences of numbers with compensated summation
+ *
+ * Each sum is computed on the fly and compensated for errors arising from the floating-point
+ * arithmetic with the Neumaier variant of the Kahan summation algorithm [1]. Summation is done
+ * independently for positive and negative numbers in order to prevent a catastrophic
+ * cancellation.
+ *
+ * Partial sums and compensations are stored in separate contiguous arrays (struct-of-arrays
+ * layout), and all sums are updated at once with method Fill. The update does not contain
+ * branches, which allows the compiler to vectorize it. Independent partial sums computed, for
+ * instance, in different streams can be combined with method Merge, which keeps the
+ * compensations.
+ * [1] https://en.wikipedia.org/wiki/Kahan_summation_algorithm#Further_enhancements
+ */
+class CompensatedSums
+{
+public:
+    /// Constructor for the given number of sums
+    CompensatedSums(unsigned size = 0);
+
+public:
+    /**
+     * \brief Adds given numbers to the sums
+     *
+     * The array must contain Size() numbers, one per sum.
+     */
+    void Fill(double const *x);
+
+    /// Returns the value of the sum with the given index
+    double GetSum(unsigned index) const;
+
+    /**
+     * \brief Adds partial sums from another object to this one
+     *
+     * If this object is empty, it is resized to match the other one. Otherwise the sizes must
+     * agree, or else an exception is thrown.
+     */
+    void Merge(CompensatedSums const &other);
+
+    /// Sets the number of sums and resets all of them to zero
+    void Resize(unsigned size);
+
+    /// Returns the number of sums
+    unsigned Size() const
+    {
+        return posSums.size();
+    }
+
+private:
+    /// Adds the given non-negative number to the sum with the given compensation
+    static void Add(double &sum, double &compensation, double x);
+
+private:
+    /// Current sums of positive and negative numbers
+    std::vector<double> posSums, negSums;
+
+    /// Compensations for the sums of positive and negative numbers
+    std::vector<double> posCompensations, negCompensations;
+};
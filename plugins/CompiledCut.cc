@@ -0,0 +1,603 @@
+#include "CompiledCut.h"
+
+#include <DataFormats/PatCandidates/interface/Electron.h>
+#include <DataFormats/PatCandidates/interface/Jet.h>
+#include <DataFormats/PatCandidates/interface/Muon.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+
+using namespace compiledcut;
+
+
+namespace
+{
+/// Description of a variable recognized by the parser
+struct VariableInfo
+{
+    char const *name;
+    Variable variable;
+
+    /// Indicates whether the method takes a string argument
+    bool hasLabel;
+};
+
+
+VariableInfo const knownVariables[] = {
+    {"pt", Variable::Pt, false},
+    {"eta", Variable::Eta, false},
+    {"phi", Variable::Phi, false},
+    {"energy", Variable::Energy, false},
+    {"et", Variable::Et, false},
+    {"mass", Variable::Mass, false},
+    {"charge", Variable::Charge, false},
+    {"px", Variable::Px, false},
+    {"py", Variable::Py, false},
+    {"pz", Variable::Pz, false},
+    {"userFloat", Variable::UserFloat, true},
+    {"userInt", Variable::UserInt, true},
+    {"electronID", Variable::ElectronID, true},
+    {"bDiscriminator", Variable::BDiscriminator, true},
+    {"isLooseMuon", Variable::IsLooseMuon, false},
+    {"isMediumMuon", Variable::IsMediumMuon, false},
+    {"isGlobalMuon", Variable::IsGlobalMuon, false},
+    {"isTrackerMuon", Variable::IsTrackerMuon, false},
+    {"isPFMuon", Variable::IsPFMuon, false}
+};
+
+
+/**
+ * \brief Recursive-descent parser that emits instructions while reading the expression
+ *
+ * Grammar:
+ *   or         := and (('|' | '||') and)*
+ *   and        := unary (('&' | '&&') unary)*
+ *   unary      := '!' unary | '(' or ')' | comparison
+ *   comparison := value op number | number op value | value
+ *   value      := 'abs' '(' value ')' | name ['(' ')'] | name '(' string ')'
+ * A bare value is only accepted for boolean variables. Chained comparisons like "a < x < b" are
+ * not supported. Each method returns false on a syntax that is not supported.
+ */
+class Parser
+{
+public:
+    Parser(std::string const &expression, Program &program);
+
+public:
+    /// Parses the full expression
+    bool Parse();
+
+private:
+    /// Checks if the given token follows and consumes it if so
+    bool Accept(char const *token);
+
+    /// Checks if the end of the expression has been reached, skipping whitespace
+    bool AtEnd();
+
+    /// Returns index of the given label in Program::labels, adding it if needed
+    unsigned FindLabel(std::string const &label);
+
+    /// Reads a comparison operator
+    bool ParseComparison(Comparison &comparison);
+
+    /// Reads an identifier
+    bool ParseIdentifier(std::string &identifier);
+
+    /// Reads a number
+    bool ParseNumber(double &value);
+
+    /// Reads a disjunction
+    bool ParseOr();
+
+    /// Reads a conjunction
+    bool ParseAnd();
+
+    /// Reads a negation, a parenthesized expression, or a comparison
+    bool ParseUnary();
+
+    /// Reads a comparison or a bare boolean variable
+    bool ParseTerm();
+
+    /// Reads a quoted string
+    bool ParseString(std::string &value);
+
+    /// Reads a value, which is a variable possibly wrapped in abs()
+    bool ParseValue(Instruction &instruction);
+
+    /// Sets targets of the given jumps to the next instruction to be emitted
+    void PatchJumps(std::vector<unsigned> const &jumps);
+
+    /// Skips whitespace
+    void SkipSpaces();
+
+private:
+    std::string const &expression;
+    Program &program;
+
+    /// Current position in the expression
+    std::size_t pos;
+};
+
+
+Parser::Parser(std::string const &expression_, Program &program_):
+    expression(expression_), program(program_),
+    pos(0)
+{}
+
+
+bool Parser::Parse()
+{
+    program.instructions.clear();
+    program.labels.assign(1, "");
+
+    if (AtEnd())
+        return true;
+
+    return ParseOr() and AtEnd();
+}
+
+
+bool Parser::Accept(char const *token)
+{
+    SkipSpaces();
+    std::size_t const length = std::char_traits<char>::length(token);
+
+    if (expression.compare(pos, length, token) != 0)
+        return false;
+
+    pos += length;
+    return true;
+}
+
+
+bool Parser::AtEnd()
+{
+    SkipSpaces();
+    return pos == expression.size();
+}
+
+
+unsigned Parser::FindLabel(std::string const &label)
+{
+    auto &labels = program.labels;
+    auto const res = std::find(labels.begin(), labels.end(), label);
+
+    if (res != labels.end())
+        return res - labels.begin();
+
+    labels.emplace_back(label);
+    return labels.size() - 1;
+}
+
+
+bool Parser::ParseComparison(Comparison &comparison)
+{
+    // Two-character operators must be checked first
+    if (Accept("<="))
+        comparison = Comparison::LessEqual;
+    else if (Accept(">="))
+        comparison = Comparison::GreaterEqual;
+    else if (Accept("=="))
+        comparison = Comparison::Equal;
+    else if (Accept("!="))
+        comparison = Comparison::NotEqual;
+    else if (Accept("<"))
+        comparison = Comparison::Less;
+    else if (Accept(">"))
+        comparison = Comparison::Greater;
+    else
+        return false;
+
+    return true;
+}
+
+
+bool Parser::ParseIdentifier(std::string &identifier)
+{
+    SkipSpaces();
+    std::size_t const start = pos;
+
+    while (pos < expression.size() and
+      (std::isalnum(expression[pos]) or expression[pos] == '_'))
+        ++pos;
+
+    if (pos == start or std::isdigit(expression[start]))
+    {
+        pos = start;
+        return false;
+    }
+
+    identifier = expression.substr(start, pos - start);
+    return true;
+}
+
+
+bool Parser::ParseNumber(double &value)
+{
+    SkipSpaces();
+
+    if (pos == expression.size())
+        return false;
+
+    char const c = expression[pos];
+
+    if (not std::isdigit(c) and c != '.' and c != '-' and c != '+')
+        return false;
+
+    char const *begin = expression.c_str() + pos;
+    char *end;
+    value = std::strtod(begin, &end);
+
+    if (end == begin)
+        return false;
+
+    pos += end - begin;
+    return true;
+}
+
+
+bool Parser::ParseOr()
+{
+    if (not ParseAnd())
+        return false;
+
+    std::vector<unsigned> jumps;
+
+    while (Accept("||") or Accept("|"))
+    {
+        jumps.emplace_back(program.instructions.size());
+        program.instructions.emplace_back(Instruction{OpCode::JumpIfTrue});
+
+        if (not ParseAnd())
+            return false;
+    }
+
+    PatchJumps(jumps);
+    return true;
+}
+
+
+bool Parser::ParseAnd()
+{
+    if (not ParseUnary())
+        return false;
+
+    std::vector<unsigned> jumps;
+
+    while (Accept("&&") or Accept("&"))
+    {
+        jumps.emplace_back(program.instructions.size());
+        program.instructions.emplace_back(Instruction{OpCode::JumpIfFalse});
+
+        if (not ParseUnary())
+            return false;
+    }
+
+    PatchJumps(jumps);
+    return true;
+}
+
+
+bool Parser::ParseUnary()
+{
+    // Make sure that operator != is not mistaken for a negation
+    SkipSpaces();
+
+    if (expression.compare(pos, 2, "!=") != 0 and Accept("!"))
+    {
+        if (not ParseUnary())
+            return false;
+
+        program.instructions.emplace_back(Instruction{OpCode::Not});
+        return true;
+    }
+
+    if (Accept("("))
+        return ParseOr() and Accept(")");
+
+    return ParseTerm();
+}
+
+
+bool Parser::ParseTerm()
+{
+    Instruction instruction{OpCode::Compare};
+    double threshold;
+
+    // A number on the left-hand side. The operator is reversed to put the variable first.
+    if (ParseNumber(threshold))
+    {
+        Comparison comparison;
+
+        if (not ParseComparison(comparison) or not ParseValue(instruction))
+            return false;
+
+        switch (comparison)
+        {
+            case Comparison::Less:
+                comparison = Comparison::Greater;
+                break;
+
+            case Comparison::LessEqual:
+                comparison = Comparison::GreaterEqual;
+                break;
+
+            case Comparison::Greater:
+                comparison = Comparison::Less;
+                break;
+
+            case Comparison::GreaterEqual:
+                comparison = Comparison::LessEqual;
+                break;
+
+            default:
+                break;
+        }
+
+        instruction.comparison = comparison;
+        instruction.threshold = threshold;
+        program.instructions.emplace_back(instruction);
+        return true;
+    }
+
+
+    // A variable on the left-hand side
+    if (not ParseValue(instruction))
+        return false;
+
+    Comparison comparison;
+
+    if (ParseComparison(comparison))
+    {
+        if (not ParseNumber(threshold))
+            return false;
+
+        instruction.comparison = comparison;
+        instruction.threshold = threshold;
+    }
+    else
+    {
+        // A bare value is only allowed for boolean variables
+        if (not IsBoolean(instruction.variable) or instruction.applyAbs)
+            return false;
+
+        instruction.opCode = OpCode::Test;
+    }
+
+    program.instructions.emplace_back(instruction);
+    return true;
+}
+
+
+bool Parser::ParseString(std::string &value)
+{
+    SkipSpaces();
+
+    if (pos == expression.size())
+        return false;
+
+    char const quote = expression[pos];
+
+    if (quote != '\'' and quote != '"')
+        return false;
+
+    std::size_t const end = expression.find(quote, pos + 1);
+
+    if (end == std::string::npos)
+        return false;
+
+    value = expression.substr(pos + 1, end - pos - 1);
+    pos = end + 1;
+    return true;
+}
+
+
+bool Parser::ParseValue(Instruction &instruction)
+{
+    std::string identifier;
+
+    if (not ParseIdentifier(identifier))
+        return false;
+
+    if (identifier == "abs")
+    {
+        if (not Accept("(") or not ParseValue(instruction) or not Accept(")"))
+            return false;
+
+        instruction.applyAbs = true;
+        return true;
+    }
+
+    auto const res = std::find_if(std::begin(knownVariables), std::end(knownVariables),
+      [&identifier](VariableInfo const &info){return identifier == info.name;});
+
+    if (res == std::end(knownVariables))
+        return false;
+
+    instruction.variable = res->variable;
+    instruction.applyAbs = false;
+    instruction.labelIndex = 0;
+
+    if (res->hasLabel)
+    {
+        std::string label;
+
+        if (not Accept("(") or not ParseString(label) or not Accept(")"))
+            return false;
+
+        instruction.labelIndex = FindLabel(label);
+    }
+    else if (Accept("("))
+    {
+        if (not Accept(")"))
+            return false;
+    }
+
+    // Method chains like "gsfTrack.pt" are not supported
+    SkipSpaces();
+
+    if (pos < expression.size() and expression[pos] == '.')
+        return false;
+
+    return true;
+}
+
+
+void Parser::PatchJumps(std::vector<unsigned> const &jumps)
+{
+    for (unsigned const index: jumps)
+        program.instructions[index].target = program.instructions.size();
+}
+
+
+void Parser::SkipSpaces()
+{
+    while (pos < expression.size() and std::isspace(expression[pos]))
+        ++pos;
+}
+}  // anonymous namespace
+
+
+bool compiledcut::Compile(std::string const &expression, Program &program)
+{
+    Parser parser(expression, program);
+    return parser.Parse();
+}
+
+
+bool compiledcut::IsKinematic(Variable variable)
+{
+    switch (variable)
+    {
+        case Variable::Pt:
+        case Variable::Eta:
+        case Variable::Phi:
+        case Variable::Energy:
+        case Variable::Et:
+        case Variable::Mass:
+        case Variable::Charge:
+        case Variable::Px:
+        case Variable::Py:
+        case Variable::Pz:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+bool compiledcut::IsBoolean(Variable variable)
+{
+    switch (variable)
+    {
+        case Variable::IsLooseMuon:
+        case Variable::IsMediumMuon:
+        case Variable::IsGlobalMuon:
+        case Variable::IsTrackerMuon:
+        case Variable::IsPFMuon:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+template<>
+bool Access<pat::Jet>::Supports(Variable variable)
+{
+    return IsKinematic(variable) or variable == Variable::UserFloat or
+      variable == Variable::UserInt or variable == Variable::BDiscriminator;
+}
+
+
+template<>
+double Access<pat::Jet>::Get(pat::Jet const &jet, Variable variable, std::string const &label)
+{
+    switch (variable)
+    {
+        case Variable::UserFloat:
+            return jet.userFloat(label);
+
+        case Variable::UserInt:
+            return jet.userInt(label);
+
+        case Variable::BDiscriminator:
+            return jet.bDiscriminator(label);
+
+        default:
+            return GetKinematic(jet, variable);
+    }
+}
+
+
+template<>
+bool Access<pat::Electron>::Supports(Variable variable)
+{
+    return IsKinematic(variable) or variable == Variable::UserFloat or
+      variable == Variable::UserInt or variable == Variable::ElectronID;
+}
+
+
+template<>
+double Access<pat::Electron>::Get(pat::Electron const &el, Variable variable,
+  std::string const &label)
+{
+    switch (variable)
+    {
+        case Variable::UserFloat:
+            return el.userFloat(label);
+
+        case Variable::UserInt:
+            return el.userInt(label);
+
+        case Variable::ElectronID:
+            return el.electronID(label);
+
+        default:
+            return GetKinematic(el, variable);
+    }
+}
+
+
+template<>
+bool Access<pat::Muon>::Supports(Variable variable)
+{
+    return IsKinematic(variable) or IsBoolean(variable) or variable == Variable::UserFloat or
+      variable == Variable::UserInt;
+}
+
+
+template<>
+double Access<pat::Muon>::Get(pat::Muon const &mu, Variable variable, std::string const &label)
+{
+    switch (variable)
+    {
+        case Variable::UserFloat:
+            return mu.userFloat(label);
+
+        case Variable::UserInt:
+            return mu.userInt(label);
+
+        case Variable::IsLooseMuon:
+            return mu.isLooseMuon();
+
+        case Variable::IsMediumMuon:
+            return mu.isMediumMuon();
+
+        case Variable::IsGlobalMuon:
+            return mu.isGlobalMuon();
+
+        case Variable::IsTrackerMuon:
+            return mu.isTrackerMuon();
+
+        case Variable::IsPFMuon:
+            return mu.isPFMuon();
+
+        default:
+            return GetKinematic(mu, variable);
+    }
+}
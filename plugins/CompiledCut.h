@@ -0,0 +1,385 @@
+#pragma once
+
+#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace pat
+{
+class Electron;
+class Jet;
+class Muon;
+}
+
+
+namespace compiledcut
+{
+/// Properties of an object that can be used in a compiled cut
+enum class Variable: std::uint8_t
+{
+    Pt,
+    Eta,
+    Phi,
+    Energy,
+    Et,
+    Mass,
+    Charge,
+    Px,
+    Py,
+    Pz,
+    UserFloat,
+    UserInt,
+    ElectronID,
+    BDiscriminator,
+    IsLooseMuon,
+    IsMediumMuon,
+    IsGlobalMuon,
+    IsTrackerMuon,
+    IsPFMuon
+};
+
+
+/// Operations of a compiled program
+enum class OpCode: std::uint8_t
+{
+    Compare,      ///< Sets the register to the result of the comparison of a variable
+    Test,         ///< Sets the register to true if a boolean variable is true
+    Not,          ///< Inverts the register
+    JumpIfFalse,  ///< Jumps to the target instruction if the register is false
+    JumpIfTrue    ///< Jumps to the target instruction if the register is true
+};
+
+
+/// Supported comparison operators
+enum class Comparison: std::uint8_t
+{
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual
+};
+
+
+/// A single instruction of a compiled program
+struct Instruction
+{
+    OpCode opCode;
+    Variable variable;
+
+    /// Indicates whether the absolute value of the variable is compared
+    bool applyAbs;
+
+    Comparison comparison;
+
+    /**
+     * \brief Index of the string argument of the variable in Program::labels
+     *
+     * Variables without arguments refer to the empty string with index 0.
+     */
+    unsigned labelIndex;
+
+    /// Threshold for comparison or index of the target instruction for jumps
+    double threshold;
+    unsigned target;
+};
+
+
+/**
+ * \brief A compiled cut
+ *
+ * The program operates on a single boolean register, which is initialized to true. Logical
+ * operators are short-circuited with jumps, as done by the interpreter of string-based cuts.
+ */
+struct Program
+{
+    std::vector<Instruction> instructions;
+
+    /// String arguments of variables such as userFloat; the first one is always empty
+    std::vector<std::string> labels;
+};
+
+
+/**
+ * \brief Compiles a string-based cut
+ *
+ * Supports expressions built from comparisons of variables listed in enumeration Variable,
+ * possibly wrapped in abs(), with numbers, bare boolean variables, parentheses, and operators !,
+ * &, &&, |, and ||. A blank expression is compiled into an empty program, which accepts all
+ * objects. Returns false if the expression uses any other syntax.
+ */
+bool Compile(std::string const &expression, Program &program);
+
+
+/// Checks if the given variable is a kinematic one, available in any reco::Candidate
+bool IsKinematic(Variable variable);
+
+
+/// Checks if the given variable has a boolean type
+bool IsBoolean(Variable variable);
+
+
+/**
+ * \brief Returns the value of a kinematic variable
+ *
+ * Returns zero for other variables.
+ */
+template<typename Object>
+double GetKinematic(Object const &obj, Variable variable);
+
+
+/**
+ * \brief Provides values of variables for objects of the given type
+ *
+ * The generic version only supports kinematic variables. Specializations for PAT jets, electrons,
+ * and muons add variables specific to them.
+ */
+template<typename Object>
+struct Access
+{
+    /// Checks if the variable is available for this type
+    static bool Supports(Variable variable)
+    {
+        return IsKinematic(variable);
+    }
+
+    /// Returns the value of a supported variable
+    static double Get(Object const &obj, Variable variable, std::string const &label);
+};
+
+
+template<>
+bool Access<pat::Jet>::Supports(Variable variable);
+
+template<>
+double Access<pat::Jet>::Get(pat::Jet const &jet, Variable variable, std::string const &label);
+
+template<>
+bool Access<pat::Electron>::Supports(Variable variable);
+
+template<>
+double Access<pat::Electron>::Get(pat::Electron const &el, Variable variable,
+  std::string const &label);
+
+template<>
+bool Access<pat::Muon>::Supports(Variable variable);
+
+template<>
+double Access<pat::Muon>::Get(pat::Muon const &mu, Variable variable, std::string const &label);
+}  // end of namespace compiledcut
+
+
+/**
+ * \class CompiledCut
+ * \brief A drop-in replacement for StringCutObjectSelector that compiles common cuts
+ *
+ * StringCutObjectSelector interprets the expression tree for every object, which involves a
+ * virtual call and a reflection-based method lookup for each node. This class parses the same
+ * syntax for the common cases, i.e. thresholds on kinematic variables, userFloat and userInt
+ * values, and boolean ID flags, and compiles them into a flat program (see
+ * compiledcut::Compile). The program is evaluated in a loop over instructions with a switch, so
+ * the only remaining indirection is the call of the accessor of the object itself. Expressions
+ * that cannot be compiled, e.g. because they use a method not listed in compiledcut::Variable or
+ * a method not available for type Object, are delegated to StringCutObjectSelector, which gives
+ * identical results.
+ */
+template<typename Object>
+class CompiledCut
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * Throws an exception if the expression can neither be compiled nor parsed by
+     * StringCutObjectSelector.
+     */
+    CompiledCut(std::string const &expression);
+
+public:
+    /// Checks if the given object passes the cut
+    bool operator()(Object const &obj) const;
+
+    /// Checks if the expression has been compiled, as opposed to using the fallback
+    bool IsCompiled() const
+    {
+        return not fallback;
+    }
+
+private:
+    /// Evaluates the value of the variable in the given comparison or test instruction
+    double GetValue(Object const &obj, compiledcut::Instruction const &instruction) const;
+
+private:
+    /// Compiled program; only used if there is no fallback
+    compiledcut::Program program;
+
+    /// Interpreted cut used when the expression cannot be compiled
+    std::unique_ptr<StringCutObjectSelector<Object>> fallback;
+};
+
+
+template<typename Object>
+double compiledcut::GetKinematic(Object const &obj, Variable variable)
+{
+    switch (variable)
+    {
+        case Variable::Pt:
+            return obj.pt();
+
+        case Variable::Eta:
+            return obj.eta();
+
+        case Variable::Phi:
+            return obj.phi();
+
+        case Variable::Energy:
+            return obj.energy();
+
+        case Variable::Et:
+            return obj.et();
+
+        case Variable::Mass:
+            return obj.mass();
+
+        case Variable::Charge:
+            return obj.charge();
+
+        case Variable::Px:
+            return obj.px();
+
+        case Variable::Py:
+            return obj.py();
+
+        case Variable::Pz:
+            return obj.pz();
+
+        default:
+            return 0.;
+    }
+}
+
+
+template<typename Object>
+double compiledcut::Access<Object>::Get(Object const &obj, Variable variable, std::string const &)
+{
+    return GetKinematic(obj, variable);
+}
+
+
+template<typename Object>
+CompiledCut<Object>::CompiledCut(std::string const &expression)
+{
+    bool compiled = compiledcut::Compile(expression, program);
+
+    for (auto const &instruction: program.instructions)
+    {
+        if ((instruction.opCode == compiledcut::OpCode::Compare or
+          instruction.opCode == compiledcut::OpCode::Test) and
+          not compiledcut::Access<Object>::Supports(instruction.variable))
+        {
+            compiled = false;
+            break;
+        }
+    }
+
+    if (not compiled)
+    {
+        program.instructions.clear();
+        program.labels.clear();
+        fallback.reset(new StringCutObjectSelector<Object>(expression));
+    }
+}
+
+
+template<typename Object>
+bool CompiledCut<Object>::operator()(Object const &obj) const
+{
+    using namespace compiledcut;
+
+    if (fallback)
+        return (*fallback)(obj);
+
+    auto const &instructions = program.instructions;
+    bool reg = true;
+    unsigned pc = 0;
+
+    while (pc < instructions.size())
+    {
+        Instruction const &instruction = instructions[pc];
+
+        switch (instruction.opCode)
+        {
+            case OpCode::Compare:
+            {
+                double const value = GetValue(obj, instruction);
+                double const threshold = instruction.threshold;
+
+                switch (instruction.comparison)
+                {
+                    case Comparison::Less:
+                        reg = (value < threshold);
+                        break;
+
+                    case Comparison::LessEqual:
+                        reg = (value <= threshold);
+                        break;
+
+                    case Comparison::Greater:
+                        reg = (value > threshold);
+                        break;
+
+                    case Comparison::GreaterEqual:
+                        reg = (value >= threshold);
+                        break;
+
+                    case Comparison::Equal:
+                        reg = (value == threshold);
+                        break;
+
+                    case Comparison::NotEqual:
+                        reg = (value != threshold);
+                        break;
+                }
+
+                ++pc;
+                break;
+            }
+
+            case OpCode::Test:
+                reg = (GetValue(obj, instruction) != 0.);
+                ++pc;
+                break;
+
+            case OpCode::Not:
+                reg = not reg;
+                ++pc;
+                break;
+
+            case OpCode::JumpIfFalse:
+                pc = (reg) ? pc + 1 : instruction.target;
+                break;
+
+            case OpCode::JumpIfTrue:
+                pc = (reg) ? instruction.target : pc + 1;
+                break;
+        }
+    }
+
+    return reg;
+}
+
+
+template<typename Object>
+double CompiledCut<Object>::GetValue(Object const &obj,
+  compiledcut::Instruction const &instruction) const
+{
+    double const value = compiledcut::Access<Object>::Get(obj, instruction.variable,
+      program.labels[instruction.labelIndex]);
+    return (instruction.applyAbs) ? std::abs(value) : value;
+}
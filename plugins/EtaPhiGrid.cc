@@ -0,0 +1,58 @@
+#include "EtaPhiGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+EtaPhiGrid::EtaPhiGrid(double cellSize, double maxAbsEta):
+    minEta(-maxAbsEta),
+    numObjects(0)
+{
+    // Very small cells would only increase the memory footprint
+    cellSize = std::max(cellSize, minCellSize);
+
+    numEtaCells = std::max(int(std::ceil(2 * maxAbsEta / cellSize)), 1);
+    etaCellSize = 2 * maxAbsEta / numEtaCells;
+
+    // Cells in phi must tile the full circle, so they can only be made larger than requested
+    numPhiCells = std::max(int(2 * M_PI / cellSize), 1);
+    phiCellSize = 2 * M_PI / numPhiCells;
+
+    cells.resize(numEtaCells * numPhiCells);
+}
+
+
+void EtaPhiGrid::Clear()
+{
+    for (unsigned const iCell: usedCells)
+        cells[iCell].clear();
+
+    usedCells.clear();
+    numObjects = 0;
+}
+
+
+void EtaPhiGrid::Insert(double eta, double phi)
+{
+    int const iPhi = ((PhiCell(phi) % numPhiCells) + numPhiCells) % numPhiCells;
+    unsigned const iCell = EtaCell(eta) * numPhiCells + iPhi;
+
+    if (cells[iCell].empty())
+        usedCells.push_back(iCell);
+
+    cells[iCell].push_back(numObjects);
+    ++numObjects;
+}
+
+
+int EtaPhiGrid::EtaCell(double eta) const
+{
+    int const iEta = int(std::floor((eta - minEta) / etaCellSize));
+    return std::min(std::max(iEta, 0), numEtaCells - 1);
+}
+
+
+int EtaPhiGrid::PhiCell(double phi) const
+{
+    return int(std::floor((phi + M_PI) / phiCellSize));
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+
+
+/**
+ * \class EtaPhiGrid
+ * \brief A spatial index to find objects close in (eta, phi)
+ *
+ * The plane (eta, phi) is split into rectangular cells, and each inserted object is assigned to
+ * the cell that contains it. Objects outside of the given range in eta are assigned to the
+ * outermost cells. When looking for objects within some angular distance from a given point, only
+ * cells overlapping with the corresponding square are visited, so matching N objects to M
+ * objects costs O(N + M) instead of O(N * M) for typical multiplicities.
+ *
+ * Objects are identified by indices in the order of their insertion, which normally coincide with
+ * their indices in the source collection. The caller must still check the actual distance for
+ * each candidate returned by method ForEachNear since cells cover a larger area. The grid is meant
+ * to be rebuilt for each event; memory allocated for cells is reused.
+ */
+class EtaPhiGrid
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * The cell size should be of the order of the typical distance used in queries. Sizes smaller
+     * than minCellSize are replaced by it.
+     */
+    EtaPhiGrid(double cellSize, double maxAbsEta = 5.);
+
+public:
+    /// Removes all objects from the grid
+    void Clear();
+
+    /**
+     * \brief Calls the given function for indices of all objects that might lie within the given
+     * angular distance from the given point
+     *
+     * The function must accept an argument of type unsigned. Objects are visited cell by cell,
+     * not in the order of their indices.
+     */
+    template<typename F>
+    void ForEachNear(double eta, double phi, double maxDR, F &&f) const;
+
+    /**
+     * \brief Adds an object with the given coordinates
+     *
+     * It is assigned the index equal to the number of objects inserted before it.
+     */
+    void Insert(double eta, double phi);
+
+    /// Returns the number of inserted objects
+    unsigned Size() const
+    {
+        return numObjects;
+    }
+
+private:
+    /// Computes index of the cell in eta, clamping it to the valid range
+    int EtaCell(double eta) const;
+
+    /// Computes index of the cell in phi, which need not be in the valid range
+    int PhiCell(double phi) const;
+
+private:
+    /// Minimal allowed size of cells
+    static constexpr double minCellSize = 0.1;
+
+private:
+    /// Lower boundary of the grid in eta
+    double minEta;
+
+    /// Sizes of cells in eta and phi
+    double etaCellSize, phiCellSize;
+
+    /// Numbers of cells in eta and phi
+    int numEtaCells, numPhiCells;
+
+    /// Indices of objects in each cell; the index of a cell is iEta * numPhiCells + iPhi
+    std::vector<std::vector<unsigned>> cells;
+
+    /// Indices of cells that are not empty
+    std::vector<unsigned> usedCells;
+
+    /// Number of inserted objects
+    unsigned numObjects;
+};
+
+
+template<typename F>
+void EtaPhiGrid::ForEachNear(double eta, double phi, double maxDR, F &&f) const
+{
+    if (numObjects == 0)
+        return;
+
+    int const etaBegin = EtaCell(eta - maxDR), etaEnd = EtaCell(eta + maxDR) + 1;
+    int phiBegin = PhiCell(phi - maxDR), phiEnd = PhiCell(phi + maxDR) + 1;
+
+    // If the range in phi covers the full circle, visit each cell only once
+    if (phiEnd - phiBegin >= numPhiCells)
+    {
+        phiBegin = 0;
+        phiEnd = numPhiCells;
+    }
+
+    for (int iEta = etaBegin; iEta < etaEnd; ++iEta)
+        for (int iPhi = phiBegin; iPhi < phiEnd; ++iPhi)
+        {
+            int const iPhiWrapped = ((iPhi % numPhiCells) + numPhiCells) % numPhiCells;
+
+            for (unsigned index: cells[iEta * numPhiCells + iPhiWrapped])
+                f(index);
+        }
+}
@@ -1,60 +1,76 @@
 #include "EventCounter.h"
 
 #include <DataFormats/Common/interface/View.h>
+#include <FWCore/Utilities/interface/EDMException.h>
 #include <FWCore/Utilities/interface/InputTag.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
 
 #include <TTree.h>
 
+#include <algorithm>
 
-SignedKahanSum::SignedKahanSum() noexcept:
-    posSum(0.), negSum(0.),
-    posCompensation(0.), negCompensation(0.)
-{}
+
+void EventCounterSums::Merge(EventCounterSums const &other)
+{
+    numProcessed += other.numProcessed;
+    nominalWeight.Merge(other.nominalWeight);
+    
+    if (other.altLheWeights.Size() > 0)
+        altLheWeights.Merge(other.altLheWeights);
+    
+    if (other.altPsWeights.Size() > 0)
+        altPsWeights.Merge(other.altPsWeights);
+    
+    if (pileupCounts.size() < other.pileupCounts.size())
+        pileupCounts.resize(other.pileupCounts.size(), 0.);
+    
+    for (unsigned bin = 0; bin < other.pileupCounts.size(); ++bin)
+        pileupCounts[bin] += other.pileupCounts[bin];
+}
 
 
-void SignedKahanSum::Fill(double x)
+void EventCounterSums::Reset()
 {
-    if (x >= 0.)
-    {
-        double const xCompensated = x - posCompensation;
-        double const sum = posSum + xCompensated;
-        posCompensation = (sum - posSum) - xCompensated;
-        posSum = sum;
-    }
-    else
-    {
-        // Run the standard Kahan algorithm with the inverted input
-        x = -x;
-        
-        double const xCompensated = x - negCompensation;
-        double const sum = negSum + xCompensated;
-        negCompensation = (sum - negSum) - xCompensated;
-        negSum = sum;
-    }
+    numProcessed = 0;
+    nominalWeight.Resize(nominalWeight.Size());
+    altLheWeights.Resize(altLheWeights.Size());
+    altPsWeights.Resize(altPsWeights.Size());
+    pileupCounts.assign(pileupCounts.size(), 0.);
 }
 
 
-double SignedKahanSum::GetSum() const
+namespace
+{
+/**
+ * \brief Makes sure that the number of sums matches the number of selected weights
+ * 
+ * Sums are created if they are empty. Otherwise an exception is thrown in case of a mismatch.
+ */
+void CheckSize(CompensatedSums &sums, unsigned numSelected)
 {
-    // Since there might be a catastrophic cancellation between the positive and negative sums,
-    //take into account also the correction from the compensations
-    return (posSum - negSum) - (posCompensation - negCompensation);
+    if (sums.Size() == 0)
+        sums.Resize(numSelected);
+    else if (sums.Size() != numSelected)
+    {
+        edm::Exception excp(edm::errors::LogicError);
+        excp << "Number of selected alternative weights has changed from " << sums.Size() <<
+          " to " << numSelected << ".";
+        excp.raise();
+    }
 }
+}  // anonymous namespace
 
 
 EventCounter::EventCounter(edm::ParameterSet const &cfg):
     lheWeightIndices(cfg.getParameter<std::vector<int>>("saveAltLHEWeights")),
     psWeightIndices(cfg.getParameter<std::vector<int>>("saveAltPSWeights")),
-    nEventProcessed(0)
+    saveLumiSummaries(cfg.getParameter<bool>("saveLumiSummaries")),
+    saveLumiPileupProfiles(cfg.getParameter<bool>("saveLumiPileupProfiles")),
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings"))
 {
-    generatorToken = consumes<GenEventInfoProduct>(cfg.getParameter<edm::InputTag>("generator"));
-    
-    if (not lheWeightIndices.Empty())
-    {
-        lheEventInfoToken =
-          consumes<LHEEventProduct>(cfg.getParameter<edm::InputTag>("lheEventProduct"));
-    }
+    contextToken = consumes<pec::GeneratorContext>(
+      cfg.getParameter<edm::InputTag>("generatorContext"));
     
     
     if (cfg.exists("puInfo"))
@@ -63,86 +79,133 @@ EventCounter::EventCounter(edm::ParameterSet const &cfg):
 }
 
 
-void EventCounter::analyze(edm::Event const &event, edm::EventSetup const &)
+std::unique_ptr<EventCounterSums> EventCounter::beginStream(edm::StreamID) const
 {
+    std::unique_ptr<EventCounterSums> sums(new EventCounterSums);
+    
+    if (not puSummaryToken.isUninitialized())
+        sums->pileupCounts.assign(numPileupBins + 2, 0.);
+    
+    return sums;
+}
+
+
+void EventCounter::analyze(edm::StreamID streamID, edm::Event const &event,
+  edm::EventSetup const &) const
+{
+    EventCounterSums &sums = *streamCache(streamID);
+    
+    
     // Update event counter
-    ++nEventProcessed;
+    ++sums.numProcessed;
     
     
     // Update the sum of nominal event weights
-    edm::Handle<GenEventInfoProduct> generator;
-    event.getByToken(generatorToken, generator);
+    edm::Handle<pec::GeneratorContext> context;
+    event.getByToken(contextToken, context);
     
-    sumNominalWeight.Fill(generator->weight());
+    double const nominalWeight = context->NominalWeight();
+    sums.nominalWeight.Fill(&nominalWeight);
     
     
-    // Update sums of alternative LHE event weights if requested
+    // Update sums of alternative LHE event weights if requested. They have already been rescaled
+    //to the nominal weight. Selected weights are first copied into a contiguous buffer, and then
+    //all sums are updated at once.
     if (not lheWeightIndices.Empty())
     {
-        edm::Handle<LHEEventProduct> lheEventInfo;
-        event.getByToken(lheEventInfoToken, lheEventInfo);
-        
-        std::vector<gen::WeightsInfo> const &altWeights = lheEventInfo->weights();
+        std::vector<double> const &altWeights = context->AltLheWeights();
         
-        
-        // If this is the first event being processed, create summators for the alternative weights
-        if (sumAltLheWeightCollection.empty())
-            sumAltLheWeightCollection.resize(
-              lheWeightIndices.NumberIndices(0, altWeights.size() - 1));
+        if (altWeights.empty())
+        {
+            edm::Exception excp(edm::errors::LogicError);
+            excp << "Alternative LHE-level weights are requested, but pec::GeneratorContext " <<
+              "does not contain them. Make sure that they are computed by its producer " <<
+              "(parameter computeAltLHEWeights).";
+            excp.raise();
+        }
         
         
-        // Add alternative weights to the corresponding sums rescaling them with the ratio between
-        //the nominal weight read above and the nominal LHE weight, as prescribed in [1]
-        //[1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW?rev=7#How_to_use_weights
-        double const factor = generator->weight() / lheEventInfo->originalXWGTUP();
+        // Select the alternative weights. If this is the first event being processed, create
+        //summators for them
+        lheWeightIndices.Compile(0, int(altWeights.size()) - 1, sums.lheWeightSelection);
+        CheckSize(sums.altLheWeights, sums.lheWeightSelection.Size());
         
-        unsigned writeIndex = 0;
-
-        for (int readIndex: lheWeightIndices.GetIndices(0, altWeights.size() - 1))
-        {
-            double const weight = altWeights[readIndex].wgt * factor;
-            sumAltLheWeightCollection[writeIndex].Fill(weight);
-            ++writeIndex;
-        }
+        sums.weightBuffer.resize(sums.lheWeightSelection.Size());
+        sums.lheWeightSelection.Gather(altWeights.data(), sums.weightBuffer.data(),
+          [](double w){return w;});
+        sums.altLheWeights.Fill(sums.weightBuffer.data());
     }
 
 
     // Update sums of alternative PS event weights if requested and if they are available
-    std::vector<double> const &psWeights = generator->weights();
+    std::vector<double> const &psWeights = context->AltPsWeights();
 
     if (not psWeightIndices.Empty() and psWeights.size() > 1)
     {
-        // If this is the first event being processed, create summators for the alternative weights
-        if (sumAltPsWeightCollection.empty())
-            sumAltPsWeightCollection.resize(
-              psWeightIndices.NumberIndices(0, psWeights.size() - 1));
+        // Select the alternative weights and create summators for them if needed
+        psWeightIndices.Compile(0, int(psWeights.size()) - 1, sums.psWeightSelection);
+        CheckSize(sums.altPsWeights, sums.psWeightSelection.Size());
         
         
-        unsigned writeIndex = 0;
-
-        for (int readIndex: psWeightIndices.GetIndices(0, psWeights.size() - 1))
-        {
-            sumAltPsWeightCollection[writeIndex].Fill(psWeights[readIndex]);
-            ++writeIndex;
-        }
+        sums.weightBuffer.resize(sums.psWeightSelection.Size());
+        sums.psWeightSelection.Gather(psWeights.data(), sums.weightBuffer.data(),
+          [](double w){return w;});
+        sums.altPsWeights.Fill(sums.weightBuffer.data());
     }
     
     
-    // Fill pileup profile if requested
+    // Fill pileup profile if requested. Bins are numbered as in ROOT histograms, with the
+    //underflow bin at index 0.
     if (not puSummaryToken.isUninitialized())
     {
         edm::Handle<edm::View<PileupSummaryInfo>> puSummary;
         event.getByToken(puSummaryToken, puSummary);
         
-        pileupProfile->Fill(puSummary->front().getTrueNumInteractions());
+        double const trueNumInteractions = puSummary->front().getTrueNumInteractions();
+        unsigned bin;
+        
+        if (trueNumInteractions < 0.)
+            bin = 0;
+        else if (trueNumInteractions >= maxPileup)
+            bin = numPileupBins + 1;
+        else
+            bin = unsigned(trueNumInteractions / maxPileup * numPileupBins) + 1;
+        
+        ++sums.pileupCounts[bin];
     }
 }
 
 
-void EventCounter::beginJob()
+std::shared_ptr<EventCounterSums> EventCounter::globalBeginLuminosityBlockSummary(
+  edm::LuminosityBlock const &, edm::EventSetup const &) const
 {
-    if (not puSummaryToken.isUninitialized())
-        pileupProfile = fileService->make<TH1D>("PileupProfile", "Pileup profile", 1000, 0., 100.);
+    return std::make_shared<EventCounterSums>();
+}
+
+
+void EventCounter::streamEndLuminosityBlockSummary(edm::StreamID streamID,
+  edm::LuminosityBlock const &, edm::EventSetup const &, EventCounterSums *summary) const
+{
+    // Calls for the same summary are serialized by the framework
+    EventCounterSums &sums = *streamCache(streamID);
+    summary->Merge(sums);
+    sums.Reset();
+}
+
+
+void EventCounter::globalEndLuminosityBlockSummary(edm::LuminosityBlock const &lumi,
+  edm::EventSetup const &, EventCounterSums *summary) const
+{
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    totalSums.Merge(*summary);
+    
+    if (saveLumiSummaries)
+    {
+        lumiSummaries.push_back({lumi.run(), lumi.luminosityBlock(), *summary});
+        
+        if (not saveLumiPileupProfiles)
+            lumiSummaries.back().sums.pileupCounts.clear();
+    }
 }
 
 
@@ -151,9 +214,10 @@ void EventCounter::endJob()
     TTree *tree = fileService->make<TTree>("EventCounts", "Event counts and weights");
     
     
+    ULong64_t nEventProcessed = totalSums.numProcessed;
     tree->Branch("NumProcessed", &nEventProcessed);
     
-    Float_t bfMeanNominalWeight = sumNominalWeight.GetSum() / nEventProcessed;
+    Float_t bfMeanNominalWeight = totalSums.nominalWeight.GetSum(0) / nEventProcessed;
     tree->Branch("MeanNominalWeight", &bfMeanNominalWeight);
     
     
@@ -161,8 +225,9 @@ void EventCounter::endJob()
     
     if (not lheWeightIndices.Empty())
     {
-        for (auto const &summator: sumAltLheWeightCollection)
-            bfMeanAltLheWeightCollection.emplace_back(summator.GetSum() / nEventProcessed);
+        for (unsigned i = 0; i < totalSums.altLheWeights.Size(); ++i)
+            bfMeanAltLheWeightCollection.emplace_back(
+              totalSums.altLheWeights.GetSum(i) / nEventProcessed);
         
         tree->Branch("MeanAltLheWeights", &bfMeanAltLheWeightCollection);
     }
@@ -172,32 +237,116 @@ void EventCounter::endJob()
     
     if (not psWeightIndices.Empty())
     {
-        for (auto const &summator: sumAltPsWeightCollection)
-            bfMeanAltPsWeightCollection.emplace_back(summator.GetSum() / nEventProcessed);
+        for (unsigned i = 0; i < totalSums.altPsWeights.Size(); ++i)
+            bfMeanAltPsWeightCollection.emplace_back(
+              totalSums.altPsWeights.GetSum(i) / nEventProcessed);
         
         tree->Branch("MeanAltPsWeights", &bfMeanAltPsWeightCollection);
     }
     
     
+    treeSettings.Apply(tree);
     tree->Fill();
+    
+    
+    // Store pileup profile if requested
+    if (not puSummaryToken.isUninitialized())
+    {
+        TH1D *pileupProfile = fileService->make<TH1D>("PileupProfile", "Pileup profile",
+          numPileupBins, 0., maxPileup);
+        double numEntries = 0.;
+        
+        for (unsigned bin = 0; bin < totalSums.pileupCounts.size(); ++bin)
+        {
+            pileupProfile->SetBinContent(bin, totalSums.pileupCounts[bin]);
+            numEntries += totalSums.pileupCounts[bin];
+        }
+        
+        pileupProfile->SetEntries(numEntries);
+    }
+    
+    
+    // Store summaries of luminosity blocks if requested. They are sorted to make the output
+    //independent of the order in which luminosity blocks have been processed.
+    if (saveLumiSummaries)
+    {
+        std::sort(lumiSummaries.begin(), lumiSummaries.end(),
+          [](LumiSummary const &lhs, LumiSummary const &rhs)
+          {return lhs.run < rhs.run or (lhs.run == rhs.run and lhs.lumi < rhs.lumi);});
+        
+        TTree *lumiTree = fileService->make<TTree>("LumiSummaries",
+          "Event counts and sums of weights per luminosity block");
+        
+        UInt_t bfRun, bfLumi;
+        ULong64_t bfNumProcessed;
+        Double_t bfSumNominalWeight;
+        std::vector<Double_t> bfSumAltLheWeights, bfSumAltPsWeights;
+        std::vector<Float_t> bfPileupCounts;
+        
+        lumiTree->Branch("Run", &bfRun);
+        lumiTree->Branch("LumiBlock", &bfLumi);
+        lumiTree->Branch("NumProcessed", &bfNumProcessed);
+        lumiTree->Branch("SumNominalWeight", &bfSumNominalWeight);
+        
+        if (not lheWeightIndices.Empty())
+            lumiTree->Branch("SumAltLheWeights", &bfSumAltLheWeights);
+        
+        if (not psWeightIndices.Empty())
+            lumiTree->Branch("SumAltPsWeights", &bfSumAltPsWeights);
+        
+        if (saveLumiPileupProfiles and not puSummaryToken.isUninitialized())
+            lumiTree->Branch("PileupCounts", &bfPileupCounts);
+        
+        treeSettings.Apply(lumiTree);
+        
+        for (auto const &summary: lumiSummaries)
+        {
+            bfRun = summary.run;
+            bfLumi = summary.lumi;
+            bfNumProcessed = summary.sums.numProcessed;
+            bfSumNominalWeight = summary.sums.nominalWeight.GetSum(0);
+            
+            // Alternative weights might be missing if no events have been processed in the block
+            bfSumAltLheWeights.assign(totalSums.altLheWeights.Size(), 0.);
+            
+            for (unsigned i = 0; i < summary.sums.altLheWeights.Size(); ++i)
+                bfSumAltLheWeights[i] = summary.sums.altLheWeights.GetSum(i);
+            
+            bfSumAltPsWeights.assign(totalSums.altPsWeights.Size(), 0.);
+            
+            for (unsigned i = 0; i < summary.sums.altPsWeights.Size(); ++i)
+                bfSumAltPsWeights[i] = summary.sums.altPsWeights.GetSum(i);
+            
+            bfPileupCounts.assign(summary.sums.pileupCounts.begin(),
+              summary.sums.pileupCounts.end());
+            
+            lumiTree->Fill();
+        }
+    }
 }
 
 
 void EventCounter::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
 {
     edm::ParameterSetDescription desc;
-    desc.add<edm::InputTag>("generator", edm::InputTag("generator"))->
-      setComment("Tag to access GenEventInfoProduct.");
+    desc.add<edm::InputTag>("generatorContext", edm::InputTag("generatorContext"))->
+      setComment("Tag to access pec::GeneratorContext.");
     desc.add<std::vector<int>>("saveAltLHEWeights", std::vector<int>())->
       setComment("Intervals of indices of alternative LHE-level weights to be stored. "
         "Parsed using class IndexIntervals.");
-    desc.add<edm::InputTag>("lheEventProduct", edm::InputTag("externalLHEProducer"))->
-      setComment("Tag to access LHEEventProduct. Ignored if saveAltLHEWeights is False.");
     desc.add<std::vector<int>>("saveAltPSWeights", std::vector<int>())->
       setComment("Intervals of indices of alternative PS weights to be stored. "
         "Parsed using class IndexIntervals.");
     desc.addOptional<edm::InputTag>("puInfo")->
       setComment("Pileup summary. Providing this requests storing of pileup profile.");
+    desc.add<bool>("saveLumiSummaries", false)->
+      setComment("Indicates whether event counts and sums of weights should be saved for each "
+        "luminosity block.");
+    desc.add<bool>("saveLumiPileupProfiles", false)->
+      setComment("Indicates whether pileup profiles should be included in the summaries of "
+        "luminosity blocks.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output trees.");
     
     descriptions.add("eventCounter", desc);
 }
@@ -1,15 +1,16 @@
 #pragma once
 
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
+#include "CompensatedSums.h"
 #include "IndexIntervals.h"
+#include "TreeSettings.h"
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/global/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
-#include <SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h>
-#include <SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h>
 #include <SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h>
 
 #include <FWCore/ServiceRegistry/interface/Service.h>
@@ -17,38 +18,50 @@
 
 #include <TH1D.h>
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 
 /**
- * \class SignedKahanSum
- * \brief Implements compensated summation for positive and negative numbers separately
+ * \struct EventCounterSums
+ * \brief Partial sums accumulated by EventCounter
  * 
- * This class computes a sum of the given sequence of numbers on the fly. It tries to compensate
- * for errors arising from the floating-point arithmetic using the Kahan summation algorithm [1].
- * Summation is done independently for positive and negative numbers in order to prevent a
- * catastrophic cancellation.
- * [1] https://en.wikipedia.org/wiki/Kahan_summation_algorithm
+ * Used for sums in a single stream, in a single luminosity block, and in the whole job.
  */
-class SignedKahanSum
+struct EventCounterSums
 {
-public:
-    /// Trivial constructor
-    SignedKahanSum() noexcept;
+    /// Adds sums from another object to this one
+    void Merge(EventCounterSums const &other);
     
-public:
-    /// Adds a new number to the sum
-    void Fill(double x);
+    /**
+     * \brief Sets all sums and counts to zero
+     * 
+     * Numbers of sums are preserved, and so is allocated memory.
+     */
+    void Reset();
     
-    /// Returns the current sum
-    double GetSum() const;
+    /// Number of processed events
+    ULong64_t numProcessed = 0;
     
-private:
-    /// Current sums of positive and negative numbers
-    double posSum, negSum;
+    /// Sum of nominal weights
+    CompensatedSums nominalWeight{1};
     
-    /// Compensation values for the two sums, which are used in the Kahan algorithm
-    double posCompensation, negCompensation;
+    /**
+     * \brief Sums of alternative LHE and PS weights, for each type of weight
+     * 
+     * They are resized when the first event is processed.
+     */
+    CompensatedSums altLheWeights, altPsWeights;
+    
+    /// Number of events in each bin of the pileup profile, including under- and overflow bins
+    std::vector<double> pileupCounts;
+    
+    /// Buffer for the weights of the current event
+    std::vector<double> weightBuffer;
+    
+    /// Indices of selected alternative LHE and PS weights, compiled for the current event
+    IndexIntervals::Compiled lheWeightSelection, psWeightSelection;
 };
 
 
@@ -59,42 +72,83 @@ private:
  * 
  * This plugin stores the total number of processed events and the mean nominal generator-level
  * event weight. If configured to do so, it also saves mean values of selected alternative LHE-level
- * weights. These quantities are stored in a trivial tree containing a single entry.
+ * weights. These quantities are stored in a trivial tree containing a single entry. Generator-level
+ * inputs are read from pec::GeneratorContext.
  * 
  * In addition, when an input tag with PileupSummaryInfo is provided in the configuration, the
  * plugin fills a histogram with pileup profile.
  * 
+ * If parameter "saveLumiSummaries" is true, the plugin also writes a tree LumiSummaries with one
+ * entry per luminosity block. It contains the run and luminosity block numbers, the number of
+ * processed events, and sums (not mean values) of the nominal and selected alternative weights in
+ * the block. Optionally, counts of events in bins of the pileup profile are saved as well. Since
+ * sums are additive, normalization for any subset of luminosity blocks can be recomputed from this
+ * tree, and results of jobs processing disjoint sets of luminosity blocks can be combined, without
+ * reading the events again. Entries are kept in memory and written in endJob.
+ * 
  * The plugin can only process simulated events. Normally it should be put in the execution path
  * before any filters.
  * 
  * Computation of mean weights is implemented with the help of the compensated summation algorithm
- * provided by class SignedKahanSum.
+ * provided by class CompensatedSums. Each stream accumulates its own partial sums and the pileup
+ * profile. They are merged into the summary of a luminosity block at its end, and summaries of all
+ * luminosity blocks are merged into the totals for the job. The output is written in endJob.
  */
-class EventCounter: public edm::EDAnalyzer
+class EventCounter: public edm::global::EDAnalyzer<edm::StreamCache<EventCounterSums>,
+  edm::LuminosityBlockSummaryCache<EventCounterSums>>
 {
+private:
+    /// Summary of a single luminosity block
+    struct LumiSummary
+    {
+        /// Run and luminosity block numbers
+        unsigned run, lumi;
+        
+        /// Sums for the luminosity block
+        EventCounterSums sums;
+    };
+    
 public:
     /// Constructor
     EventCounter(edm::ParameterSet const &cfg);
     
 public:
+    /// Creates partial sums for a new stream
+    virtual std::unique_ptr<EventCounterSums> beginStream(edm::StreamID) const override;
+    
     /// Updates event counter and sums of event weights
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+    virtual void analyze(edm::StreamID streamID, edm::Event const &event,
+      edm::EventSetup const &) const override;
+    
+    /// Creates an empty summary for a new luminosity block
+    virtual std::shared_ptr<EventCounterSums> globalBeginLuminosityBlockSummary(
+      edm::LuminosityBlock const &, edm::EventSetup const &) const override;
     
-    /// Creates histogram for pileup profile if needed
-    virtual void beginJob() override;
+    /// Merges partial sums from the given stream into the summary and resets them
+    virtual void streamEndLuminosityBlockSummary(edm::StreamID streamID,
+      edm::LuminosityBlock const &, edm::EventSetup const &, EventCounterSums *summary) const
+      override;
     
-    /// Saves output in a trivial tree
+    /// Merges the summary into the totals and saves it if requested
+    virtual void globalEndLuminosityBlockSummary(edm::LuminosityBlock const &lumi,
+      edm::EventSetup const &, EventCounterSums *summary) const override;
+    
+    /// Saves output in a trivial tree and, if requested, a histogram with pileup profile
     virtual void endJob() override;
     
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
 private:
-    /// Token to access global generator information
-    edm::EDGetTokenT<GenEventInfoProduct> generatorToken;
+    /// Number of bins in the pileup profile
+    static unsigned const numPileupBins = 1000;
+    
+    /// Range of the pileup profile
+    static constexpr double maxPileup = 100.;
     
-    /// Token to access per-event LHE weights
-    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
+private:
+    /// Token to access generator-level information shared by several plugins
+    edm::EDGetTokenT<pec::GeneratorContext> contextToken;
     
     /// Indices of LHE event weights to be stored
     IndexIntervals lheWeightIndices;
@@ -109,32 +163,23 @@ private:
      */
     edm::EDGetTokenT<edm::View<PileupSummaryInfo>> puSummaryToken;
     
-    /// Running number of processed events
-    ULong64_t nEventProcessed;
+    /// Indicates whether summaries of luminosity blocks should be saved
+    bool saveLumiSummaries;
     
-    /// Sum of nominal weights of processed events
-    SignedKahanSum sumNominalWeight;
+    /// Indicates whether pileup profiles should be included in the summaries
+    bool saveLumiPileupProfiles;
     
-    /**
-     * \brief Sums of alternative LHE weights, for each type of weight
-     * 
-     * This vector is reinitialized when the first event is processed.
-     */
-    std::vector<SignedKahanSum> sumAltLheWeightCollection;
+    /// Protects totalSums and lumiSummaries
+    mutable std::mutex mergeMutex;
     
-    /**
-     * \brief Sums of alternative PS weights, for each type of weight
-     * 
-     * This vector is reinitialized when the first event is processed.
-     */
-    std::vector<SignedKahanSum> sumAltPsWeightCollection;
+    /// Sums merged from all luminosity blocks that have ended
+    mutable EventCounterSums totalSums;
     
-    /**
-     * \brief Non-owning pointer to a histogram with pileup profile
-     * 
-     * Only filled when requested through the plugin's configuration.
-     */
-    TH1D *pileupProfile;
+    /// Summaries of all luminosity blocks that have ended
+    mutable std::vector<LumiSummary> lumiSummaries;
+    
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
     
     /// An object to handle the output ROOT file
     edm::Service<TFileService> fileService;
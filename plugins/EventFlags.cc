@@ -1,12 +1,10 @@
 #include "EventFlags.h"
 
-#include <FWCore/Common/interface/TriggerNames.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
 #include <FWCore/Utilities/interface/EDMException.h>
 
 
 EventFlags::FlagInfo::FlagInfo(std::string const &name):
-    index(-1),
     decision(false)
 {
     auto const delimPos = name.find(':');
@@ -25,9 +23,13 @@ EventFlags::FlagInfo::FlagInfo(std::string const &name):
 
 
 EventFlags::EventFlags(edm::ParameterSet const &cfg):
-    indicesSetup(false),
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings")),
+    clusterStart(0),
     tree(nullptr)
 {
+    usesResource("TFileService");
+    
+    
     flagToken = consumes<edm::TriggerResults>(cfg.getParameter<edm::InputTag>("src"));
     
     
@@ -36,6 +38,13 @@ EventFlags::EventFlags(edm::ParameterSet const &cfg):
     
     for (auto const &name: flagStrings)
         flagInfos.emplace_back(name);
+    
+    std::vector<std::string> flagNames;
+    
+    for (auto const &info: flagInfos)
+        flagNames.emplace_back(info.flagName);
+    
+    menuCache.reset(new TriggerMenuCache(flagNames));
 }
 
 
@@ -44,6 +53,8 @@ void EventFlags::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
     edm::ParameterSetDescription desc;
     desc.add<edm::InputTag>("src")->setComment("TriggerResults object with evaluated flags.");
     desc.add<std::vector<std::string>>("flags")->setComment("Flags to store.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output tree.");
     
     descriptions.add("eventFlags", desc);
 }
@@ -51,38 +62,27 @@ void EventFlags::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
 
 void EventFlags::analyze(edm::Event const &event, edm::EventSetup const &eventSetup)
 {
-    // Read flags for the current event. If this is the first event, find indices correspoinding
-    //to the selected flags.
+    // Read flags for the current event and find indices correspoinding to the selected flags in
+    //the current menu
     edm::Handle<edm::TriggerResults> flags;
     event.getByToken(flagToken, flags);
     
-    if (not indicesSetup)
+    auto const &indices = menuCache->GetIndices(event, *flags);
+    
+    
+    // Read and store flag values
+    for (unsigned i = 0; i < flagInfos.size(); ++i)
     {
-        edm::TriggerNames const &flagNames = event.triggerNames(*flags);
-        unsigned const nFlags = flagNames.size();
-        
-        for (unsigned i = 0; i < flagInfos.size(); ++i)
+        if (indices[i] < 0)
         {
-            unsigned const index = flagNames.triggerIndex(flagInfos[i].flagName);
-            
-            if (index == nFlags)
-            {
-                edm::Exception excp(edm::errors::LogicError);
-                excp << "Flag \"" << flagInfos[i].flagName << "\" is not found.";
-                excp.raise();
-            }
-            else
-                flagInfos[i].index = i;
+            edm::Exception excp(edm::errors::LogicError);
+            excp << "Flag \"" << flagInfos[i].flagName << "\" is not found.";
+            excp.raise();
         }
         
-        indicesSetup = true;
+        flagInfos[i].decision = flags->accept(indices[i]);
     }
     
-    
-    // Read and store flag values
-    for (auto &flagInfo: flagInfos)
-        flagInfo.decision = flags->accept(flagInfo.index);
-    
     tree->Fill();
 }
 
@@ -93,6 +93,18 @@ void EventFlags::beginJob()
     
     for (auto &info: flagInfos)
         tree->Branch(info.branchName.c_str(), &info.decision);
+    
+    treeSettings.Apply(tree);
+}
+
+
+void EventFlags::beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{}
+
+
+void EventFlags::endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{
+    treeSettings.EndLuminosityBlock(tree, clusterStart);
 }
 
 
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include "TreeSettings.h"
+#include "TriggerMenuCache.h"
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
@@ -12,6 +16,7 @@
 
 #include <TTree.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -25,8 +30,12 @@
  * FlagName is the name of the flag in TriggerResults and BranchName is the desired name for the
  * TTree branch to store this flag; if the colon is not found in the string, the string is used as
  * both FlagName and BranchName.
+ * 
+ * Indices of the flags are resolved for each menu of flags (identified by the ParameterSetID of
+ * the TriggerResults object) and cached. If a flag is missing in a menu, an exception is thrown.
  */
-class EventFlags: public edm::EDAnalyzer
+class EventFlags: public edm::one::EDAnalyzer<edm::one::SharedResources,
+  edm::one::WatchLuminosityBlocks>
 {
 private:
     /// Auxiliary structure to aggregate information about a flag
@@ -46,9 +55,6 @@ private:
         /// Name for the corresponding branch in the output tree
         std::string branchName;
         
-        /// Index of the flag in TriggerResults
-        unsigned index;
-        
         /// Buffer for the tree to write flag decision in each event
         Bool_t decision;
     };
@@ -68,6 +74,14 @@ private:
     /// Creates the output tree
     virtual void beginJob() override;
     
+    /// Does nothing
+    virtual void beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+    
+    /// Closes the current cluster of the output tree if requested
+    virtual void endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+    
 private:
     /// Token to access precomputed flags
     edm::EDGetTokenT<edm::TriggerResults> flagToken;
@@ -76,11 +90,17 @@ private:
     std::vector<FlagInfo> flagInfos;
     
     /**
-     * \brief Flag showing whether indices to access flags have been set up
+     * \brief Indices of selected flags in menus of flags
      * 
-     * It is assumed that the indices do not change throughout the whole job.
+     * Keys are the original names of flags, in the same order as in flagInfos.
      */
-    bool indicesSetup;
+    std::unique_ptr<TriggerMenuCache> menuCache;
+    
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+    
+    /// Number of entries in the output tree at the previous flush forced at the end of a lumi
+    Long64_t clusterStart;
     
     /// An object to handle the output ROOT file
     edm::Service<TFileService> fileService;
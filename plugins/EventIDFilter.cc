@@ -9,7 +9,6 @@
 #include <TTree.h>
 
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/regex.hpp>
 
 #include <algorithm>
 #include <fstream>
@@ -25,13 +24,24 @@ using namespace std;
 EventIDFilter::EventIDFilter(ParameterSet const &cfg):
     rejectKnownEvents(cfg.getParameter<bool>("rejectKnownEvents"))
 {
-    // Check the type of the input file with collection of event IDs and read it
+    // Check the type of the input file with collection of event IDs. Binary event lists are
+    //used in place and need no further processing
     string const eventListFileName((cfg.getParameter<FileInPath>("eventListFile")).fullPath());
     
+    if (boost::ends_with(eventListFileName, ".evl"))
+    {
+        mappedList.reset(new MappedEventList(eventListFileName));
+        return;
+    }
+    
+    
+    // Read the event list in one of other formats
+    vector<EventID> knownEvents;
+    
     if (boost::ends_with(eventListFileName, ".txt"))
-        ReadTextFile(eventListFileName);
+        ReadTextFile(eventListFileName, knownEvents);
     else if (boost::ends_with(eventListFileName, ".root"))
-        ReadROOTFile(eventListFileName);
+        ReadROOTFile(eventListFileName, knownEvents);
     else
     {
         Exception excp(errors::LogicError);
@@ -41,9 +51,21 @@ EventIDFilter::EventIDFilter(ParameterSet const &cfg):
     }
     
     
-    // Sort the collection of event IDs read from the file. This is needed to improve the
-    //performance of the lookup
+    // Sort the collection of event IDs read from the file and remove duplicates. Then split it
+    //into luminosity sections, recording the range of event numbers for each of them
     sort(knownEvents.begin(), knownEvents.end());
+    knownEvents.erase(unique(knownEvents.begin(), knownEvents.end()), knownEvents.end());
+    
+    eventNumbers.reserve(knownEvents.size());
+    
+    for (auto const &id: knownEvents)
+    {
+        auto const key = LumiKey(id.run(), id.luminosityBlock());
+        auto res = lumiRanges.emplace(key, make_pair(eventNumbers.size(), eventNumbers.size()));
+        
+        eventNumbers.emplace_back(id.event());
+        res.first->second.second = eventNumbers.size();
+    }
 }
 
 
@@ -51,7 +73,7 @@ void EventIDFilter::fillDescriptions(ConfigurationDescriptions &descriptions)
 {
     ParameterSetDescription desc;
     desc.add<FileInPath>("eventListFile")->
-     setComment("Name of a text file containing a list of events.");
+     setComment("Name of a text, ROOT, or binary file containing a list of events.");
     desc.add<bool>("rejectKnownEvents", false)->
      setComment("Determines whether a known event is kept or rejected.");
     
@@ -59,18 +81,77 @@ void EventIDFilter::fillDescriptions(ConfigurationDescriptions &descriptions)
 }
 
 
-bool EventIDFilter::filter(Event &event, EventSetup const &)
+bool EventIDFilter::filter(StreamID, Event &event, EventSetup const &) const
 {
-    // Check if ID of the current event is present in the collection. Profit from the fact that the
-    //collection is sorted
-    bool const eventKnown = binary_search(knownEvents.begin(), knownEvents.end(), event.id());
+    // Known events in the current luminosity section have been found at its beginning. Profit from
+    //the fact that their numbers are sorted
+    auto const &lumiCache = *luminosityBlockCache(event.getLuminosityBlock().index());
     
+    if (lumiCache.begin == lumiCache.end)
+        return rejectKnownEvents;
     
+    bool const eventKnown = binary_search(lumiCache.begin, lumiCache.end, event.id().event());
     return rejectKnownEvents xor eventKnown;
 }
 
 
-void EventIDFilter::ReadTextFile(string const &fileName)
+shared_ptr<EventIDFilterLumiCache> EventIDFilter::globalBeginLuminosityBlock(
+  LuminosityBlock const &lumi, EventSetup const &) const
+{
+    auto lumiCache = make_shared<EventIDFilterLumiCache>();
+    auto const key = LumiKey(lumi.run(), lumi.luminosityBlock());
+    
+    if (mappedList)
+    {
+        auto const *entry = mappedList->FindLumi(key);
+        
+        if (entry)
+        {
+            mappedList->Decode(*entry, lumiCache->decoded);
+            lumiCache->begin = lumiCache->decoded.data();
+            lumiCache->end = lumiCache->begin + lumiCache->decoded.size();
+        }
+    }
+    else
+    {
+        auto const rangeIt = lumiRanges.find(key);
+        
+        if (rangeIt != lumiRanges.end())
+        {
+            lumiCache->begin = eventNumbers.data() + rangeIt->second.first;
+            lumiCache->end = eventNumbers.data() + rangeIt->second.second;
+        }
+    }
+    
+    return lumiCache;
+}
+
+
+void EventIDFilter::globalEndLuminosityBlock(LuminosityBlock const &, EventSetup const &) const
+{}
+
+
+bool EventIDFilter::ParseNumber(string const &text, string::size_type &pos, uint64_t &value)
+{
+    auto const start = pos;
+    value = 0;
+    
+    for (; pos < text.length() and text[pos] >= '0' and text[pos] <= '9'; ++pos)
+    {
+        uint64_t const digit = text[pos] - '0';
+        
+        // Check for overflow
+        if (value > (UINT64_MAX - digit) / 10)
+            return false;
+        
+        value = value * 10 + digit;
+    }
+    
+    return (pos != start);
+}
+
+
+void EventIDFilter::ReadTextFile(string const &fileName, vector<EventID> &events)
 {
     // Open the given text file with event IDs
     ifstream eventListFile(fileName);
@@ -83,10 +164,9 @@ void EventIDFilter::ReadTextFile(string const &fileName)
     }
     
     
-    // Read IDs from the file. Lines are parsed with the help of a regular expression
+    // Read IDs from the file. Lines are parsed by hand, which is much faster than using a regular
+    //expression
     string line;
-    boost::regex eventIDRegex("^(\\d+):(\\d+):(\\d+)$", boost::regex::extended);
-    boost::smatch matchResults;
     
     while (true)
     {
@@ -98,7 +178,14 @@ void EventIDFilter::ReadTextFile(string const &fileName)
         
         
         // Extract the event ID from the line and add it to the collection
-        if (not boost::regex_match(line, matchResults, eventIDRegex))
+        uint64_t run, lumiSection, event;
+        string::size_type pos = 0;
+        
+        bool const parsed = ParseNumber(line, pos, run) and pos < line.length() and
+          line[pos++] == ':' and ParseNumber(line, pos, lumiSection) and pos < line.length() and
+          line[pos++] == ':' and ParseNumber(line, pos, event) and pos == line.length();
+        
+        if (not parsed or run > UINT32_MAX or lumiSection > UINT32_MAX)
         {
             Exception excp(errors::LogicError);
             excp << "Failed to parse line\n  \"" << line << "\"\nof input file \"" << fileName <<
@@ -106,11 +193,7 @@ void EventIDFilter::ReadTextFile(string const &fileName)
             excp.raise();
         }
         
-        unsigned long const run = stol(matchResults[1]);
-        unsigned long const lumiSection = stol(matchResults[2]);
-        unsigned long long const event = stoll(matchResults[3]);
-        
-        knownEvents.emplace_back(run, lumiSection, event);
+        events.emplace_back(run, lumiSection, event);
     }
     
     
@@ -118,7 +201,7 @@ void EventIDFilter::ReadTextFile(string const &fileName)
 }
 
 
-void EventIDFilter::ReadROOTFile(string const &fileName)
+void EventIDFilter::ReadROOTFile(string const &fileName, vector<EventID> &events)
 {
     // Open the ROOT file with event IDs
     unique_ptr<TFile> eventListFile(TFile::Open(fileName.c_str()));
@@ -204,11 +287,12 @@ void EventIDFilter::ReadROOTFile(string const &fileName)
     
     // Finally, read event IDs from the tree
     unsigned long const nEntries = eventListTree->GetEntries();
+    events.reserve(events.size() + nEntries);
     
     for (unsigned long ev = 0; ev < nEntries; ++ev)
     {
         eventListTree->GetEntry(ev);
-        knownEvents.emplace_back(run, lumiSection, event);
+        events.emplace_back(run, lumiSection, event);
     }
 }
 
@@ -1,32 +1,74 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDFilter.h>
+#include "MappedEventList.h"
+
+#include <FWCore/Framework/interface/global/EDFilter.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 
 #include <DataFormats/Provenance/interface/EventID.h>
 
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <string>
 
 
+/**
+ * \struct EventIDFilterLumiCache
+ * \brief Known events in a luminosity section, cached by EventIDFilter
+ */
+struct EventIDFilterLumiCache
+{
+    /**
+     * \brief Sorted event numbers in the current luminosity section
+     * 
+     * The range is empty if the section contains no known events.
+     */
+    edm::EventNumber_t const *begin = nullptr, *end = nullptr;
+    
+    /// Buffer for decoded event numbers; only used with binary event lists
+    std::vector<edm::EventNumber_t> decoded;
+};
+
+
 /**
  * \class EventIDFilter
  * \brief Performs event filtering based on given collection of event IDs
  * 
  * Depending on the configuration, keeps or rejects events whose IDs are found in the collection.
- * The collection is read from a text or a ROOT file. Their formats are described in the
- * documentation for methods ReadTextFile and ReadROOTFile.
+ * The collection is read from a text, a ROOT, or a binary file, which is recognized by the
+ * extension ".txt", ".root", or ".evl". Formats of the first two are described in the
+ * documentation for methods ReadTextFile and ReadROOTFile. They are parsed at construction.
+ * Binary files, described in the documentation for class MappedEventList, are instead mapped into
+ * memory and read in place. This is the preferred format for large lists since it requires no
+ * parsing, and the memory is shared among jobs via the page cache.
+ * 
+ * For a fast lookup in large collections, event IDs are partitioned by run and luminosity section.
+ * For text and ROOT files, event numbers from all luminosity sections are stored in a single
+ * vector, sorted by run, luminosity section, and event number, and a hash map gives the range in
+ * this vector that corresponds to each luminosity section. For binary files the directory of the
+ * file serves the same purpose.
+ * 
+ * The lookup of the luminosity section is done only once per section, at its beginning, and the
+ * resulting range of event numbers is cached. Within an event, only a binary search in this
+ * (short) range is performed. Events from sections that contain no known events are accepted or
+ * rejected without any lookup. For sparse event lists it is also advisable to restrict the input
+ * with parameter lumisToProcess of the source, so that irrelevant sections are not read at all
+ * (see function get_lumis_from_event_list in Utils_cff.py).
  */
-class EventIDFilter: public edm::EDFilter
+class EventIDFilter: public edm::global::EDFilter<edm::LuminosityBlockCache<EventIDFilterLumiCache>>
 {
 public:
     /**
      * \brief Constructor
      * 
-     * Reads the configuration. Reads the input file with event IDs, stores them in a vector, and
-     * sorts it.
+     * Reads the configuration. Reads the input file with event IDs and builds the lookup
+     * structures.
      */
     EventIDFilter(edm::ParameterSet const &cfg);
     
@@ -35,35 +77,69 @@ public:
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
     /// Performs event filtering based on ID of the current event
-    virtual bool filter(edm::Event &event, edm::EventSetup const &) override;
+    virtual bool filter(edm::StreamID, edm::Event &event, edm::EventSetup const &) const override;
+    
+    /// Finds known events in the new luminosity section
+    virtual std::shared_ptr<EventIDFilterLumiCache> globalBeginLuminosityBlock(
+      edm::LuminosityBlock const &lumi, edm::EventSetup const &) const override;
+    
+    /// Does nothing; required by edm::LuminosityBlockCache
+    virtual void globalEndLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      const override;
     
 private:
     /**
      * \brief Reads a collection of event IDs from a text file
      * 
      * Event IDs must be stored in the form "run:lumi:event", one per line. No blank lines or
-     * comments are allowed. If method fails to parse the file, it throws an exception.
+     * comments are allowed. If method fails to parse the file, it throws an exception. Read IDs
+     * are added to the given vector.
      */
-    void ReadTextFile(std::string const &fileName);
+    static void ReadTextFile(std::string const &fileName, std::vector<edm::EventID> &events);
     
     /**
      * \brief Reads a collection of event IDs from a ROOT file
      * 
      * Event IDs must be stored in a tree called "EventID" in branches "run", "lumi", "event" of
      * types 'i', 'i', 'l' (as defined in TBranch) respectively. If these requirements are not
-     * satisfied, the method throws an exception.
+     * satisfied, the method throws an exception. Read IDs are added to the given vector.
+     */
+    static void ReadROOTFile(std::string const &fileName, std::vector<edm::EventID> &events);
+    
+    /**
+     * \brief Parses an unsigned integer number starting from the given position in a string
+     * 
+     * On success, advances the position past the last digit and returns true. Returns false if
+     * there are no digits at the given position or if the number does not fit into 64 bits.
      */
-    void ReadROOTFile(std::string const &fileName);
+    static bool ParseNumber(std::string const &text, std::string::size_type &pos,
+      std::uint64_t &value);
+    
+    /// Constructs the key for the map with ranges of event numbers
+    static std::uint64_t LumiKey(edm::RunNumber_t run, edm::LuminosityBlockNumber_t lumi)
+    {
+        return (std::uint64_t(run) << 32) | lumi;
+    }
     
 private:
     /**
-     * \brief Collection of event IDs read from the input file
+     * \brief Event numbers of all known events
+     * 
+     * Sorted by run, luminosity section, and event number. Duplicates are removed. Not used if
+     * mappedList is set.
+     */
+    std::vector<edm::EventNumber_t> eventNumbers;
+    
+    /**
+     * \brief Ranges in vector eventNumbers for all luminosity sections
      * 
-     * The vector will be sorted before the first event is checked. Use a vector instead of a set
-     * because lookup in an ordered vector is at least as fast as in a set, while insertion is
-     * much faster.
+     * The key is constructed with method LumiKey. The value gives the index of the first element
+     * in the range and the index past the last element.
      */
-    std::vector<edm::EventID> knownEvents;
+    std::unordered_map<std::uint64_t, std::pair<std::size_t, std::size_t>> lumiRanges;
+    
+    /// Binary event list mapped into memory; only set if the list is read from a binary file
+    std::unique_ptr<MappedEventList> mappedList;
     
     /// Determines if events present in the container should be kept or rejected
     bool rejectKnownEvents;
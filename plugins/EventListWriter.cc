@@ -0,0 +1,47 @@
+#include "EventListWriter.h"
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <TDirectory.h>
+
+
+EventListWriter::EventListWriter(edm::ParameterSet const &)
+{
+    usesResource("TFileService");
+}
+
+
+void EventListWriter::beginJob()
+{
+    // Create the tree in the root directory of the output file. This is where EventIDFilter
+    //expects to find it. Since the tree is attached to the file, it will be written when the file
+    //is closed by TFileService.
+    TDirectory::TContext context(&fileService->file());
+    tree = new TTree("EventID", "IDs of selected events");
+
+    tree->Branch("run", &runNumber);
+    tree->Branch("lumi", &lumiNumber);
+    tree->Branch("event", &eventNumber);
+}
+
+
+void EventListWriter::analyze(edm::Event const &event, edm::EventSetup const &)
+{
+    edm::EventID const &id = event.id();
+    runNumber = id.run();
+    lumiNumber = id.luminosityBlock();
+    eventNumber = id.event();
+
+    tree->Fill();
+}
+
+
+void EventListWriter::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription desc;
+    descriptions.add("eventListWriter", desc);
+}
+
+
+DEFINE_FWK_MODULE(EventListWriter);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+#include <TTree.h>
+
+
+/**
+ * \class EventListWriter
+ * \brief Saves IDs of all events that reach it in the format read by EventIDFilter
+ *
+ * IDs are stored in a tree "EventID" with branches "run", "lumi", and "event" of types UInt_t,
+ * UInt_t, and ULong64_t. The tree is created in the root directory of the file opened by
+ * TFileService, not in a per-module directory, so that the output file can be given directly to
+ * EventIDFilter (see EventIDFilter::ReadROOTFile). The plugin is intended for a fast pre-pass
+ * over the input, which applies a loose selection and records the accepted events, so that the
+ * full processing only needs to be run over them.
+ */
+class EventListWriter: public edm::one::EDAnalyzer<edm::one::SharedResources>
+{
+public:
+    /// Constructor
+    EventListWriter(edm::ParameterSet const &);
+
+public:
+    /// Creates the output tree
+    virtual void beginJob() override;
+
+    /// Writes ID of the current event into the output tree
+    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+private:
+    /// An object to handle the output ROOT file
+    edm::Service<TFileService> fileService;
+
+    /**
+     * \brief The output tree
+     *
+     * The tree is owned by the output file.
+     */
+    TTree *tree;
+
+    /// Buffers to fill the output tree
+    UInt_t runNumber, lumiNumber;
+    ULong64_t eventNumber;
+};
@@ -5,8 +5,13 @@
 
 
 EventWeights::EventWeights(edm::ParameterSet const &cfg):
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings")),
+    clusterStart(0),
     outTree(nullptr)
 {
+    usesResource("TFileService");
+
+
     auto const tags = cfg.getParameter<std::vector<edm::InputTag>>("sources");
 
     for (auto const &tag: tags)
@@ -40,6 +45,33 @@ EventWeights::EventWeights(edm::ParameterSet const &cfg):
         for (unsigned i = 0; i < weightInfos.size(); ++i)
             weightInfos[i].branchName = branchNames[i];
     }
+
+
+    for (auto const &vectorCfg: cfg.getParameter<std::vector<edm::ParameterSet>>("vectorSources"))
+    {
+        auto const tag = vectorCfg.getParameter<edm::InputTag>("src");
+        auto const type = vectorCfg.getParameter<std::string>("type");
+        auto const branchName = vectorCfg.getParameter<std::string>("name");
+        auto const names = vectorCfg.getParameter<std::vector<std::string>>("componentNames");
+
+        if (names.empty())
+        {
+            cms::Exception excp("Configuration");
+            excp << "No names of components are given for branch \"" << branchName << "\".";
+            excp.raise();
+        }
+
+        if (type == "Floats")
+            floatVectorInfos.emplace_back(consumes<std::vector<float>>(tag), branchName, names);
+        else if (type == "Doubles")
+            doubleVectorInfos.emplace_back(consumes<std::vector<double>>(tag), branchName, names);
+        else
+        {
+            cms::Exception excp("Configuration");
+            excp << "Branch \"" << branchName << "\" has unsupported type \"" << type << "\".";
+            excp.raise();
+        }
+    }
 }
 
 
@@ -49,6 +81,18 @@ void EventWeights::fillDescriptions(edm::ConfigurationDescriptions &descriptions
     desc.add<std::vector<edm::InputTag>>("sources")->setComment("Plugins that produce weights.");
     desc.add<std::vector<std::string>>("storeNames", std::vector<std::string>())->
       setComment("(Optional) names for output branches.");
+
+    edm::ParameterSetDescription vectorDesc;
+    vectorDesc.add<edm::InputTag>("src")->setComment("Plugin that produces the weights.");
+    vectorDesc.add<std::string>("type")->
+      setComment("Type of the product: \"Floats\" or \"Doubles\".");
+    vectorDesc.add<std::string>("name")->setComment("Name for the output branch.");
+    vectorDesc.add<std::vector<std::string>>("componentNames")->
+      setComment("Names of individual weights, which also define their number.");
+    desc.addVPSet("vectorSources", vectorDesc, std::vector<edm::ParameterSet>())->
+      setComment("Groups of weights read from vectors.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output tree.");
     
     descriptions.add("eventWeights", desc);
 }
@@ -59,6 +103,12 @@ void EventWeights::analyze(edm::Event const &event, edm::EventSetup const &)
     for (auto &weightInfo: weightInfos)
         weightInfo.Read(event);
 
+    for (auto &info: floatVectorInfos)
+        info.Read(event);
+
+    for (auto &info: doubleVectorInfos)
+        info.Read(event);
+
     outTree->Fill();
 }
 
@@ -69,6 +119,61 @@ void EventWeights::beginJob()
 
     for (auto &weightInfo: weightInfos)
         outTree->Branch(weightInfo.branchName.c_str(), &weightInfo.value);
+
+    for (auto &info: floatVectorInfos)
+        outTree->Branch(info.branchName.c_str(), info.values.data(),
+          (info.branchName + "[" + std::to_string(info.values.size()) + "]/F").c_str());
+
+    for (auto &info: doubleVectorInfos)
+        outTree->Branch(info.branchName.c_str(), info.values.data(),
+          (info.branchName + "[" + std::to_string(info.values.size()) + "]/D").c_str());
+
+    treeSettings.Apply(outTree);
+
+    if (not floatVectorInfos.empty() or not doubleVectorInfos.empty())
+        WriteWeightNames();
+}
+
+
+void EventWeights::beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{}
+
+
+void EventWeights::endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{
+    treeSettings.EndLuminosityBlock(outTree, clusterStart);
+}
+
+
+void EventWeights::WriteWeightNames() const
+{
+    TTree *tree = fileService->make<TTree>("WeightNames", "Names of components of vector weights");
+
+    std::string branchName, name;
+    UInt_t index;
+    tree->Branch("branch", &branchName);
+    tree->Branch("index", &index);
+    tree->Branch("name", &name);
+
+    auto fill = [&](auto const &infos)
+    {
+        for (auto const &info: infos)
+        {
+            branchName = info.branchName;
+
+            for (index = 0; index < info.componentNames.size(); ++index)
+            {
+                name = info.componentNames[index];
+                tree->Fill();
+            }
+        }
+    };
+
+    fill(floatVectorInfos);
+    fill(doubleVectorInfos);
+
+    // The tree must not refer to the local buffers after this method exits
+    tree->ResetBranchAddresses();
 }
 
 
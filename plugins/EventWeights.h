@@ -1,7 +1,10 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include "TreeSettings.h"
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
@@ -10,8 +13,11 @@
 #include <FWCore/ServiceRegistry/interface/Service.h>
 #include <CommonTools/UtilAlgos/interface/TFileService.h>
 
+#include <FWCore/Utilities/interface/Exception.h>
+
 #include <TTree.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -22,8 +28,18 @@
  * The configuration must provide a vector of input tags that identify the weights to be stored
  * (which must be of type double). Names for the corresponding branches in the output tree can also
  * be provided. If not, they are constructed from the input tags.
+ *
+ * Groups of related weights, such as systematic variations of scale factors, can be read from
+ * products of type std::vector<float> or std::vector<double>, which are described in the vector of
+ * parameter sets "vectorSources". Each group is stored in a single branch with a fixed-length
+ * array, whose size is given by the number of names of the components in the configuration. The
+ * size of the product is checked in every event, and an exception is thrown in case of a
+ * mismatch. Names of the components are saved in an additional tree "WeightNames" with one entry
+ * per component and branches "branch", "index", and "name". The tree is filled once at the
+ * beginning of the job.
  */
-class EventWeights: public edm::EDAnalyzer
+class EventWeights: public edm::one::EDAnalyzer<edm::one::SharedResources,
+  edm::one::WatchLuminosityBlocks>
 {
 private:
     /// Auxiliary class to aggregate details about a single weight
@@ -47,6 +63,29 @@ private:
         T value;
     };
 
+    /// Auxiliary class to aggregate details about a group of weights read from a vector
+    template <typename T>
+    struct VectorWeightInfo
+    {
+        VectorWeightInfo(edm::EDGetTokenT<std::vector<T>> &&token, std::string const &branchName,
+          std::vector<std::string> const &componentNames);
+
+        /// Read the values of the weights from the given event, checking their number
+        void Read(edm::Event const &event);
+
+        /// Token to read the weights from the event
+        edm::EDGetTokenT<std::vector<T>> token;
+
+        /// Name for the branch in which the weights will be stored
+        std::string branchName;
+
+        /// Names of individual weights
+        std::vector<std::string> componentNames;
+
+        /// Buffer to read the values of the weights into
+        std::vector<T> values;
+    };
+
 public:
     EventWeights(edm::ParameterSet const &cfg);
 
@@ -56,10 +95,25 @@ public:
 private:
     void analyze(edm::Event const &event, edm::EventSetup const &) override;
     void beginJob() override;
+    void beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &) override;
+    void endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &) override;
+
+    /// Writes names of components of vector weights into a dedicated tree
+    void WriteWeightNames() const;
 
 private:
     /// Details about weights to be saved
     std::vector<WeightInfo<double>> weightInfos;
+
+    /// Details about groups of weights read from vectors of floats and doubles
+    std::vector<VectorWeightInfo<float>> floatVectorInfos;
+    std::vector<VectorWeightInfo<double>> doubleVectorInfos;
+    
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+    
+    /// Number of entries in the output tree at the previous flush forced at the end of a lumi
+    Long64_t clusterStart;
     
     /// An object to handle output ROOT file
     edm::Service<TFileService> fileService;
@@ -87,3 +141,32 @@ void EventWeights::WeightInfo<T>::Read(edm::Event const &event)
     value = *handle;
 }
 
+
+template <typename T>
+EventWeights::VectorWeightInfo<T>::VectorWeightInfo(edm::EDGetTokenT<std::vector<T>> &&token_,
+  std::string const &branchName_, std::vector<std::string> const &componentNames_):
+    token(token_),
+    branchName(branchName_),
+    componentNames(componentNames_),
+    values(componentNames_.size())
+{}
+
+
+template <typename T>
+void EventWeights::VectorWeightInfo<T>::Read(edm::Event const &event)
+{
+    edm::Handle<std::vector<T>> handle;
+    event.getByToken(token, handle);
+
+    if (handle->size() != values.size())
+    {
+        cms::Exception excp("LogicError");
+        excp << "Product for branch \"" << branchName << "\" contains " << handle->size() <<
+          " weights while " << values.size() << " are expected.";
+        excp.raise();
+    }
+
+    // Copy in place since the address of the buffer is registered with the output tree
+    std::copy(handle->begin(), handle->end(), values.begin());
+}
+
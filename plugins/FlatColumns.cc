@@ -0,0 +1,171 @@
+#include "FlatColumns.h"
+
+#include <cstdint>
+
+
+namespace
+{
+/// Adds columns for members of pec::Candidate
+template<typename T>
+void AddCandidate(FlatTable<T> &table)
+{
+    table.AddFloat("pt", [](T const &c){return c.Pt();});
+    table.AddFloat("eta", [](T const &c){return c.Eta();});
+    table.AddFloat("phi", [](T const &c){return c.Phi();});
+    table.AddFloat("mass", [](T const &c){return c.M();});
+}
+
+
+/// Adds columns for members of pec::CandidateWithID and its base class
+template<typename T>
+void AddCandidateWithID(FlatTable<T> &table)
+{
+    AddCandidate(table);
+
+    // The ID flags are stored as a bit pattern in (signed) integer columns. If they do not fit
+    //into a single column, the upper bits go into a separate one
+    table.AddInt("id", [](T const &c){return int(std::uint32_t(c.IdBits()));});
+
+    if constexpr (pec::CandidateWithID::maxIdBits > 32)
+        table.AddInt("idHigh", [](T const &c){return int(std::uint32_t(c.IdBits() >> 32));});
+    table.AddInt("triggerMatches", [](T const &c){return int(c.TriggerMatches());});
+}
+
+
+/// Adds columns for members of pec::Lepton and its base classes
+template<typename T>
+void AddLepton(FlatTable<T> &table)
+{
+    AddCandidateWithID(table);
+    table.AddInt("charge", [](T const &l){return l.Charge();});
+    table.AddFloat("relIso", [](T const &l){return l.RelIso();});
+}
+}  // anonymous namespace
+
+
+void flatcolumns::Define(FlatTable<pec::Candidate> &table)
+{
+    AddCandidate(table);
+}
+
+
+void flatcolumns::Define(FlatTable<pec::Electron> &table)
+{
+    AddLepton(table);
+    table.AddFloat("etaSC", [](pec::Electron const &e){return e.EtaSC();});
+    table.AddInt("cutBasedId", [](pec::Electron const &e)
+    {
+        int mask = 0;
+
+        for (unsigned bit = 0; bit < 8; ++bit)
+            mask |= (int(e.BooleanID(bit)) << bit);
+
+        return mask;
+    });
+    table.AddFloat("mvaId", [](pec::Electron const &e){return e.ContinuousID(0);});
+}
+
+
+void flatcolumns::Define(FlatTable<pec::Muon> &table)
+{
+    AddLepton(table);
+}
+
+
+void flatcolumns::Define(FlatTable<pec::Jet> &table)
+{
+    using Jet = pec::Jet;
+
+    AddCandidateWithID(table);
+    table.AddFloat("corrFactor", [](Jet const &j){return j.CorrFactor();});
+    table.AddFloat("jecUncertainty", [](Jet const &j){return j.JECUncertainty();});
+    table.AddFloat("jerUncertainty", [](Jet const &j){return j.JERUncertainty();});
+    table.AddInt("jecEtaBin", [](Jet const &j){return int(j.JECEtaBin());});
+    table.AddInt("jecPtNode", [](Jet const &j){return int(j.JECPtNode());});
+    table.AddFloatArray("bTags", 2,
+      [](Jet const &j, unsigned i){return j.BTag(Jet::BTagAlgo(i));});
+    table.AddFloatArray("cTags", 2,
+      [](Jet const &j, unsigned i){return j.CTag(Jet::CTagAlgo(i));});
+    table.AddFloatArray("bTagsDNN", 4,
+      [](Jet const &j, unsigned i){return j.BTagDNN(Jet::BTagDNNType(i));});
+    table.AddFloat("pileUpMVA", [](Jet const &j){return j.PileUpID();});
+    table.AddFloat("qgTag", [](Jet const &j){return j.QGTag();});
+    table.AddFloat("area", [](Jet const &j){return j.Area();});
+    table.AddFloat("charge", [](Jet const &j){return j.Charge();});
+    table.AddFloat("pullAngle", [](Jet const &j){return j.PullAngle();});
+    table.AddIntArray("flavours", 3,
+      [](Jet const &j, unsigned i){return j.Flavour(Jet::FlavourType(i));});
+}
+
+
+void flatcolumns::Define(FlatTable<pec::GenParticle> &table)
+{
+    using GenParticle = pec::GenParticle;
+
+    AddCandidate(table);
+    table.AddInt("pdgId", [](GenParticle const &p){return p.PdgId();});
+    table.AddInt("firstMotherIndex", [](GenParticle const &p){return p.FirstMotherIndex();});
+    table.AddInt("lastMotherIndex", [](GenParticle const &p){return p.LastMotherIndex();});
+}
+
+
+void flatcolumns::Define(FlatTable<pec::GenJet> &table)
+{
+    AddCandidate(table);
+    table.AddInt("bottomMult", [](pec::GenJet const &j){return int(j.BottomMult());});
+    table.AddInt("charmMult", [](pec::GenJet const &j){return int(j.CharmMult());});
+}
+
+
+void flatcolumns::Define(FlatRecord<pec::EventID> &record)
+{
+    using EventID = pec::EventID;
+
+    record.AddUInt("run", [](EventID const &id){return unsigned(id.RunNumber());});
+    record.AddUInt("lumi", [](EventID const &id){return unsigned(id.LumiSectionNumber());});
+    record.AddULong64("event", [](EventID const &id){return ULong64_t(id.EventNumber());});
+    record.AddUInt("bunchCrossing", [](EventID const &id){return id.BunchCrossing();});
+}
+
+
+void flatcolumns::Define(FlatRecord<pec::MET> &record)
+{
+    using MET = pec::MET;
+
+    record.AddFloat("px", [](MET const &m){return m.Px();});
+    record.AddFloat("py", [](MET const &m){return m.Py();});
+    record.AddFloatArray("shiftedPx", MET::numVariations,
+      [](MET const &m, unsigned i){return m.Px(MET::Variation(i));});
+    record.AddFloatArray("shiftedPy", MET::numVariations,
+      [](MET const &m, unsigned i){return m.Py(MET::Variation(i));});
+}
+
+
+void flatcolumns::Define(FlatRecord<pec::PileUpInfo> &record)
+{
+    using PileUpInfo = pec::PileUpInfo;
+
+    record.AddUInt("numPV", [](PileUpInfo const &p){return p.NumPV();});
+    record.AddFloat("rho", [](PileUpInfo const &p){return p.Rho();});
+    record.AddFloat("rhoCentral", [](PileUpInfo const &p){return p.RhoCentral();});
+    record.AddFloat("trueNumPU", [](PileUpInfo const &p){return p.TrueNumPU();});
+    record.AddUInt("inTimeNumPU", [](PileUpInfo const &p){return p.InTimePU();});
+    record.AddFloat("maxPtHat", [](PileUpInfo const &p){return p.MaxPtHat();});
+    record.AddFloat("weight", [](PileUpInfo const &p){return p.Weight();});
+    record.AddFloat("weightUp", [](PileUpInfo const &p){return p.WeightUp();});
+    record.AddFloat("weightDown", [](PileUpInfo const &p){return p.WeightDown();});
+}
+
+
+void flatcolumns::Define(FlatRecord<pec::GeneratorInfo> &record)
+{
+    using GeneratorInfo = pec::GeneratorInfo;
+
+    record.AddInt("processId", [](GeneratorInfo const &g){return g.ProcessId();});
+    record.AddFloat("nominalWeight", [](GeneratorInfo const &g){return g.NominalWeight();});
+    record.AddFloatList("altLheWeights", [](GeneratorInfo const &g){return g.AltLheWeights();});
+    record.AddFloatList("altPsWeights", [](GeneratorInfo const &g){return g.AltPsWeights();});
+    record.AddFloatArray("pdfX", 2, [](GeneratorInfo const &g, unsigned i){return g.PdfX(i);});
+    record.AddIntArray("pdfId", 2, [](GeneratorInfo const &g, unsigned i){return g.PdfId(i);});
+    record.AddFloat("pdfQScale", [](GeneratorInfo const &g){return g.PdfQScale();});
+}
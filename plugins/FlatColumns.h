@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FlatRecord.h"
+#include "FlatTable.h"
+
+#include <Analysis/PECTuples/interface/Candidate.h>
+#include <Analysis/PECTuples/interface/Electron.h>
+#include <Analysis/PECTuples/interface/EventID.h>
+#include <Analysis/PECTuples/interface/GeneratorInfo.h>
+#include <Analysis/PECTuples/interface/GenJet.h>
+#include <Analysis/PECTuples/interface/GenParticle.h>
+#include <Analysis/PECTuples/interface/Jet.h>
+#include <Analysis/PECTuples/interface/MET.h>
+#include <Analysis/PECTuples/interface/Muon.h>
+#include <Analysis/PECTuples/interface/PileUpInfo.h>
+
+
+/**
+ * \brief Functions that define columns of flat tables and records for PEC classes
+ *
+ * Each function adds to the given table one column per data member of the corresponding class,
+ * including members of its base classes. Column names follow names of the data members. Values are
+ * the ones returned by the public getters, e.g. flavours of a jet are stored as a column of three
+ * integer numbers, one per definition of the flavour, and sets of boolean flags are stored as
+ * integer bit masks. Similarly, encoded members are decoded, e.g. shifts of MET are stored as
+ * columns "shiftedPx" and "shiftedPy" with the components of MET for all variations, and
+ * alternative LHE weights are stored as their full values for all events.
+ */
+namespace flatcolumns
+{
+void Define(FlatTable<pec::Candidate> &table);
+void Define(FlatTable<pec::Electron> &table);
+void Define(FlatTable<pec::Muon> &table);
+void Define(FlatTable<pec::Jet> &table);
+void Define(FlatTable<pec::GenParticle> &table);
+void Define(FlatTable<pec::GenJet> &table);
+
+void Define(FlatRecord<pec::EventID> &record);
+void Define(FlatRecord<pec::MET> &record);
+void Define(FlatRecord<pec::PileUpInfo> &record);
+void Define(FlatRecord<pec::GeneratorInfo> &record);
+}  // end of namespace flatcolumns
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "FlatTable.h"
+
+#include <TTree.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class FlatRecord
+ * \brief Stores a single object of type T per entry of a tree using a flat layout
+ *
+ * This is the counterpart of FlatTable for products that contain exactly one object per event,
+ * such as pec::EventID or pec::GeneratorInfo. Each property of the object (a "column") with name
+ * "<name>" is stored in branch "<prefix>_<name>", which contains a single value of a fundamental
+ * type or an array of such values with a fixed size. A property given by a vector whose size
+ * varies from event to event is stored as a collection in the sense of FlatTable, with prefix
+ * "<prefix>_<name>" and a single float column "value". A reader thus only deals with branches of
+ * fundamental types and needs no dictionaries.
+ *
+ * Columns are defined by the user with methods AddFloat, AddInt, etc., which take getters, so only
+ * the public interface of T is used. All columns must be defined before the record is booked.
+ */
+template<typename T>
+class FlatRecord
+{
+private:
+    /// Description and buffer of a column of values of type V
+    template<typename V>
+    struct Column
+    {
+        /// Name of the column, without the prefix
+        std::string name;
+
+        /// Number of values in the column
+        unsigned width;
+
+        /// Function to obtain the value with the given index for an object
+        std::function<V(T const &, unsigned)> getter;
+
+        /// Buffer with values for the current event
+        std::vector<V> buffer;
+    };
+
+    /// Description of a column with a variable number of values
+    struct ListColumn
+    {
+        /// Function to obtain all values for an object
+        std::function<std::vector<float>(T const &)> getter;
+
+        /// Table that stores the values
+        FlatTable<float> table;
+    };
+
+public:
+    /// Constructor from the prefix for names of all branches
+    FlatRecord(std::string const &prefix);
+
+public:
+    /// Adds a column with a floating-point value
+    void AddFloat(std::string const &name, std::function<float(T const &)> getter);
+
+    /// Adds a column with an array of floating-point values with the given fixed size
+    void AddFloatArray(std::string const &name, unsigned width,
+      std::function<float(T const &, unsigned)> getter);
+
+    /// Adds a column with a signed integer value
+    void AddInt(std::string const &name, std::function<int(T const &)> getter);
+
+    /// Adds a column with an array of signed integer values with the given fixed size
+    void AddIntArray(std::string const &name, unsigned width,
+      std::function<int(T const &, unsigned)> getter);
+
+    /// Adds a column with an unsigned integer value
+    void AddUInt(std::string const &name, std::function<unsigned(T const &)> getter);
+
+    /// Adds a column with a 64-bit unsigned integer value
+    void AddULong64(std::string const &name, std::function<ULong64_t(T const &)> getter);
+
+    /// Adds a column with a variable number of floating-point values
+    void AddFloatList(std::string const &name,
+      std::function<std::vector<float>(T const &)> getter);
+
+    /// Creates branches for all columns in the given tree
+    void Book(TTree *tree);
+
+    /// Fills buffers of all columns from the given object
+    void Fill(T const &object);
+
+private:
+    /// Adds a column of the given type
+    template<typename V>
+    static void AddColumn(std::vector<Column<V>> &columns, std::string const &name,
+      unsigned width, std::function<V(T const &, unsigned)> getter);
+
+    /// Creates a branch for the given column
+    template<typename V>
+    void BookColumn(TTree *tree, Column<V> &column, char typeCode);
+
+    /// Fills the buffer of the given column
+    template<typename V>
+    static void FillColumn(Column<V> &column, T const &object);
+
+private:
+    /// Prefix for names of all branches
+    std::string prefix;
+
+    /// Columns of floating-point values
+    std::vector<Column<Float_t>> floatColumns;
+
+    /// Columns of signed integer values
+    std::vector<Column<Int_t>> intColumns;
+
+    /// Columns of unsigned integer values
+    std::vector<Column<UInt_t>> uintColumns;
+
+    /// Columns of 64-bit unsigned integer values
+    std::vector<Column<ULong64_t>> ulong64Columns;
+
+    /// Columns with variable numbers of values
+    std::vector<ListColumn> listColumns;
+};
+
+
+template<typename T>
+FlatRecord<T>::FlatRecord(std::string const &prefix_):
+    prefix(prefix_)
+{}
+
+
+template<typename T>
+void FlatRecord<T>::AddFloat(std::string const &name, std::function<float(T const &)> getter)
+{
+    AddColumn<Float_t>(floatColumns, name, 1,
+      [getter](T const &obj, unsigned){return getter(obj);});
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddFloatArray(std::string const &name, unsigned width,
+  std::function<float(T const &, unsigned)> getter)
+{
+    AddColumn<Float_t>(floatColumns, name, width, getter);
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddInt(std::string const &name, std::function<int(T const &)> getter)
+{
+    AddColumn<Int_t>(intColumns, name, 1, [getter](T const &obj, unsigned){return getter(obj);});
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddIntArray(std::string const &name, unsigned width,
+  std::function<int(T const &, unsigned)> getter)
+{
+    AddColumn<Int_t>(intColumns, name, width, getter);
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddUInt(std::string const &name, std::function<unsigned(T const &)> getter)
+{
+    AddColumn<UInt_t>(uintColumns, name, 1,
+      [getter](T const &obj, unsigned){return getter(obj);});
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddULong64(std::string const &name,
+  std::function<ULong64_t(T const &)> getter)
+{
+    AddColumn<ULong64_t>(ulong64Columns, name, 1,
+      [getter](T const &obj, unsigned){return getter(obj);});
+}
+
+
+template<typename T>
+void FlatRecord<T>::AddFloatList(std::string const &name,
+  std::function<std::vector<float>(T const &)> getter)
+{
+    listColumns.push_back({getter, FlatTable<float>(prefix + "_" + name)});
+    listColumns.back().table.AddFloat("value", [](float const &value){return value;});
+}
+
+
+template<typename T>
+void FlatRecord<T>::Book(TTree *tree)
+{
+    for (auto &column: floatColumns)
+        BookColumn(tree, column, 'F');
+
+    for (auto &column: intColumns)
+        BookColumn(tree, column, 'I');
+
+    for (auto &column: uintColumns)
+        BookColumn(tree, column, 'i');
+
+    for (auto &column: ulong64Columns)
+        BookColumn(tree, column, 'l');
+
+    for (auto &column: listColumns)
+        column.table.Book(tree);
+}
+
+
+template<typename T>
+void FlatRecord<T>::Fill(T const &object)
+{
+    for (auto &column: floatColumns)
+        FillColumn(column, object);
+
+    for (auto &column: intColumns)
+        FillColumn(column, object);
+
+    for (auto &column: uintColumns)
+        FillColumn(column, object);
+
+    for (auto &column: ulong64Columns)
+        FillColumn(column, object);
+
+    for (auto &column: listColumns)
+        column.table.Fill(column.getter(object));
+}
+
+
+template<typename T>
+template<typename V>
+void FlatRecord<T>::AddColumn(std::vector<Column<V>> &columns, std::string const &name,
+  unsigned width, std::function<V(T const &, unsigned)> getter)
+{
+    // The buffer is allocated here and never resized, so its address does not change
+    columns.push_back({name, width, getter, std::vector<V>(width)});
+}
+
+
+template<typename T>
+template<typename V>
+void FlatRecord<T>::BookColumn(TTree *tree, Column<V> &column, char typeCode)
+{
+    std::string const branchName(prefix + "_" + column.name);
+    std::string leafList(branchName);
+
+    if (column.width > 1)
+        leafList += "[" + std::to_string(column.width) + "]";
+
+    leafList += std::string("/") + typeCode;
+    tree->Branch(branchName.c_str(), column.buffer.data(), leafList.c_str());
+}
+
+
+template<typename T>
+template<typename V>
+void FlatRecord<T>::FillColumn(Column<V> &column, T const &object)
+{
+    for (unsigned j = 0; j < column.width; ++j)
+        column.buffer[j] = column.getter(object, j);
+}
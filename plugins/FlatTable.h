@@ -0,0 +1,261 @@
+#pragma once
+
+#include <TBranch.h>
+#include <TTree.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class FlatTable
+ * \brief Stores a collection of objects of type T in a tree using a flat columnar layout
+ *
+ * Instead of streaming std::vector<T> through the dictionary, the collection is written as a
+ * counter branch and a set of branches with arrays of fundamental types, one per property of the
+ * objects (a "column"). The counter is stored in branch "n_<prefix>", and a column with name
+ * "<name>" is stored in branch "<prefix>_<name>". A column can contain several values per object,
+ * in which case the corresponding branch is a two-dimensional array with a fixed second dimension.
+ *
+ * Columns are defined by the user with methods AddFloat, AddInt, and their versions for arrays.
+ * Values are obtained with the help of provided getters, so only the public interface of T is
+ * used. All columns must be defined before the table is booked. Getters of the columns can also
+ * be looked up by name, which allows to evaluate properties of objects without booking the table.
+ */
+template<typename T>
+class FlatTable
+{
+private:
+    /// Description and buffer of a column of values of type V
+    template<typename V>
+    struct Column
+    {
+        /// Name of the column, without the prefix
+        std::string name;
+
+        /// Number of values per object
+        unsigned width;
+
+        /// Function to obtain the value with the given index for an object
+        std::function<V(T const &, unsigned)> getter;
+
+        /// Buffer with values for all objects in the current event
+        std::vector<V> buffer;
+
+        /// Branch that stores the column
+        TBranch *branch;
+    };
+
+public:
+    /// Constructor from the prefix for names of all branches
+    FlatTable(std::string const &prefix);
+
+public:
+    /// Adds a column of floating-point values
+    void AddFloat(std::string const &name, std::function<float(T const &)> getter);
+
+    /// Adds a column of arrays of floating-point values with the given fixed size
+    void AddFloatArray(std::string const &name, unsigned width,
+      std::function<float(T const &, unsigned)> getter);
+
+    /// Adds a column of integer values
+    void AddInt(std::string const &name, std::function<int(T const &)> getter);
+
+    /// Adds a column of arrays of integer values with the given fixed size
+    void AddIntArray(std::string const &name, unsigned width,
+      std::function<int(T const &, unsigned)> getter);
+
+    /// Creates branches for the counter and all columns in the given tree
+    void Book(TTree *tree);
+
+    /**
+     * \brief Returns a function that evaluates the given column for an object
+     *
+     * For columns with several values per object, the value with the given index is returned. If
+     * the column is not defined or the index exceeds its width, an empty function is returned.
+     */
+    std::function<double(T const &)> FindGetter(std::string const &name, unsigned index = 0) const;
+
+    /// Fills buffers of all columns from the given collection of objects
+    void Fill(std::vector<T> const &objects);
+
+private:
+    /// Creates a branch for the given column
+    template<typename V>
+    void BookColumn(TTree *tree, Column<V> &column, char typeCode);
+
+    /**
+     * \brief Makes sure the buffers can hold values for the given number of objects
+     *
+     * If the buffers need to be reallocated, addresses of the branches are updated.
+     */
+    void Reserve(unsigned newCapacity);
+
+    /// Fills the buffer of the given column
+    template<typename V>
+    static void FillColumn(Column<V> &column, std::vector<T> const &objects);
+
+private:
+    /// Prefix for names of all branches
+    std::string prefix;
+
+    /// Number of objects in the current event
+    Int_t size;
+
+    /// Number of objects buffers of the columns can hold
+    unsigned capacity;
+
+    /// Columns of floating-point values
+    std::vector<Column<Float_t>> floatColumns;
+
+    /// Columns of integer values
+    std::vector<Column<Int_t>> intColumns;
+};
+
+
+template<typename T>
+FlatTable<T>::FlatTable(std::string const &prefix_):
+    prefix(prefix_),
+    size(0), capacity(0)
+{}
+
+
+template<typename T>
+void FlatTable<T>::AddFloat(std::string const &name, std::function<float(T const &)> getter)
+{
+    floatColumns.push_back({name, 1, [getter](T const &obj, unsigned){return getter(obj);}, {},
+      nullptr});
+}
+
+
+template<typename T>
+void FlatTable<T>::AddFloatArray(std::string const &name, unsigned width,
+  std::function<float(T const &, unsigned)> getter)
+{
+    floatColumns.push_back({name, width, getter, {}, nullptr});
+}
+
+
+template<typename T>
+void FlatTable<T>::AddInt(std::string const &name, std::function<int(T const &)> getter)
+{
+    intColumns.push_back({name, 1, [getter](T const &obj, unsigned){return getter(obj);}, {},
+      nullptr});
+}
+
+
+template<typename T>
+void FlatTable<T>::AddIntArray(std::string const &name, unsigned width,
+  std::function<int(T const &, unsigned)> getter)
+{
+    intColumns.push_back({name, width, getter, {}, nullptr});
+}
+
+
+template<typename T>
+void FlatTable<T>::Book(TTree *tree)
+{
+    std::string const counterName("n_" + prefix);
+    tree->Branch(counterName.c_str(), &size, (counterName + "/I").c_str());
+
+    // Allocate buffers for a reasonable number of objects. They will be extended if needed.
+    Reserve(16);
+
+    for (auto &column: floatColumns)
+        BookColumn(tree, column, 'F');
+
+    for (auto &column: intColumns)
+        BookColumn(tree, column, 'I');
+}
+
+
+template<typename T>
+std::function<double(T const &)> FlatTable<T>::FindGetter(std::string const &name,
+  unsigned index) const
+{
+    for (auto const &column: floatColumns)
+        if (column.name == name and index < column.width)
+        {
+            auto const getter = column.getter;
+            return [getter, index](T const &obj){return getter(obj, index);};
+        }
+
+    for (auto const &column: intColumns)
+        if (column.name == name and index < column.width)
+        {
+            auto const getter = column.getter;
+            return [getter, index](T const &obj){return getter(obj, index);};
+        }
+
+    return {};
+}
+
+
+template<typename T>
+void FlatTable<T>::Fill(std::vector<T> const &objects)
+{
+    size = objects.size();
+
+    if (objects.size() > capacity)
+        Reserve(2 * objects.size());
+
+    for (auto &column: floatColumns)
+        FillColumn(column, objects);
+
+    for (auto &column: intColumns)
+        FillColumn(column, objects);
+}
+
+
+template<typename T>
+template<typename V>
+void FlatTable<T>::BookColumn(TTree *tree, Column<V> &column, char typeCode)
+{
+    std::string const branchName(prefix + "_" + column.name);
+    std::string leafList(branchName + "[n_" + prefix + "]");
+
+    if (column.width > 1)
+        leafList += "[" + std::to_string(column.width) + "]";
+
+    leafList += std::string("/") + typeCode;
+    column.branch = tree->Branch(branchName.c_str(), column.buffer.data(), leafList.c_str());
+}
+
+
+template<typename T>
+void FlatTable<T>::Reserve(unsigned newCapacity)
+{
+    if (newCapacity <= capacity)
+        return;
+
+    capacity = newCapacity;
+
+    for (auto &column: floatColumns)
+    {
+        column.buffer.resize(capacity * column.width);
+
+        if (column.branch)
+            column.branch->SetAddress(column.buffer.data());
+    }
+
+    for (auto &column: intColumns)
+    {
+        column.buffer.resize(capacity * column.width);
+
+        if (column.branch)
+            column.branch->SetAddress(column.buffer.data());
+    }
+}
+
+
+template<typename T>
+template<typename V>
+void FlatTable<T>::FillColumn(Column<V> &column, std::vector<T> const &objects)
+{
+    V *out = column.buffer.data();
+
+    for (auto const &obj: objects)
+        for (unsigned j = 0; j < column.width; ++j, ++out)
+            *out = column.getter(obj, j);
+}
@@ -0,0 +1,100 @@
+#include "GeneratorContextProducer.h"
+
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+
+#include <memory>
+
+
+using namespace edm;
+using namespace std;
+
+
+GeneratorContextProducer::GeneratorContextProducer(ParameterSet const &cfg):
+    rescaleLHEWeights(cfg.getParameter<bool>("rescaleLHEWeights")),
+    computeAltLHEWeights(cfg.getParameter<bool>("computeAltLHEWeights"))
+{
+    generatorToken = consumes<GenEventInfoProduct>(cfg.getParameter<InputTag>("generator"));
+    
+    InputTag const lheEventInfoTag(cfg.getParameter<InputTag>("lheEventProduct"));
+    readLHEEventRecord = (lheEventInfoTag.label() != "");
+    
+    if (readLHEEventRecord)
+        lheEventInfoToken = consumes<LHEEventProduct>(lheEventInfoTag);
+    
+    produces<pec::GeneratorContext>();
+}
+
+
+void GeneratorContextProducer::fillDescriptions(ConfigurationDescriptions &descriptions)
+{
+    ParameterSetDescription desc;
+    desc.add<InputTag>("generator", InputTag("generator"))->
+      setComment("Tag to access GenEventInfoProduct.");
+    desc.add<InputTag>("lheEventProduct", InputTag("externalLHEProducer"))->
+      setComment("Tag to access LHEEventProduct. An empty value (\"\") is allowed.");
+    desc.add<bool>("rescaleLHEWeights", true)->
+      setComment("Requires that LHE weights are rescaled taking into account the weight from "
+        "GenEventInfoProduct.");
+    desc.add<bool>("computeAltLHEWeights", true)->
+      setComment("Indicates whether alternative LHE weights should be provided.");
+    
+    descriptions.add("generatorContext", desc);
+}
+
+
+void GeneratorContextProducer::produce(Event &event, EventSetup const &)
+{
+    unique_ptr<pec::GeneratorContext> context(new pec::GeneratorContext);
+    
+    Handle<GenEventInfoProduct> generator;
+    event.getByToken(generatorToken, generator);
+    
+    context->SetNominalWeight(generator->weight());
+    
+    
+    // Process ID and LHE weights
+    if (readLHEEventRecord)
+    {
+        Handle<LHEEventProduct> lheEventInfo;
+        event.getByToken(lheEventInfoToken, lheEventInfo);
+        
+        context->SetProcessId(lheEventInfo->hepeup().IDPRUP);
+        
+        double const factor = (rescaleLHEWeights) ?
+          generator->weight() / lheEventInfo->originalXWGTUP() : 1.;
+        context->SetLheNominalWeight(lheEventInfo->originalXWGTUP() * factor, factor);
+        
+        if (computeAltLHEWeights)
+        {
+            vector<gen::WeightsInfo> const &altWeights = lheEventInfo->weights();
+            vector<double> &storeWeights = context->AltLheWeights();
+            storeWeights.resize(altWeights.size());
+            
+            for (unsigned i = 0; i < altWeights.size(); ++i)
+                storeWeights[i] = altWeights[i].wgt * factor;
+        }
+    }
+    else
+        context->SetProcessId(generator->signalProcessID());
+    
+    
+    // Parton shower weights
+    context->AltPsWeights() = generator->weights();
+    
+    
+    // PDF information
+    GenEventInfoProduct::PDF const *pdf = generator->pdf();
+    
+    if (pdf)
+        context->SetPdf(pdf->x.first, pdf->x.second, pdf->id.first, pdf->id.second,
+          pdf->scalePDF);
+    
+    
+    event.put(move(context));
+}
+
+
+DEFINE_FWK_MODULE(GeneratorContextProducer);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <FWCore/Framework/interface/stream/EDProducer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h>
+#include <SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h>
+
+
+/**
+ * \class GeneratorContextProducer
+ * \brief Puts generator-level information shared by several plugins into the event
+ * 
+ * Reads GenEventInfoProduct and, if a non-empty input tag is given, LHEEventProduct, and puts into
+ * the event an object of type pec::GeneratorContext. The process ID is read from the LHE record if
+ * it is available and from GenEventInfoProduct otherwise. If flag rescaleLHEWeights is true, the
+ * nominal and alternative LHE weights are rescaled by the ratio between the nominal weights from
+ * GenEventInfoProduct and LHEEventProduct, as instructed in [1]. Alternative LHE weights are only
+ * copied if flag computeAltLHEWeights is true.
+ * [1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW?rev=7#How_to_use_weights
+ * 
+ * Plugins ProcessIDFilter, EventCounter, PECGenerator, and LHEEventWeights read this product
+ * instead of accessing the generator-level products directly, so that the rescaling and the
+ * conversion of weights are done only once per event.
+ * 
+ * This plugin must be only run on simulation.
+ */
+class GeneratorContextProducer: public edm::stream::EDProducer<>
+{
+public:
+    /// Constructor
+    GeneratorContextProducer(edm::ParameterSet const &cfg);
+    
+public:
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+    
+    /// Puts generator-level information into the event
+    virtual void produce(edm::Event &event, edm::EventSetup const &) override;
+    
+private:
+    /// Token to access global generator information
+    edm::EDGetTokenT<GenEventInfoProduct> generatorToken;
+    
+    /// Token to access per-event LHE information
+    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
+    
+    /// Indicates whether LHE event record should be read
+    bool readLHEEventRecord;
+    
+    /// Indicates whether LHE weights should be rescaled to the weight from GenEventInfoProduct
+    bool rescaleLHEWeights;
+    
+    /// Indicates whether alternative LHE weights should be copied
+    bool computeAltLHEWeights;
+};
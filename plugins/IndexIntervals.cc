@@ -86,6 +86,31 @@ IndexIntervals::IndexIntervals(std::vector<index_t> edges)
 }
 
 
+void IndexIntervals::Compile(index_t min, index_t max, Compiled &compiled) const
+{
+    compiled.ranges.clear();
+    compiled.size = 0;
+
+    for (auto const &interval: intervals)
+    {
+        index_t const begin = std::max(interval.first, min);
+        index_t const last = std::min(interval.second, max);
+
+        if (begin > last)
+            continue;
+
+        index_t const end = last + 1;
+
+        if (not compiled.ranges.empty() and compiled.ranges.back().second == begin)
+            compiled.ranges.back().second = end;
+        else
+            compiled.ranges.emplace_back(begin, end);
+
+        compiled.size += end - begin;
+    }
+}
+
+
 unsigned IndexIntervals::NumberIndices(index_t min, index_t max) const
 {
     if (Empty())
@@ -11,7 +11,9 @@
  *
  * Allows to test whether a given index is contained within one of the included intervals (using
  * method \ref Contain). Provides means to iterate over all indices in all intervals (method
- * \ref GetIndices).
+ * \ref GetIndices). For tight loops the intervals can be compiled for a given range of indices
+ * (method \ref Compile) into a list of contiguous ranges, which are visited without checking
+ * interval boundaries for each index.
  */
 class IndexIntervals
 {
@@ -90,6 +92,65 @@ public:
         std::vector<interval_t>::const_iterator beginIntervalIt;
     };
 
+    /**
+     * \brief Intervals restricted to a given range of indices
+     *
+     * Indices are stored as a list of non-empty half-open ranges [begin, end), sorted in the
+     * increasing order. Adjacent intervals are merged into a single range.
+     */
+    class Compiled
+    {
+        friend class IndexIntervals;
+
+    public:
+        /**
+         * \brief Calls the given function for each index
+         *
+         * The function must accept an argument of type index_t. Indices are visited in the
+         * increasing order.
+         */
+        template<typename F>
+        void ForEach(F &&f) const
+        {
+            for (auto const &range: ranges)
+                for (index_t index = range.first; index < range.second; ++index)
+                    f(index);
+        }
+
+        /**
+         * \brief Copies selected elements of the source array into the destination array
+         *
+         * The destination array must have space for Size() elements. Elements are converted
+         * with the given function, which must accept an element of the source array.
+         */
+        template<typename Src, typename Dst, typename F>
+        void Gather(Src const *src, Dst *dst, F &&transform) const
+        {
+            for (auto const &range: ranges)
+                for (index_t index = range.first; index < range.second; ++index, ++dst)
+                    *dst = transform(src[index]);
+        }
+
+        /// Returns half-open ranges of indices
+        std::vector<interval_t> const &Ranges() const
+        {
+            return ranges;
+        }
+
+        /// Returns the total number of indices
+        unsigned Size() const
+        {
+            return size;
+        }
+
+    private:
+        /// Half-open ranges of indices
+        std::vector<interval_t> ranges;
+
+        /// Total number of indices
+        unsigned size = 0;
+    };
+
 public:
     /**
      * \brief Constructor from edges of intervals
@@ -103,6 +164,14 @@ public:
      */
     IndexIntervals(std::vector<index_t> edges);
 
+    /**
+     * \brief Restricts intervals to the given range and compiles them into a list of ranges
+     *
+     * The boundaries of the range are included, and max must be smaller than the largest value of
+     * index_t. The result is written into the given object, whose memory is reused.
+     */
+    void Compile(index_t min, index_t max, Compiled &compiled) const;
+
     /// Checks if given index is contained in one of the intervals
     bool Contain(index_t index) const
     {
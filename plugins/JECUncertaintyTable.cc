@@ -0,0 +1,141 @@
+#include "JECUncertaintyTable.h"
+
+#include <CondFormats/JetMETObjects/interface/JetCorrectorParameters.h>
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <algorithm>
+#include <fstream>
+
+
+JECUncertaintyTable::JECUncertaintyTable(std::string const &fileName,
+  std::vector<std::string> sourceNames)
+{
+    if (sourceNames.empty())
+        sourceNames = ReadSectionNames(fileName);
+
+    if (sourceNames.empty())
+    {
+        cms::Exception excp("Configuration");
+        excp << "File \"" << fileName << "\" contains no sources of JEC uncertainty.";
+        excp.raise();
+    }
+
+
+    for (auto const &name: sourceNames)
+    {
+        JetCorrectorParameters const parameters(fileName, name);
+
+        if (parameters.definitions().nBinVar() != 1 or
+          parameters.definitions().binVar(0) != "JetEta")
+        {
+            cms::Exception excp("Configuration");
+            excp << "Source \"" << name << "\" of JEC uncertainty in file \"" << fileName <<
+              "\" is not binned in jet pseudorapidity only.";
+            excp.raise();
+        }
+
+
+        // Extract the grid of this source. Each record gives nodes in pt followed by the up and
+        //down variations: (pt, up, down) for each node.
+        std::vector<float> curEtaEdges, curPtNodes;
+        Source source;
+        source.name = name;
+
+        for (unsigned iRecord = 0; iRecord < parameters.size(); ++iRecord)
+        {
+            auto const &record = parameters.record(iRecord);
+
+            if (iRecord == 0)
+                curEtaEdges.emplace_back(record.xMin(0));
+
+            curEtaEdges.emplace_back(record.xMax(0));
+            std::vector<float> recordPtNodes;
+
+            for (unsigned i = 0; i + 2 < record.nParameters(); i += 3)
+            {
+                recordPtNodes.emplace_back(record.parameter(i));
+                source.up.emplace_back(record.parameter(i + 1));
+                source.down.emplace_back(record.parameter(i + 2));
+            }
+
+            if (iRecord == 0)
+                curPtNodes = recordPtNodes;
+            else if (recordPtNodes != curPtNodes)
+            {
+                cms::Exception excp("Configuration");
+                excp << "Nodes in jet pt for source \"" << name << "\" of JEC uncertainty in " <<
+                  "file \"" << fileName << "\" differ between bins in pseudorapidity.";
+                excp.raise();
+            }
+        }
+
+
+        // Make sure that all sources share the same grid, and the indices fit into 8 bits
+        if (sources.empty())
+        {
+            etaEdges = curEtaEdges;
+            ptNodes = curPtNodes;
+
+            if (etaEdges.size() < 2 or ptNodes.empty() or etaEdges.size() - 1 > 256 or
+              ptNodes.size() > 256)
+            {
+                cms::Exception excp("Configuration");
+                excp << "Source \"" << name << "\" of JEC uncertainty in file \"" << fileName <<
+                  "\" defines " << etaEdges.size() - 1 << " bins in pseudorapidity and " <<
+                  ptNodes.size() << " nodes in pt, while between 1 and 256 are supported.";
+                excp.raise();
+            }
+        }
+        else if (curEtaEdges != etaEdges or curPtNodes != ptNodes)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Source \"" << name << "\" of JEC uncertainty in file \"" << fileName <<
+              "\" is defined on a grid different from that of source \"" << sources.front().name <<
+              "\".";
+            excp.raise();
+        }
+
+        sources.emplace_back(std::move(source));
+    }
+}
+
+
+std::pair<unsigned, unsigned> JECUncertaintyTable::FindBins(double eta, double pt) const
+{
+    // Edges are sorted, so the bins are found with a binary search and clamped to the valid range
+    unsigned const numEtaBins = etaEdges.size() - 1;
+    unsigned etaBin = std::upper_bound(etaEdges.begin(), etaEdges.end(), eta) - etaEdges.begin();
+    etaBin = std::min(std::max(etaBin, 1u), numEtaBins) - 1;
+
+    unsigned ptNode = std::upper_bound(ptNodes.begin(), ptNodes.end(), pt) - ptNodes.begin();
+    ptNode = (ptNode == 0) ? 0 : ptNode - 1;
+
+    return {etaBin, ptNode};
+}
+
+
+std::vector<std::string> JECUncertaintyTable::ReadSectionNames(std::string const &fileName)
+{
+    std::ifstream file(fileName);
+
+    if (not file)
+    {
+        cms::Exception excp("Configuration");
+        excp << "Cannot open file \"" << fileName << "\".";
+        excp.raise();
+    }
+
+    std::vector<std::string> names;
+    std::string line;
+
+    // Sections start with lines of the form "[name]"
+    while (std::getline(file, line))
+    {
+        auto const end = line.find(']');
+
+        if (not line.empty() and line.front() == '[' and end != std::string::npos)
+            names.emplace_back(line.substr(1, end - 1));
+    }
+
+    return names;
+}
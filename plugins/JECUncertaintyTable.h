@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * \class JECUncertaintyTable
+ * \brief Tabulated sources of JEC uncertainty on a common grid
+ *
+ * The tables are read from a text file with the standard format of JEC uncertainty sources [1],
+ * which contains one section per source. For each bin in jet pseudorapidity, a source defines
+ * the relative uncertainty (separately for the up and down variations) at a number of nodes in
+ * corrected jet pt. All sources in the file are required to share the same bins in pseudorapidity
+ * and the same nodes in pt, which is the case for the official files. Then the uncertainty due to
+ * any source for a given jet is fully determined by the index of the pseudorapidity bin and the
+ * index of the pt node below the jet pt: it is obtained with a linear interpolation between this
+ * node and the next one, as done by JetCorrectionUncertainty, and the nodes at the ends of the
+ * range are used for jets outside of it. This allows to evaluate all sources downstream with a
+ * table lookup, storing only the two indices for each jet.
+ *
+ * Both indices must fit into 8 bits. An exception is thrown if this is not the case or the grids
+ * of the sources differ.
+ *
+ * [1] https://twiki.cern.ch/twiki/bin/view/CMS/JECUncertaintySources?rev=19
+ */
+class JECUncertaintyTable
+{
+public:
+    /// Uncertainties due to a single source
+    struct Source
+    {
+        /// Name of the source
+        std::string name;
+
+        /**
+         * \brief Relative uncertainties for up and down variations
+         *
+         * Values are ordered by the index of the pseudorapidity bin and then by the index of the
+         * pt node, i.e. index etaBin * NumPtNodes() + ptNode.
+         */
+        std::vector<float> up, down;
+    };
+
+public:
+    /**
+     * \brief Constructor
+     *
+     * Reads the given sources from the file. If the vector of names is empty, all sources in the
+     * file are read.
+     */
+    JECUncertaintyTable(std::string const &fileName, std::vector<std::string> sourceNames = {});
+
+public:
+    /// Returns edges of bins in jet pseudorapidity
+    std::vector<float> const &EtaEdges() const
+    {
+        return etaEdges;
+    }
+
+    /**
+     * \brief Finds the pseudorapidity bin and the pt node below the given jet pt
+     *
+     * Values outside of the range are attributed to the outermost bins and nodes.
+     */
+    std::pair<unsigned, unsigned> FindBins(double eta, double pt) const;
+
+    /// Returns the number of nodes in jet pt
+    unsigned NumPtNodes() const
+    {
+        return ptNodes.size();
+    }
+
+    /// Returns nodes in corrected jet pt
+    std::vector<float> const &PtNodes() const
+    {
+        return ptNodes;
+    }
+
+    /// Returns tables for all read sources
+    std::vector<Source> const &Sources() const
+    {
+        return sources;
+    }
+
+private:
+    /// Returns names of all sections in the given file
+    static std::vector<std::string> ReadSectionNames(std::string const &fileName);
+
+private:
+    std::vector<float> etaEdges;
+    std::vector<float> ptNodes;
+    std::vector<Source> sources;
+};
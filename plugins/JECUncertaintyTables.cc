@@ -0,0 +1,66 @@
+#include "JECUncertaintyTables.h"
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/ParameterSet/interface/FileInPath.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <TTree.h>
+
+#include <string>
+#include <vector>
+
+
+JECUncertaintyTables::JECUncertaintyTables(edm::ParameterSet const &cfg):
+    table(cfg.getParameter<edm::FileInPath>("jecUncertaintySources").fullPath(),
+      cfg.getParameter<std::vector<std::string>>("sourceNames"))
+{
+    usesResource("TFileService");
+}
+
+
+void JECUncertaintyTables::beginJob()
+{
+    // The trees are only filled here, so they must not refer to the local buffers afterwards
+    TTree *gridTree = fileService->make<TTree>("Grid", "Grid of JEC uncertainty sources");
+    std::vector<float> etaEdges(table.EtaEdges()), ptNodes(table.PtNodes());
+    gridTree->Branch("etaEdges", &etaEdges);
+    gridTree->Branch("ptNodes", &ptNodes);
+    gridTree->Fill();
+    gridTree->ResetBranchAddresses();
+
+    TTree *sourcesTree = fileService->make<TTree>("Sources", "JEC uncertainty sources");
+    std::string name;
+    std::vector<float> up, down;
+    sourcesTree->Branch("name", &name);
+    sourcesTree->Branch("up", &up);
+    sourcesTree->Branch("down", &down);
+
+    for (auto const &source: table.Sources())
+    {
+        name = source.name;
+        up = source.up;
+        down = source.down;
+        sourcesTree->Fill();
+    }
+
+    sourcesTree->ResetBranchAddresses();
+}
+
+
+void JECUncertaintyTables::analyze(edm::Event const &, edm::EventSetup const &)
+{}
+
+
+void JECUncertaintyTables::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription desc;
+    desc.add<edm::FileInPath>("jecUncertaintySources")->
+      setComment("File with sources of JEC uncertainty.");
+    desc.add<std::vector<std::string>>("sourceNames", std::vector<std::string>())->
+      setComment("Sources to save. If empty, all sources in the file are saved.");
+
+    descriptions.add("jecUncertaintyTables", desc);
+}
+
+
+DEFINE_FWK_MODULE(JECUncertaintyTables);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "JECUncertaintyTable.h"
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+
+/**
+ * \class JECUncertaintyTables
+ * \brief Saves tables of JEC uncertainty sources
+ *
+ * The tables are read from the file given by parameter "jecUncertaintySources" (see class
+ * JECUncertaintyTable). If parameter "sourceNames" is not empty, only the listed sources are
+ * read. The plugin writes two trees in its directory. Tree "Grid" contains a single entry with
+ * edges of bins in jet pseudorapidity ("etaEdges") and nodes in corrected jet pt ("ptNodes").
+ * Tree "Sources" contains one entry per source, with its name ("name") and relative uncertainties
+ * for the up and down variations ("up" and "down"). The latter are ordered as described in the
+ * documentation for JECUncertaintyTable::Source. Together with indices stored for each jet by
+ * plugin PECJetMET, this allows to evaluate all sources without rereading the original file.
+ *
+ * The tables are written once, at the beginning of the job, since they do not depend on the
+ * conditions.
+ */
+class JECUncertaintyTables: public edm::one::EDAnalyzer<edm::one::SharedResources>
+{
+public:
+    /// Constructor
+    JECUncertaintyTables(edm::ParameterSet const &cfg);
+
+public:
+    /// Writes the tables
+    virtual void beginJob() override;
+
+    /// Does nothing
+    virtual void analyze(edm::Event const &, edm::EventSetup const &) override;
+
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+private:
+    /// Tables of uncertainty sources
+    JECUncertaintyTable const table;
+
+    /// An object to handle the output ROOT file
+    edm::Service<TFileService> fileService;
+};
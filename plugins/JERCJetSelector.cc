@@ -7,8 +7,9 @@
 #include <FWCore/Utilities/interface/Exception.h>
 #include <FWCore/Utilities/interface/InputTag.h>
 
+#include <DataFormats/Common/interface/PtrVector.h>
+#include <DataFormats/Common/interface/ValueMap.h>
 #include <CondFormats/JetMETObjects/interface/JetCorrectorParameters.h>
-#include <JetMETCorrections/Objects/interface/JetCorrectionsRecord.h>
 
 #include <CLHEP/Random/RandGaussQ.h>
 
@@ -20,21 +21,36 @@
 
 
 JERCJetSelector::JERCJetSelector(edm::ParameterSet const &cfg):
-    edm::EDFilter(),
     preselector(cfg.getParameter<std::string>("preselection")),
+    jetID(cfg.getParameter<std::vector<edm::ParameterSet>>("jetID")),
     minPt(cfg.getParameter<double>("minPt")),
     minRawPt(cfg.getParameter<double>("minRawPt")),
     minNumJets(cfg.getParameter<unsigned>("minNum")),
+    lightOutput(cfg.getParameter<bool>("lightOutput")),
     includeJERCVariations(cfg.getParameter<bool>("includeJERCVariations")),
     jetTypeLabel(cfg.getParameter<std::string>("jetTypeLabel")),
     jetConeSize(cfg.getParameter<double>("jetConeSize")),
-    nSigmaJERUnmatched(std::abs(cfg.getParameter<double>("nSigmaJERUnmatched")))
+    deterministicSmearing(cfg.getParameter<bool>("deterministicSmearing")),
+    smearingSeed(cfg.getParameter<unsigned>("seed")),
+    nSigmaJERUnmatched(std::abs(cfg.getParameter<double>("nSigmaJERUnmatched"))),
+    genJetGrid(jetConeSize / 2.)
 {
     jetToken = consumes<edm::View<pat::Jet>>(cfg.getParameter<edm::InputTag>("src"));
     genJetToken = consumes<edm::View<reco::GenJet>>(cfg.getParameter<edm::InputTag>("genJets"));
-    rhoToken = consumes<double>(cfg.getParameter<edm::InputTag>("rho"));
+    contextToken = consumes<pec::RecoContext>(cfg.getParameter<edm::InputTag>("recoContext"));
     
-    produces<std::vector<pat::Jet>>();
+    if (lightOutput)
+    {
+        produces<edm::PtrVector<pat::Jet>>();
+        
+        for (auto const &label: floatMapLabels)
+            produces<edm::ValueMap<float>>(label);
+        
+        produces<edm::ValueMap<int>>("hasGenMatch");
+        floatValues.resize(floatMapLabels.size());
+    }
+    else
+        produces<std::vector<pat::Jet>>();
 }
 
 
@@ -46,17 +62,25 @@ void JERCJetSelector::fillDescriptions(edm::ConfigurationDescriptions &descripti
       setComment("Jet type label for JES and JER corrections.");
     desc.add<double>("jetConeSize", 0.4)->setComment("Jet cone size.");
     desc.add<std::string>("preselection", "")->setComment("Preselection for jets.");
+    desc.addVPSet("jetID", PFJetID::GetRegionDescription(), std::vector<edm::ParameterSet>())->
+      setComment("Regions of PF jet ID included in the preselection. Empty to disable.");
     desc.add<double>("minPt")->setComment("Cut on jet pt.");
     desc.add<double>("minRawPt", 9999.)->setComment("Cut on jet raw pt.");
     desc.add<bool>("includeJERCVariations", true)->
       setComment("Indicates whether variations in JEC and JER should be considered.");
     desc.add<edm::InputTag>("genJets")->setComment("GEN-level jets.");
-    desc.add<edm::InputTag>("rho")->setComment("Rho (mean angular pt density).");
+    desc.add<edm::InputTag>("recoContext", edm::InputTag("recoContext"))->
+      setComment("Event-level reconstructed information, which provides rho.");
     desc.add<double>("nSigmaJERUnmatched", 3.)->
       setComment("JER variation to be used to choose jets without GEN-level matches.");
     desc.add<unsigned>("minNum", 0)->
       setComment("Minimal number of selected jets to accept an event.");
-    desc.add<unsigned>("seed", 0)->setComment("Seed for random number generator.");
+    desc.add<bool>("deterministicSmearing", false)->
+      setComment("Derive random numbers for JER smearing from event ID and jet index.");
+    desc.add<unsigned>("seed", 0)->
+      setComment("Seed for random number generator used with deterministic smearing.");
+    desc.add<bool>("lightOutput", false)->
+      setComment("Requests that selected jets are stored as a PtrVector with value maps.");
     
     descriptions.add("jetSelector", desc);
 }
@@ -64,20 +88,34 @@ void JERCJetSelector::fillDescriptions(edm::ConfigurationDescriptions &descripti
 
 void JERCJetSelector::beginRun(edm::Run const &, edm::EventSetup const &setup)
 {
-    // Construct an object to obtain JEC uncertainty [1]
+    // Construct an object to obtain JEC uncertainty [1]. This is only done when the conditions
+    //have changed since the previous run.
     //[1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/WorkBookJetEnergyCorrections?rev=137#JetCorUncertainties
-    edm::ESHandle<JetCorrectorParametersCollection> jecParametersCollection;
-    setup.get<JetCorrectionsRecord>().get(jetTypeLabel, jecParametersCollection); 
+    if (jecWatcher.check(setup) or not jecUncProvider)
+    {
+        edm::ESHandle<JetCorrectorParametersCollection> jecParametersCollection;
+        setup.get<JetCorrectionsRecord>().get(jetTypeLabel, jecParametersCollection); 
+        
+        JetCorrectorParameters const &jecParameters = (*jecParametersCollection)["Uncertainty"];
+        jecUncProvider.reset(new JetCorrectionUncertainty(jecParameters));
+    }
     
-    JetCorrectorParameters const &jecParameters = (*jecParametersCollection)["Uncertainty"];
-    jecUncProvider.reset(new JetCorrectionUncertainty(jecParameters));
     
+    // Objects that provide jet energy resolution and its scale factors. Lookup tables are rebuilt
+    //whenever any of them changes.
+    bool const jerChanged = (jerWatcher.check(setup) or not jerProvider);
+    bool const jerSFChanged = (jerSFWatcher.check(setup) or not jerSFProvider);
     
-    // Objects that provide jet energy resolution and its scale factors
-    jerProvider.reset(
-      new JME::JetResolution(std::move(JME::JetResolution::get(setup, jetTypeLabel + "_pt"))));
-    jerSFProvider.reset(new JME::JetResolutionScaleFactor(
-      std::move(JME::JetResolutionScaleFactor::get(setup, jetTypeLabel))));
+    if (jerChanged)
+        jerProvider.reset(new JME::JetResolution(
+          std::move(JME::JetResolution::get(setup, jetTypeLabel + "_pt"))));
+    
+    if (jerSFChanged)
+        jerSFProvider.reset(new JME::JetResolutionScaleFactor(
+          std::move(JME::JetResolutionScaleFactor::get(setup, jetTypeLabel))));
+    
+    if (jerChanged or jerSFChanged)
+        jerLookup.reset(new JERLookup(*jerProvider, *jerSFProvider));
 }
 
 
@@ -88,19 +126,31 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
     edm::Handle<edm::View<pat::Jet>> srcJets;
     event.getByToken(jetToken, srcJets);
     
-    edm::Handle<double> rho;
+    double rho = 0.;
+    
     if (includeJERCVariations)
-        event.getByToken(rhoToken, rho);
+    {
+        edm::Handle<pec::RecoContext> context;
+        event.getByToken(contextToken, context);
+        rho = context->Rho();
+    }
     
     edm::Handle<edm::View<reco::GenJet>> genJets;
+    genJetGrid.Clear();
+    
     if (includeJERCVariations and not event.isRealData())
+    {
         event.getByToken(genJetToken, genJets);
+        
+        for (auto const &genJet: *genJets)
+            genJetGrid.Insert(genJet.eta(), genJet.phi());
+    }
     
     
     // Get random-number engine
     CLHEP::HepRandomEngine *randomNumberEngine = nullptr;
     
-    if (includeJERCVariations and not event.isRealData())
+    if (includeJERCVariations and not event.isRealData() and not deterministicSmearing)
     {
         if (not rGenService.isAvailable())
         {
@@ -113,12 +163,41 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
     }
     
     
-    // Build a collection of jets passing the selection
-    std::unique_ptr<std::vector<pat::Jet>> selectedJets(new std::vector<pat::Jet>);
+    // Build a collection of jets passing the selection. Depending on the configuration, either
+    //the jets are copied or pointers to them are stored together with their additional
+    //properties.
+    std::unique_ptr<std::vector<pat::Jet>> selectedJets;
+    std::unique_ptr<edm::PtrVector<pat::Jet>> selectedJetPtrs;
+    
+    if (lightOutput)
+    {
+        selectedJetPtrs.reset(new edm::PtrVector<pat::Jet>);
+        
+        // All values are initialized with the defaults used when variations are not evaluated.
+        //The buffers keep their capacity from previous events.
+        floatValues[0].assign(srcJets->size(), 0.f);
+        
+        for (unsigned i = 1; i < floatMapLabels.size(); ++i)
+            floatValues[i].assign(srcJets->size(), 1.f);
+        
+        hasGenMatchValues.assign(srcJets->size(), 0);
+    }
+    else
+    {
+        // The collection is a product and must be allocated anew, but reserve enough space so that
+        //expensive copies of jets are not repeated on reallocations
+        selectedJets.reset(new std::vector<pat::Jet>);
+        selectedJets->reserve(srcJets->size());
+    }
+    
+    std::vector<std::uint8_t> const *passJetID =
+      (jetID.IsEnabled()) ? &jetID.Evaluate(*srcJets) : nullptr;
     
-    for (auto const &j: *srcJets)
+    for (unsigned iJet = 0; iJet < srcJets->size(); ++iJet)
     {
-        if (not preselector(j))
+        pat::Jet const &j = srcJets->at(iJet);
+        
+        if (not preselector(j) or (passJetID and not (*passJetID)[iJet]))
             continue;
         
         
@@ -145,16 +224,12 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
             if (not event.isRealData())
             {
                 // JER pt resolution (relative) and scale factors
-                double const ptResolution =
-                  jerProvider->getResolution({{JME::Binning::JetPt, j.pt()},
-                  {JME::Binning::JetEta, j.eta()}, {JME::Binning::Rho, *rho}});
+                double const ptResolution = jerLookup->GetResolution(j.pt(), j.eta(), rho);
                 
-                double const jerSFNominal = jerSFProvider->getScaleFactor(
-                  {{JME::Binning::JetEta, j.eta()}}, Variation::NOMINAL);
-                double const jerSFUp = jerSFProvider->getScaleFactor(
-                  {{JME::Binning::JetEta, j.eta()}}, Variation::UP);
-                double const jerSFDown = jerSFProvider->getScaleFactor(
-                  {{JME::Binning::JetEta, j.eta()}}, Variation::DOWN);
+                JERLookup::ScaleFactors const jerSF = jerLookup->GetScaleFactors(j.eta());
+                double const jerSFNominal = jerSF.nominal;
+                double const jerSFUp = jerSF.up;
+                double const jerSFDown = jerSF.down;
                 
                 
                 // Try to match the current jet to a generator-level one.  The maximal pt
@@ -183,8 +258,19 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
                     //for the systematical variations. Otherwise the variations would also include
                     //the effect of resampling and not just the shift in the scale factor.
                     //[1] https://github.com/cms-sw/cmssw/blob/CMSSW_8_0_18/PhysicsTools/PatUtils/interface/SmearedJetProducerT.h#L244-L250
-                    double const mcShift = CLHEP::RandGaussQ::shoot(randomNumberEngine,
-                      0., ptResolution);
+                    double mcShift;
+                    
+                    if (deterministicSmearing)
+                    {
+                        edm::EventID const &id = event.id();
+                        PhiloxRandom const generator(
+                          (std::uint64_t(iJet) << 32) | smearingSeed);
+                        mcShift = ptResolution * generator.Gauss({{
+                          std::uint32_t(id.event()), std::uint32_t(id.event() >> 32),
+                          id.luminosityBlock(), id.run()}});
+                    }
+                    else
+                        mcShift = CLHEP::RandGaussQ::shoot(randomNumberEngine, 0., ptResolution);
                     
                     jerFactorNominal = 1. + mcShift *
                       std::sqrt(std::max(std::pow(jerSFNominal, 2) - 1., 0.));
@@ -205,20 +291,34 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
         }
         
         
-        // Copy the jet if it has a chance to pass one of the pt thresholds
+        // Select the jet if it has a chance to pass one of the pt thresholds
         double const jetPtUpVarFactor = std::max({1. + jecUncertainty, jerSafetyFactor});
         
+        if (lightOutput)
+        {
+            floatValues[0][iJet] = jecUncertainty;
+            floatValues[1][iJet] = jerFactorNominal;
+            floatValues[2][iJet] = jerFactorUp;
+            floatValues[3][iJet] = jerFactorDown;
+            hasGenMatchValues[iJet] = int(hasGenMatch);
+        }
+        
         if (j.pt() * jetPtUpVarFactor > minPt or j.correctedP4("Uncorrected").pt() > minRawPt)
         {
-            pat::Jet copyJet(j);
-            
-            copyJet.addUserFloat("jecUncertainty", jecUncertainty);
-            copyJet.addUserFloat("jerFactorNominal", jerFactorNominal);
-            copyJet.addUserFloat("jerFactorUp", jerFactorUp);
-            copyJet.addUserFloat("jerFactorDown", jerFactorDown);
-            copyJet.addUserInt("hasGenMatch", int(hasGenMatch));
-            
-            selectedJets->emplace_back(std::move(copyJet));
+            if (lightOutput)
+                selectedJetPtrs->push_back(srcJets->ptrAt(iJet));
+            else
+            {
+                pat::Jet copyJet(j);
+                
+                copyJet.addUserFloat("jecUncertainty", jecUncertainty);
+                copyJet.addUserFloat("jerFactorNominal", jerFactorNominal);
+                copyJet.addUserFloat("jerFactorUp", jerFactorUp);
+                copyJet.addUserFloat("jerFactorDown", jerFactorDown);
+                copyJet.addUserInt("hasGenMatch", int(hasGenMatch));
+                
+                selectedJets->emplace_back(std::move(copyJet));
+            }
         }
         
         
@@ -246,8 +346,34 @@ bool JERCJetSelector::filter(edm::Event &event, edm::EventSetup const &)
     
     
     // Evaluate the filter dicision and write selected jets into the event
-    bool const filterDecision = (selectedJets->size() >= minNumJets);
-    event.put(std::move(selectedJets));
+    bool filterDecision;
+    
+    if (lightOutput)
+    {
+        filterDecision = (selectedJetPtrs->size() >= minNumJets);
+        event.put(std::move(selectedJetPtrs));
+        
+        for (unsigned i = 0; i < floatMapLabels.size(); ++i)
+        {
+            std::unique_ptr<edm::ValueMap<float>> valueMap(new edm::ValueMap<float>);
+            edm::ValueMap<float>::Filler filler(*valueMap);
+            filler.insert(srcJets, floatValues[i].begin(), floatValues[i].end());
+            filler.fill();
+            event.put(std::move(valueMap), floatMapLabels[i]);
+        }
+        
+        std::unique_ptr<edm::ValueMap<int>> genMatchMap(new edm::ValueMap<int>);
+        edm::ValueMap<int>::Filler filler(*genMatchMap);
+        filler.insert(srcJets, hasGenMatchValues.begin(), hasGenMatchValues.end());
+        filler.fill();
+        event.put(std::move(genMatchMap), "hasGenMatch");
+    }
+    else
+    {
+        filterDecision = (selectedJets->size() >= minNumJets);
+        event.put(std::move(selectedJets));
+    }
+    
     return filterDecision;
 }
 
@@ -259,23 +385,29 @@ reco::GenJet const *JERCJetSelector::MatchGenJet(reco::Jet const &jet,
     double minDR2 = std::numeric_limits<double>::infinity();
     double const maxDR2 = jetConeSize * jetConeSize / 4.;
     
-    for (auto const &genJet: genJets)
-    {
-        double const dR2 = ROOT::Math::VectorUtil::DeltaR2(jet.p4(), genJet.p4());
-        
-        if (dR2 > maxDR2 or dR2 > minDR2)
-            continue;
-        
-        if (std::abs(jet.pt() - genJet.pt()) > maxDPt)
-            continue;
-        
-        minDR2 = dR2;
-        matchedJet = &genJet;
-    }
+    genJetGrid.ForEachNear(jet.eta(), jet.phi(), jetConeSize / 2.,
+      [&](unsigned index)
+      {
+          reco::GenJet const &genJet = genJets[index];
+          double const dR2 = ROOT::Math::VectorUtil::DeltaR2(jet.p4(), genJet.p4());
+          
+          if (dR2 > maxDR2 or dR2 > minDR2)
+              return;
+          
+          if (std::abs(jet.pt() - genJet.pt()) > maxDPt)
+              return;
+          
+          minDR2 = dR2;
+          matchedJet = &genJet;
+      });
     
     
     return matchedJet;
 }
 
 
+std::array<std::string, 4> const JERCJetSelector::floatMapLabels{{"jecUncertainty",
+  "jerFactorNominal", "jerFactorUp", "jerFactorDown"}};
+
+
 DEFINE_FWK_MODULE(JERCJetSelector);
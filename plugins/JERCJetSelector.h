@@ -1,19 +1,33 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDFilter.h>
+#include <Analysis/PECTuples/interface/RecoContext.h>
+#include "CompiledCut.h"
+#include "EtaPhiGrid.h"
+#include "JERLookup.h"
+#include "PFJetID.h"
+#include "PhiloxRandom.h"
+
+#include <FWCore/Framework/interface/stream/EDFilter.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/ESWatcher.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ServiceRegistry/interface/Service.h>
 #include <FWCore/Utilities/interface/RandomNumberGenerator.h>
 
+#include <CondFormats/DataRecord/interface/JetResolutionRcd.h>
+#include <CondFormats/DataRecord/interface/JetResolutionScaleFactorRcd.h>
 #include <CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
+#include <JetMETCorrections/Objects/interface/JetCorrectionsRecord.h>
 #include <DataFormats/JetReco/interface/GenJet.h>
 #include <DataFormats/PatCandidates/interface/Jet.h>
 #include <JetMETCorrections/Modules/interface/JetResolution.h>
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 
 /**
@@ -31,24 +45,45 @@
  * Jet variations can be switched off by setting flag "includeJERCVariations" to false. In this
  * case the plugin simply selects jets with pt larger than then given threshold. A string-based
  * preselection can be applied to jets (parameter "preselection"). Jets failing it are rejected
- * unconditionally. If the number of selected jets is less than the given value (parameter
- * "minNum", set to zero by default), the event is rejected.
+ * unconditionally. The same applies to the optional table-driven PF jet ID given by parameter
+ * "jetID" (see class PFJetID). If the number of selected jets is less than the given value
+ * (parameter "minNum", set to zero by default), the event is rejected.
  * 
  * Additional information is added to the produced collection of jets. JEC uncertainty and JER
  * factors are written as userFloats "jecUncertainty", "jerFactor[Nominal|Up|Down]", and a flag
  * indicating the presence of a matching generator-level jet is written as userInt "hasGenMatch".
  * The matching is performed as recommended in [1].
  * 
+ * Copying pat::Jet is expensive. If flag "lightOutput" is set to true, selected jets are not
+ * copied. Instead, the plugin produces an edm::PtrVector that points to selected jets in the
+ * source collection, and the additional information is written in the form of value maps with
+ * instance labels "jecUncertainty", "jerFactor[Nominal|Up|Down]" (float), and "hasGenMatch" (int).
+ * The value maps cover all jets in the source collection, including the rejected ones.
+ * 
+ * Random numbers for the stochastic smearing are normally drawn from the engine that the random-
+ * number service provides for the current stream. The smeared values then depend on how many
+ * numbers have been drawn for preceding events in the same stream, and thus on the number of
+ * threads and the set of processed events. If flag "deterministicSmearing" is set to true,
+ * instead, the random number for each jet is computed with the counter-based generator Philox
+ * (class PhiloxRandom). The run, luminosity section, and event numbers are used as the counter,
+ * and the key is built from parameter "seed" and the index of the jet in the source collection.
+ * The random-number service is not used in this case.
+ *
  * [1] https://twiki.cern.ch/twiki/bin/view/CMS/JetResolution?rev=54#Smearing_procedures
  */
-class JERCJetSelector: public edm::EDFilter
+class JERCJetSelector: public edm::stream::EDFilter<>
 {
 public:
     /// Constructor
     JERCJetSelector(edm::ParameterSet const &cfg);
     
 public:
-    /// Creates objects that provide JEC uncertainty and JER resolution and scale factors
+    /**
+     * \brief Creates objects that provide JEC uncertainty and JER resolution and scale factors
+     * 
+     * JER resolution and scale factors are flattened into lookup tables (class JERLookup). The
+     * objects are only rebuilt when the IOV of the corresponding record changes.
+     */
     virtual void beginRun(edm::Run const &, edm::EventSetup const &setup) override;
     
     /// Verifies plugin configuration
@@ -63,17 +98,25 @@ private:
      * 
      * Considers only GEN-level jets with dR less than half of the jet cone size and with the
      * absolute pt difference less than the given value. Among them, returns the jet closest in dR.
-     * If no match is found, a nullptr is returned.
+     * If no match is found, a nullptr is returned. Only GEN-level jets in the neighbouring cells
+     * of genJetGrid are checked, so the grid must have been filled for the current event.
      */
     reco::GenJet const *MatchGenJet(reco::Jet const &jet, edm::View<reco::GenJet> const &genJets,
       double maxDPt) const;
     
+private:
+    /// Instance labels of value maps with real-valued properties of jets in the light output
+    static std::array<std::string, 4> const floatMapLabels;
+    
 private:
     /// Source collection of jets
     edm::EDGetTokenT<edm::View<pat::Jet>> jetToken;
     
     /// Preselection for jets
-    StringCutObjectSelector<pat::Jet> const preselector;
+    CompiledCut<pat::Jet> const preselector;
+    
+    /// PF jet ID included in the preselection; disabled if no regions are given
+    PFJetID jetID;
     
     /// Selection on corrected pt
     double minPt;
@@ -88,6 +131,9 @@ private:
     /// Threshold on the number of selected jets
     unsigned minNumJets;
     
+    /// Requests the output in the form of a PtrVector and value maps instead of copied jets
+    bool const lightOutput;
+    
     /// Flag showing whether JERC variations should be considered
     bool includeJERCVariations;
     
@@ -116,11 +162,11 @@ private:
     double jetConeSize;
     
     /**
-     * \brief Rho (mean angular pt density)
+     * \brief Event-level reconstructed information
      * 
-     * Used in JER smearing.
+     * Provides rho, which is used in JER smearing.
      */
-    edm::EDGetTokenT<double> rhoToken;
+    edm::EDGetTokenT<pec::RecoContext> contextToken;
     
     /// An object that provides jet energy resolution in simulation
     std::unique_ptr<JME::JetResolution> jerProvider;
@@ -128,6 +174,14 @@ private:
     /// An object that provides JER scale factors
     std::unique_ptr<JME::JetResolutionScaleFactor> jerSFProvider;
     
+    /// Lookup tables built from jerProvider and jerSFProvider
+    std::unique_ptr<JERLookup> jerLookup;
+    
+    /// Objects to detect changes in records from which JEC uncertainty and JER are read
+    edm::ESWatcher<JetCorrectionsRecord> jecWatcher;
+    edm::ESWatcher<JetResolutionRcd> jerWatcher;
+    edm::ESWatcher<JetResolutionScaleFactorRcd> jerSFWatcher;
+    
     /**
      * \brief Random-number generator service
      * 
@@ -135,6 +189,24 @@ private:
      */
     edm::Service<edm::RandomNumberGenerator> rGenService;
     
+    /// Requests that random numbers are derived from event ID and jet index with generator
+    bool const deterministicSmearing;
+    
+    /// Seed for the counter-based generator used when deterministicSmearing is set
+    std::uint32_t const smearingSeed;
+    
     /// Variation of this size is used to determine if a jet w/o GEN-level match to be saved
     double nSigmaJERUnmatched;
+    
+    /// Spatial index of GEN-level jets in the current event
+    EtaPhiGrid genJetGrid;
+    
+    /**
+     * \brief Buffers with values for the value maps in the light output, indexed with positions
+     * of jets in the source collection
+     * 
+     * Kept as data members to avoid memory allocations in every event.
+     */
+    std::vector<std::vector<float>> floatValues;
+    std::vector<int> hasGenMatchValues;
 };
@@ -0,0 +1,202 @@
+#include "JERLookup.h"
+
+#include <algorithm>
+
+
+bool JERLookup::Axis::Build(std::vector<JME::JetResolutionObject::Range> ranges)
+{
+    upperEdges.clear();
+
+    if (ranges.empty())
+        return false;
+
+    std::sort(ranges.begin(), ranges.end(),
+      [](auto const &lhs, auto const &rhs){return lhs.min < rhs.min or
+      (lhs.min == rhs.min and lhs.max < rhs.max);});
+    ranges.erase(std::unique(ranges.begin(), ranges.end(),
+      [](auto const &lhs, auto const &rhs){return lhs.min == rhs.min and lhs.max == rhs.max;}),
+      ranges.end());
+
+    for (unsigned i = 0; i + 1 < ranges.size(); ++i)
+        if (ranges[i].max != ranges[i + 1].min)
+            return false;
+
+    minValue = ranges.front().min;
+
+    for (auto const &range: ranges)
+        upperEdges.push_back(range.max);
+
+    return true;
+}
+
+
+int JERLookup::Axis::FindBin(float value) const
+{
+    if (value < minValue)
+        return -1;
+
+    auto const res = std::lower_bound(upperEdges.begin(), upperEdges.end(), value);
+
+    if (res == upperEdges.end())
+        return -1;
+
+    return res - upperEdges.begin();
+}
+
+
+JERLookup::JERLookup(JME::JetResolution const &resolution_,
+  JME::JetResolutionScaleFactor const &sf_):
+    resolution(resolution_), sf(sf_)
+{
+    useResolutionTable = BuildResolutionTable();
+    useScaleFactorTable = BuildScaleFactorTable();
+}
+
+
+double JERLookup::GetResolution(double pt, double eta, double rho)
+{
+    resolutionParameters.setJetPt(pt).setJetEta(eta).setRho(rho);
+
+    if (not useResolutionTable)
+        return resolution.getResolution(resolutionParameters);
+
+    int const iEta = resolutionEtaAxis.FindBin(eta);
+    int const iRho = resolutionRhoAxis.FindBin(rho);
+
+    // Same value as returned by JME::JetResolution when no bin is found
+    if (iEta < 0 or iRho < 0)
+        return 1.;
+
+    auto const *record = resolutionRecords[iEta * resolutionRhoAxis.NumBins() + iRho];
+    return resolution.getResolutionObject()->evaluateFormula(*record, resolutionParameters);
+}
+
+
+JERLookup::ScaleFactors JERLookup::GetScaleFactors(double eta) const
+{
+    if (not useScaleFactorTable)
+    {
+        JME::JetParameters parameters;
+        parameters.setJetEta(eta);
+        return {sf.getScaleFactor(parameters, Variation::NOMINAL),
+          sf.getScaleFactor(parameters, Variation::UP),
+          sf.getScaleFactor(parameters, Variation::DOWN)};
+    }
+
+    int const iEta = sfEtaAxis.FindBin(eta);
+
+    // Same value as returned by JME::JetResolutionScaleFactor when no bin is found
+    if (iEta < 0)
+        return {1., 1., 1.};
+
+    return sfValues[iEta];
+}
+
+
+bool JERLookup::BuildResolutionTable()
+{
+    auto const *object = resolution.getResolutionObject();
+    auto const &bins = object->getDefinition().getBins();
+
+    if (bins.size() != 2)
+        return false;
+
+    unsigned iEtaVar, iRhoVar;
+
+    if (bins[0] == JME::Binning::JetEta and bins[1] == JME::Binning::Rho)
+    {
+        iEtaVar = 0;
+        iRhoVar = 1;
+    }
+    else if (bins[0] == JME::Binning::Rho and bins[1] == JME::Binning::JetEta)
+    {
+        iEtaVar = 1;
+        iRhoVar = 0;
+    }
+    else
+        return false;
+
+
+    // Construct the axes
+    auto const &records = object->getRecords();
+    std::vector<JME::JetResolutionObject::Range> etaRanges, rhoRanges;
+
+    for (auto const &record: records)
+    {
+        etaRanges.emplace_back(record.getBinsRange()[iEtaVar]);
+        rhoRanges.emplace_back(record.getBinsRange()[iRhoVar]);
+    }
+
+    if (not resolutionEtaAxis.Build(etaRanges) or not resolutionRhoAxis.Build(rhoRanges))
+        return false;
+
+
+    // Fill the table. Bins along each axis are contiguous, so the centre of a bin is only
+    //contained in that bin. The first record is used if several records match the same cell, as
+    //done in JME::JetResolutionObject.
+    unsigned const nRho = resolutionRhoAxis.NumBins();
+    resolutionRecords.assign(resolutionEtaAxis.NumBins() * nRho, nullptr);
+
+    for (auto const &record: records)
+    {
+        auto const &etaRange = record.getBinsRange()[iEtaVar];
+        auto const &rhoRange = record.getBinsRange()[iRhoVar];
+        int const iEta = resolutionEtaAxis.FindBin((etaRange.min + etaRange.max) / 2);
+        int const iRho = resolutionRhoAxis.FindBin((rhoRange.min + rhoRange.max) / 2);
+
+        auto &cell = resolutionRecords[iEta * nRho + iRho];
+
+        if (not cell)
+            cell = &record;
+    }
+
+    for (auto const *record: resolutionRecords)
+        if (not record)
+            return false;
+
+    return true;
+}
+
+
+bool JERLookup::BuildScaleFactorTable()
+{
+    auto const *object = sf.getResolutionObject();
+    auto const &bins = object->getDefinition().getBins();
+
+    if (bins.size() != 1 or bins[0] != JME::Binning::JetEta)
+        return false;
+
+    auto const &records = object->getRecords();
+    std::vector<JME::JetResolutionObject::Range> etaRanges;
+
+    for (auto const &record: records)
+    {
+        // Three parameters are expected: nominal scale factor and its down and up variations
+        if (record.getParametersValues().size() < 3)
+            return false;
+
+        etaRanges.emplace_back(record.getBinsRange()[0]);
+    }
+
+    if (not sfEtaAxis.Build(etaRanges))
+        return false;
+
+    sfValues.assign(sfEtaAxis.NumBins(), {0., 0., 0.});
+    std::vector<bool> filled(sfEtaAxis.NumBins(), false);
+
+    for (auto const &record: records)
+    {
+        auto const &range = record.getBinsRange()[0];
+        int const iEta = sfEtaAxis.FindBin((range.min + range.max) / 2);
+
+        if (filled[iEta])
+            continue;
+
+        auto const &p = record.getParametersValues();
+        sfValues[iEta] = {p[int(Variation::NOMINAL)], p[int(Variation::UP)],
+          p[int(Variation::DOWN)]};
+        filled[iEta] = true;
+    }
+
+    return std::all_of(filled.begin(), filled.end(), [](bool f){return f;});
+}
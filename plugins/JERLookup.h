@@ -0,0 +1,117 @@
+#pragma once
+
+#include <JetMETCorrections/Modules/interface/JetResolution.h>
+
+#include <array>
+#include <vector>
+
+
+/**
+ * \class JERLookup
+ * \brief Provides jet pt resolution and JER scale factors using precomputed lookup tables
+ *
+ * Objects JME::JetResolution and JME::JetResolutionScaleFactor find the bin for a jet with a
+ * linear search over all records, building a map of parameters for each call. This class
+ * flattens their records into dense arrays of bin edges once, when it is constructed, so that a
+ * bin is found with a binary search. The three scale factors (nominal, up, down) are stored next
+ * to each other and are returned together.
+ *
+ * The tables are only built for the layouts used in practice, i.e. scale factors binned in jet
+ * pseudorapidity and resolution binned in pseudorapidity and rho, where the bins along each axis
+ * are contiguous. For any other layout the original objects are used, which gives identical
+ * results. The formula for the resolution is always evaluated by the original object.
+ */
+class JERLookup
+{
+public:
+    /// Scale factors for the nominal JER and its up and down variations
+    struct ScaleFactors
+    {
+        double nominal, up, down;
+    };
+
+private:
+    /// Contiguous bins along one axis
+    class Axis
+    {
+    public:
+        /**
+         * \brief Constructs the axis from the given ranges
+         *
+         * The ranges are sorted, and duplicates are removed. Returns false if they are not
+         * contiguous.
+         */
+        bool Build(std::vector<JME::JetResolutionObject::Range> ranges);
+
+        /**
+         * \brief Finds the bin containing the given value
+         *
+         * Both boundaries of a bin are inclusive, and the first matching bin is chosen, as in
+         * JME::JetResolutionObject. Returns -1 if the value is outside of the axis.
+         */
+        int FindBin(float value) const;
+
+        /// Returns the number of bins
+        unsigned NumBins() const
+        {
+            return upperEdges.size();
+        }
+
+    private:
+        /// Lower boundary of the first bin
+        float minValue;
+
+        /// Upper boundaries of all bins
+        std::vector<float> upperEdges;
+    };
+
+public:
+    /**
+     * \brief Constructor
+     *
+     * The given objects must outlive this one.
+     */
+    JERLookup(JME::JetResolution const &resolution, JME::JetResolutionScaleFactor const &sf);
+
+public:
+    /// Returns relative jet pt resolution in simulation
+    double GetResolution(double pt, double eta, double rho);
+
+    /// Returns data-to-simulation scale factors for the pt resolution
+    ScaleFactors GetScaleFactors(double eta) const;
+
+private:
+    /// Builds the table for the resolution; returns false if the layout is not supported
+    bool BuildResolutionTable();
+
+    /// Builds the table for the scale factors; returns false if the layout is not supported
+    bool BuildScaleFactorTable();
+
+private:
+    /// Original object that provides the resolution
+    JME::JetResolution const &resolution;
+
+    /// Original object that provides the scale factors
+    JME::JetResolutionScaleFactor const &sf;
+
+    /// Indicates whether the table for the resolution is used
+    bool useResolutionTable;
+
+    /// Axes of the table for the resolution
+    Axis resolutionEtaAxis, resolutionRhoAxis;
+
+    /// Records of the resolution for bins (iEta, iRho), at index iEta * numRhoBins + iRho
+    std::vector<JME::JetResolutionObject::Record const *> resolutionRecords;
+
+    /// Parameters for the evaluation of the resolution, reused to avoid memory allocations
+    JME::JetParameters resolutionParameters;
+
+    /// Indicates whether the table for the scale factors is used
+    bool useScaleFactorTable;
+
+    /// Axis of the table for the scale factors
+    Axis sfEtaAxis;
+
+    /// Scale factors for each bin in eta
+    std::vector<ScaleFactors> sfValues;
+};
@@ -1,7 +1,10 @@
 #include "LHEEventWeights.h"
 
+#include <Analysis/PECTuples/interface/Minifloat.h>
+
 #include <FWCore/Framework/interface/MakerMacros.h>
 #include <FWCore/Framework/interface/Run.h>
+#include <FWCore/MessageLogger/interface/MessageLogger.h>
 #include <FWCore/Utilities/interface/InputTag.h>
 #include <FWCore/Utilities/interface/EDMException.h>
 
@@ -18,13 +21,39 @@ using namespace std;
 
 LHEEventWeights::LHEEventWeights(ParameterSet const &cfg):
     weightsHeaderTag(cfg.getParameter<string>("weightsHeaderTag")),
-    rescaleLHEWeights(cfg.getParameter<bool>("rescaleLHEWeights")),
     computeMeanWeights(cfg.getParameter<bool>("computeMeanWeights")),
     storeWeights(cfg.getParameter<bool>("storeWeights")),
     printToFiles(cfg.getParameter<bool>("printToFiles")),
+    numClippedRatios(0),
     nEventsProcessed(0),
-    bfAltWeights(nullptr)
+    treeSettings(cfg.getParameter<ParameterSet>("treeSettings")),
+    bfAltWeights(nullptr),
+    bfAltWeightCodes(nullptr)
 {
+    usesResource("TFileService");
+    
+    
+    // Range for ratios of alternative weights to the nominal one
+    auto const &ratioRange = cfg.getParameter<vector<double>>("altWeightRatioRange");
+    storeWeightRatios = not ratioRange.empty();
+    
+    if (storeWeightRatios)
+    {
+        if (ratioRange.size() != 2 or not (ratioRange[0] < ratioRange[1]))
+        {
+            Exception excp(errors::Configuration);
+            excp << "Parameter altWeightRatioRange must be either empty or contain two values " <<
+              "in the increasing order.";
+            excp.raise();
+        }
+        
+        bfAltWeightRatioRange[0] = ratioRange[0];
+        bfAltWeightRatioRange[1] = ratioRange[1];
+    }
+    else
+        bfAltWeightRatioRange[0] = bfAltWeightRatioRange[1] = 0.f;
+    
+    
     // Register required input data
     lheRunInfoToken =
      consumes<LHERunInfoProduct, edm::InRun>(cfg.getParameter<InputTag>("lheRunInfoProduct"));
@@ -32,15 +61,14 @@ LHEEventWeights::LHEEventWeights(ParameterSet const &cfg):
     //[1] https://hypernews.cern.ch/HyperNews/CMS/get/edmFramework/3583/1.html
     lheEventInfoToken =
      consumes<LHEEventProduct>(cfg.getParameter<InputTag>("lheEventInfoProduct"));
-    
-    if (rescaleLHEWeights)
-        generatorToken = consumes<GenEventInfoProduct>(cfg.getParameter<InputTag>("generator"));
+    contextToken = consumes<pec::GeneratorContext>(cfg.getParameter<InputTag>("generatorContext"));
 }
 
 
 LHEEventWeights::~LHEEventWeights()
 {
     delete [] bfAltWeights;
+    delete [] bfAltWeightCodes;
 }
 
 
@@ -51,18 +79,20 @@ void LHEEventWeights::fillDescriptions(ConfigurationDescriptions &descriptions)
     desc.add<string>("weightsHeaderTag", "initrwgt")->
      setComment("Tag to identify LHE header with description of event weights.");
     desc.add<InputTag>("lheEventInfoProduct")->
-     setComment("Tag to access per-event LHE information.");
-    desc.add<InputTag>("generator", InputTag("generator"))->
-     setComment("Tag to access general generator-level event information.");
-    desc.add<bool>("rescaleLHEWeights", true)->
-     setComment("Requires that LHE weights are rescaled taking into account the weight from "
-     "GenEventInfoProduct.");
+     setComment("Tag to access per-event LHE information. Only used to read IDs of weights.");
+    desc.add<InputTag>("generatorContext", InputTag("generatorContext"))->
+     setComment("Tag to access pec::GeneratorContext, which provides (possibly rescaled) weights.");
     desc.add<bool>("computeMeanWeights", true)->
      setComment("Indicates whether mean values of all weights should be computed.");
     desc.add<bool>("storeWeights", false)->
      setComment("Indicates whether event weights should be stored in a ROOT tree.");
+    desc.add<vector<double>>("altWeightRatioRange", vector<double>())->
+     setComment("Range in which ratios of alternative weights to the nominal weight are encoded "
+     "in the ROOT tree. If empty, the weights are stored as is.");
     desc.add<bool>("printToFiles", false)->
      setComment("Indicates whether the output should be stored in text files or printed to cout.");
+    desc.add<ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+     setComment("I/O settings for the output tree.");
     
     descriptions.add("lheEventWeights", desc);
 }
@@ -70,17 +100,31 @@ void LHEEventWeights::fillDescriptions(ConfigurationDescriptions &descriptions)
 
 void LHEEventWeights::analyze(Event const &event, EventSetup const &)
 {
-    // Read LHE information for the current event
-    Handle<LHEEventProduct> lheEventInfo;
-    event.getByToken(lheEventInfoToken, lheEventInfo);
+    // Read weights for the current event. Any rescaling has already been applied by the producer
+    //of pec::GeneratorContext
+    Handle<pec::GeneratorContext> context;
+    event.getByToken(contextToken, context);
     
-    vector<gen::WeightsInfo> const &altWeightObjects = lheEventInfo->weights();
+    double const nominalWeight = context->LheNominalWeight();
+    vector<double> const &altWeights = context->AltLheWeights();
     
     
-    // Perform initialization when processing the first event
+    // Perform initialization when processing the first event. IDs of weights are only available
+    //from the LHE event record
     if (nEventsProcessed == 0)
     {
-        altWeights.reserve(altWeightObjects.size());
+        Handle<LHEEventProduct> lheEventInfo;
+        event.getByToken(lheEventInfoToken, lheEventInfo);
+        
+        vector<gen::WeightsInfo> const &altWeightObjects = lheEventInfo->weights();
+        
+        if (not context->HasLhe() or altWeightObjects.size() != altWeights.size())
+        {
+            Exception excp(errors::LogicError);
+            excp << "pec::GeneratorContext does not contain all alternative LHE weights. Make " <<
+              "sure that they are computed by its producer.";
+            excp.raise();
+        }
         
         if (computeMeanWeights)
             SetupWeightMeans(altWeightObjects);
@@ -90,32 +134,6 @@ void LHEEventWeights::analyze(Event const &event, EventSetup const &)
     }
     
     
-    // Scale factor for weights
-    double factor = 1.;
-    
-    if (rescaleLHEWeights)
-    {
-        Handle<GenEventInfoProduct> generator;
-        event.getByToken(generatorToken, generator);
-        
-        factor = generator->weight() / lheEventInfo->originalXWGTUP();
-        //^ This rescaling is included in the instruction in [1]
-        //[1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW?rev=7#How_to_use_weights
-    }
-    
-    
-    // The nominal weight
-    double const nominalWeight = lheEventInfo->originalXWGTUP() * factor;
-    
-    
-    // Alternative weights
-    altWeights.clear();
-    
-    for (gen::WeightsInfo const &weight: altWeightObjects)
-        altWeights.push_back(weight.wgt * factor);
-    
-    
-        
     // Update means if requested
     if (computeMeanWeights)
     {
@@ -138,8 +156,24 @@ void LHEEventWeights::analyze(Event const &event, EventSetup const &)
         bfNominalWeight = nominalWeight;
         bfNumAltWeights = altWeights.size();
         
-        for (unsigned i = 0; i < altWeights.size(); ++i)
-            bfAltWeights[i] = altWeights.at(i);
+        if (storeWeightRatios)
+        {
+            for (unsigned i = 0; i < altWeights.size(); ++i)
+            {
+                double const ratio = altWeights[i] / nominalWeight;
+                
+                if (ratio < bfAltWeightRatioRange[0] or ratio >= bfAltWeightRatioRange[1])
+                    ++numClippedRatios;
+                
+                bfAltWeightCodes[i] = pec::minifloat::Quantize(ratio, bfAltWeightRatioRange[0],
+                  bfAltWeightRatioRange[1], ratioBits);
+            }
+        }
+        else
+        {
+            for (unsigned i = 0; i < altWeights.size(); ++i)
+                bfAltWeights[i] = altWeights.at(i);
+        }
         
         
         outTree->Fill();
@@ -151,40 +185,19 @@ void LHEEventWeights::analyze(Event const &event, EventSetup const &)
 }
 
 
-void LHEEventWeights::endRun(Run const &run, EventSetup const &)
+void LHEEventWeights::beginJob()
 {
-    // Print description of LHE weights from the LHE header
-    
-    // Create the output stream. Depending on the value of the printToFiles flag, it is either the
-    //standard output or a file
-    std::streambuf *buf;
-    std::ofstream outFile;
-    
     if (printToFiles)
-    {
-        outFile.open("weightsInfo.txt");
-        buf = outFile.rdbuf();
-    }
-    else
-        buf = std::cout.rdbuf();
-    
-    std::ostream out(buf);
-    
-    
-    // Print information about the output format
-    out << "Destription of LHE weights:\n index   ID   description\n\n";
-    
-    
-    // Create regular expressions to parse the the part of the header containing event weights
-    boost::regex weightRegex("^\\s*<weight\\s+[^>]*id=\"(\\w+)\"[^>]*>\\s*(\\S.*\\S)\\s*</weight>\\s*\n?$",
-     boost::regex::extended);
-    //^ The first group is the weight ID, the second group is the description
-    boost::regex groupStartRegex("^\\s*<weightgroup\\s+(.*)>\\s*(#.*)?\n?$", boost::regex::extended);
-    boost::regex groupEndRegex("^\\s*</weightgroup>\\s*(#.*)?\n?$", boost::regex::extended);
-    boost::regex emptyLineRegex("^\\s*\n?$", boost::regex::extended);
-    boost::regex tagRegex("^\\s*<.+>\\s*\n?$", boost::regex::extended);
-    
-    
+        weightsInfoFile.open("weightsInfo.txt");
+}
+
+
+void LHEEventWeights::beginRun(Run const &, EventSetup const &)
+{}
+
+
+void LHEEventWeights::endRun(Run const &run, EventSetup const &)
+{
     // Read LHE header
     Handle<LHERunInfoProduct> lheRunInfo;
     run.getByToken(lheRunInfoToken, lheRunInfo);
@@ -203,55 +216,34 @@ void LHEEventWeights::endRun(Run const &run, EventSetup const &)
         headerFound = true;
         
         
-        // Parse the current header and print formatted results
-        boost::smatch matchResults;
-        unsigned nWeightsFound = 0;
+        // Compute a hash of the content of the header (64-bit FNV-1a) and check if the same header
+        //has been seen before. Lines are separated with a zero byte.
+        std::uint64_t hash = 14695981039346656037ULL;
         
         for (auto const &line: header->lines())
         {
-            // Skip empty lines
-            if (boost::regex_match(line, matchResults, emptyLineRegex))
-                continue;
+            for (char const c: line)
+                hash = (hash ^ std::uint8_t(c)) * 1099511628211ULL;
             
-            // If a new group is started, mention this in the print out
-            if (boost::regex_match(line, matchResults, groupStartRegex))
-            {
-                out << "Weight group: " << matchResults[1] << "\n\n";
-                continue;
-            }
-            
-            // If a group is finished, insert empty lines
-            if (boost::regex_match(line, matchResults, groupEndRegex))
-            {
-                out << "\n\n";
-                continue;
-            }
-            
-            // If a weight desription is found, print it as well as the index of the weight
-            if (boost::regex_match(line, matchResults, weightRegex))
-            {
-                out << " " << setw(3) << nWeightsFound << "   " << matchResults[1] << "   " <<
-                 matchResults[2] << '\n';
-                ++nWeightsFound;
-                continue;
-            }
-            
-            
-            // If control reaches this point, the current line could not be parsed
-            if (not boost::regex_match(line, matchResults, tagRegex))
-            {
-                cerr << "ERROR in LHEEventWeights: Failed to parse line\n  \"" << line <<
-                  "\"\nin the header \"" << weightsHeaderTag << "\". This line is not a valid " <<
-                  "XML tag. Will try to ignore it and continue." << endl;
-            }
-            else
+            hash *= 1099511628211ULL;
+        }
+        
+        bool cached = false;
+        
+        for (auto const &parsedHeader: parsedHeaders)
+            if (parsedHeader.first == hash)
             {
-                Exception excp(errors::LogicError);
-                excp << "Unexpected XML tag found in line\n  \"" << line <<
-                  "\"\nin the header \"" << weightsHeaderTag << "\".";
-                excp.raise();
+                cached = true;
+                break;
             }
-        }
+        
+        if (cached)
+            continue;
+        
+        
+        // This is a new header. Parse and print it
+        parsedHeaders.emplace_back(hash, ParseHeader(header->lines()));
+        PrintHeader(hash, parsedHeaders.back().second);
     }
     
     
@@ -267,6 +259,12 @@ void LHEEventWeights::endRun(Run const &run, EventSetup const &)
 
 void LHEEventWeights::endJob()
 {
+    if (numClippedRatios > 0)
+        LogWarning("LHEEventWeights") << numClippedRatios << " ratios of alternative weights " <<
+          "to the nominal one fell outside of the range [" << bfAltWeightRatioRange[0] << ", " <<
+          bfAltWeightRatioRange[1] << ") and were clipped.";
+    
+    
     // Print mean values of all weights
     
     // Create the output stream. Depending on the value of the printToFiles flag, it is either the
@@ -297,6 +295,147 @@ void LHEEventWeights::endJob()
     }
     
     out << endl;
+    
+    
+    // Store descriptions of weights from all distinct headers if weights are stored
+    if (storeWeights)
+    {
+        TTree *descTree = fileService->make<TTree>("WeightDescriptions",
+          "Descriptions of LHE weights");
+        
+        ULong64_t bfHeaderHash;
+        UInt_t bfIndex;
+        string bfId, bfDescription, bfGroup;
+        
+        descTree->Branch("headerHash", &bfHeaderHash);
+        descTree->Branch("index", &bfIndex);
+        descTree->Branch("id", &bfId);
+        descTree->Branch("description", &bfDescription);
+        descTree->Branch("group", &bfGroup);
+        
+        for (auto const &parsedHeader: parsedHeaders)
+        {
+            bfHeaderHash = parsedHeader.first;
+            bfIndex = 0;
+            bfGroup = "";
+            
+            for (auto const &line: parsedHeader.second)
+            {
+                if (line.type == HeaderLine::Type::GroupStart)
+                    bfGroup = line.description;
+                else if (line.type == HeaderLine::Type::GroupEnd)
+                    bfGroup = "";
+                else
+                {
+                    bfId = line.id;
+                    bfDescription = line.description;
+                    descTree->Fill();
+                    ++bfIndex;
+                }
+            }
+        }
+    }
+}
+
+
+LHEEventWeights::ParsedHeader LHEEventWeights::ParseHeader(vector<string> const &lines) const
+{
+    // Create regular expressions to parse the the part of the header containing event weights
+    boost::regex weightRegex("^\\s*<weight\\s+[^>]*id=\"(\\w+)\"[^>]*>\\s*(\\S.*\\S)\\s*</weight>\\s*\n?$",
+     boost::regex::extended);
+    //^ The first group is the weight ID, the second group is the description
+    boost::regex groupStartRegex("^\\s*<weightgroup\\s+(.*)>\\s*(#.*)?\n?$", boost::regex::extended);
+    boost::regex groupEndRegex("^\\s*</weightgroup>\\s*(#.*)?\n?$", boost::regex::extended);
+    boost::regex emptyLineRegex("^\\s*\n?$", boost::regex::extended);
+    boost::regex tagRegex("^\\s*<.+>\\s*\n?$", boost::regex::extended);
+    
+    
+    ParsedHeader parsedHeader;
+    boost::smatch matchResults;
+    
+    for (auto const &line: lines)
+    {
+        // Skip empty lines
+        if (boost::regex_match(line, matchResults, emptyLineRegex))
+            continue;
+        
+        // Start of a new group
+        if (boost::regex_match(line, matchResults, groupStartRegex))
+        {
+            parsedHeader.push_back({HeaderLine::Type::GroupStart, "", matchResults[1]});
+            continue;
+        }
+        
+        // End of a group
+        if (boost::regex_match(line, matchResults, groupEndRegex))
+        {
+            parsedHeader.push_back({HeaderLine::Type::GroupEnd, "", ""});
+            continue;
+        }
+        
+        // Description of a weight
+        if (boost::regex_match(line, matchResults, weightRegex))
+        {
+            parsedHeader.push_back({HeaderLine::Type::Weight, matchResults[1], matchResults[2]});
+            continue;
+        }
+        
+        
+        // If control reaches this point, the current line could not be parsed
+        if (not boost::regex_match(line, matchResults, tagRegex))
+        {
+            cerr << "ERROR in LHEEventWeights: Failed to parse line\n  \"" << line <<
+              "\"\nin the header \"" << weightsHeaderTag << "\". This line is not a valid " <<
+              "XML tag. Will try to ignore it and continue." << endl;
+        }
+        else
+        {
+            Exception excp(errors::LogicError);
+            excp << "Unexpected XML tag found in line\n  \"" << line <<
+              "\"\nin the header \"" << weightsHeaderTag << "\".";
+            excp.raise();
+        }
+    }
+    
+    return parsedHeader;
+}
+
+
+void LHEEventWeights::PrintHeader(std::uint64_t hash, ParsedHeader const &header)
+{
+    // Select the output stream. Depending on the value of the printToFiles flag, it is either the
+    //standard output or the file shared by all headers
+    std::ostream &out = (printToFiles) ? weightsInfoFile : std::cout;
+    
+    
+    // Print information about the output format. The hash separates descriptions from different
+    //headers and allows to match them to tree WeightDescriptions
+    out << "Destription of LHE weights (header hash " << hash <<
+      "):\n index   ID   description\n\n";
+    
+    
+    // Print formatted lines of the header
+    unsigned nWeightsFound = 0;
+    
+    for (auto const &line: header)
+    {
+        switch (line.type)
+        {
+            case HeaderLine::Type::GroupStart:
+                out << "Weight group: " << line.description << "\n\n";
+                break;
+            
+            case HeaderLine::Type::GroupEnd:
+                out << "\n\n";
+                break;
+            
+            case HeaderLine::Type::Weight:
+                out << " " << setw(3) << nWeightsFound << "   " << line.id << "   " <<
+                 line.description << '\n';
+                ++nWeightsFound;
+                break;
+        }
+    }
 }
 
 
@@ -317,7 +456,11 @@ void LHEEventWeights::SetupWeightTree(unsigned nAltWeights)
 {
     // Allocate a buffer to store alternative weights
     bfNumAltWeights = nAltWeights;
-    bfAltWeights = new Float_t[nAltWeights];
+    
+    if (storeWeightRatios)
+        bfAltWeightCodes = new UShort_t[nAltWeights];
+    else
+        bfAltWeights = new Float_t[nAltWeights];
     
     
     // Create the tree and setup its branches
@@ -325,7 +468,16 @@ void LHEEventWeights::SetupWeightTree(unsigned nAltWeights)
     
     outTree->Branch("nominalWeight", &bfNominalWeight);
     outTree->Branch("numAltWeights", &bfNumAltWeights);
-    outTree->Branch("altWeights", bfAltWeights, "altWeights[numAltWeights]/F");
+    
+    if (storeWeightRatios)
+    {
+        outTree->Branch("altWeightRatioRange", bfAltWeightRatioRange, "altWeightRatioRange[2]/F");
+        outTree->Branch("altWeightCodes", bfAltWeightCodes, "altWeightCodes[numAltWeights]/s");
+    }
+    else
+        outTree->Branch("altWeights", bfAltWeights, "altWeights[numAltWeights]/F");
+    
+    treeSettings.Apply(outTree);
 }
 
 
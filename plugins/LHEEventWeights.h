@@ -1,6 +1,9 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
+#include "TreeSettings.h"
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
@@ -8,13 +11,14 @@
 
 #include <SimDataFormats/GeneratorProducts/interface/LHERunInfoProduct.h>
 #include <SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h>
-#include <SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h>
 
 #include <FWCore/ServiceRegistry/interface/Service.h>
 #include <CommonTools/UtilAlgos/interface/TFileService.h>
 
 #include <TTree.h>
 
+#include <cstdint>
+#include <fstream>
 #include <string>
 #include <vector>
 #include <utility>
@@ -28,10 +32,50 @@
  * their IDs and brief descriptions provided in the header. If requested, it computes average values
  * of all weights in the current job. The output is either printed to the standard output or
  * directed to text files, depending on the configuration. User can also configure the plugin to
- * store weights in all events in a ROOT file.
+ * store weights in all events in a ROOT file. The weights are read from pec::GeneratorContext,
+ * whose producer decides whether they are rescaled to the weight from GenEventInfoProduct.
+ * 
+ * If parameter "altWeightRatioRange" is not empty, the alternative weights are stored in the ROOT
+ * file as ratios to the nominal weight, quantized uniformly in the given range with 16 bits (see
+ * pec::minifloat::Quantize). The range is saved in the tree as well, and an alternative weight is
+ * reconstructed as nominalWeight * Dequantize(altWeightCodes[i], altWeightRatioRange[0],
+ * altWeightRatioRange[1], 16). Ratios are not meaningful in events with a zero nominal weight.
+ * Ratios outside of the range are clipped to its boundaries, and their number is reported at the
+ * end of the job.
+ * 
+ * The LHE header is parsed only when its content changes. Parsed headers are cached, identified by
+ * a hash of their content, and printed once. When the output is directed to files, descriptions
+ * from all distinct headers are written one after another into file weightsInfo.txt, each preceded
+ * by the hash of the header. If weights are stored in a ROOT file, descriptions from all distinct
+ * headers are also written into tree WeightDescriptions in endJob.
  */
-class LHEEventWeights: public edm::EDAnalyzer
+class LHEEventWeights: public edm::one::EDAnalyzer<edm::one::WatchRuns, edm::one::SharedResources>
 {
+private:
+    /// A parsed line of the LHE header with descriptions of weights
+    struct HeaderLine
+    {
+        /// Supported types of lines
+        enum class Type
+        {
+            GroupStart,
+            GroupEnd,
+            Weight
+        };
+        
+        /// Type of the line
+        Type type;
+        
+        /// ID of the weight; empty for other lines
+        std::string id;
+        
+        /// Description of the weight or attributes of the group
+        std::string description;
+    };
+    
+    /// Parsed LHE header with descriptions of weights
+    using ParsedHeader = std::vector<HeaderLine>;
+    
 public:
     /**
      * \brief Constructor
@@ -50,19 +94,40 @@ public:
     /// Stores weights and updates their mean values (if requested)
     virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
     
+    /// Opens the file for descriptions of weights if the output is directed to files
+    virtual void beginJob() override;
+    
+    /// Does nothing; required by edm::one::WatchRuns
+    virtual void beginRun(edm::Run const &, edm::EventSetup const &) override;
+    
     /**
      * \brief Prints out description of alternative weights as provided in the LHE header
      * 
      * It would be more natural to read the LHE header in beginRun, but this cannot be done because
-     * of technical limitations, see e.g. here [1].
+     * of technical limitations, see e.g. here [1]. The header is only parsed and printed if it
+     * differs from the headers seen before.
      * [1] https://hypernews.cern.ch/HyperNews/CMS/get/physTools/3437.html
      */
     virtual void endRun(edm::Run const &run, edm::EventSetup const &) override;
     
-    /// Prints out mean values of the nominal and alternative weights
+    /**
+     * \brief Prints out mean values of the nominal and alternative weights
+     * 
+     * Also stores descriptions of weights if the weights are stored.
+     */
     virtual void endJob() override;
     
 private:
+    /**
+     * \brief Parses lines of LHE header with descriptions of weights
+     * 
+     * Throws an exception if an unexpected XML tag is found.
+     */
+    ParsedHeader ParseHeader(std::vector<std::string> const &lines) const;
+    
+    /// Prints out parsed header with the given hash
+    void PrintHeader(std::uint64_t hash, ParsedHeader const &header);
+    
     /**
      * \brief Sets up running means of nominal and alternative weights while processing first event
      * 
@@ -77,15 +142,15 @@ private:
     /// Token to access per-run LHE information
     edm::EDGetTokenT<LHERunInfoProduct> lheRunInfoToken;
     
-    /// Token to access per-event weights
-    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
-    
     /**
-     * \brief Token to access global generator information
+     * \brief Token to access per-event LHE information
      * 
-     * Only read if flag rescaleLHEWeights is set to true.
+     * Only read in the first event to obtain IDs of weights.
      */
-    edm::EDGetTokenT<GenEventInfoProduct> generatorToken;
+    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
+    
+    /// Token to access (possibly rescaled) nominal and alternative weights
+    edm::EDGetTokenT<pec::GeneratorContext> contextToken;
     
     /**
      * \brief Tag of the LHE header with information about weights
@@ -95,15 +160,6 @@ private:
      */
     std::string weightsHeaderTag;
     
-    /**
-     * \brief Indicates whether varied LHE weights should be rescaled to the weight given by
-     * GenEventInfoProduct
-     * 
-     * Such rescaling is included in the instruction in [1].
-     * [1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW?rev=7#How_to_use_weights
-     */
-    bool rescaleLHEWeights;
-    
     /// Indicates whether mean values of all weights should be calculated
     bool computeMeanWeights;
     
@@ -113,9 +169,29 @@ private:
     /// Indicates if the output should be directed to files instead of standard output
     bool printToFiles;
     
+    /**
+     * \brief File with descriptions of weights
+     * 
+     * Opened in beginJob if printToFiles is true and shared by all headers.
+     */
+    std::ofstream weightsInfoFile;
+    
+    /**
+     * \brief Parsed LHE headers together with hashes of their content
+     * 
+     * Headers are stored in the order in which they have been encountered.
+     */
+    std::vector<std::pair<std::uint64_t, ParsedHeader>> parsedHeaders;
+    
+    /// Indicates whether alternative weights are stored as quantized ratios to the nominal one
+    bool storeWeightRatios;
+    
+    /// Number of bits used to encode ratios of alternative weights to the nominal one
+    static unsigned const ratioBits = 16;
+    
+    /// Number of ratios of alternative weights that fell outside of the range and were clipped
+    unsigned long long numClippedRatios;
     
-    /// Buffer to keep (possibly rescaled) alternative LHE weights
-    std::vector<double> altWeights;
     
     /**
      * \brief Running means of nominal and alternative weights
@@ -134,6 +210,9 @@ private:
     unsigned long long nEventsProcessed;
     
     
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+    
     /// An object to handle the output ROOT file
     edm::Service<TFileService> fileService;
     
@@ -161,4 +240,14 @@ private:
      * Pointer to a dynamically allocated array. The array is owned by this.
      */
     Float_t *bfAltWeights;
+    
+    /// Range in which ratios of alternative weights to the nominal one are encoded
+    Float_t bfAltWeightRatioRange[2];
+    
+    /**
+     * \brief Encoded ratios of alternative weights to the nominal one
+     * 
+     * Pointer to a dynamically allocated array. The array is owned by this.
+     */
+    UShort_t *bfAltWeightCodes;
 };
@@ -0,0 +1,151 @@
+#include "MappedEventList.h"
+
+#include <FWCore/Utilities/interface/EDMException.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+/// Magic string that starts a binary event list
+char const magic[] = "PECEVL01";
+
+/// Size of the header, in bytes
+std::size_t const headerSize = 16;
+}
+
+
+MappedEventList::MappedEventList(std::string const &fileName_):
+    fileName(fileName_),
+    mapping(nullptr), mappingSize(0)
+{
+    int const fd = open(fileName.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        edm::Exception excp(edm::errors::FileOpenError);
+        excp << "Cannot open file \"" << fileName << "\": " << std::strerror(errno) << ".\n";
+        excp.raise();
+    }
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 or std::size_t(fileStat.st_size) < headerSize)
+    {
+        close(fd);
+        edm::Exception excp(edm::errors::FileReadError);
+        excp << "File \"" << fileName << "\" is too short to contain an event list.\n";
+        excp.raise();
+    }
+
+
+    // Map the whole file. The mapping remains valid after the descriptor is closed
+    mappingSize = fileStat.st_size;
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        mapping = nullptr;
+        edm::Exception excp(edm::errors::FileReadError);
+        excp << "Failed to map file \"" << fileName << "\" into memory: " <<
+          std::strerror(errno) << ".\n";
+        excp.raise();
+    }
+
+
+    // Check the header and locate the directory and the data
+    auto const *start = static_cast<std::uint8_t const *>(mapping);
+    std::uint64_t numLumis;
+    std::memcpy(&numLumis, start + 8, sizeof(numLumis));
+
+    if (std::memcmp(start, magic, 8) != 0 or
+      numLumis > (mappingSize - headerSize) / sizeof(LumiEntry))
+    {
+        munmap(mapping, mappingSize);
+        mapping = nullptr;
+        edm::Exception excp(edm::errors::LogicError);
+        excp << "File \"" << fileName << "\" does not follow the format of binary event lists.\n";
+        excp.raise();
+    }
+
+    directoryBegin = reinterpret_cast<LumiEntry const *>(start + headerSize);
+    directoryEnd = directoryBegin + numLumis;
+    dataBegin = reinterpret_cast<std::uint8_t const *>(directoryEnd);
+    dataEnd = start + mappingSize;
+}
+
+
+MappedEventList::~MappedEventList() noexcept
+{
+    if (mapping)
+        munmap(mapping, mappingSize);
+}
+
+
+MappedEventList::LumiEntry const *MappedEventList::FindLumi(std::uint64_t key) const
+{
+    auto const res = std::lower_bound(directoryBegin, directoryEnd, key,
+      [](LumiEntry const &entry, std::uint64_t k){return entry.key < k;});
+
+    if (res == directoryEnd or res->key != key)
+        return nullptr;
+
+    return res;
+}
+
+
+void MappedEventList::Decode(LumiEntry const &entry, std::vector<edm::EventNumber_t> &events)
+  const
+{
+    events.clear();
+
+    if (entry.numEvents == 0)
+        return;
+
+    events.reserve(entry.numEvents);
+    std::uint64_t event = entry.firstEvent;
+    events.emplace_back(event);
+
+    std::uint8_t const *p = dataBegin + std::min<std::uint64_t>(entry.offset, dataEnd - dataBegin);
+
+    for (std::uint64_t i = 1; i < entry.numEvents; ++i)
+    {
+        // Decode a varint. Each byte holds seven bits of the value, and the most significant bit
+        //indicates whether more bytes follow
+        std::uint64_t delta = 0;
+        unsigned shift = 0;
+        bool complete = false;
+
+        while (p < dataEnd and shift < 64)
+        {
+            std::uint8_t const byte = *p++;
+            delta |= std::uint64_t(byte & 0x7F) << shift;
+            shift += 7;
+
+            if (not (byte & 0x80))
+            {
+                complete = true;
+                break;
+            }
+        }
+
+        if (not complete)
+        {
+            edm::Exception excp(edm::errors::FileReadError);
+            excp << "Data for run " << (entry.key >> 32) << ", luminosity section " <<
+              (entry.key & 0xFFFFFFFF) << " in file \"" << fileName << "\" are corrupted.\n";
+            excp.raise();
+        }
+
+        event += delta;
+        events.emplace_back(event);
+    }
+}
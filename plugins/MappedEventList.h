@@ -0,0 +1,94 @@
+#pragma once
+
+#include <DataFormats/Provenance/interface/RunLumiEventNumber.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class MappedEventList
+ * \brief A read-only view of a binary event list mapped into memory
+ *
+ * The binary format is designed to be used in place, without parsing or copying the list into
+ * the heap. Pages of the file are loaded on demand and, since the mapping is shared, they are
+ * shared via the page cache among all jobs that read the same file on a node. All numbers are
+ * stored in little-endian byte order. The file consists of three parts:
+ *   1. Header: magic string "PECEVL01" (8 bytes) followed by the number of luminosity sections,
+ *      as a 64-bit integer.
+ *   2. Directory: one LumiEntry per luminosity section in the list, sorted by LumiEntry::key.
+ *   3. Data: for each luminosity section, sorted numbers of events that differ from each other,
+ *      written as differences between consecutive numbers. The first number in the section is
+ *      stored in the directory, and each of the remaining (numEvents - 1) differences is encoded
+ *      as an unsigned LEB128 varint. Data for a section start at LumiEntry::offset, counted from
+ *      the start of this part.
+ *
+ * Such files can be produced from text or ROOT event lists with script convertEventList.py.
+ */
+class MappedEventList
+{
+public:
+    /// An entry of the directory of luminosity sections
+    struct LumiEntry
+    {
+        /// Run number in the upper 32 bits and luminosity section number in the lower 32 bits
+        std::uint64_t key;
+
+        /// Smallest event number in the luminosity section
+        std::uint64_t firstEvent;
+
+        /// Number of events in the luminosity section
+        std::uint64_t numEvents;
+
+        /// Position of the encoded differences in the data part of the file, in bytes
+        std::uint64_t offset;
+    };
+
+public:
+    /**
+     * \brief Maps the given file into memory
+     *
+     * Throws an exception if the file cannot be opened or mapped or if its header or directory
+     * are not consistent with the format.
+     */
+    MappedEventList(std::string const &fileName);
+
+    MappedEventList(MappedEventList const &) = delete;
+
+    /// Unmaps the file
+    ~MappedEventList() noexcept;
+
+    MappedEventList &operator=(MappedEventList const &) = delete;
+
+public:
+    /**
+     * \brief Finds the entry in the directory with the given key
+     *
+     * Returns a null pointer if the list contains no events from this luminosity section.
+     */
+    LumiEntry const *FindLumi(std::uint64_t key) const;
+
+    /**
+     * \brief Decodes numbers of events in the given luminosity section
+     *
+     * The numbers are written into the given vector, replacing its content. They are sorted.
+     * Throws an exception if the data are corrupted.
+     */
+    void Decode(LumiEntry const &entry, std::vector<edm::EventNumber_t> &events) const;
+
+private:
+    /// Name of the mapped file, used for error messages
+    std::string fileName;
+
+    /// Start and size of the mapped region
+    void *mapping;
+    std::size_t mappingSize;
+
+    /// Directory of luminosity sections, located in the mapped region
+    LumiEntry const *directoryBegin, *directoryEnd;
+
+    /// Data part of the file, located in the mapped region
+    std::uint8_t const *dataBegin, *dataEnd;
+};
@@ -15,7 +15,8 @@ PATCandViewCountMultiFilter::PATCandViewCountMultiFilter(edm::ParameterSet const
 }
 
 
-bool PATCandViewCountMultiFilter::filter(edm::Event &event, edm::EventSetup const &eventSetup)
+bool PATCandViewCountMultiFilter::filter(edm::StreamID, edm::Event &event,
+  edm::EventSetup const &) const
 {
     // Loop over the input collections
     for (auto const &sourceToken: sourceTokens)
@@ -9,7 +9,9 @@
 
 #pragma once
 
-#include <FWCore/Framework/interface/EDFilter.h>
+#include "CompiledCut.h"
+
+#include <FWCore/Framework/interface/global/EDFilter.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
@@ -17,7 +19,6 @@
 #include <FWCore/Utilities/interface/InputTag.h>
 
 #include <DataFormats/Candidate/interface/Candidate.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
 
 #include <vector>
 
@@ -29,7 +30,7 @@
  * 
  * Consult the file's documentation section for details.
  */
-class PATCandViewCountMultiFilter: public edm::EDFilter
+class PATCandViewCountMultiFilter: public edm::global::EDFilter<>
 {
 public:
     /// Constructor
@@ -37,7 +38,7 @@ public:
     
 public:
     /// Evaluates decision of the plugin
-    virtual bool filter(edm::Event &event, edm::EventSetup const &eventSetup);
+    virtual bool filter(edm::StreamID, edm::Event &event, edm::EventSetup const &) const override;
     
     /// A method to verify plugin's configuration
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
@@ -51,7 +52,7 @@ private:
     std::vector<edm::EDGetTokenT<edm::View<reco::Candidate>>> sourceTokens;
     
     /// Desired selection to filter candidates
-    StringCutObjectSelector<reco::Candidate> const selection;
+    CompiledCut<reco::Candidate> const selection;
     
     /**
      * \brief Allowed range of numbers of candidates that pass the selection
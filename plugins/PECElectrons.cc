@@ -1,12 +1,13 @@
 #include "PECElectrons.h"
 
-#include <DataFormats/VertexReco/interface/Vertex.h>
-#include <FWCore/Utilities/interface/EDMException.h>
+#include <Analysis/PECTuples/interface/Minifloat.h>
+
 #include <FWCore/Utilities/interface/InputTag.h>
 #include <FWCore/ParameterSet/interface/FileInPath.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
 
 #include <algorithm>
+#include <memory>
 
 
 using namespace edm;
@@ -14,15 +15,16 @@ using namespace std;
 
 
 PECElectrons::PECElectrons(ParameterSet const &cfg):
+    PECLeptons(cfg),
     embeddedBoolIDLabels(cfg.getParameter<vector<string>>("embeddedBoolIDs")),
     embeddedContIDLabels(cfg.getParameter<vector<string>>("embeddedContIDs")),
-    eaReader((cfg.getParameter<FileInPath>("effAreas")).fullPath())
+    separateContIDs(cfg.getParameter<bool>("separateContIDs")),
+    contIDBits(cfg.getParameter<unsigned>("contIDBits")),
+    eaReader((cfg.getParameter<FileInPath>("effAreas")).fullPath()),
+    embeddedBoolIDIndices(embeddedBoolIDLabels.size(), -1)
 {
     // Register required input data
-    electronToken = consumes<View<pat::Electron>>(cfg.getParameter<InputTag>("src"));
-    rhoToken = consumes<double>(cfg.getParameter<InputTag>("rho"));
-    primaryVerticesToken =
-      consumes<reco::VertexCollection>(cfg.getParameter<InputTag>("primaryVertices"));
+    contextToken = consumes<pec::RecoContext>(cfg.getParameter<InputTag>("recoContext"));
     
     for (InputTag const &tag: cfg.getParameter<vector<InputTag>>("boolIDMaps"))
         boolIDMapTokens.emplace_back(consumes<ValueMap<bool>>(tag));
@@ -30,23 +32,39 @@ PECElectrons::PECElectrons(ParameterSet const &cfg):
     for (InputTag const &tag: cfg.getParameter<vector<InputTag>>("contIDMaps"))
         contIDMapTokens.emplace_back(consumes<ValueMap<float>>(tag));
     
+    boolIDMapValues.resize(boolIDMapTokens.size());
+    contIDMapValues.resize(contIDMapTokens.size());
+    
+    
+    // Check the storage of real-valued IDs and register the separate product
+    if (contIDBits > 16 or (contIDBits > 0 and not separateContIDs))
+    {
+        cms::Exception excp("Configuration");
+        excp << "Real-valued IDs can only be quantized if they are stored separately, with " <<
+          "at most 16 bits, while separateContIDs = " << separateContIDs << " and contIDBits = " <<
+          contIDBits << " are given.";
+        excp.raise();
+    }
     
-    // Construct string-based selectors
-    for (string const &selection: cfg.getParameter<vector<string>>("selection"))
-        eleSelectors.emplace_back(selection);
+    if (separateContIDs)
+    {
+        if (contIDBits > 0)
+            produces<vector<unsigned short>>("contIDs");
+        else
+            produces<vector<float>>("contIDs");
+    }
 }
 
 
 void PECElectrons::fillDescriptions(ConfigurationDescriptions &descriptions)
 {
     ParameterSetDescription desc;
-    desc.add<InputTag>("src")->setComment("Source collection of electrons.");
-    desc.add<InputTag>("rho", InputTag("fixedGridRhoFastjetAll"))->
-      setComment("Rho (mean angular pt density).");
+    AddCommonParameters(desc);
+    desc.add<InputTag>("recoContext", InputTag("recoContext"))->
+      setComment("Event-level reconstructed information, which provides rho and the first "
+      "primary vertex.");
     desc.add<FileInPath>("effAreas")->
       setComment("Data file with effective areas for electron isolation.");
-    desc.add<InputTag>("primaryVertices")->
-      setComment("Collection of reconstructed primary vertices.");
     desc.add<vector<string>>("embeddedBoolIDs", vector<string>(0))->
       setComment("Labels of embedded boolean electron ID decisions to be stored.");
     desc.add<vector<InputTag>>("boolIDMaps", vector<InputTag>(0))->
@@ -55,160 +73,205 @@ void PECElectrons::fillDescriptions(ConfigurationDescriptions &descriptions)
       setComment("Labels of embedded real-valued electron ID decisions to be stored.");
     desc.add<vector<InputTag>>("contIDMaps", vector<InputTag>(0))->
       setComment("Maps with additional real-valued electron ID decisions to be stored.");
-    desc.add<vector<string>>("selection", vector<string>(0))->
-      setComment("User-defined selections for electrons whose results will be stored in the "
-      "output tree.");
+    desc.add<bool>("separateContIDs", false)->
+      setComment("Indicates whether real-valued IDs should be put into the event as a separate "
+      "product instead of being stored in pec::Electron.");
+    desc.add<unsigned>("contIDBits", 0)->
+      setComment("Number of bits to quantize separately stored real-valued IDs in the range "
+      "[-1, 1]. Zero means that they are stored as floats.");
     
     descriptions.add("electrons", desc);
 }
 
 
-void PECElectrons::beginJob()
+void PECElectrons::ComputeIsolation(View<pat::Electron> const &electrons, vector<float> &relIso)
 {
-    outTree = fileService->make<TTree>("Electrons", "Properties of selected electrons");
-    
-    storeElectronsPointer = &storeElectrons;
-    outTree->Branch("electrons", &storeElectronsPointer);
+    // Isolation is computed as in [1].  See also explanations here [2].
+    //[1] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleEffAreaPFIsoCut.cc#L83-L94
+    //[2] https://hypernews.cern.ch/HyperNews/CMS/get/egamma/1664/1.html
+    for (unsigned i = 0; i < electrons.size(); ++i)
+    {
+        pat::Electron const &el = electrons[i];
+        reco::GsfElectron::PflowIsolationVariables const &pfIso = el.pfIsolationVariables();
+        double const ea = eaReader.getEffectiveArea(fabs(el.superCluster()->eta()));
+        double const iso = pfIso.sumChargedHadronPt +
+         max(pfIso.sumNeutralHadronEt + pfIso.sumPhotonEt - rho * ea, 0.);
+        
+        relIso[i] = iso / el.pt();
+    }
 }
 
 
-void PECElectrons::analyze(Event const &event, EventSetup const &)
+void PECElectrons::FillLepton(pec::Electron &storeElectron, pat::Electron const &el,
+  unsigned index)
 {
-    // Read the electron collection and rho
-    Handle<View<pat::Electron>> srcElectrons;
-    Handle<double> rho;
+    // Set pseudorapidity of the associated supercluster
+    storeElectron.SetEtaSC(el.superCluster()->eta());
+    
     
-    event.getByToken(electronToken, srcElectrons);
-    event.getByToken(rhoToken, rho);
+    // Copy non-triggering MVA ID stored as a userFloat
+    // storeElectron.SetContinuousID(0,
+    //   el.userFloat("ElectronMVAEstimatorRun2Spring15NonTrig25nsV1Values"));
+    unsigned nUsedContIDs = 0;
     
     
-    // Get the first primary vertex
-    Handle<reco::VertexCollection> vertices;
-    event.getByToken(primaryVerticesToken, vertices);
+    // Copy embedded ID decisions. Real-valued ones are written either into the electron or into
+    //the separate buffer
+    unsigned const nEmbeddedBoolIDs = embeddedBoolIDLabels.size();
+    unsigned const nEmbeddedContIDs = embeddedContIDLabels.size();
+    unsigned const nContIDs = nEmbeddedContIDs + contIDMapValues.size();
     
-    if (vertices->size() == 0)
+    auto setContID = [&](unsigned i, float value)
     {
-        edm::Exception excp(edm::errors::LogicError);
-        excp << "Event must contain at least one primary vertex.\n";
-        excp.raise();
-    }
+        if (separateContIDs)
+            contIDValues[index * nContIDs + i] = value;
+        else
+            storeElectron.SetContinuousID(i, value);
+    };
     
-    auto const &firstPV = vertices->front();
+    for (unsigned i = 0; i < nEmbeddedBoolIDs; ++i)
+        storeElectron.SetBooleanID(i, GetEmbeddedBoolID(el, i));
     
+    for (unsigned i = 0; i < nEmbeddedContIDs; ++i)
+        setContID(nUsedContIDs + i, el.userFloat(embeddedContIDLabels[i]));
     
-    // Read ID maps
-    vector<Handle<ValueMap<bool>>> boolIDMaps(boolIDMapTokens.size());
-    vector<Handle<ValueMap<float>>> contIDMaps(contIDMapTokens.size());
+    nUsedContIDs += nEmbeddedContIDs;
     
-    for (unsigned i = 0; i < boolIDMapTokens.size(); ++i)
-        event.getByToken(boolIDMapTokens.at(i), boolIDMaps.at(i));
     
-    for (unsigned i = 0; i < contIDMapTokens.size(); ++i)
-        event.getByToken(contIDMapTokens.at(i), contIDMaps.at(i));
+    // Copy additional ID decisions read from the maps
+    for (unsigned i = 0; i < boolIDMapValues.size(); ++i)
+        storeElectron.SetBooleanID(nEmbeddedBoolIDs + i, boolIDMapValues[i][index]);
     
+    for (unsigned i = 0; i < contIDMapValues.size(); ++i)
+        setContID(nUsedContIDs + i, contIDMapValues[i][index]);
     
-    // Loop through the collection and store relevant properties of electrons
-    storeElectrons.clear();
-    pec::Electron storeElectron;  // will reuse this object to fill the vector
     
-    for (unsigned i = 0; i < srcElectrons->size(); ++i)
+    // Evaluate loose selection on impact parameters [1]. It is implemented as in [2-3].
+    //[1] https://twiki.cern.ch/twiki/bin/view/CMS/CutBasedElectronIdentificationRun2?rev=41#Offline_selection_criteria
+    //[2] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleDxyCut.cc#L58-L68
+    //[3] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleDzCut.cc#L58-L68
+    bool passIPCuts;
+    double const d0 = std::abs(el.gsfTrack()->dxy(firstPVPosition));
+    double const dz = std::abs(el.gsfTrack()->dz(firstPVPosition));
+    
+    if (std::abs(el.superCluster()->eta()) < 1.479)
+        passIPCuts = (d0 < 0.05 and dz < 0.10);  // units are cm
+    else
+        passIPCuts = (d0 < 0.10 and dz < 0.20);
+    
+    storeElectron.SetBit(0, passIPCuts);
+}
+
+
+bool PECElectrons::GetEmbeddedBoolID(pat::Electron const &el, unsigned index) const
+{
+    // Check if the ID is found at the cached position. This only requires a single string
+    //comparison instead of a linear search.
+    int const position = embeddedBoolIDIndices[index];
+    auto const &ids = el.electronIDs();
+    
+    if (position >= 0 and unsigned(position) < ids.size() and
+      ids[position].first == embeddedBoolIDLabels[index])
+        return (ids[position].second > 0.5f);
+    
+    return (el.electronID(embeddedBoolIDLabels[index]) > 0.5f);
+    //^ Since pat::Electron::electronID returns a float, need to be accurate with the conversion
+    //to a boolean value
+}
+
+
+void PECElectrons::PutProducts(Event &event)
+{
+    if (not separateContIDs)
+        return;
+    
+    if (contIDBits > 0)
     {
-        pat::Electron const &el = srcElectrons->at(i);
-        storeElectron.Reset();
-        
-        
-        // Set four-momentum. Mass is ignored
-        storeElectron.SetPt(el.pt());
-        storeElectron.SetEta(el.eta());
-        storeElectron.SetPhi(el.phi());
-        
-        storeElectron.SetCharge(el.charge());
-        
-        
-        // Isolation is calculated by a dedicated method
-        storeElectron.SetRelIso(CalculateRhoIsolation(el, *rho));
-        
+        unique_ptr<vector<unsigned short>> codes(new vector<unsigned short>);
+        codes->reserve(contIDValues.size());
         
-        // Set pseudorapidity of the associated supercluster
-        storeElectron.SetEtaSC(el.superCluster()->eta());
+        for (float const value: contIDValues)
+            codes->emplace_back(pec::minifloat::Quantize(value, -1.f, 1.f, contIDBits));
         
+        event.put(move(codes), "contIDs");
+    }
+    else
+        event.put(unique_ptr<vector<float>>(new vector<float>(move(contIDValues))), "contIDs");
+}
+
+
+void PECElectrons::ReadEvent(Event const &event, View<pat::Electron> const &electrons)
+{
+    // Read rho and position of the first primary vertex
+    Handle<pec::RecoContext> context;
+    event.getByToken(contextToken, context);
+    
+    rho = context->Rho();
+    firstPVPosition.SetXYZ(context->FirstPVPosition(0), context->FirstPVPosition(1),
+      context->FirstPVPosition(2));
+    
+    
+    // Resolve positions of embedded boolean IDs using the first electron
+    if (electrons.size() > 0)
+    {
+        auto const &ids = electrons.front().electronIDs();
         
-        // Copy non-triggering MVA ID stored as a userFloat
-        // storeElectron.SetContinuousID(0,
-        //   el.userFloat("ElectronMVAEstimatorRun2Spring15NonTrig25nsV1Values"));
-        unsigned nUsedContIDs = 0;
-        
-        
-        // Copy embedded ID decisions
-        unsigned const nEmbeddedBoolIDs = embeddedBoolIDLabels.size();
-        unsigned const nEmbeddedContIDs = embeddedContIDLabels.size();
-        
-        for (unsigned i = 0; i < nEmbeddedBoolIDs; ++i)
-            storeElectron.SetBooleanID(i, (el.electronID(embeddedBoolIDLabels.at(i)) > 0.5f));
-            //^ Since pat::Electron::electronID returns a float, need to be accurate with the
-            //conversion to a boolean value
-        
-        for (unsigned i = 0; i < nEmbeddedContIDs; ++i)
-            storeElectron.SetContinuousID(nUsedContIDs + i,
-              el.userFloat(embeddedContIDLabels.at(i)));
-        
-        nUsedContIDs += nEmbeddedContIDs;
-        
-        
-        // Copy additional ID decisions from the maps
-        Ptr<pat::Electron> const elPtr(srcElectrons, i);
-        
-        for (unsigned i = 0; i < boolIDMaps.size(); ++i)
-            storeElectron.SetBooleanID(nEmbeddedBoolIDs + i, (*boolIDMaps.at(i))[elPtr]);
-        
-        for (unsigned i = 0; i < contIDMaps.size(); ++i)
-            storeElectron.SetContinuousID(nUsedContIDs + i, (*contIDMaps.at(i))[elPtr]);
-        
-        
-        // Evaluate loose selection on impact parameters [1]. It is implemented as in [2-3].
-        //[1] https://twiki.cern.ch/twiki/bin/view/CMS/CutBasedElectronIdentificationRun2?rev=41#Offline_selection_criteria
-        //[2] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleDxyCut.cc#L58-L68
-        //[3] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleDzCut.cc#L58-L68
-        bool passIPCuts;
-        double const d0 = std::abs(el.gsfTrack()->dxy(firstPV.position()));
-        double const dz = std::abs(el.gsfTrack()->dz(firstPV.position()));
-        
-        if (std::abs(el.superCluster()->eta()) < 1.479)
-            passIPCuts = (d0 < 0.05 and dz < 0.10);  // units are cm
-        else
-            passIPCuts = (d0 < 0.10 and dz < 0.20);
-        
-        storeElectron.SetBit(0, passIPCuts);
-        
+        for (unsigned i = 0; i < embeddedBoolIDLabels.size(); ++i)
+        {
+            int &position = embeddedBoolIDIndices[i];
+            
+            if (position >= 0 and unsigned(position) < ids.size() and
+              ids[position].first == embeddedBoolIDLabels[i])
+                continue;
+            
+            position = -1;
+            
+            for (unsigned j = 0; j < ids.size(); ++j)
+                if (ids[j].first == embeddedBoolIDLabels[i])
+                {
+                    position = j;
+                    break;
+                }
+        }
+    }
+    
+    
+    // Read ID maps and copy their values for all electrons, one map at a time
+    for (unsigned iMap = 0; iMap < boolIDMapTokens.size(); ++iMap)
+    {
+        Handle<ValueMap<bool>> map;
+        event.getByToken(boolIDMapTokens[iMap], map);
         
-        // Evaluate user-defined selectors if any
-        unsigned const nUsedBits = 1;
+        auto &values = boolIDMapValues[iMap];
+        values.resize(electrons.size());
         
-        for (unsigned i = 0; i < eleSelectors.size(); ++i)
-            storeElectron.SetBit(nUsedBits + i, eleSelectors[i](el));
+        for (unsigned i = 0; i < electrons.size(); ++i)
+        {
+            Ptr<pat::Electron> const elPtr = electrons.ptrAt(i);
+            values[i] = map->get(elPtr.id(), elPtr.key());
+        }
+    }
+    
+    for (unsigned iMap = 0; iMap < contIDMapTokens.size(); ++iMap)
+    {
+        Handle<ValueMap<float>> map;
+        event.getByToken(contIDMapTokens[iMap], map);
         
+        auto &values = contIDMapValues[iMap];
+        values.resize(electrons.size());
         
-        // The electron is set up. Add it to the vector.
-        storeElectrons.emplace_back(storeElectron);
+        for (unsigned i = 0; i < electrons.size(); ++i)
+        {
+            Ptr<pat::Electron> const elPtr = electrons.ptrAt(i);
+            values[i] = map->get(elPtr.id(), elPtr.key());
+        }
     }
     
     
-    // Fill the output tree
-    outTree->Fill();
-}
-
-
-double PECElectrons::CalculateRhoIsolation(reco::GsfElectron const &el, double const rho) const
-{
-    // Isolation is computed as in [1].  See also explanations here [2].
-    //[1] https://github.com/ikrav/cmssw/blob/egm_id_80X_v1/RecoEgamma/ElectronIdentification/plugins/cuts/GsfEleEffAreaPFIsoCut.cc#L83-L94
-    //[2] https://hypernews.cern.ch/HyperNews/CMS/get/egamma/1664/1.html
-    reco::GsfElectron::PflowIsolationVariables const &pfIso = el.pfIsolationVariables();
-    double const ea = eaReader.getEffectiveArea(fabs(el.superCluster()->eta()));
-    double const iso = pfIso.sumChargedHadronPt +
-     max(pfIso.sumNeutralHadronEt + pfIso.sumPhotonEt - rho * ea, 0.);
-    
-    return iso / el.pt();
+    // Allocate the buffer for separately stored real-valued IDs
+    if (separateContIDs)
+        contIDValues.assign(electrons.size() * (embeddedContIDLabels.size() +
+          contIDMapTokens.size()), 0.f);
 }
 
 
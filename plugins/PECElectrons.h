@@ -1,22 +1,18 @@
 #pragma once
 
+#include "PECLeptons.h"
+
 #include <Analysis/PECTuples/interface/Electron.h>
+#include <Analysis/PECTuples/interface/RecoContext.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
 #include <DataFormats/PatCandidates/interface/Electron.h>
-#include <DataFormats/VertexReco/interface/VertexFwd.h>
+#include <DataFormats/VertexReco/interface/Vertex.h>
 #include <RecoEgamma/EgammaTools/interface/EffectiveAreas.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
-
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
 
 #include <string>
 #include <vector>
@@ -24,21 +20,47 @@
 
 /**
  * \class PECElectrons
- * \brief Stores electrons
+ * \brief Converts electrons into PEC format
  * 
- * The plugin stores basic properties of electrons in the given collection. It saves their
- * four-momenta, isolation, quality flags, etc. The mass in the four-momentum is always set to zero
- * to facilitate file compression. Bit field inherited from CandidateWithID includes decision of a
- * conversion rejection algorithm and results of custom selections specifed by the user.
+ * The plugin extracts basic properties of electrons in the given collection and puts them into the
+ * event as a collection of pec::Electron, which is expected to be written into a ROOT file with
+ * plugin PECWriter. It saves their four-momenta, isolation, quality flags, etc. The mass in the
+ * four-momentum is always set to zero to facilitate file compression. Bit field inherited from
+ * CandidateWithID includes decision of a conversion rejection algorithm and results of custom
+ * selections specifed by the user.
  * 
  * The plugin can store various IDs in a flexible way. It can store a variable number of boolean
  * and real-valued decisions embedded in pat::Electron, accessing them via labels provided in the
  * configuration. In addition, it can include boolean and real-valued decisions provided in the
  * form of value maps. All these IDs are optional. It also stores the value of the dicriminator for
  * non-triggering MVA ID; the access to it is hard-coded.
+ * 
+ * By default, real-valued IDs are stored in pec::Electron, whose capacity is fixed at compile time
+ * (see pec::Electron::contIdSize). If parameter "separateContIDs" is set to true, they are instead
+ * put into the event as a separate product with instance label "contIDs", and the corresponding
+ * fields of pec::Electron are left at their default values. The product contains exactly N values
+ * per electron, where N is the number of embedded real-valued IDs plus the number of the maps,
+ * with all values for the first electron followed by all values for the second one, etc. Within
+ * each electron, embedded IDs precede the ones from the maps, in the order given in the
+ * configuration. The number of IDs is thus only limited by the configuration. If parameter
+ * "contIDBits" is positive, the values are expected to lie in the range [-1, 1], as is usual for
+ * MVA scores, and are stored as codes of the given length obtained with pec::minifloat::Quantize.
+ * The product is then of type std::vector<unsigned short>; otherwise it is std::vector<float>.
+ * Names of the IDs and the number of bits can be recorded in the output file by PECWriter (see
+ * the documentation for that class).
+ * 
+ * If filters are listed in parameter set "triggerMatching", each electron is matched to trigger
+ * objects, and the mask of filters with a matched object is stored (see class TriggerMatcher).
+ * 
+ * The loop over electrons and the common properties of leptons are implemented in class
+ * PECLeptons. Positions of embedded boolean IDs in pat::Electron are resolved once and then
+ * reused while the layout does not change, and values from the ID maps are read for all
+ * electrons of an event in a single pass over each map.
  */
-class PECElectrons: public edm::EDAnalyzer
+class PECElectrons: public PECLeptons<PECElectrons, pat::Electron, pec::Electron>
 {
+    friend PECLeptons<PECElectrons, pat::Electron, pec::Electron>;
+    
 public:
     /**
      * \brief Constructor
@@ -51,36 +73,40 @@ public:
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates output tree
-    virtual void beginJob() override;
-    
-    /**
-     * \brief Analyses current event
-     * 
-     * Copies electrons into the buffers, evaluates string-based selections, fills the output tree.
-     */
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
-    
 private:
     /**
-     * \brief Calculates rho-corrected relative isolation for the given electron
+     * \brief Calculates rho-corrected relative isolation for all electrons
      * 
      * Generic description of electron isolation is provided in [1]. Note that the effective areas
      * are now calculated in a more elaborate way than in Run 1 [2].
      * [1] https://twiki.cern.ch/twiki/bin/view/CMS/EgammaPFBasedIsolationRun2
      * [2] https://indico.cern.ch/event/369239/contribution/4
      */
-    double CalculateRhoIsolation(reco::GsfElectron const &el, double const rho) const;
+    void ComputeIsolation(edm::View<pat::Electron> const &electrons, std::vector<float> &relIso);
     
-private:
-    /// Source collection of electrons
-    edm::EDGetTokenT<edm::View<pat::Electron>> electronToken;
+    /// Sets electron-specific properties: IDs, pseudorapidity of supercluster, and IP cuts
+    void FillLepton(pec::Electron &storeElectron, pat::Electron const &el, unsigned index);
     
-    /// Rho (mean angular pt density)
-    edm::EDGetTokenT<double> rhoToken;
+    /// Puts real-valued IDs into the event if they are stored separately
+    void PutProducts(edm::Event &event);
     
-    /// Collection of reconstructed primary vertices
-    edm::EDGetTokenT<reco::VertexCollection> primaryVerticesToken;
+    /// Returns the value of the embedded boolean ID with the given index
+    bool GetEmbeddedBoolID(pat::Electron const &el, unsigned index) const;
+    
+    /**
+     * \brief Reads rho, the first primary vertex, and ID maps
+     * 
+     * Values from the ID maps are copied for all electrons. Positions of embedded boolean IDs
+     * are resolved from the first electron if the layout differs from what was seen before.
+     */
+    void ReadEvent(edm::Event const &event, edm::View<pat::Electron> const &electrons);
+    
+private:
+    /// Number of bits in the bit field set by this class
+    static unsigned const numReservedBits = 1;
+    
+    /// Event-level reconstructed information, which provides rho and the first primary vertex
+    edm::EDGetTokenT<pec::RecoContext> contextToken;
     
     /// Names of embedded boolean IDs to be saved
     std::vector<std::string> embeddedBoolIDLabels;
@@ -94,37 +120,38 @@ private:
     /// Maps with additional real-valued IDs
     std::vector<edm::EDGetTokenT<edm::ValueMap<float>>> contIDMapTokens;
     
-    /**
-     * \brief String-based selections
-     * 
-     * These selections do not affect which electrons are stored in the output files. Instead, each
-     * string defines a selection that is evaluated and whose result is saved in the bit field of
-     * the CandidateWithID class.
-     * 
-     * Details on implementation are documented in [1].
-     * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuidePhysicsCutParser
-     */
-    std::vector<StringCutObjectSelector<pat::Electron>> eleSelectors;
-    
-    
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Indicates whether real-valued IDs are put into the event as a separate product
+    bool separateContIDs;
     
+    /// Number of bits to quantize separately stored real-valued IDs; zero means no quantization
+    unsigned contIDBits;
     
     /// An object to access effective areas for electron isolation
     EffectiveAreas eaReader;
     
+    /**
+     * \brief Positions of embedded boolean IDs in pat::Electron::electronIDs()
+     * 
+     * A negative value means that the ID was not found, and the name-based accessor is used.
+     */
+    std::vector<int> embeddedBoolIDIndices;
+    
+    /// Rho in the current event
+    double rho;
+    
+    /// Position of the first primary vertex in the current event
+    reco::Vertex::Point firstPVPosition;
     
-    /// Output tree
-    TTree *outTree;
+    /// Values of boolean IDs from the maps for all electrons, indexed as [map][electron]
+    std::vector<std::vector<bool>> boolIDMapValues;
     
-    /// Buffer to store electrons
-    std::vector<pec::Electron> storeElectrons;
+    /// Values of real-valued IDs from the maps for all electrons, indexed as [map][electron]
+    std::vector<std::vector<float>> contIDMapValues;
     
     /**
-     * \brief An auxiliary pointer
+     * \brief Separately stored real-valued IDs for all electrons in the current event
      * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
+     * Indexed as [electron * numContIDs + id]. Only used if separateContIDs is true.
      */
-    std::vector<pec::Electron> *storeElectronsPointer;
+    std::vector<float> contIDValues;
 };
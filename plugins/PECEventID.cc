@@ -3,11 +3,17 @@
 #include <FWCore/Utilities/interface/InputTag.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
 
+#include <memory>
+
+
 using namespace edm;
+using namespace std;
 
 
 PECEventID::PECEventID(ParameterSet const &)
-{}
+{
+    produces<pec::EventID>();
+}
 
 
 void PECEventID::fillDescriptions(ConfigurationDescriptions &descriptions)
@@ -18,31 +24,20 @@ void PECEventID::fillDescriptions(ConfigurationDescriptions &descriptions)
 }
 
 
-void PECEventID::beginJob()
-{
-    outTree = fileService->make<TTree>("EventID", "Event ID");
-    
-    eventIdPointer = &eventId;
-    outTree->Branch("eventId", &eventIdPointer);
-}
-
-
-void PECEventID::analyze(edm::Event const &event, edm::EventSetup const &)
+void PECEventID::produce(StreamID, Event &event, EventSetup const &) const
 {
-    // Reset the buffer from the previous event
-    eventId.Reset();
-    
+    unique_ptr<pec::EventID> eventId(new pec::EventID);
     
-    eventId.SetRunNumber(event.id().run());
-    eventId.SetEventNumber(event.id().event());
-    eventId.SetLumiSectionNumber(event.luminosityBlock());
+    eventId->SetRunNumber(event.id().run());
+    eventId->SetEventNumber(event.id().event());
+    eventId->SetLumiSectionNumber(event.luminosityBlock());
     
     if (event.isRealData())
-        eventId.SetBunchCrossing(event.bunchCrossing());
+        eventId->SetBunchCrossing(event.bunchCrossing());
     
     
-    // Fill the output tree
-    outTree->Fill();
+    // Put the ID into the event
+    event.put(move(eventId));
 }
 
 
@@ -9,6 +9,8 @@
 
 #include <Math/GenVector/VectorUtil.h>
 
+#include <memory>
+
 
 using namespace std;
 using namespace edm;
@@ -17,7 +19,8 @@ using namespace edm;
 PECGenJetMET::PECGenJetMET(edm::ParameterSet const &cfg):
     jetSelector(cfg.getParameter<string>("cut")),
     saveFlavourCounters(cfg.getParameter<bool>("saveFlavourCounters")),
-    noDoubleCounting(cfg.getParameter<bool>("noDoubleCounting"))
+    noDoubleCounting(cfg.getParameter<bool>("noDoubleCounting")),
+    compactMET(cfg.getParameter<bool>("compactMET"))
 {
     // Register required input data
     jetToken = consumes<View<reco::GenJet>>(cfg.getParameter<InputTag>("jets"));
@@ -29,6 +32,15 @@ PECGenJetMET::PECGenJetMET(edm::ParameterSet const &cfg):
     }
     else
         metGiven = false;
+    
+    
+    // Register products
+    produces<vector<pec::GenJet>>();
+    
+    if (metGiven and compactMET)
+        produces<pec::MET>("MET");
+    else if (metGiven)
+        produces<vector<pec::Candidate>>("METs");
 }
 
 
@@ -44,55 +56,51 @@ void PECGenJetMET::fillDescriptions(ConfigurationDescriptions &descriptions)
     desc.add<bool>("noDoubleCounting", true)->
      setComment("Indicates if same heavy-flavour hadron can be counted in several jets.");
     desc.addOptional<InputTag>("met")->setComment("MET.");
+    desc.add<bool>("compactMET", false)->
+     setComment("Indicates if MET should be stored as an object pec::MET.");
     
     descriptions.add("genJetMET", desc);
 }
 
 
-void PECGenJetMET::beginJob()
-{
-    tree = fs->make<TTree>("GenJetMET", "Properties of generator-level jets and generator-level "
-     "MET");
-    
-    
-    storeJetsPointer = &storeJets;
-    tree->Branch("jets", &storeJetsPointer);
-    
-    if (metGiven)
-    {
-        storeMETsPointer = &storeMETs;
-        tree->Branch("METs", &storeMETsPointer);
-    }
-}
-
-
-void PECGenJetMET::analyze(edm::Event const &event, edm::EventSetup const &setup)
+void PECGenJetMET::produce(edm::Event &event, edm::EventSetup const &setup)
 {
     // Read the collection of generator-level jets
     Handle<View<reco::GenJet>> jets;
     event.getByToken(jetToken, jets);
     
     
-    // Collections of already encountered hadrons with b and c quarks. They are needed to prevent
-    //accounting for same hadrons twice. The collections are global for all jets in the event;
-    //therefore if a parton has been counted in a jet, it normally cannot be counted again even in a
-    //different jet. Since jets are ordered in pt, harder jets have priority in getting the hadrons
-    //assigned. However, if the noDoubleCounting flag is set to false, the collections are reset for
-    //every jet, which turns the cleaning local, per-jet only
-    vector<reco::Candidate const *> bHadFound, cHadFound;
+    // Reset the memoization of hadron ancestors
+    hadronRoots.clear();
+    
+    
+    // Flags of already encountered hadrons with b and c quarks. They are needed to prevent
+    //accounting for same hadrons twice. The flags are global for all jets in the event; therefore
+    //if a parton has been counted in a jet, it normally cannot be counted again even in a different
+    //jet. Since jets are ordered in pt, harder jets have priority in getting the hadrons assigned.
+    //However, if the noDoubleCounting flag is set to false, the flags are reset for every jet,
+    //which turns the cleaning local, per-jet only
+    for (int const key: countedHadrons)
+        hadronCounted[key] = 0;
+    
+    countedHadrons.clear();
     
     
     // Loop over the jets
-    storeJets.clear();
-    pec::GenJet storeJet;  // will reuse same object to fill the vector
+    unique_ptr<vector<pec::GenJet>> storeJets(new vector<pec::GenJet>);
+    storeJets->reserve(jets->size());
     
     for (unsigned i = 0; i < jets->size(); ++i)
     {
         auto const &j = jets->at(i);
-        storeJet.Reset();
         
         if (jetSelector(j))
         {
+            // Add a default-initialized jet to the vector and fill it in place
+            storeJets->emplace_back();
+            pec::GenJet &storeJet = storeJets->back();
+            
+            
             // Save the jet four-momentum
             storeJet.SetPt(j.pt());
             storeJet.SetEta(j.eta());
@@ -112,8 +120,10 @@ void PECGenJetMET::analyze(edm::Event const &event, edm::EventSetup const &setup
                 //restricted to the current jet only
                 if (not noDoubleCounting)
                 {
-                    bHadFound.clear();
-                    cHadFound.clear();
+                    for (int const key: countedHadrons)
+                        hadronCounted[key] = 0;
+                    
+                    countedHadrons.clear();
                 }
                 
                 
@@ -128,64 +138,44 @@ void PECGenJetMET::analyze(edm::Event const &event, edm::EventSetup const &setup
                         continue;
                     
                     
-                    // The jet constituent is a stable particle. Check its parents among pruned GEN
-                    //particles
-                    
-                    // Get the first mother. It is treated specially because it is of a different
-                    //type (reco::GenParticle) than the constituent. Though it is downcasted to
-                    //reco::Candidate for simplicity
-                    reco::Candidate const *p =
-                     dynamic_cast<pat::PackedGenParticle const *>(constituent.get())->mother(0);
+                    // The jet constituent is a stable particle. Find the oldest hadron among its
+                    //ancestors in the collection of pruned GEN particles. A typical situation with
+                    //miniAOD when there is no such hadron is when a consituent is declared an
+                    //immediate daughter of an initial proton
+                    reco::GenParticleRef const &mother =
+                     dynamic_cast<pat::PackedGenParticle const *>(constituent.get())->motherRef();
                     
-                    if (not p)
+                    if (mother.isNull())
                         continue;
                     
+                    int const root = FindHadronRoot(mother);
                     
-                    // To calculate the b/c-hadron multiplicities, we are only interested in
-                    //hadron ancestors. They have status 2 and abs(pdgId) > 100. If this condition
-                    //is not met, skip to the next jet constituent. A typical situation with miniAOD
-                    //when it happens, is when a consituent is declared an immediate daughter of an
-                    //initial proton
-                    if (p->status() > 2 or abs(p->pdgId()) <= 100)
+                    if (root < 0)
                         continue;
                     
                     
-                    // Follow the ancestors until the oldest hadron is reached. On the stopping
-                    //condition see the comment above
-                    while (p->mother(0) and abs(p->mother(0)->pdgId()) > 100 and
-                     p->mother(0)->status() <= 2)
-                        p = p->mother(0);
+                    // Make sure the hadron has not been counted before
+                    if (hadronCounted[root])
+                        continue;
+                    
+                    hadronCounted[root] = 1;
+                    countedHadrons.emplace_back(root);
                     
                     
-                    // Check the type of the particle as in AN-2012/251
-                    int const absPdgId = abs(p->pdgId());
+                    // Check the type of the hadron as in AN-2012/251
+                    int const absPdgId = abs((*mother.product())[root].pdgId());
                     
                     if ((absPdgId / 100) % 10 == 5 or (absPdgId / 1000) % 10 == 5)
-                    {
-                        // It is a hadron with b quark. Make sure it is a new one
-                        if (find(bHadFound.begin(), bHadFound.end(), p) == bHadFound.end())
-                        {
-                            ++bMult;
-                            bHadFound.emplace_back(p);
-                        }
-                    }
+                        ++bMult;
                     
                     if ((absPdgId / 100) % 10 == 4 or (absPdgId / 1000) % 10 == 4)
-                        if (find(cHadFound.begin(), cHadFound.end(), p) == cHadFound.end())
-                        {
-                            ++cMult;
-                            cHadFound.emplace_back(p);
-                        }
+                        ++cMult;
                 }
                 
                 
                 storeJet.SetBottomMult(bMult);
                 storeJet.SetCharmMult(cMult);
             }
-            
-            
-            // Add the jet to the vector
-            storeJets.emplace_back(storeJet);
         }
     }
     
@@ -198,18 +188,93 @@ void PECGenJetMET::analyze(edm::Event const &event, edm::EventSetup const &setup
         pat::MET const &met = metHandle->front();
         
         
-        storeMETs.clear();
+        if (compactMET)
+        {
+            unique_ptr<pec::MET> storeMET(new pec::MET);
+            storeMET->SetP(met.genMET()->px(), met.genMET()->py());
+            event.put(move(storeMET), "MET");
+        }
+        else
+        {
+            unique_ptr<vector<pec::Candidate>> storeMETs(new vector<pec::Candidate>(1));
+            pec::Candidate &storeMET = storeMETs->front();
+            storeMET.SetPt(met.genMET()->pt());
+            storeMET.SetPhi(met.genMET()->phi());
+            
+            event.put(move(storeMETs), "METs");
+        }
+    }
+    
+    
+    // Put the collection of jets into the event
+    event.put(move(storeJets));
+}
+
+
+int PECGenJetMET::FindHadronRoot(reco::GenParticleRef const &particle)
+{
+    // Set up the memoization table when the first pruned particle in the event is visited
+    if (hadronRoots.empty())
+    {
+        prunedParticlesID = particle.id();
+        unsigned const nParticles = particle.product()->size();
+        hadronRoots.assign(nParticles, -2);
+        
+        if (hadronCounted.size() < nParticles)
+            hadronCounted.resize(nParticles, 0);
+    }
+    
+    
+    // Particles from a different collection are not expected. Do not memoize them
+    if (particle.id() != prunedParticlesID)
+        return -1;
+    
+    int const key = particle.key();
+    
+    if (hadronRoots[key] != -2)
+        return hadronRoots[key];
+    
+    if (particle->status() > 2 or abs(particle->pdgId()) <= 100)
+    {
+        hadronRoots[key] = -1;
+        return -1;
+    }
+    
+    
+    // Follow the ancestors until the oldest hadron or a particle with a known result is reached
+    ancestorPath.clear();
+    reco::GenParticleRef p = particle;
+    int root = -1;
+    
+    while (true)
+    {
+        ancestorPath.emplace_back(p.key());
+        
+        if (p->numberOfMothers() == 0)
+            break;
         
-        pec::Candidate storeMET;
-        storeMET.SetPt(met.genMET()->pt());
-        storeMET.SetPhi(met.genMET()->phi());
+        reco::GenParticleRef const mother = p->motherRef(0);
         
-        storeMETs.emplace_back(storeMET);
+        if (mother.id() != prunedParticlesID or abs(mother->pdgId()) <= 100 or
+         mother->status() > 2)
+            break;
+        
+        if (hadronRoots[mother.key()] >= 0)
+        {
+            root = hadronRoots[mother.key()];
+            break;
+        }
+        
+        p = mother;
     }
     
+    if (root < 0)
+        root = ancestorPath.back();
+    
+    for (int const visited: ancestorPath)
+        hadronRoots[visited] = root;
     
-    // Fill the output tree
-    tree->Fill();
+    return root;
 }
 
 
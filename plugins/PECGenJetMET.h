@@ -1,42 +1,50 @@
 #pragma once
 
 #include <Analysis/PECTuples/interface/GenJet.h>
+#include <Analysis/PECTuples/interface/MET.h>
+#include "CompiledCut.h"
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/stream/EDProducer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
+#include <DataFormats/HepMCCandidate/interface/GenParticleFwd.h>
 #include <DataFormats/JetReco/interface/GenJet.h>
 #include <DataFormats/PatCandidates/interface/MET.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
-
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
 
+#include <cstdint>
 #include <vector>
 
 
 /**
  * \class PECGenJetMET
- * \brief A CMSSW plugin to save generator-level jets and MET
+ * \brief A CMSSW plugin to convert generator-level jets and MET into PEC format
  * 
- * Saves generator-level jets in a ROOT file. In the default configuration the plugin stores only
- * their four momenta. If the flag saveFlavourCounters is set to true, it saves additionally the
- * numbers of hadrons with b or c quarks among ancestors of jet's constituents (as it was done in
- * AN-2012/251). In the default configuration each hadron is counted only once; it the case of
+ * Puts generator-level jets into the event as a collection of pec::GenJet, which is expected to be
+ * written into a ROOT file with plugin PECWriter. In the default configuration the plugin stores
+ * only their four momenta. If the flag saveFlavourCounters is set to true, it saves additionally
+ * the numbers of hadrons with b or c quarks among ancestors of jet's constituents (as it was done
+ * in AN-2012/251). In the default configuration each hadron is counted only once; it the case of
  * ambiguity (when its decay products are shared among several jets), it is assigned to the harder
  * jet. This behaviour can be switched off by setting the flag noDoubleCounting to false, which is
  * usually not recommended however [1].
  * [1] https://github.com/andrey-popov/single-top/issues/49
  * 
+ * Oldest hadron ancestors of jet constituents are found among pruned generator-level particles.
+ * Since many constituents share ancestors, results are memoized per event for every pruned
+ * particle visited, and each decay chain is followed only once for all jets.
+ * 
  * In an optional input tag for reconstructed (sic!) MET is provided, the corresponding
- * generator-level MET is also stored.
+ * generator-level MET is also stored, with instance label "METs". Although only a single
+ * generator-level MET is stored in each event, a vector is used for the sake of uniformity with
+ * the PECJetMET plugin. MET is stored as an instance of pec::Candidate, but pseudorapidity and
+ * mass are set to zeros, which allows them to be compressed efficiently. If parameter
+ * "compactMET" is set to true, generator-level MET is instead stored as an object pec::MET with
+ * instance label "MET", as done in PECJetMET. Its shifts are all zero.
  */
-class PECGenJetMET: public edm::EDAnalyzer
+class PECGenJetMET: public edm::stream::EDProducer<>
 {
 public:
     /// Constructor from a configuration fragment
@@ -46,11 +54,18 @@ public:
     /// A method to verify plugin's configuration
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates the output tree and assigns it branches
-    void beginJob() override;
+    /// Puts generator-level jets and MET into the event
+    void produce(edm::Event &event, edm::EventSetup const &setup) override;
     
-    /// Fills the output tree with generator-level jets
-    void analyze(edm::Event const &event, edm::EventSetup const &setup) override;
+private:
+    /**
+     * \brief Finds the oldest hadron ancestor of the given pruned particle
+     * 
+     * A hadron is a particle with status 2 or lower and abs(pdgId) > 100. Ancestors are followed
+     * along first mothers as long as they are hadrons. Returns the key of the oldest hadron, or
+     * (-1) if the given particle is not a hadron. Results are memoized for all particles visited.
+     */
+    int FindHadronRoot(reco::GenParticleRef const &particle);
     
 private:
     /// Collection of generator-level jets
@@ -64,7 +79,7 @@ private:
      * 
      * If the string is empty, all jets are saved.
      */
-    StringCutObjectSelector<reco::Candidate> const jetSelector;
+    CompiledCut<reco::Candidate> const jetSelector;
     
     /// Indicates whether the plugin should store information on flavours of jet constituents
     bool const saveFlavourCounters;
@@ -79,44 +94,26 @@ private:
     /// Indicates whether an input tag for MET is provided in the configuration
     bool metGiven;
     
-    
-    /// A service to write to ROOT files
-    edm::Service<TFileService> fs;
-    
-    
-    /// The output tree (owned by the TFile service)
-    TTree *tree;
+    /// Requests that MET is stored as an object pec::MET
+    bool const compactMET;
     
     /**
-     * \brief Trimmed generator-level jets to be stored in the output file
+     * \brief Memoized results of FindHadronRoot in the current event
      * 
-     * Depending on the flag saveFlavourCounters, the jets will or will not contain information on
-     * the numbers of B and C hadrons inside them.
+     * Indexed with keys of pruned particles. The value (-2) means that the result has not been
+     * computed yet. Empty until the first pruned particle in the event is visited.
      */
-    std::vector<pec::GenJet> storeJets;
+    std::vector<int> hadronRoots;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    std::vector<pec::GenJet> *storeJetsPointer;
+    /// Product ID of the collection of pruned particles in the current event
+    edm::ProductID prunedParticlesID;
     
-    /**
-     * \brief Buffer to store MET
-     * 
-     * Although only a single generator-level MET is stored in each event, a vector is used for the
-     * sake of uniformity with the PECJetMET plugin. MET is  stored as an instance of
-     * pec::Candidate, but pseudorapidity and mass are set to zeros, which allows them to be
-     * compressed efficiently. The buffer is filled if only an tag to access MET is provided in the
-     * configuration.
-     */
-    std::vector<pec::Candidate> storeMETs;
+    /// Buffer with keys of particles visited while following ancestors
+    std::vector<int> ancestorPath;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    std::vector<pec::Candidate> *storeMETsPointer;
+    /// Flags indicating which hadrons, identified by their keys, have already been counted
+    std::vector<std::uint8_t> hadronCounted;
+    
+    /// Keys of hadrons that have been counted, to reset hadronCounted
+    std::vector<int> countedHadrons;
 };
@@ -5,92 +5,60 @@
 
 #include <FWCore/Framework/interface/MakerMacros.h>
 
-#include <map>
+#include <memory>
 
 
 using namespace std;
 using namespace edm;
 
 
-PECGenParticles::ParticleWithMother::ParticleWithMother():
-    particle(nullptr),
-    mother(nullptr)
-{}
-
-
-PECGenParticles::ParticleWithMother::ParticleWithMother(reco::Candidate const *particle_,
- reco::Candidate const *mother_ /*= nullptr*/):
-    particle(particle_),
-    mother(mother_)
-{}
-
-
-reco::Candidate const *PECGenParticles::ParticleWithMother::operator->() const
-{
-    return particle;
-}
-
-
-bool PECGenParticles::ParticleWithMother::operator==(reco::Candidate const *rhs) const
+void PECGenParticles::Adjacency::Build(View<reco::GenParticle> const &particles, bool mothers)
 {
-    return (particle == rhs);
-}
-
-
-reco::Candidate const *PECGenParticles::ParticleWithMother::Get() const
-{
-    return particle;
-}
-
-
-void PECGenParticles::ParticleWithMother::ResetMother(reco::Candidate const *mother_)
-{
-    mother = mother_;
-}
-
-
-unsigned PECGenParticles::ParticleWithMother::NumberOfMothers() const
-{
-    if (mother)
-        return 1;
-    else
-        return particle->numberOfMothers();
-}
-
-
-reco::Candidate const *PECGenParticles::ParticleWithMother::Mother(int index) const
-{
-    if (mother)
+    start.clear();
+    indices.clear();
+    start.reserve(particles.size() + 1);
+    
+    if (particles.size() == 0)
     {
-        // Return the overriding mother
-        return (index == 0 or index == -1) ? mother : nullptr;
+        start.emplace_back(0);
+        return;
     }
-    else
+    
+    
+    // References to mothers and daughters are only followed if they point to the same product
+    ProductID const id = particles.refAt(0).id();
+    
+    for (reco::GenParticle const &p: particles)
     {
-        int const nMothers = particle->numberOfMothers();
-        
-        
-        // Check the range of the index
-        if (index >= nMothers or index < -nMothers)
-            return nullptr;
-        
-        
-        // Reinterpret a negative index
-        if (index < 0)
-            index += nMothers;
+        start.emplace_back(indices.size());
+        unsigned const n = (mothers) ? p.numberOfMothers() : p.numberOfDaughters();
         
-        return particle->mother(index);
+        for (unsigned j = 0; j < n; ++j)
+        {
+            reco::GenParticleRef const ref = (mothers) ? p.motherRef(j) : p.daughterRef(j);
+            
+            if (ref.id() == id)
+                indices.emplace_back(ref.key());
+        }
     }
+    
+    start.emplace_back(indices.size());
 }
 
 
-PECGenParticles::PECGenParticles(ParameterSet const &cfg)
+PECGenParticles::PECGenParticles(ParameterSet const &cfg):
+    saveFullRecord(cfg.getParameter<bool>("saveFullRecord"))
 {
     genParticlesToken =
      consumes<View<reco::GenParticle>>(cfg.getParameter<InputTag>("genParticles"));
     
     for (auto const &absPdgId: cfg.getParameter<vector<unsigned>>("saveExtraParticles"))
         desiredExtraPartIds.emplace(absPdgId);
+    
+    produces<vector<pec::GenParticle>>();
+    
+    if (saveFullRecord)
+        produces<pec::GenParticleRecord>("fullRecord");
 }
 
 
@@ -101,46 +69,70 @@ void PECGenParticles::fillDescriptions(ConfigurationDescriptions &descriptions)
      setComment("Tag to access generator particles.");
     desc.add<vector<unsigned>>("saveExtraParticles", {6, 23, 24, 25})->
      setComment("(Absolute) PDG IDs of additional particles to be stored.");
+    desc.add<bool>("saveFullRecord", false)->
+     setComment("Indicates whether all particles from the source collection should be stored in "
+     "a compact record.");
     
     descriptions.add("pecGenParticles", desc);
 }
 
 
-void PECGenParticles::beginJob()
-{
-    outTree = fileService->make<TTree>("HardInteraction",
-     "Tree contrains generator-level particles from the hard interaction");
-    
-    storeParticlesPointer = &storeParticles;
-    outTree->Branch("particles", &storeParticlesPointer);
-}
-
-
-void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &setup)
+void PECGenParticles::produce(edm::Event &event, edm::EventSetup const &setup)
 {
     #ifdef DEBUG
     cout << "\033[1;34mEvent: " << event.id().run() << ":" << event.id().event() << "\033[0m\n\n";
     #endif
-        
-    
-    // Clear vectors of particles to be stored
-    bookedParticles.clear();
-    storeParticles.clear();
     
     
     // Read the generator-level particles
     Handle<View<reco::GenParticle>> genParticles;
     event.getByToken(genParticlesToken, genParticles);
+    int const nParticles = genParticles->size();
+    
+    
+    // Reset buffers and copy the information needed to navigate the decay tree
+    unique_ptr<vector<pec::GenParticle>> storeParticles(new vector<pec::GenParticle>);
+    bookedParticles.clear();
+    bookedSlots.assign(nParticles, -1);
+    roots.assign(nParticles, -1);
+    isMEFinalState.assign(nParticles, 0);
+    isExtraPartRoot.assign(nParticles, 0);
+    
+    pdgIds.resize(nParticles);
+    
+    for (int i = 0; i < nParticles; ++i)
+        pdgIds[i] = (*genParticles)[i].pdgId();
+    
+    mothers.Build(*genParticles, true);
+    daughters.Build(*genParticles, false);
+    
+    
+    // Save all particles in the compact record if requested
+    if (saveFullRecord)
+    {
+        unique_ptr<pec::GenParticleRecord> record(new pec::GenParticleRecord);
+        
+        for (int i = 0; i < nParticles; ++i)
+        {
+            reco::GenParticle const &p = (*genParticles)[i];
+            record->AddParticle(p.pdgId(), p.status(), p.pt(), p.eta(), p.phi(), p.mass());
+            
+            for (unsigned iMother = 0; iMother < mothers.Size(i); ++iMother)
+                record->AddMother(mothers.Get(i, iMother));
+        }
+        
+        event.put(move(record), "fullRecord");
+    }
     
     
     // Loop over the source collection of GEN-level particles and identify particles from the final
     //state of the hard(est) interaction and oldest versions of desired additional particles. Both
-    //groups of pointers are stored in sets, so there is no need to care about double counting
-    set<reco::Candidate const *> meFinalState, extraPartRoots;
-    
-    for (reco::GenParticle const &p: *genParticles)
+    //groups are marked with flags indexed with positions in the source collection, so there is no
+    //need to care about double counting
+    for (int i = 0; i < nParticles; ++i)
     {
-        int const absPdgId = abs(p.pdgId());
+        reco::GenParticle const &p = (*genParticles)[i];
+        int const absPdgId = abs(pdgIds[i]);
         
         
         // Skip artificial objects like string or clusters
@@ -158,52 +150,49 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
             //done below
             //[1] http://home.thep.lu.se/~torbjorn/pythia81html/ParticleProperties.html
             if (p.status() == 3 or (p.status() > 20 and p.status() < 30))
-                meFinalState.emplace(&p);
+                isMEFinalState[i] = 1;
         }
         
         
-        // Check if the current particle is of type the user wants to store
+        // Check if the current particle is of type the user wants to store. If so, find the
+        //oldest ancestor of the same type (in Pythia 8 same particle might enter the history many
+        //times)
         if (desiredExtraPartIds.count(absPdgId) > 0)
-        {
-            // Find the oldest ancestor of the same type (in Pythia 8 same particle might enter the
-            //history many times)
-            reco::Candidate const *root = &p;
-            
-            while (root->numberOfMothers() > 0 and root->mother(0)->pdgId() == root->pdgId())
-                root = root->mother(0);
-            
-            
-            extraPartRoots.emplace(root);
-        }
+            isExtraPartRoot[FindRoot(i)] = 1;
     }
     
     
     #ifdef DEBUG
     cout << "Final state:\n";
     
-    for (auto const &p: meFinalState)
-        cout << " PDG ID: " << p->pdgId() << ", status: " << p->status() << '\n';
+    for (int i = 0; i < nParticles; ++i)
+        if (isMEFinalState[i])
+            cout << " PDG ID: " << pdgIds[i] << ", status: " << (*genParticles)[i].status() << '\n';
     
     cout << "\nRoots of interesting particles:\n";
     
-    for (auto const &p: extraPartRoots)
-        cout << " PDG ID: " << p->pdgId() << ", status: " << p->status() << '\n';
+    for (int i = 0; i < nParticles; ++i)
+        if (isExtraPartRoot[i])
+            cout << " PDG ID: " << pdgIds[i] << ", status: " << (*genParticles)[i].status() << '\n';
     
     cout << endl;
     #endif
     
     
     // Identify particles from the initial state. They are mothers of the final state
-    for (auto const &pMEFinal: meFinalState)
+    for (int i = 0; i < nParticles; ++i)
     {
-        for (unsigned iMother = 0; iMother < pMEFinal->numberOfMothers(); ++iMother)
+        if (not isMEFinalState[i])
+            continue;
+        
+        for (unsigned iMother = 0; iMother < mothers.Size(i); ++iMother)
         {
-            auto const *mother = pMEFinal->mother(iMother);
+            int const mother = mothers.Get(i, iMother);
             
             // In miniAOD with Pythia 8 gluons from the initial state are not stored. As a result,
             //one or both of the incoming protons are set as mothers of the final state. Do not
             //store them
-            if (abs(mother->pdgId()) == 2212)
+            if (abs(pdgIds[mother]) == 2212)
                 continue;
             
             
@@ -216,44 +205,53 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
     cout << "Initial state:\n";
     
     for (auto const &p: bookedParticles)
-        cout << " PDG ID: " << p->pdgId() << ", status: " << p->status() << '\n';
+        cout << " PDG ID: " << pdgIds[p.index] << ", status: " <<
+          (*genParticles)[p.index].status() << '\n';
     
     cout << endl;
     #endif
     
     
     // Book particles from the final state
-    for (auto const &p: meFinalState)
-        BookParticle(p);
+    for (int i = 0; i < nParticles; ++i)
+        if (isMEFinalState[i])
+            BookParticle(i);
     
     
     // Book additional particles requested by the user
-    for (auto const &root: extraPartRoots)
+    for (int root = 0; root < nParticles; ++root)
     {
+        if (not isExtraPartRoot[root])
+            continue;
+        
+        
         // The oldest ancestor (the "root") found before
         BookParticle(root);
-                
+        
         
         // Move along descendants of the root until the youngest descendant of the same type is
         //found. It then decays to other particles
-        reco::Candidate const *decay = root;
+        int decay = root;
         
         while (true)
         {
-            reco::Candidate const *daughterSamePdgId = nullptr;
+            int daughterSamePdgId = -1;
             
-            for (unsigned iDaughter = 0; iDaughter < decay->numberOfDaughters(); ++iDaughter)
-                if (decay->daughter(iDaughter)->pdgId() == decay->pdgId() and
-                 decay->daughter(iDaughter)->status() > 2)
+            for (unsigned iDaughter = 0; iDaughter < daughters.Size(decay); ++iDaughter)
+            {
+                int const d = daughters.Get(decay, iDaughter);
+                
+                if (pdgIds[d] == pdgIds[decay] and (*genParticles)[d].status() > 2)
                 //^ The second part of the condition is needed for Pythia 6. It has decays like
                 //W[3] -> e[3] v[3] W[2], W[2] -> W[2], W[2] -> nothing, where the number in
                 //brackets is the status
                 {
-                    daughterSamePdgId = decay->daughter(iDaughter);
+                    daughterSamePdgId = d;
                     break;
                 }
+            }
             
-            if (not daughterSamePdgId)
+            if (daughterSamePdgId < 0)
                 break;
             else
                 decay = daughterSamePdgId;
@@ -261,13 +259,13 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
         
         
         // Book decay products of the youngest descendant
-        for (unsigned iDaughter = 0; iDaughter < decay->numberOfDaughters(); ++iDaughter)
+        for (unsigned iDaughter = 0; iDaughter < daughters.Size(decay); ++iDaughter)
         {
-            reco::Candidate const *d = decay->daughter(iDaughter);
+            int const d = daughters.Get(decay, iDaughter);
             
             
             // Skip hadrons (seen this happening in Pythia 6) and artificial objects
-            if (abs(d->pdgId()) > 80)
+            if (abs(pdgIds[d]) > 80)
                 continue;
             
             
@@ -276,63 +274,52 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
     }
     
     
-    // Put all booked particles into the storage vector
-    for (auto const &p: bookedParticles)
-    {
-        pec::GenParticle storeParticle;
-        
-        // Fill PDG ID and four-momentum. Indices of mothers will be set later
-        storeParticle.SetPdgId(p->pdgId());
-        storeParticle.SetPt(p->pt());
-        storeParticle.SetEta(p->eta());
-        storeParticle.SetPhi(p->phi());
-        storeParticle.SetM(p->mass());
-        
-        
-        // Add the new particle to the storage vector
-        storeParticles.emplace_back(storeParticle);
-    }
-    
-    
-    // Set mothers of particles in the storage vector. The mothers are identified with their indices
-    //in the vector. In order to be able to find these indices efficiently, build a mapping from
-    //particle pointers in bookedParticles to their indices in the same vector
-    map<reco::Candidate const *, unsigned> particleToIndex;
-    
-    for (unsigned iPart = 0; iPart < bookedParticles.size(); ++iPart)
-        particleToIndex[bookedParticles.at(iPart).Get()] = iPart;
+    // Put all booked particles into the storage vector and set indices of their mothers. The
+    //mothers are identified with their indices in the vector, which are looked up in bookedSlots.
+    //Note that particles in vectors bookedParticles and storeParticles are ordered identically.
+    storeParticles->resize(bookedParticles.size());
     
-    
-    // Use the map to set up indices of mothers. Note that particles in vectors bookedParticles and
-    //storeParticles are ordered identically
-    for (unsigned iPart = 0; iPart < bookedParticles.size(); ++iPart)
+    for (unsigned iBooked = 0; iBooked < bookedParticles.size(); ++iBooked)
     {
-        auto const &p = bookedParticles.at(iPart);
+        auto const &booked = bookedParticles[iBooked];
+        reco::GenParticle const &p = (*genParticles)[booked.index];
+        pec::GenParticle &storeParticle = (*storeParticles)[iBooked];
+        
+        // Fill PDG ID and four-momentum
+        storeParticle.SetPdgId(p.pdgId());
+        storeParticle.SetPt(p.pt());
+        storeParticle.SetEta(p.eta());
+        storeParticle.SetPhi(p.phi());
+        storeParticle.SetM(p.mass());
         
         
         // First check mothers that were suggested when the particle was booked
         bool motherFound = false;
         
-        // Set first mother (if any)
-        if (p.NumberOfMothers() > 0)
+        if (booked.mother >= 0)
         {
-            auto res = particleToIndex.find(p.Mother(0));
-            
-            if (res != particleToIndex.end())
+            if (bookedSlots[booked.mother] >= 0)
             {
-                storeParticles.at(iPart).SetFirstMotherIndex(res->second);
+                storeParticle.SetFirstMotherIndex(bookedSlots[booked.mother]);
                 motherFound = true;
             }
         }
-        
-        // Set last mother (if more than one)
-        if (p.NumberOfMothers() > 1)
+        else
         {
-            auto res = particleToIndex.find(p.Mother(-1));
+            unsigned const nMothers = mothers.Size(booked.index);
             
-            if (res != particleToIndex.end())
+            // Set first mother (if any)
+            if (nMothers > 0 and bookedSlots[mothers.Get(booked.index, 0)] >= 0)
             {
-                storeParticles.at(iPart).SetLastMotherIndex(res->second);
+                storeParticle.SetFirstMotherIndex(bookedSlots[mothers.Get(booked.index, 0)]);
+                motherFound = true;
+            }
+            
+            // Set last mother (if more than one)
+            if (nMothers > 1 and bookedSlots[mothers.Get(booked.index, nMothers - 1)] >= 0)
+            {
+                storeParticle.SetLastMotherIndex(
+                  bookedSlots[mothers.Get(booked.index, nMothers - 1)]);
                 motherFound = true;
             }
         }
@@ -343,16 +330,15 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
         //saved daughters
         if (not motherFound)
         {
-            reco::Candidate const *mother = p.Get();
+            int mother = booked.index;
             
-            while (mother->numberOfMothers() > 0)
+            while (mothers.Size(mother) > 0)
             {
-                mother = mother->mother(0);
-                auto res = particleToIndex.find(mother);
+                mother = mothers.Get(mother, 0);
                 
-                if (res != particleToIndex.end())
+                if (bookedSlots[mother] >= 0)
                 {
-                    storeParticles.at(iPart).SetFirstMotherIndex(res->second);
+                    storeParticle.SetFirstMotherIndex(bookedSlots[mother]);
                     break;
                 }
             }
@@ -363,9 +349,9 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
     #ifdef DEBUG
     cout << "All particles that will be stored:\n";
     
-    for (unsigned iPart = 0; iPart < storeParticles.size(); ++iPart)
+    for (unsigned iPart = 0; iPart < storeParticles->size(); ++iPart)
     {
-        auto const &p = storeParticles.at(iPart);
+        auto const &p = storeParticles->at(iPart);
         
         cout << " #" << iPart << ": PDG ID: " << p.PdgId() << ", mothers: " <<
          p.FirstMotherIndex() << ", " << p.LastMotherIndex() << endl;
@@ -375,35 +361,62 @@ void PECGenParticles::analyze(edm::Event const &event, edm::EventSetup const &se
     #endif
     
     
-    // Everything is done. Save the event in the output tree
-    outTree->Fill();
+    // Everything is done. Put the collection into the event
+    event.put(move(storeParticles));
 }
 
 
-bool PECGenParticles::BookParticle(reco::Candidate const *p,
- reco::Candidate const *mother /*= nullptr*/)
+bool PECGenParticles::BookParticle(int index, int mother /*= -1*/)
 {
     // Check if the given particle has already been booked for storing
-    auto res = find(bookedParticles.begin(), bookedParticles.end(), p);
+    int const slot = bookedSlots[index];
     
-    if (res != bookedParticles.end())
+    if (slot >= 0)
     //^ The particle is already known
     {
         // Update the mother. It is needed because same particle could be booked twice: as a root
         //and as a decay product (consider a W from decay of a top quark, when the user requests to
         //store both t and W). In this case the particle should be stored with the mother specified
         //when the particle was booked as a decay product, not the real mother
-        if (mother)
-            res->ResetMother(mother);
+        if (mother >= 0)
+            bookedParticles[slot].mother = mother;
         
         return false;
     }
     else
     {
-        bookedParticles.emplace_back(p, mother);
+        bookedSlots[index] = bookedParticles.size();
+        bookedParticles.push_back({index, mother});
         return true;
     }
 }
 
 
+int PECGenParticles::FindRoot(int index)
+{
+    // Climb along first mothers until a particle with a different PDG ID or a particle with a
+    //known root is found
+    int root = index;
+    
+    while (roots[root] < 0 and mothers.Size(root) > 0 and
+      pdgIds[mothers.Get(root, 0)] == pdgIds[root])
+        root = mothers.Get(root, 0);
+    
+    if (roots[root] >= 0)
+        root = roots[root];
+    
+    
+    // Memoize the result for all particles along the path
+    for (int i = index; roots[i] < 0; i = mothers.Get(i, 0))
+    {
+        roots[i] = root;
+        
+        if (i == root)
+            break;
+    }
+    
+    return root;
+}
+
+
 DEFINE_FWK_MODULE(PECGenParticles);
@@ -1,29 +1,29 @@
 #pragma once
 
 #include <Analysis/PECTuples/interface/GenParticle.h>
+#include <Analysis/PECTuples/interface/GenParticleRecord.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/stream/EDProducer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
 #include <DataFormats/HepMCCandidate/interface/GenParticle.h>
+#include <DataFormats/HepMCCandidate/interface/GenParticleFwd.h>
 
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
-
+#include <cstdint>
 #include <set>
 #include <vector>
 
 
 /**
  * \class PECGenParticles
- * \brief Stores particles from the hard(est) interaction and other selected ones in a ROOT file
+ * \brief Converts particles from the hard(est) interaction and other selected ones into PEC format
  * 
- * Stores particles from the final and initial states of the hard(est) interaction.
+ * Selects particles from the final and initial states of the hard(est) interaction and puts them
+ * into the event as a collection of pec::GenParticle, which is expected to be written into a ROOT
+ * file with plugin PECWriter.
  * 
  * In addition, can store extra particles according to a list of PDG ID codes provided by the user.
  * Same particle can be written many times in the event record, as it proceeds through various steps
@@ -37,72 +37,64 @@
  * originating from t -> b -> ... -> B0 -> J/psi, the b quark (which is stored because its a
  * daughter of the top quark) will be listed as the mother of the J/psi in the stored collection.
  * 
+ * If parameter "saveFullRecord" is set to true, the plugin also puts into the event an object of
+ * type pec::GenParticleRecord with instance label "fullRecord". It contains all particles from the
+ * source collection together with their mother-daughter relations, which makes it possible to
+ * study the full (pruned) generator history without running over MiniAOD again.
+ * 
  * The plugin is designed for samples produced with Pythia 6 or 8 (possibly, with an external LHE
  * generator). It might not work properly with other showering and hadronization programs.
+ * 
+ * Internally, particles are identified by their indices in the source collection. Mother-daughter
+ * relations are copied into flat adjacency arrays once per event, and all subsequent navigation
+ * and bookkeeping use these indices. Mothers and daughters that are not in the source collection
+ * are ignored. Buffers are reused between events.
  */
-class PECGenParticles: public edm::EDAnalyzer
+class PECGenParticles: public edm::stream::EDProducer<>
 {
 private:
-    /**
-     * \class ParticleMother
-     * \brief Wraps a pointer to reco::Candidate and overrides its mother
-     * 
-     * If the user constructs an object of this class providing a mother, the given one overrides
-     * real mothers of the particle. If the mother is not specified, the class serves as a proxy
-     * providing access to the real mothers.
-     */
-    class ParticleWithMother
+    /// A particle booked for storing
+    struct BookedParticle
     {
-    public:
-        /// Constructor with no parameters
-        ParticleWithMother();
+        /// Index of the particle in the source collection
+        int index;
         
         /**
-         * \brief Constructor with complete initialisation
+         * \brief Index of the overriding mother in the source collection
          * 
-         * If a null pointer is given as the second argument, the real mothers are not overridden.
+         * If negative, real mothers of the particle are used.
          */
-        ParticleWithMother(reco::Candidate const *particle,
-         reco::Candidate const *mother = nullptr);
-        
-        /// Default move constructor
-        ParticleWithMother(ParticleWithMother &&) = default;
-        
-    public:
-        /// Forwards the call to the wrapped particle
-        reco::Candidate const *operator->() const;
-        
-        /// Compares the wrapped pointer to a particle to the argument
-        bool operator==(reco::Candidate const *rhs) const;
+        int mother;
+    };
+    
+    /**
+     * \brief Flat adjacency arrays
+     * 
+     * Neighbours of particle i are stored at positions [start[i], start[i + 1]) of vector
+     * indices, in the same order as in the source collection.
+     */
+    struct Adjacency
+    {
+        /// Builds the arrays for mothers (if the flag is true) or daughters of all particles
+        void Build(edm::View<reco::GenParticle> const &particles, bool mothers);
         
-        /// Returns the wrapped pointer to a particle
-        reco::Candidate const *Get() const;
+        /// Returns the number of neighbours of the given particle
+        unsigned Size(int i) const
+        {
+            return start[i + 1] - start[i];
+        }
         
-        /// Resets the mother
-        void ResetMother(reco::Candidate const *mother);
+        /// Returns neighbour with the given index for the given particle
+        int Get(int i, unsigned j) const
+        {
+            return indices[start[i] + j];
+        }
         
-        /// Returns the number of mothers of the referenced particle
-        unsigned NumberOfMothers() const;
+        /// Starting positions of neighbours of each particle
+        std::vector<unsigned> start;
         
-        /**
-         * \brief Returns mother with the given index
-         * 
-         * Negative indices are allowed and interpreted as starting from the last mother (for
-         * instance, (-1) means the last mother). If the index is out of the allowed range, returns
-         * a null pointer.
-         */
-        reco::Candidate const *Mother(int index) const;
-        
-    private:
-        /// Wrapped pointer to a particle
-        reco::Candidate const *particle;
-        
-        /**
-         * \brief Overriding mother
-         * 
-         * The overriding mother is considered defined if this pointer is not null.
-         */
-        reco::Candidate const *mother;
+        /// Indices of neighbours of all particles
+        std::vector<int> indices;
     };
     
 public:
@@ -113,22 +105,27 @@ public:
     /// A method to verify plugin's configuration
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates the output tree
-    virtual void beginJob() override;
-    
-    /// Reads the event and stores the relevant information in the output tree
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &setup) override;
+    /// Reads the event and puts selected particles into it
+    virtual void produce(edm::Event &event, edm::EventSetup const &setup) override;
     
 private:
     /**
      * \brief Adds the given particle to the collection of particles that are going to be stored
      * 
-     * The particle is added if only is has not been added before, i.e. duplicates are avoided. The
-     * return value indicates if the particle has been added (if not, it was a duplicate).
-     * Regardless of whether the given particle is new or already present in the collection, its
-     * mother is updated if the second argument is not null.
+     * The particle is identified by its index in the source collection. It is added if only is
+     * has not been added before, i.e. duplicates are avoided. The return value indicates if the
+     * particle has been added (if not, it was a duplicate). Regardless of whether the given
+     * particle is new or already present in the collection, its mother is updated if the second
+     * argument is not negative.
      */
-    bool BookParticle(reco::Candidate const *p, reco::Candidate const *mother = nullptr);
+    bool BookParticle(int index, int mother = -1);
+    
+    /**
+     * \brief Finds the oldest ancestor of the same type for the given particle
+     * 
+     * Ancestors are followed along first mothers. Results are memoized for all particles visited.
+     */
+    int FindRoot(int index);
     
 private:
     /// Collection of generator-level particles
@@ -137,29 +134,34 @@ private:
     /// (Absolute) PDG IDs of additional particles to be saved
     std::set<int> desiredExtraPartIds;
     
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Indicates whether the full record of particles should be saved
+    bool saveFullRecord;
+    
+    /// PDG IDs of all particles in the current event
+    std::vector<int> pdgIds;
+    
+    /// Mothers and daughters of all particles in the current event
+    Adjacency mothers, daughters;
+    
+    /// Memoized roots of particles in the current event; negative if not yet computed
+    std::vector<int> roots;
     
     /**
      * \brief Particles that are going to be stored
      * 
      * The container is utilised to keep track of paricles that have been accepted to be stored in
-     * the output file and helps to avoid duplicates. Pointers in elements of the container refer to
-     * particles in the collection read via genPartilcesToken. Original mothers of some of the
-     * particles are overridden.
+     * the output file. Original mothers of some of the particles are overridden.
      */
-    std::vector<ParticleWithMother> bookedParticles;
-    
-    /// Tree to be written in the output ROOT file
-    TTree *outTree;
-    
-    /// Trimmed generator-level particles to be stored in the output file
-    std::vector<pec::GenParticle> storeParticles;
+    std::vector<BookedParticle> bookedParticles;
     
     /**
-     * \brief An auxiliary pointer
+     * \brief Positions of particles in bookedParticles
      * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
+     * Indexed with indices of particles in the source collection. Negative values mean that the
+     * particle has not been booked.
      */
-    std::vector<pec::GenParticle> *storeParticlesPointer;
+    std::vector<int> bookedSlots;
+    
+    /// Buffers to mark particles from the final state and roots of extra particles
+    std::vector<std::uint8_t> isMEFinalState, isExtraPartRoot;
 };
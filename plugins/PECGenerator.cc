@@ -2,9 +2,12 @@
 
 #include <FWCore/Framework/interface/EventSetup.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/MessageLogger/interface/MessageLogger.h>
 #include <FWCore/Utilities/interface/Exception.h>
 #include <FWCore/Utilities/interface/InputTag.h>
 
+#include <memory>
+
 
 using namespace edm;
 using namespace std;
@@ -12,46 +15,55 @@ using namespace std;
 
 PECGenerator::PECGenerator(ParameterSet const &cfg):
     lheWeightIndices(cfg.getParameter<std::vector<int>>("saveAltLHEWeights")),
-    psWeightIndices(cfg.getParameter<std::vector<int>>("saveAltPSWeights"))
+    psWeightIndices(cfg.getParameter<std::vector<int>>("saveAltPSWeights")),
+    numClippedRatios(0)
 {
-    generatorToken = consumes<GenEventInfoProduct>(cfg.getParameter<InputTag>("generator"));
+    contextToken = consumes<pec::GeneratorContext>(
+      cfg.getParameter<InputTag>("generatorContext"));
     
-    // LHEEventProduct must be read whenever an LHE-based sample is processed, not just when
-    //alternative LHE-level weights are requested. This is because process ID is normally read from
-    //the LHE event record. When processing samples without LHE (e.g. pure Pythia), an empty tag
-    //should be given to indicate that this information is not available.
-    InputTag lheEventInfoTag(cfg.getParameter<InputTag>("lheEventProduct"));
     
-    if (lheEventInfoTag.label() != "")
-    {
-        readLHEEventRecord = true;
-        lheEventInfoToken = consumes<LHEEventProduct>(lheEventInfoTag);
-    }
-    else
+    // Range for ratios of alternative LHE weights to the nominal one
+    auto const &ratioRange = cfg.getParameter<vector<double>>("altLHEWeightRatioRange");
+    storeAltLHEWeightRatios = not ratioRange.empty();
+    
+    if (storeAltLHEWeightRatios)
     {
-        readLHEEventRecord = false;
-        
-        if (not lheWeightIndices.Empty())
+        if (ratioRange.size() != 2 or not (ratioRange[0] < ratioRange[1]))
         {
             cms::Exception excp("Configuration");
-            excp << "A valid value for lheEventProduct must be provided in order to access " <<
-              "alternative LHE-level weights.";
+            excp << "Parameter altLHEWeightRatioRange must be either empty or contain two " <<
+              "values in the increasing order.";
             excp.raise();
         }
+        
+        altLHEWeightRatioMin = ratioRange[0];
+        altLHEWeightRatioMax = ratioRange[1];
     }
+    else
+        altLHEWeightRatioMin = altLHEWeightRatioMax = 0.f;
+}
+
+
+void PECGenerator::endJob()
+{
+    if (numClippedRatios > 0)
+        LogWarning("PECGenerator") << numClippedRatios.load() << " ratios of alternative LHE " <<
+          "weights to the nominal one fell outside of the range [" << altLHEWeightRatioMin <<
+          ", " << altLHEWeightRatioMax << ") and were clipped.";
 }
 
 
 void PECGenerator::fillDescriptions(ConfigurationDescriptions &descriptions)
 {
     ParameterSetDescription desc;
-    desc.add<InputTag>("generator", InputTag("generator"))->
-      setComment("Tag to access GenEventInfoProduct.");
-    desc.add<InputTag>("lheEventProduct", InputTag("externalLHEProducer"))->
-      setComment("Tag to access LHEEventProduct. An empty value (\"\") is allowed.");
+    desc.add<InputTag>("generatorContext", InputTag("generatorContext"))->
+      setComment("Tag to access pec::GeneratorContext.");
     desc.add<std::vector<int>>("saveAltLHEWeights", std::vector<int>())->
       setComment("Intervals of indices of alternative LHE-level weights to be stored. "
         "Parsed using class IndexIntervals.");
+    desc.add<std::vector<double>>("altLHEWeightRatioRange", std::vector<double>())->
+      setComment("Range in which ratios of alternative LHE-level weights to the nominal weight "
+        "are encoded. If empty, the weights are stored as is.");
     desc.add<std::vector<int>>("saveAltPSWeights", std::vector<int>())->
       setComment("Intervals of indices of alternative PS weights to be stored. "
         "Parsed using class IndexIntervals.");
@@ -60,81 +72,98 @@ void PECGenerator::fillDescriptions(ConfigurationDescriptions &descriptions)
 }
 
 
-void PECGenerator::beginJob()
-{
-    outTree = fileService->make<TTree>("Generator", "Global generator-level properties");
-    
-    generatorInfoPointer = &generatorInfo;
-    outTree->Branch("generator", &generatorInfoPointer);
-}
-
-
-void PECGenerator::analyze(Event const &event, EventSetup const &)
+void PECGenerator::produce(StreamID, Event &event, EventSetup const &) const
 {
-    // Reset the buffer from the previous event
-    generatorInfo.Reset();
+    unique_ptr<pec::GeneratorInfo> generatorInfo(new pec::GeneratorInfo);
     
     
     // Read generator information for the current event and set process ID
-    Handle<GenEventInfoProduct> generator;
-    event.getByToken(generatorToken, generator);
-    
-    Handle<LHEEventProduct> lheEventInfo;
+    Handle<pec::GeneratorContext> context;
+    event.getByToken(contextToken, context);
     
-    if (readLHEEventRecord)
-    {
-        event.getByToken(lheEventInfoToken, lheEventInfo);
-        generatorInfo.SetProcessId(lheEventInfo->hepeup().IDPRUP);
-    }
-    else
-    {
-        // Cannot read process ID as given in the LHE event record. Instead of a default, read one
-        //from GenEventInfoProduct
-        generatorInfo.SetProcessId(generator->signalProcessID());
-    }
-
+    generatorInfo->SetProcessId(context->ProcessId());
     
     
     // Event weights
-    generatorInfo.SetNominalWeight(generator->weight());
+    generatorInfo->SetNominalWeight(context->NominalWeight());
     
-    if (readLHEEventRecord and not lheWeightIndices.Empty())
+    if (not lheWeightIndices.Empty())
     {
-        // Alternative LHE weights will be rescaled by the ratio between the nominal weight above
-        //and the nominal LHE weight, as instructed here [1]
-        //[1] https://twiki.cern.ch/twiki/bin/viewauth/CMS/LHEReaderCMSSW?rev=7#How_to_use_weights
-        double const factor = generator->weight() / lheEventInfo->originalXWGTUP();
+        if (not context->HasLhe())
+        {
+            cms::Exception excp("Configuration");
+            excp << "Alternative LHE-level weights are requested, but LHE information is not " <<
+              "available in pec::GeneratorContext.";
+            excp.raise();
+        }
         
+        if (context->AltLheWeights().empty())
+        {
+            cms::Exception excp("Configuration");
+            excp << "Alternative LHE-level weights are requested, but pec::GeneratorContext " <<
+              "does not contain them. Make sure that they are computed by its producer " <<
+              "(parameter computeAltLHEWeights).";
+            excp.raise();
+        }
         
-        // Save selected alternative weights
-        vector<gen::WeightsInfo> const &altWeights = lheEventInfo->weights();
-
-        for (int i: lheWeightIndices.GetIndices(0, altWeights.size() - 1))
-            generatorInfo.AddAltLheWeight(altWeights[i].wgt * factor);
+        
+        // Store the weights as ratios to the nominal one if requested. This is not possible if
+        //the nominal weight is zero
+        if (storeAltLHEWeightRatios and generatorInfo->NominalWeight() != 0.)
+            generatorInfo->SetAltLheWeightRatioRange(altLHEWeightRatioMin, altLHEWeightRatioMax);
+        
+        
+        // Save selected alternative weights. They have already been rescaled to the nominal
+        //weight. They are gathered into a buffer and then set all at once
+        vector<double> const &altWeights = context->AltLheWeights();
+        IndexIntervals::Compiled selection;
+        lheWeightIndices.Compile(0, int(altWeights.size()) - 1, selection);
+        
+        vector<float> buffer(selection.Size());
+        selection.Gather(altWeights.data(), buffer.data(), [](double w){return w;});
+        generatorInfo->SetAltLheWeights(buffer.data(), buffer.size());
+        
+        if (generatorInfo->AltLheWeightsAsRatios())
+        {
+            double const nominalWeight = generatorInfo->NominalWeight();
+            unsigned numClipped = 0;
+            
+            for (float const w: buffer)
+            {
+                double const ratio = w / nominalWeight;
+                
+                if (ratio < altLHEWeightRatioMin or ratio >= altLHEWeightRatioMax)
+                    ++numClipped;
+            }
+            
+            numClippedRatios += numClipped;
+        }
     }
 
-    vector<double> const &genWeights = generator->weights();
+    vector<double> const &genWeights = context->AltPsWeights();
 
     if (not psWeightIndices.Empty() and genWeights.size() > 1)
     {
-        for (int i: psWeightIndices.GetIndices(0, genWeights.size() - 1))
-            generatorInfo.AddAltPsWeight(genWeights[i]);
+        IndexIntervals::Compiled selection;
+        psWeightIndices.Compile(0, int(genWeights.size()) - 1, selection);
+        
+        vector<float> buffer(selection.Size());
+        selection.Gather(genWeights.data(), buffer.data(), [](double w){return w;});
+        generatorInfo->SetAltPsWeights(buffer.data(), buffer.size());
     }
         
     
     // PDF information
-    GenEventInfoProduct::PDF const *pdf = generator->pdf();
-    
-    if (pdf)
+    if (context->HasPdf())
     {
-        generatorInfo.SetPdfXs(pdf->x.first, pdf->x.second);
-        generatorInfo.SetPdfIds(pdf->id.first, pdf->id.second);
-        generatorInfo.SetPdfQScale(pdf->scalePDF);
+        generatorInfo->SetPdfXs(context->PdfX(0), context->PdfX(1));
+        generatorInfo->SetPdfIds(context->PdfId(0), context->PdfId(1));
+        generatorInfo->SetPdfQScale(context->PdfQScale());
     }
     
     
-    // Fill the output tree
-    outTree->Fill();
+    // Put the generator information into the event
+    event.put(move(generatorInfo));
 }
 
 
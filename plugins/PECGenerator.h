@@ -1,91 +1,73 @@
 #pragma once
 
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
 #include <Analysis/PECTuples/interface/GeneratorInfo.h>
 #include "IndexIntervals.h"
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/global/EDProducer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
-#include <SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h>
-#include <SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h>
-
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
-
+#include <atomic>
 #include <string>
 #include <vector>
 
 
 /**
  * \class PECGenerator
- * \brief Stores global generator-level information
+ * \brief Puts global generator-level information into the event
+ * 
+ * Extracts generator-level weights, PDF information, etc. and puts them into the event as an
+ * instance of pec::GeneratorInfo, which is expected to be written into a ROOT file with plugin
+ * PECWriter. The inputs are read from pec::GeneratorContext produced by plugin
+ * GeneratorContextProducer, which also rescales alternative LHE-level weights to the nominal
+ * weight from GenEventInfoProduct. If alternative LHE weights are requested, they must be
+ * provided by pec::GeneratorContext; otherwise an exception is thrown.
  * 
- * Saves generator-level weights, PDF information, etc. If the plugin is requested to store
- * alternative LHE-level event weights, they are corrected for the ratio of the nominal weights
- * from GenEventInfoProduct and LHEEventProduct (see the code), as the latter might differ from
- * unity. The process ID is read from the LHE record if it is available. If an empty tag is given
- * as lheEventProduct, the process ID is read from GenEventInfoProduct instead.
+ * If parameter "altLHEWeightRatioRange" is not empty, alternative LHE weights are stored as
+ * quantized ratios to the nominal weight, as described in the documentation for class
+ * pec::GeneratorInfo. In events with a zero nominal weight they are stored as absolute values.
+ * Ratios outside of the range are clipped to its boundaries. The range should therefore include
+ * negative values for samples with negative weights. The number of clipped ratios is reported at
+ * the end of the job.
  * 
  * This plugin must be only run on simulation.
  */
-class PECGenerator: public edm::EDAnalyzer
+class PECGenerator: public edm::global::EDProducer<>
 {
 public:
     /// Constructor
     PECGenerator(edm::ParameterSet const &cfg);
     
 public:
+    /// Reports the number of clipped ratios of alternative LHE weights if any
+    virtual void endJob() override;
+    
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates output tree
-    virtual void beginJob() override;
-    
-    /// Writes global generator information into the buffer and fills the output tree
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+    /// Puts global generator information into the event
+    virtual void produce(edm::StreamID, edm::Event &event, edm::EventSetup const &) const
+      override;
     
 private:
-    /// Token to access global generator information
-    edm::EDGetTokenT<GenEventInfoProduct> generatorToken;
-    
-    /**
-     * \brief Token to access per-event LHE weights
-     * 
-     * The plugin attempts to read these data only in events generated with an external LHE
-     * generator. This is not available for pure Pythia samples, for instance.
-     */
-    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
-    
-    /// Flag requesting to read LHE event record
-    bool readLHEEventRecord;
+    /// Token to access generator-level information shared by several plugins
+    edm::EDGetTokenT<pec::GeneratorContext> contextToken;
     
     /// Indices of LHE event weights to be stored
     IndexIntervals lheWeightIndices;
 
-    /// Indices of PS event weights to be stored
-    IndexIntervals psWeightIndices;
-    
-    
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Indicates whether alternative LHE weights should be stored as ratios to the nominal one
+    bool storeAltLHEWeightRatios;
     
+    /// Range in which ratios of alternative LHE weights to the nominal one are encoded
+    float altLHEWeightRatioMin, altLHEWeightRatioMax;
     
-    /// Output tree
-    TTree *outTree;
-    
-
-    /// Buffer to store generator information
-    pec::GeneratorInfo generatorInfo;
+    /// Indices of PS event weights to be stored
+    IndexIntervals psWeightIndices;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    pec::GeneratorInfo *generatorInfoPointer;
+    /// Number of ratios of alternative LHE weights that fell outside of the range
+    mutable std::atomic<unsigned long long> numClippedRatios;
 };
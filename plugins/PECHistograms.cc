@@ -0,0 +1,328 @@
+#include "PECHistograms.h"
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <cstdlib>
+
+
+PECHistograms::SourceBase::SourceBase(std::string const &name_):
+    name(name_)
+{}
+
+
+std::string const &PECHistograms::SourceBase::Name() const
+{
+    return name;
+}
+
+
+PECHistograms::METSource::METSource(std::string const &name, edm::EDGetTokenT<pec::MET> &&token_):
+    SourceBase(name),
+    token(token_)
+{}
+
+
+PECHistograms::Getter PECHistograms::METSource::FindVariable(std::string const &name,
+  unsigned) const
+{
+    if (name == "pt")
+        return [this](unsigned){return met.Pt();};
+    else if (name == "phi")
+        return [this](unsigned){return met.Phi();};
+    else if (name == "px")
+        return [this](unsigned){return met.Px();};
+    else if (name == "py")
+        return [this](unsigned){return met.Py();};
+    else
+        return {};
+}
+
+
+bool PECHistograms::METSource::IsCollection() const
+{
+    return false;
+}
+
+
+void PECHistograms::METSource::Read(edm::Event const &event)
+{
+    edm::Handle<pec::MET> handle;
+    event.getByToken(token, handle);
+    met = *handle;
+}
+
+
+unsigned PECHistograms::METSource::Size() const
+{
+    return 1;
+}
+
+
+PECHistograms::PECHistograms(edm::ParameterSet const &cfg):
+    useGeneratorWeight(cfg.exists("generator"))
+{
+    usesResource("TFileService");
+
+    for (auto const &branchCfg: cfg.getParameter<std::vector<edm::ParameterSet>>("branches"))
+        AddSource(branchCfg.getParameter<std::string>("name"),
+          branchCfg.getParameter<std::string>("type"),
+          branchCfg.getParameter<edm::InputTag>("src"));
+
+    if (useGeneratorWeight)
+        generatorToken = consumes<pec::GeneratorInfo>(
+          cfg.getParameter<edm::InputTag>("generator"));
+
+    for (auto const &tag: cfg.getParameter<std::vector<edm::InputTag>>("weights"))
+        weightTokens.emplace_back(consumes<double>(tag));
+
+
+    // Resolve variables of all histograms
+    for (auto const &histCfg: cfg.getParameter<std::vector<edm::ParameterSet>>("histograms"))
+    {
+        Histogram hist;
+        hist.name = histCfg.getParameter<std::string>("name");
+        hist.title = histCfg.getParameter<std::string>("title");
+        hist.x = ResolveVariable(histCfg.getParameter<std::string>("x"));
+        hist.binsX = histCfg.getParameter<unsigned>("binsX");
+        hist.minX = histCfg.getParameter<double>("minX");
+        hist.maxX = histCfg.getParameter<double>("maxX");
+
+        std::string const yExpression = histCfg.getParameter<std::string>("y");
+        hist.is2D = not yExpression.empty();
+        hist.collection = hist.x.collection;
+
+        if (hist.is2D)
+        {
+            hist.y = ResolveVariable(yExpression);
+            hist.binsY = histCfg.getParameter<unsigned>("binsY");
+            hist.minY = histCfg.getParameter<double>("minY");
+            hist.maxY = histCfg.getParameter<double>("maxY");
+
+            if (hist.x.collection and hist.y.collection and
+              hist.x.collection != hist.y.collection)
+            {
+                cms::Exception excp("Configuration");
+                excp << "Variables of histogram \"" << hist.name << "\" refer to different " <<
+                  "collections \"" << hist.x.collection->Name() << "\" and \"" <<
+                  hist.y.collection->Name() << "\".";
+                excp.raise();
+            }
+
+            if (not hist.collection)
+                hist.collection = hist.y.collection;
+        }
+
+        hist.hist1D = nullptr;
+        hist.hist2D = nullptr;
+        histograms.emplace_back(std::move(hist));
+    }
+}
+
+
+void PECHistograms::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription branchDesc;
+    branchDesc.add<std::string>("name")->setComment("Name of the branch.");
+    branchDesc.add<std::string>("type")->setComment("Label of the type of the product.");
+    branchDesc.add<edm::InputTag>("src")->setComment("Product to be read.");
+    branchDesc.setAllowAnything();
+
+    edm::ParameterSetDescription histDesc;
+    histDesc.add<std::string>("name")->setComment("Name of the histogram.");
+    histDesc.add<std::string>("title", "")->setComment("Title of the histogram.");
+    histDesc.add<std::string>("x")->setComment("Variable plotted along the x axis.");
+    histDesc.add<unsigned>("binsX")->setComment("Number of bins along the x axis.");
+    histDesc.add<double>("minX")->setComment("Lower edge of the range along the x axis.");
+    histDesc.add<double>("maxX")->setComment("Upper edge of the range along the x axis.");
+    histDesc.add<std::string>("y", "")->setComment(
+      "Variable plotted along the y axis. Leave empty for one-dimensional histograms.");
+    histDesc.add<unsigned>("binsY", 1)->setComment("Number of bins along the y axis.");
+    histDesc.add<double>("minY", 0.)->setComment("Lower edge of the range along the y axis.");
+    histDesc.add<double>("maxY", 1.)->setComment("Upper edge of the range along the y axis.");
+
+    edm::ParameterSetDescription desc;
+    desc.addVPSet("branches", branchDesc)->setComment("Descriptions of products to be read.");
+    desc.addVPSet("histograms", histDesc)->setComment("Descriptions of histograms.");
+    desc.addOptional<edm::InputTag>("generator")->setComment(
+      "Generator-level information that provides the nominal event weight.");
+    desc.add<std::vector<edm::InputTag>>("weights", std::vector<edm::InputTag>())->
+      setComment("Additional event weights.");
+
+    descriptions.add("pecHistograms", desc);
+}
+
+
+void PECHistograms::analyze(edm::Event const &event, edm::EventSetup const &)
+{
+    for (auto &source: sources)
+        source->Read(event);
+
+
+    // Compute the event weight
+    double weight = 1.;
+
+    if (useGeneratorWeight)
+    {
+        edm::Handle<pec::GeneratorInfo> generator;
+        event.getByToken(generatorToken, generator);
+        weight *= generator->NominalWeight();
+    }
+
+    for (auto const &token: weightTokens)
+    {
+        edm::Handle<double> extraWeight;
+        event.getByToken(token, extraWeight);
+        weight *= *extraWeight;
+    }
+
+
+    // Fill the histograms, once per object for histograms that involve a collection
+    for (auto &hist: histograms)
+    {
+        if (not hist.x.IsAvailable() or (hist.is2D and not hist.y.IsAvailable()))
+            continue;
+
+        unsigned const n = (hist.collection) ? hist.collection->Size() : 1;
+
+        for (unsigned i = 0; i < n; ++i)
+        {
+            if (hist.is2D)
+                hist.hist2D->Fill(hist.x.getter(i), hist.y.getter(i), weight);
+            else
+                hist.hist1D->Fill(hist.x.getter(i), weight);
+        }
+    }
+}
+
+
+void PECHistograms::beginJob()
+{
+    for (auto &hist: histograms)
+    {
+        if (hist.is2D)
+        {
+            hist.hist2D = fileService->make<TH2D>(hist.name.c_str(), hist.title.c_str(),
+              hist.binsX, hist.minX, hist.maxX, hist.binsY, hist.minY, hist.maxY);
+            hist.hist2D->Sumw2();
+        }
+        else
+        {
+            hist.hist1D = fileService->make<TH1D>(hist.name.c_str(), hist.title.c_str(),
+              hist.binsX, hist.minX, hist.maxX);
+            hist.hist1D->Sumw2();
+        }
+    }
+}
+
+
+void PECHistograms::AddSource(std::string const &name, std::string const &type,
+  edm::InputTag const &src)
+{
+    if (type == "Candidates")
+        sources.emplace_back(new CollectionSource<pec::Candidate>(name,
+          consumes<std::vector<pec::Candidate>>(src)));
+    else if (type == "Electrons")
+        sources.emplace_back(new CollectionSource<pec::Electron>(name,
+          consumes<std::vector<pec::Electron>>(src)));
+    else if (type == "Muons")
+        sources.emplace_back(new CollectionSource<pec::Muon>(name,
+          consumes<std::vector<pec::Muon>>(src)));
+    else if (type == "Jets")
+        sources.emplace_back(new CollectionSource<pec::Jet>(name,
+          consumes<std::vector<pec::Jet>>(src)));
+    else if (type == "GenParticles")
+        sources.emplace_back(new CollectionSource<pec::GenParticle>(name,
+          consumes<std::vector<pec::GenParticle>>(src)));
+    else if (type == "GenJets")
+        sources.emplace_back(new CollectionSource<pec::GenJet>(name,
+          consumes<std::vector<pec::GenJet>>(src)));
+    else if (type == "MET")
+        sources.emplace_back(new METSource(name, consumes<pec::MET>(src)));
+    else if (type == "UInt")
+        sources.emplace_back(new ScalarSource<unsigned>(name, consumes<unsigned>(src)));
+    else if (type == "Float")
+        sources.emplace_back(new ScalarSource<float>(name, consumes<float>(src)));
+    else if (type == "Double")
+        sources.emplace_back(new ScalarSource<double>(name, consumes<double>(src)));
+    else
+    {
+        cms::Exception excp("Configuration");
+        excp << "Branch \"" << name << "\" has type \"" << type << "\", which is not supported " <<
+          "for histograms.";
+        excp.raise();
+    }
+}
+
+
+PECHistograms::Variable PECHistograms::ResolveVariable(std::string const &expression) const
+{
+    // Split off the index of the value in a column with several values per object
+    std::string name(expression);
+    unsigned index = 0;
+    auto const bracket = name.rfind('[');
+
+    if (bracket != std::string::npos and name.back() == ']')
+    {
+        index = std::strtoul(name.c_str() + bracket + 1, nullptr, 10);
+        name.resize(bracket);
+    }
+
+
+    for (auto const &source: sources)
+    {
+        std::string const &sourceName = source->Name();
+
+        // Number of objects in a collection
+        if (source->IsCollection() and name == "n_" + sourceName)
+        {
+            SourceBase const *collection = source.get();
+            return {[collection](unsigned){return collection->Size();}, nullptr, nullptr, 0};
+        }
+
+        // Property of the object with the given index in a collection
+        if (source->IsCollection() and
+          name.compare(0, sourceName.size() + 1, sourceName + "[") == 0)
+        {
+            auto const closing = name.find("]_", sourceName.size() + 1);
+
+            if (closing != std::string::npos)
+            {
+                unsigned const object = std::strtoul(
+                  name.c_str() + sourceName.size() + 1, nullptr, 10);
+                auto const getter = source->FindVariable(name.substr(closing + 2), index);
+
+                if (getter)
+                    return {[getter, object](unsigned){return getter(object);}, nullptr,
+                      source.get(), object};
+            }
+        }
+
+        // Properties of objects or event-level numbers
+        Getter getter;
+
+        if (name == sourceName)
+            getter = source->FindVariable("", index);
+        else if (name.compare(0, sourceName.size() + 1, sourceName + "_") == 0)
+            getter = source->FindVariable(name.substr(sourceName.size() + 1), index);
+
+        if (getter)
+            return {getter, (source->IsCollection()) ? source.get() : nullptr, nullptr, 0};
+    }
+
+
+    cms::Exception excp("Configuration");
+    excp << "Variable \"" << expression << "\" cannot be resolved.";
+    excp.raise();
+
+    return {};
+}
+
+
+bool PECHistograms::Variable::IsAvailable() const
+{
+    return not objectSource or objectIndex < objectSource->Size();
+}
+
+
+DEFINE_FWK_MODULE(PECHistograms);
@@ -0,0 +1,381 @@
+#pragma once
+
+#include "FlatColumns.h"
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+#include <Analysis/PECTuples/interface/GeneratorInfo.h>
+#include <Analysis/PECTuples/interface/MET.h>
+
+#include <TH1D.h>
+#include <TH2D.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class PECHistograms
+ * \brief Fills histograms of properties of PEC objects instead of writing them into a tree
+ *
+ * This plugin is an alternative to PECWriter for quick checks of data quality and validation of
+ * samples. It reads the same products, which are described with the same vector of parameter sets
+ * "branches" (only parameters "name", "type", and "src" are used), but instead of filling an
+ * output tree it fills a configurable set of one- and two-dimensional histograms, which are
+ * stored through TFileService. Outputs of different jobs are then merged by summing the
+ * histograms, and their size does not depend on the number of processed events.
+ *
+ * Each histogram is described with a parameter set that provides its name, title, and binning
+ * along each axis, as well as the variable to be plotted along it ("x" and, for two-dimensional
+ * histograms, "y"). Variables are referred to with the names of the corresponding branches in the
+ * flat layout of PECWriter:
+ *   "<branch>_<column>"     property of objects in a collection, with column names defined in
+ *                           namespace flatcolumns (e.g. "jets_pt"); for columns with several
+ *                           values per object, the index is given in square brackets, e.g.
+ *                           "jets_flavour[1]",
+ *   "<branch>[<i>]_<column>" property of the object with index i in a collection, e.g.
+ *                           "METs[0]_pt" for the nominal MET; events in which the collection
+ *                           contains fewer objects are skipped,
+ *   "n_<branch>"            number of objects in a collection,
+ *   "<branch>"              value of a branch of type "UInt", "Float", or "Double",
+ *   "<branch>_<property>"   property "pt", "phi", "px", or "py" of a branch of type "MET".
+ * A histogram that involves a property of objects in a collection, other than a property of an
+ * object with a given index, is filled once per object. If
+ * it is two-dimensional, both variables must then refer either to the same collection or to
+ * event-level quantities. Supported types of branches are "Candidates", "Electrons", "Muons",
+ * "Jets", "GenParticles", "GenJets", "MET", "UInt", "Float", and "Double".
+ *
+ * Histograms are filled with the product of the nominal generator-level weight from the
+ * pec::GeneratorInfo given by optional parameter "generator" and the additional event weights of
+ * type double listed in parameter "weights". All histograms store sums of squared weights.
+ * Exceptions are thrown if a variable cannot be resolved or a branch has an unsupported type.
+ */
+class PECHistograms: public edm::one::EDAnalyzer<edm::one::SharedResources>
+{
+private:
+    /// Function that evaluates a variable for an object with the given index
+    using Getter = std::function<double(unsigned)>;
+
+    /// Abstract interface for a product from which variables are evaluated
+    class SourceBase
+    {
+    public:
+        /// Constructor from the name of the branch
+        SourceBase(std::string const &name);
+
+        /// Virtual destructor
+        virtual ~SourceBase() = default;
+
+    public:
+        /**
+         * \brief Returns a function to evaluate the variable with the given name
+         *
+         * The name is given without the name of the branch and the separating underscore, and it
+         * is empty for branches that store a single number. The index is used for columns with
+         * several values per object. If the variable is not known, an empty function is returned.
+         */
+        virtual Getter FindVariable(std::string const &name, unsigned index) const = 0;
+
+        /// Indicates whether the product is a collection of objects
+        virtual bool IsCollection() const = 0;
+
+        /// Returns name of the branch
+        std::string const &Name() const;
+
+        /// Reads the product from the event
+        virtual void Read(edm::Event const &event) = 0;
+
+        /// Returns the number of objects in the current event
+        virtual unsigned Size() const = 0;
+
+    private:
+        /// Name of the branch
+        std::string name;
+    };
+
+
+    /// A collection of PEC objects of type T
+    template<typename T>
+    class CollectionSource: public SourceBase
+    {
+    public:
+        /// Constructor
+        CollectionSource(std::string const &name, edm::EDGetTokenT<std::vector<T>> &&token);
+
+    public:
+        /// Returns a function to evaluate the column with the given name
+        virtual Getter FindVariable(std::string const &name, unsigned index) const override;
+
+        /// Returns true
+        virtual bool IsCollection() const override;
+
+        /// Reads the collection from the event
+        virtual void Read(edm::Event const &event) override;
+
+        /// Returns the number of objects in the current event
+        virtual unsigned Size() const override;
+
+    private:
+        /// Token to read the collection
+        edm::EDGetTokenT<std::vector<T>> token;
+
+        /// Table that provides getters for properties of the objects; it is never booked
+        FlatTable<T> table;
+
+        /// Collection in the current event
+        std::vector<T> const *objects;
+    };
+
+
+    /// A single number of type T
+    template<typename T>
+    class ScalarSource: public SourceBase
+    {
+    public:
+        /// Constructor
+        ScalarSource(std::string const &name, edm::EDGetTokenT<T> &&token);
+
+    public:
+        /// Returns a function to evaluate the number if the name is empty
+        virtual Getter FindVariable(std::string const &name, unsigned index) const override;
+
+        /// Returns false
+        virtual bool IsCollection() const override;
+
+        /// Reads the number from the event
+        virtual void Read(edm::Event const &event) override;
+
+        /// Returns 1
+        virtual unsigned Size() const override;
+
+    private:
+        /// Token to read the number
+        edm::EDGetTokenT<T> token;
+
+        /// Value in the current event
+        double value;
+    };
+
+
+    /// A pec::MET object
+    class METSource: public SourceBase
+    {
+    public:
+        /// Constructor
+        METSource(std::string const &name, edm::EDGetTokenT<pec::MET> &&token);
+
+    public:
+        /// Returns a function to evaluate the nominal property with the given name
+        virtual Getter FindVariable(std::string const &name, unsigned index) const override;
+
+        /// Returns false
+        virtual bool IsCollection() const override;
+
+        /// Reads MET from the event
+        virtual void Read(edm::Event const &event) override;
+
+        /// Returns 1
+        virtual unsigned Size() const override;
+
+    private:
+        /// Token to read MET
+        edm::EDGetTokenT<pec::MET> token;
+
+        /// MET in the current event
+        pec::MET met;
+    };
+
+
+    /// Resolved variable
+    struct Variable
+    {
+        /// Function to evaluate the variable
+        Getter getter;
+
+        /// Collection to which the variable refers, or null for event-level variables
+        SourceBase const *collection;
+
+        /// Collection from which a single object is taken, or null if not applicable
+        SourceBase const *objectSource;
+
+        /// Index of the object in collection objectSource
+        unsigned objectIndex;
+
+        /// Checks whether the variable can be evaluated in the current event
+        bool IsAvailable() const;
+    };
+
+
+    /// Description of a histogram
+    struct Histogram
+    {
+        /// Name and title of the histogram
+        std::string name, title;
+
+        /// Variables plotted along the axes; y is not used for one-dimensional histograms
+        Variable x, y;
+
+        /// Indicates whether the histogram is two-dimensional
+        bool is2D;
+
+        /// Binning along the axes
+        unsigned binsX, binsY;
+        double minX, maxX, minY, maxY;
+
+        /// Collection over whose objects the histogram is filled, or null
+        SourceBase const *collection;
+
+        /// Histogram, which is created at the beginning of the job
+        TH1D *hist1D;
+        TH2D *hist2D;
+    };
+
+public:
+    /// Constructor
+    PECHistograms(edm::ParameterSet const &cfg);
+
+public:
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+    /// Reads all products and fills histograms
+    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+
+    /// Creates the histograms
+    virtual void beginJob() override;
+
+private:
+    /**
+     * \brief Registers a new source of variables
+     *
+     * Throws an exception if the type label is not supported.
+     */
+    void AddSource(std::string const &name, std::string const &type, edm::InputTag const &src);
+
+    /**
+     * \brief Finds the variable with the given name
+     *
+     * Throws an exception if the variable cannot be resolved.
+     */
+    Variable ResolveVariable(std::string const &expression) const;
+
+private:
+    /// Sources of variables
+    std::vector<std::unique_ptr<SourceBase>> sources;
+
+    /// Histograms to be filled
+    std::vector<Histogram> histograms;
+
+    /// Indicates whether the generator-level weight is used
+    bool useGeneratorWeight;
+
+    /// Token to read the generator-level weight
+    edm::EDGetTokenT<pec::GeneratorInfo> generatorToken;
+
+    /// Tokens to read additional event weights
+    std::vector<edm::EDGetTokenT<double>> weightTokens;
+
+    /// An object to handle output ROOT file
+    edm::Service<TFileService> fileService;
+};
+
+
+template<typename T>
+PECHistograms::CollectionSource<T>::CollectionSource(std::string const &name,
+  edm::EDGetTokenT<std::vector<T>> &&token_):
+    SourceBase(name),
+    token(token_),
+    table(name),
+    objects(nullptr)
+{
+    flatcolumns::Define(table);
+}
+
+
+template<typename T>
+PECHistograms::Getter PECHistograms::CollectionSource<T>::FindVariable(std::string const &name,
+  unsigned index) const
+{
+    auto const getter = table.FindGetter(name, index);
+
+    if (not getter)
+        return {};
+
+    return [this, getter](unsigned i){return getter((*objects)[i]);};
+}
+
+
+template<typename T>
+bool PECHistograms::CollectionSource<T>::IsCollection() const
+{
+    return true;
+}
+
+
+template<typename T>
+void PECHistograms::CollectionSource<T>::Read(edm::Event const &event)
+{
+    edm::Handle<std::vector<T>> handle;
+    event.getByToken(token, handle);
+    objects = handle.product();
+}
+
+
+template<typename T>
+unsigned PECHistograms::CollectionSource<T>::Size() const
+{
+    return objects->size();
+}
+
+
+template<typename T>
+PECHistograms::ScalarSource<T>::ScalarSource(std::string const &name,
+  edm::EDGetTokenT<T> &&token_):
+    SourceBase(name),
+    token(token_),
+    value(0.)
+{}
+
+
+template<typename T>
+PECHistograms::Getter PECHistograms::ScalarSource<T>::FindVariable(std::string const &name,
+  unsigned) const
+{
+    if (not name.empty())
+        return {};
+
+    return [this](unsigned){return value;};
+}
+
+
+template<typename T>
+bool PECHistograms::ScalarSource<T>::IsCollection() const
+{
+    return false;
+}
+
+
+template<typename T>
+void PECHistograms::ScalarSource<T>::Read(edm::Event const &event)
+{
+    edm::Handle<T> handle;
+    event.getByToken(token, handle);
+    value = *handle;
+}
+
+
+template<typename T>
+unsigned PECHistograms::ScalarSource<T>::Size() const
+{
+    return 1;
+}
@@ -2,6 +2,7 @@
 
 #include <FWCore/Utilities/interface/InputTag.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/ParameterSet/interface/FileInPath.h>
 
 #include <FWCore/Utilities/interface/Exception.h>
 
@@ -12,6 +13,7 @@
 #include <array>
 #include <cmath>
 #include <cstdlib>
+#include <memory>
 
 
 using namespace edm;
@@ -20,18 +22,51 @@ using namespace std;
 
 PECJetMET::PECJetMET(edm::ParameterSet const &cfg):
     runOnData(cfg.getParameter<bool>("runOnData")),
-    rawJetMomentaOnly(cfg.getParameter<bool>("rawJetMomentaOnly"))
+    rawJetMomentaOnly(cfg.getParameter<bool>("rawJetMomentaOnly")),
+    computePullAngle(cfg.getParameter<bool>("computePullAngle")),
+    compactMET(cfg.getParameter<bool>("compactMET")),
+    jetID(cfg.getParameter<vector<ParameterSet>>("jetID")),
+    triggerMatcher(cfg, consumesCollector())
 {
     // Register required input data
     jetToken = consumes<edm::View<pat::Jet>>(cfg.getParameter<InputTag>("jets"));
     metToken = consumes<edm::View<pat::MET>>(cfg.getParameter<InputTag>("met"));
     
+    string const jercMapsLabel = cfg.getParameter<string>("jercMaps");
+    
+    if (not jercMapsLabel.empty())
+    {
+        for (string const &instance:
+          {"jecUncertainty", "jerFactorNominal", "jerFactorUp", "jerFactorDown"})
+            jercMapTokens.emplace_back(consumes<ValueMap<float>>(InputTag(jercMapsLabel,
+              instance)));
+        
+        genMatchMapToken = consumes<ValueMap<int>>(InputTag(jercMapsLabel, "hasGenMatch"));
+    }
+    
     for (InputTag const &tag: cfg.getParameter<vector<InputTag>>("contIDMaps"))
         contIDMapTokens.emplace_back(consumes<ValueMap<float>>(tag));
     
     for (InputTag const &tag: cfg.getParameter<vector<InputTag>>("metCorrToUndo"))
         metCorrectorTokens.emplace_back(consumes<CorrMETData>(tag));
     
+    jercMaps.resize(jercMapTokens.size());
+    contIDMaps.resize(contIDMapTokens.size());
+    metCorrectors.resize(metCorrectorTokens.size());
+    
+    if (compactMET and not metCorrectorTokens.empty())
+    {
+        cms::Exception excp("Configuration");
+        excp << "MET corrections to undo are not supported when MET is stored in the compact "
+          "form.";
+        excp.raise();
+    }
+    
+    if (cfg.exists("jecUncertaintySources"))
+        jecUncTable.reset(new JECUncertaintyTable(
+          cfg.getParameter<FileInPath>("jecUncertaintySources").fullPath(),
+          cfg.getParameter<vector<string>>("jecUncertaintySourceNames")));
+    
     
     // Currently plugin does not read any information from the ID maps. Throw an exception if any
     //are actually given.
@@ -43,24 +78,32 @@ PECJetMET::PECJetMET(edm::ParameterSet const &cfg):
     }
     
     
-    // Read version of jet ID
-    string const jetIDLabel = cfg.getParameter<string>("jetIDVersion");
+    // Construct string-based selectors. Their results are stored after the two reserved ID bits,
+    //so make sure they fit into the bit field
+    for (string const &selection: cfg.getParameter<vector<string>>("jetSelection"))
+        jetSelectors.emplace_back(selection);
     
-    if (jetIDLabel == "2017")
-        jetIDVersion = JetID::Ver2017;
-    else if (jetIDLabel == "2016")
-        jetIDVersion = JetID::Ver2016;
-    else
+    if (2 + jetSelectors.size() > pec::Jet::maxIdBits)
     {
         cms::Exception excp("Configuration");
-        excp << "Jet ID version \"" << jetIDLabel << "\" is not known.";
+        excp << "Number of jet selections (" << jetSelectors.size() << ") exceeds the number " <<
+          "of available ID bits (" << pec::Jet::maxIdBits - 2 << ").";
         excp.raise();
     }
     
     
-    // Construct string-based selectors
-    for (string const &selection: cfg.getParameter<vector<string>>("jetSelection"))
-        jetSelectors.emplace_back(selection);
+    // Register products
+    produces<vector<pec::Jet>>();
+    
+    if (compactMET)
+        produces<pec::MET>("MET");
+    else
+    {
+        produces<vector<pec::Candidate>>("METs");
+        produces<vector<pec::Candidate>>("uncorrMETs");
+    }
+    
+    produces<float>("METSignificance");
 }
 
 
@@ -70,50 +113,59 @@ void PECJetMET::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
     desc.add<bool>("runOnData")->
       setComment("Indicates whether data or simulation is being processed.");
     desc.add<InputTag>("jets")->setComment("Collection of jets.");
+    desc.add<string>("jercMaps", "")->
+      setComment("Label of JERCJetSelector that has produced value maps with JEC uncertainties "
+      "and JER factors. If empty, they are read from userData of jets.");
     desc.add<vector<string>>("jetSelection", vector<string>())->
       setComment("User-defined selections for jets whose results will be stored in the output "
       "tree.");
     desc.add<vector<InputTag>>("contIDMaps", vector<InputTag>())->
       setComment("Maps with real-valued ID decisions to be stored.");
-    desc.add<string>("jetIDVersion")->setComment("Version of jet ID to evaluate.");
+    desc.addVPSet("jetID", PFJetID::GetRegionDescription())->
+      setComment("Regions in |eta| with cuts that define PF jet ID.");
     desc.add<bool>("rawJetMomentaOnly", false)->
       setComment("Requests that only raw jet momenta are saved but not their corrections.");
+    desc.add<bool>("computePullAngle", false)->
+      setComment("Requests that jet pull angles are computed.");
     desc.add<InputTag>("met")->setComment("MET.");
     desc.add<vector<InputTag>>("metCorrToUndo", vector<InputTag>())->
       setComment("MET corrections to undo for (partly) uncorreted METs.");
+    desc.add<bool>("compactMET", false)->
+      setComment("Requests that MET and its variations are stored as a single object pec::MET.");
+    desc.add<edm::ParameterSetDescription>("triggerMatching", TriggerMatcher::GetDescription())->
+      setComment("Matching to trigger objects.");
+    desc.addOptional<FileInPath>("jecUncertaintySources")->
+      setComment("File with sources of JEC uncertainty. If given, bins of jets in their tables "
+      "are stored.");
+    desc.add<vector<string>>("jecUncertaintySourceNames", vector<string>())->
+      setComment("Sources of JEC uncertainty to consider. If empty, all sources in the file are "
+      "used.");
     
     descriptions.add("jetMET", desc);
 }
 
 
-void PECJetMET::beginJob()
-{
-    outTree = fileService->make<TTree>("JetMET", "Properties of reconstructed jets and MET");
-    
-    
-    storeJetsPointer = &storeJets;
-    outTree->Branch("jets", &storeJetsPointer);
-    
-    storeMETsPointer = &storeMETs;
-    outTree->Branch("METs", &storeMETsPointer);
-    
-    storeUncorrMETsPointer = &storeUncorrMETs;
-    outTree->Branch("uncorrMETs", &storeUncorrMETsPointer);
-    
-    outTree->Branch("METSignificance", &storeMETSignificance);
-}
-
-
-void PECJetMET::analyze(Event const &event, EventSetup const &)
+void PECJetMET::produce(Event &event, EventSetup const &)
 {
     // Read the jet collection
     Handle<View<pat::Jet>> srcJets;
     event.getByToken(jetToken, srcJets);
     
     
-    // Read maps with real-valued jet ID. They are however not used currently.
-    vector<Handle<ValueMap<float>>> contIDMaps(contIDMapTokens.size());
+    // Read value maps with JEC uncertainties, JER factors, and flags of generator-level matches
+    //if they are not stored as userData in jets
+    Handle<ValueMap<int>> genMatchMap;
+    
+    if (not jercMapTokens.empty())
+    {
+        for (unsigned i = 0; i < jercMapTokens.size(); ++i)
+            event.getByToken(jercMapTokens[i], jercMaps[i]);
+        
+        event.getByToken(genMatchMapToken, genMatchMap);
+    }
     
+    
+    // Read maps with real-valued jet ID. They are however not used currently.
     for (unsigned i = 0; i < contIDMapTokens.size(); ++i)
         event.getByToken(contIDMapTokens.at(i), contIDMaps.at(i));
     
@@ -123,17 +175,26 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
     TVector2 metT1Corr;
     
     
-    // Loop through the collection and store relevant properties of jets
-    storeJets.clear();
-    pec::Jet storeJet;  // will reuse this object to fill the vector
+    // Loop through the collection and store relevant properties of jets. All jets are stored, so
+    //the output vector is allocated at once, and its default-initialized elements are filled in
+    //place
+    unique_ptr<vector<pec::Jet>> storeJets(new vector<pec::Jet>(srcJets->size()));
+    triggerMatcher.ReadEvent(event);
+    
+    if (not srcJets->empty())
+        jetLayout.Update(srcJets->front());
+    
+    
+    // Evaluate PF jet ID for all jets at once
+    vector<uint8_t> const &passPFID = jetID.Evaluate(*srcJets);
     
     for (unsigned int i = 0; i < srcJets->size(); ++i)
     {
         pat::Jet const &j = srcJets->at(i);
-        storeJet.Reset();
+        pec::Jet &storeJet = (*storeJets)[i];
         
         
-        reco::Candidate::LorentzVector const &rawP4 = j.correctedP4("Uncorrected");
+        reco::Candidate::LorentzVector const rawP4 = jetLayout.RawP4(j);
         
         storeJet.SetPt(rawP4.pt());
         storeJet.SetEta(rawP4.eta());
@@ -144,20 +205,34 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
         {
             if (runOnData)
             {
-                storeJet.SetCorrFactor(1. / j.jecFactor("Uncorrected"));
+                storeJet.SetCorrFactor(1. / jetLayout.UncorrectedFactor(j));
                 //^ Here jecFactor("Uncorrected") returns the factor to get raw momentum starting
                 //from the corrected one. Since in fact the raw momentum is stored, the factor is
                 //inverted
             }
             else
             {
-                double const jerFactorNominal = j.userFloat("jerFactorNominal");
-                double const jerFactorUp = j.userFloat("jerFactorUp");
-                double const jerFactorDown = j.userFloat("jerFactorDown");
+                double jecUncertainty, jerFactorNominal, jerFactorUp, jerFactorDown;
                 
-                storeJet.SetCorrFactor(1. / j.jecFactor("Uncorrected") * jerFactorNominal);
+                if (jercMapTokens.empty())
+                {
+                    jecUncertainty = j.userFloat("jecUncertainty");
+                    jerFactorNominal = j.userFloat("jerFactorNominal");
+                    jerFactorUp = j.userFloat("jerFactorUp");
+                    jerFactorDown = j.userFloat("jerFactorDown");
+                }
+                else
+                {
+                    Ptr<pat::Jet> const jetPtr = srcJets->ptrAt(i);
+                    jecUncertainty = (*jercMaps[0])[jetPtr];
+                    jerFactorNominal = (*jercMaps[1])[jetPtr];
+                    jerFactorUp = (*jercMaps[2])[jetPtr];
+                    jerFactorDown = (*jercMaps[3])[jetPtr];
+                }
+                
+                storeJet.SetCorrFactor(1. / jetLayout.UncorrectedFactor(j) * jerFactorNominal);
                 //^ See the comment for real data concerning the inverted JEC factor
-                storeJet.SetJECUncertainty(j.userFloat("jecUncertainty"));
+                storeJet.SetJECUncertainty(jecUncertainty);
                 
                 // For JER the variation is not necessarily symmetric. Save the largest
                 //variation. Information about the sign of the variation is preserved, and the
@@ -172,21 +247,30 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
         }
         
         
+        // Bins in the tables of JEC uncertainty sources are found with the corrected momentum,
+        //like the total uncertainty in JERCJetSelector
+        if (jecUncTable)
+        {
+            auto const bins = jecUncTable->FindBins(j.eta(), j.pt());
+            storeJet.SetJECUncBins(bins.first, bins.second);
+        }
+        
+        
         storeJet.SetArea(j.jetArea());
         storeJet.SetCharge(j.jetCharge());
         
         
         // Save b-tagging discriminators
-        storeJet.SetBTag(pec::Jet::BTagAlgo::CMVA, j.bDiscriminator("pfCombinedMVAV2BJetTags"));
+        storeJet.SetBTag(pec::Jet::BTagAlgo::CMVA, jetLayout.BTagValue(j, JetLayout::CMVA));
         
         // In DeepCSV the "cc" class has been dropped [1]. Since jet stores only four of the five
         //given discriminators and makes assumptions about their sum, provide zero as the value of
         //the "cc" discriminator, except for the cases when b tags cannot be evaluated. Then all
         //five discriminators are set to (-1).
         //[1] https://hypernews.cern.ch/HyperNews/CMS/get/btag/1503/1.html
-        array<float, 4> bTagsDNN{{j.bDiscriminator("pfDeepCSVJetTags:probbb"),
-          j.bDiscriminator("pfDeepCSVJetTags:probb"), j.bDiscriminator("pfDeepCSVJetTags:probc"),
-          j.bDiscriminator("pfDeepCSVJetTags:probudsg")}};
+        array<float, 4> bTagsDNN{{jetLayout.BTagValue(j, JetLayout::DeepCSVbb),
+          jetLayout.BTagValue(j, JetLayout::DeepCSVb), jetLayout.BTagValue(j, JetLayout::DeepCSVc),
+          jetLayout.BTagValue(j, JetLayout::DeepCSVudsg)}};
         storeJet.SetBTagDNN(bTagsDNN[0], bTagsDNN[1],
           (bTagsDNN[0] != -1.f) ? 0.f : -1.f,
           bTagsDNN[2], bTagsDNN[3]);
@@ -197,98 +281,24 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
         storeJet.SetPileUpID(j.userFloat("pileupJetId:fullDiscriminant"));
         
         
-        #if 0
-        // Calculate the jet pull angle
-        double const y = rawP4.Rapidity();
-        double const phi = rawP4.phi();
+        if (computePullAngle)
+            storeJet.SetPullAngle(ComputePullAngle(j, rawP4.Rapidity(), rawP4.phi()));
         //^ It is fine to use uncorrected jet momentum since JEC does not affect the direction
-        double pullY = 0., pullPhi = 0.;  // projections of the pull vector (unnormalised)
-        
-        // Loop over constituents of the jet
-        for (unsigned iDaughter = 0; iDaughter < j.numberOfDaughters(); ++iDaughter)
-        {
-            reco::Candidate const *p = j.daughter(iDaughter);
-            //^ Actually jet constituents are of type pat::PackedCandidate, but here only their
-            //four-momenta are needed, so I do not upcast them
-            
-            double dPhi = p->phi() - phi;
-            
-            if (dPhi < -TMath::Pi())
-                dPhi = 2 * TMath::Pi() + dPhi;
-            else if (dPhi > TMath::Pi())
-                dPhi = -2 * TMath::Pi() + dPhi;
-            
-            double const r = hypot(p->rapidity() - y, dPhi);
-            pullY += p->pt() * r * (p->rapidity() - y);
-            pullPhi += p->pt() * r * dPhi;
-        }
-        //^ The pull vector should be normalised by the jet's pt, but since I'm interested in
-        //the polar angle only, it is not necessary
-        
-        storeJet.SetPullAngle(atan2(pullPhi, pullY));
-        #endif
         
 
         if (not runOnData)
         {
             storeJet.SetFlavour(j.hadronFlavour(), j.partonFlavour(),
               (j.genParton() ? j.genParton()->pdgId() : 0));
-            storeJet.SetBit(0, bool(j.userInt("hasGenMatch")));
-        }
-        
-        
-        // PF jet ID [1-2]. Accessors to energy fractions take into account JEC, so there is no
-        //need to undo the corrections.
-        //[1] https://twiki.cern.ch/twiki/bin/view/CMS/JetID13TeVRun2016?rev=1
-        //[2] https://twiki.cern.ch/twiki/bin/view/CMS/JetID13TeVRun2017?rev=6
-        bool passPFID = false;
-        double const absEta = std::abs(rawP4.Eta());
-        
-        if (jetIDVersion == JetID::Ver2016)
-        {
-            if (absEta <= 2.7)
-            {
-                bool const commonCriteria = (j.neutralHadronEnergyFraction() < 0.99 and
-                  j.neutralEmEnergyFraction() < 0.99 and
-                  (j.chargedMultiplicity() + j.neutralMultiplicity() > 1));
-                
-                if (absEta <= 2.4)
-                    passPFID = (commonCriteria and j.chargedHadronEnergyFraction() > 0. and
-                      j.chargedMultiplicity() > 0 and j.chargedEmEnergyFraction() < 0.99);
-                else
-                    passPFID = commonCriteria;
-            }
-            else if (absEta <= 3.)
-                passPFID = (j.neutralMultiplicity() > 2 and
-                  j.neutralHadronEnergyFraction() < 0.98 and j.neutralEmEnergyFraction() > 0.01);
-            else
-                passPFID = (j.neutralMultiplicity() > 10 and j.neutralEmEnergyFraction() < 0.9);
-        }
-        else if (jetIDVersion == JetID::Ver2017)
-        {
-            // Use the "TightLepVeto" working point as recommended in [1]
-            //[1] https://hypernews.cern.ch/HyperNews/CMS/get/jet-algorithms/462/3/1.html
-            if (absEta <= 2.7)
-            {
-                bool const commonCriteria = (j.neutralHadronEnergyFraction() < 0.9 and
-                  j.neutralEmEnergyFraction() < 0.9  and j.muonEnergyFraction() < 0.8 and
-                  j.numberOfDaughters() > 1);
-                
-                if (absEta <= 2.4)
-                    passPFID = (commonCriteria and j.chargedHadronEnergyFraction() > 0. and
-                      j.chargedMultiplicity() > 0 and j.chargedEmEnergyFraction() < 0.8);
-                else
-                    passPFID = commonCriteria;
-            }
-            else if (absEta <= 3.)
-                passPFID = (j.neutralMultiplicity() > 2 and
-                  j.neutralEmEnergyFraction() < 0.99 and j.neutralEmEnergyFraction() > 0.02);
+            
+            if (jercMapTokens.empty())
+                storeJet.SetBit(0, bool(j.userInt("hasGenMatch")));
             else
-                passPFID = (j.neutralMultiplicity() > 10 and j.neutralEmEnergyFraction() < 0.9 and
-                  j.neutralHadronEnergyFraction() > 0.02);
+                storeJet.SetBit(0, bool((*genMatchMap)[srcJets->ptrAt(i)]));
         }
         
-        storeJet.SetBit(1, passPFID);
+        
+        storeJet.SetBit(1, bool(passPFID[i]));
         
         
         // User-defined selectors if any. The first two bits have already been used.
@@ -296,12 +306,11 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
             storeJet.SetBit(i + 2, jetSelectors[i](j));
         
         
-        // The jet is set up. Add it to the vector
-        storeJets.emplace_back(storeJet);
+        storeJet.SetTriggerMatches(triggerMatcher.Match(j));
         
         
         // Update the partial T1 MET correction
-        auto const deltaT1JetP4 = -(j.p4() - j.correctedP4("L1FastJet"));
+        auto const deltaT1JetP4 = -(j.p4() - jetLayout.L1P4(j));
         metT1Corr += TVector2(deltaT1JetP4.Px(), deltaT1JetP4.Py());
     }
     
@@ -313,23 +322,66 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
     
     
     // Read MET correctors that will be used to undo the corrections
-    vector<Handle<CorrMETData>> metCorrectors(metCorrectorTokens.size());
-    
     for (unsigned i = 0; i < metCorrectorTokens.size(); ++i)
         event.getByToken(metCorrectorTokens.at(i), metCorrectors.at(i));
     
     
-    storeMETSignificance = met.metSignificance();
+    unique_ptr<float> storeMETSignificance(new float(met.metSignificance()));
+    
+    // MET with partly undone T1 correction
+    TVector2 const metUncorrT1(met.shiftedPx(pat::MET::NoShift, pat::MET::Type1) - metT1Corr.Px(),
+      met.shiftedPy(pat::MET::NoShift, pat::MET::Type1) - metT1Corr.Py());
     
-    storeMETs.clear();
-    pec::Candidate storeMET;
-    //^ Will reuse this object to fill the vector of METs
+    
+    // In the compact mode, all versions of MET are stored as shifts with respect to the nominal
+    //one in a single object
+    if (compactMET)
+    {
+        using Var = pat::MET::METUncertainty;
+        using PECVar = pec::MET::Variation;
+        
+        unique_ptr<pec::MET> storeMET(new pec::MET);
+        storeMET->SetP(met.shiftedPx(pat::MET::NoShift, pat::MET::Type1),
+          met.shiftedPy(pat::MET::NoShift, pat::MET::Type1));
+        
+        if (not runOnData)
+        {
+            for (auto const &var: {make_pair(Var::JetEnUp, PECVar::JetEnUp),
+              make_pair(Var::JetEnDown, PECVar::JetEnDown),
+              make_pair(Var::JetResUp, PECVar::JetResUp),
+              make_pair(Var::JetResDown, PECVar::JetResDown),
+              make_pair(Var::UnclusteredEnUp, PECVar::UnclusteredEnUp),
+              make_pair(Var::UnclusteredEnDown, PECVar::UnclusteredEnDown)})
+                storeMET->SetShiftedP(var.second, met.shiftedPx(var.first, pat::MET::Type1),
+                  met.shiftedPy(var.first, pat::MET::Type1));
+        }
+        
+        storeMET->SetShiftedP(PECVar::Raw, met.shiftedPx(pat::MET::NoShift, pat::MET::Raw),
+          met.shiftedPy(pat::MET::NoShift, pat::MET::Raw));
+        storeMET->SetShiftedP(PECVar::UncorrT1, metUncorrT1.Px(), metUncorrT1.Py());
+        
+        event.put(move(storeJets));
+        event.put(move(storeMET), "MET");
+        event.put(move(storeMETSignificance), "METSignificance");
+        return;
+    }
+    
+    
+    // METs are added to the output vectors as default-initialized elements, whose pt and phi
+    //are then set in place
+    auto addMET = [](vector<pec::Candidate> &mets, double pt, double phi)
+    {
+        mets.emplace_back();
+        mets.back().SetPt(pt);
+        mets.back().SetPhi(phi);
+    };
+    
+    unique_ptr<vector<pec::Candidate>> storeMETs(new vector<pec::Candidate>);
+    storeMETs->reserve(7);
     
     // Nominal MET (type-I corrected)
-    storeMET.Reset();
-    storeMET.SetPt(met.shiftedPt(pat::MET::NoShift, pat::MET::Type1));
-    storeMET.SetPhi(met.shiftedPhi(pat::MET::NoShift, pat::MET::Type1));
-    storeMETs.emplace_back(storeMET);
+    addMET(*storeMETs, met.shiftedPt(pat::MET::NoShift, pat::MET::Type1),
+      met.shiftedPhi(pat::MET::NoShift, pat::MET::Type1));
     
     
     // Save MET with systematical variations
@@ -339,31 +391,21 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
         
         for (Var const &var: {Var::JetEnUp, Var::JetEnDown, Var::JetResUp, Var::JetResDown,
          Var::UnclusteredEnUp, Var::UnclusteredEnDown})
-        {
-            storeMET.Reset();
-            storeMET.SetPt(met.shiftedPt(var, pat::MET::Type1));
-            storeMET.SetPhi(met.shiftedPhi(var, pat::MET::Type1));
-            storeMETs.emplace_back(storeMET);
-        }
+            addMET(*storeMETs, met.shiftedPt(var, pat::MET::Type1),
+              met.shiftedPhi(var, pat::MET::Type1));
     }
     
     
     // Save variants of uncorrected MET
-    storeUncorrMETs.clear();
+    unique_ptr<vector<pec::Candidate>> storeUncorrMETs(new vector<pec::Candidate>);
+    storeUncorrMETs->reserve(2 + metCorrectors.size());
     
     // Raw MET
-    storeMET.Reset();
-    storeMET.SetPt(met.shiftedPt(pat::MET::NoShift, pat::MET::Raw));
-    storeMET.SetPhi(met.shiftedPhi(pat::MET::NoShift, pat::MET::Raw));
-    storeUncorrMETs.emplace_back(storeMET);
+    addMET(*storeUncorrMETs, met.shiftedPt(pat::MET::NoShift, pat::MET::Raw),
+      met.shiftedPhi(pat::MET::NoShift, pat::MET::Raw));
     
     // MET with partly undone T1 correction
-    TVector2 const metUncorrT1(met.shiftedPx(pat::MET::NoShift, pat::MET::Type1) - metT1Corr.Px(),
-      met.shiftedPy(pat::MET::NoShift, pat::MET::Type1) - metT1Corr.Py());
-    storeMET.Reset();
-    storeMET.SetPt(metUncorrT1.Mod());
-    storeMET.SetPhi(metUncorrT1.Phi());
-    storeUncorrMETs.emplace_back(storeMET);
+    addMET(*storeUncorrMETs, metUncorrT1.Mod(), metUncorrT1.Phi());
     
     // (Partly) uncorrected MET for each given corrector
     for (auto const &metCorrector: metCorrectors)
@@ -371,15 +413,197 @@ void PECJetMET::analyze(Event const &event, EventSetup const &)
         TVector2 const uncorrMET(
           met.shiftedPx(pat::MET::NoShift, pat::MET::Type1) - metCorrector->mex,
           met.shiftedPy(pat::MET::NoShift, pat::MET::Type1) - metCorrector->mey);
-        storeMET.Reset();
-        storeMET.SetPt(uncorrMET.Mod());
-        storeMET.SetPhi(uncorrMET.Phi());
-        storeUncorrMETs.emplace_back(storeMET);
+        addMET(*storeUncorrMETs, uncorrMET.Mod(), uncorrMET.Phi());
+    }
+    
+    
+    // Put the collections into the event
+    event.put(move(storeJets));
+    event.put(move(storeMETs), "METs");
+    event.put(move(storeUncorrMETs), "uncorrMETs");
+    event.put(move(storeMETSignificance), "METSignificance");
+}
+
+
+float PECJetMET::ComputePullAngle(pat::Jet const &jet, double y, double phi)
+{
+    // Gather properties of constituents into contiguous arrays. Constituents are in fact of type
+    //pat::PackedCandidate, but only their four-momenta are needed, so they are not upcast.
+    unsigned const nDaughters = jet.numberOfDaughters();
+    constituentPt.resize(nDaughters);
+    constituentDY.resize(nDaughters);
+    constituentDPhi.resize(nDaughters);
+    
+    for (unsigned i = 0; i < nDaughters; ++i)
+    {
+        reco::Candidate const *p = jet.daughter(i);
+        constituentPt[i] = p->pt();
+        constituentDY[i] = p->rapidity() - y;
+        constituentDPhi[i] = p->phi() - phi;
+    }
+    
+    
+    // Compute projections of the pull vector. The difference in azimuthal angle is mapped into
+    //[-pi, pi) without branches, so that the loop can be vectorized. The pull vector should be
+    //normalised by the jet's pt, but since only its polar angle is needed, it is not necessary.
+    float const pi = TMath::Pi();
+    float const twoPi = 2 * TMath::Pi();
+    float const *pt = constituentPt.data();
+    float const *dY = constituentDY.data();
+    float *dPhi = constituentDPhi.data();
+    float pullY = 0.f, pullPhi = 0.f;
+    
+    for (unsigned i = 0; i < nDaughters; ++i)
+    {
+        dPhi[i] -= twoPi * std::floor((dPhi[i] + pi) / twoPi);
+        float const w = pt[i] * std::sqrt(dY[i] * dY[i] + dPhi[i] * dPhi[i]);
+        pullY += w * dY[i];
+        pullPhi += w * dPhi[i];
+    }
+    
+    return std::atan2(pullPhi, pullY);
+}
+
+
+std::array<std::string, PECJetMET::JetLayout::numBTags> const PECJetMET::JetLayout::bTagNames{{
+  "pfCombinedMVAV2BJetTags", "pfDeepCSVJetTags:probbb", "pfDeepCSVJetTags:probb",
+  "pfDeepCSVJetTags:probc", "pfDeepCSVJetTags:probudsg"}};
+
+
+PECJetMET::JetLayout::JetLayout():
+    numStoredBTags(0),
+    jecSet(-1), uncorrectedLevel(-1), l1Level(-1)
+{
+    bTagIndices.fill(-1);
+}
+
+
+void PECJetMET::JetLayout::Update(pat::Jet const &jet)
+{
+    if (not Matches(jet))
+        Resolve(jet);
+}
+
+
+float PECJetMET::JetLayout::BTagValue(pat::Jet const &jet, BTag algo) const
+{
+    int const index = bTagIndices[algo];
+    auto const &discriminators = jet.getPairDiscri();
+    
+    // The layout has been resolved from the first jet of the event only. Make sure the current
+    //jet shares it by checking the name at the cached position
+    if (index >= 0 and unsigned(index) < discriminators.size() and
+      discriminators[index].first == bTagNames[algo])
+        return discriminators[index].second;
+    else
+        return jet.bDiscriminator(bTagNames[algo]);
+}
+
+
+reco::Candidate::LorentzVector PECJetMET::JetLayout::RawP4(pat::Jet const &jet) const
+{
+    if (uncorrectedLevel >= 0)
+        return jet.correctedP4(uncorrectedLevel, pat::JetCorrFactors::NONE, jecSet);
+    else
+        return jet.correctedP4("Uncorrected");
+}
+
+
+float PECJetMET::JetLayout::UncorrectedFactor(pat::Jet const &jet) const
+{
+    if (uncorrectedLevel >= 0)
+        return jet.jecFactor(uncorrectedLevel, pat::JetCorrFactors::NONE, jecSet);
+    else
+        return jet.jecFactor("Uncorrected");
+}
+
+
+reco::Candidate::LorentzVector PECJetMET::JetLayout::L1P4(pat::Jet const &jet) const
+{
+    if (l1Level >= 0)
+        return jet.correctedP4(l1Level, pat::JetCorrFactors::NONE, jecSet);
+    else
+        return jet.correctedP4("L1FastJet");
+}
+
+
+bool PECJetMET::JetLayout::Matches(pat::Jet const &jet) const
+{
+    // Check b-tagging discriminators
+    auto const &discriminators = jet.getPairDiscri();
+    
+    if (discriminators.size() != numStoredBTags)
+        return false;
+    
+    for (unsigned i = 0; i < numBTags; ++i)
+    {
+        // Positions of discriminators that were missing are not rechecked, so the name-based
+        //accessor will be used for them until the number of discriminators changes
+        if (bTagIndices[i] >= 0 and discriminators[bTagIndices[i]].first != bTagNames[i])
+            return false;
     }
     
     
-    // Fill the output tree
-    outTree->Fill();
+    // Check JEC levels
+    if (jecSet < 0 or not jet.jecSetsAvailable())
+        return (jecSet < 0 and not jet.jecSetsAvailable());
+    
+    if (jet.jecSet(jet.currentJECSet()) != jecSet)
+        return false;
+    
+    auto const &levels = jet.availableJECLevels(jecSet);
+    
+    if (uncorrectedLevel >= 0 and (unsigned(uncorrectedLevel) >= levels.size() or
+      levels[uncorrectedLevel] != "Uncorrected"))
+        return false;
+    
+    if (l1Level >= 0 and (unsigned(l1Level) >= levels.size() or levels[l1Level] != "L1FastJet"))
+        return false;
+    
+    return true;
+}
+
+
+void PECJetMET::JetLayout::Resolve(pat::Jet const &jet)
+{
+    // Find b-tagging discriminators
+    auto const &discriminators = jet.getPairDiscri();
+    numStoredBTags = discriminators.size();
+    bTagIndices.fill(-1);
+    
+    for (unsigned i = 0; i < numBTags; ++i)
+    {
+        for (unsigned iStored = 0; iStored < discriminators.size(); ++iStored)
+        {
+            if (discriminators[iStored].first == bTagNames[i])
+            {
+                bTagIndices[i] = iStored;
+                break;
+            }
+        }
+    }
+    
+    
+    // Find JEC levels
+    jecSet = uncorrectedLevel = l1Level = -1;
+    
+    if (not jet.jecSetsAvailable())
+        return;
+    
+    jecSet = jet.jecSet(jet.currentJECSet());
+    
+    if (jecSet < 0)
+        return;
+    
+    auto const &levels = jet.availableJECLevels(jecSet);
+    
+    for (unsigned i = 0; i < levels.size(); ++i)
+    {
+        if (levels[i] == "Uncorrected")
+            uncorrectedLevel = i;
+        else if (levels[i] == "L1FastJet")
+            l1Level = i;
+    }
 }
 
 
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "CompiledCut.h"
+#include "JECUncertaintyTable.h"
+#include "PFJetID.h"
+#include "TriggerMatcher.h"
+
 #include <Analysis/PECTuples/interface/Jet.h>
+#include <Analysis/PECTuples/interface/MET.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/stream/EDProducer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
@@ -11,29 +17,29 @@
 #include <DataFormats/METReco/interface/CorrMETData.h>
 #include <DataFormats/PatCandidates/interface/Jet.h>
 #include <DataFormats/PatCandidates/interface/MET.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
-
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
 
+#include <array>
+#include <memory>
 #include <string>
 #include <vector>
-#include <memory>
 
 
 /**
  * \class PECJetMET
- * \brief Stores reconstructed jets and MET
+ * \brief Converts reconstructed jets and MET into PEC format
  * 
- * This plugin stores basic properties of jets (four-momenta, b-tagging discriminators, IDs, etc.)
- * and MET. Bit flags indicate the presence of a generator-level jet nearby and include decisions
- * of user-defined selectors. Fields with generator-level information are not filled when
- * processing data.
+ * This plugin extracts basic properties of jets (four-momenta, b-tagging discriminators, IDs, etc.)
+ * and MET and puts them into the event as collections of pec::Jet and pec::Candidate. They are
+ * expected to be written into a ROOT file with plugin PECWriter. Bit flags indicate the presence of
+ * a generator-level jet nearby, PF jet ID, and decisions of user-defined selectors. PF jet ID is
+ * defined by a table of cuts given in parameter "jetID" (see class PFJetID). Jet pull angle is
+ * only computed if parameter "computePullAngle" is set to true. Fields with
+ * generator-level information are not filled when processing data.
  * 
  * The input collection of jets must have been created by an instance of plugin JERCJetSelector
  * as the plugin reads some userData from it, such as JEC uncertainties and JER smearing factors.
+ * If that plugin is run with the light output, its label must be given in parameter "jercMaps",
+ * and this information is read from the value maps instead.
  * By default, the plugin stores raw momenta. Depending on the configuration, it can also save full
  * JEC+JER correction factor and corresponding uncertainties. In case of JER the two variations are
  * not necessarily symmetric, and the largest one is chosen as the uncertainty to store.
@@ -43,15 +49,97 @@
  * corrections induced by stored jets are removed. User can provide a list of MET correction
  * objects (same as used by the standard MET tool); for each of them the plugin stores fully
  * corrected MET from which that correction is undone.
+ * 
+ * The plugin produces the following products: jets (no instance label), "METs" (nominal MET and
+ * its systematic variations), "uncorrMETs", and "METSignificance" (a float). Consult the source
+ * code to find indices of different versions of MET. MET is stored as an instance of
+ * pec::Candidate, but pseudorapidity and mass are set to zeros, which allows them to be compressed
+ * efficiently.
+ * 
+ * If parameter "compactMET" is set to true, products "METs" and "uncorrMETs" are replaced by a
+ * single object pec::MET with instance label "MET". It contains the nominal MET, its systematic
+ * variations (only in simulation), raw MET, and MET with partly undone T1 corrections. This mode
+ * does not support parameter "metCorrToUndo".
+ * 
+ * If filters are listed in parameter set "triggerMatching", each jet is matched to trigger
+ * objects, and the mask of filters with a matched object is stored (see class TriggerMatcher).
+ * 
+ * If a file with sources of JEC uncertainty is given in parameter "jecUncertaintySources", each
+ * jet is assigned indices of its bin in the tables of the sources (see class JECUncertaintyTable),
+ * which are computed from the corrected pt and pseudorapidity. The tables themselves are saved
+ * by plugin JECUncertaintyTables, which must be given the same file and sources.
  */
-class PECJetMET: public edm::EDAnalyzer
+class PECJetMET: public edm::stream::EDProducer<>
 {
 private:
-    /// Supported versions of jet ID
-    enum class JetID
+    /**
+     * \brief Positions of b-tagging discriminators and JEC levels in pat::Jet
+     * 
+     * Accessing these properties by name involves a linear search with string comparisons for
+     * every jet. Instead, their positions are resolved from the first jet of an event whenever
+     * the layout seen previously does not match it any more, and then all jets of the event are
+     * accessed by index. If a property is not found in the layout, the name-based accessor is
+     * used, which produces the standard behaviour for a missing property. Other jets of the
+     * event are assumed to share the layout of the first one. For b-tagging discriminators, this
+     * is verified for every jet with a single comparison of the name stored at the cached
+     * position, and the name-based accessor is used in case of a mismatch.
+     */
+    class JetLayout
     {
-        Ver2016,
-        Ver2017
+    public:
+        /// Supported b-tagging discriminators, in the order of their names in bTagNames
+        enum BTag: unsigned
+        {
+            CMVA,
+            DeepCSVbb,
+            DeepCSVb,
+            DeepCSVc,
+            DeepCSVudsg,
+            numBTags
+        };
+        
+    public:
+        /// Constructor
+        JetLayout();
+        
+    public:
+        /// Checks the layout against the given jet and resolves positions again if needed
+        void Update(pat::Jet const &jet);
+        
+        /// Returns value of the given b-tagging discriminator
+        float BTagValue(pat::Jet const &jet, BTag algo) const;
+        
+        /// Returns four-momentum of the given jet without JEC
+        reco::Candidate::LorentzVector RawP4(pat::Jet const &jet) const;
+        
+        /// Returns factor to obtain the raw momentum from the corrected one
+        float UncorrectedFactor(pat::Jet const &jet) const;
+        
+        /// Returns four-momentum of the given jet corrected up to level L1FastJet
+        reco::Candidate::LorentzVector L1P4(pat::Jet const &jet) const;
+        
+    private:
+        /// Checks if cached positions are valid for the given jet
+        bool Matches(pat::Jet const &jet) const;
+        
+        /// Finds positions of all properties in the given jet
+        void Resolve(pat::Jet const &jet);
+        
+    private:
+        /// Names of supported b-tagging discriminators
+        static std::array<std::string, numBTags> const bTagNames;
+        
+        /// Number of b-tagging discriminators in the jet when the layout was resolved
+        unsigned numStoredBTags;
+        
+        /// Positions of supported b-tagging discriminators; (-1) if not available
+        std::array<int, numBTags> bTagIndices;
+        
+        /// Index of the current set of JEC
+        int jecSet;
+        
+        /// Indices of JEC levels "Uncorrected" and "L1FastJet"; (-1) if not available
+        int uncorrectedLevel, l1Level;
     };
     
 public:
@@ -66,16 +154,23 @@ public:
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates output tree
-    virtual void beginJob() override;
+    /**
+     * \brief Processes current event
+     * 
+     * Converts jets and MET into PEC format, evaluates string-based selections for jets, and
+     * puts the resulting collections into the event.
+     */
+    virtual void produce(edm::Event &event, edm::EventSetup const &) override;
     
+private:
     /**
-     * \brief Analyses current event
+     * \brief Computes jet pull angle
      * 
-     * Copies jets and MET into the buffers, evaluates string-based selections for jets, fills the
-     * output tree.
+     * The rapidity and azimuthal angle of the jet are given as arguments. Properties of jet
+     * constituents are gathered into buffers, and the weighted sums are then computed in a single
+     * loop over contiguous arrays.
      */
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+    float ComputePullAngle(pat::Jet const &jet, double y, double phi);
     
 private:
     /// Collection of jets
@@ -84,6 +179,17 @@ private:
     /// MET
     edm::EDGetTokenT<edm::View<pat::MET>> metToken;
     
+    /**
+     * \brief Value maps with JEC uncertainty and JER factors produced by JERCJetSelector
+     * 
+     * The maps are given in the order "jecUncertainty", "jerFactorNominal", "jerFactorUp",
+     * "jerFactorDown". The vector is empty if these properties are read from userData of jets.
+     */
+    std::vector<edm::EDGetTokenT<edm::ValueMap<float>>> jercMapTokens;
+    
+    /// Value map with flags of generator-level matches produced by JERCJetSelector
+    edm::EDGetTokenT<edm::ValueMap<int>> genMatchMapToken;
+    
     /**
      * \brief String-based selections
      * 
@@ -94,7 +200,7 @@ private:
      * Details on implementation are documented in [1].
      * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuidePhysicsCutParser
      */
-    std::vector<StringCutObjectSelector<pat::Jet>> jetSelectors;
+    std::vector<CompiledCut<pat::Jet>> jetSelectors;
     
     /// Maps with real-valued IDs
     std::vector<edm::EDGetTokenT<edm::ValueMap<float>>> contIDMapTokens;
@@ -113,74 +219,42 @@ private:
      */
     bool const rawJetMomentaOnly;
     
-    /// Version of jet ID to be evaluated
-    JetID jetIDVersion;
-    
-    // MET corrections to undo when computing uncorrected METs
-    std::vector<edm::EDGetTokenT<CorrMETData>> metCorrectorTokens;
-    
-    
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Requests computation of jet pull angles
+    bool const computePullAngle;
     
+    /// Requests that MET and its variations are stored as a single object pec::MET
+    bool const compactMET;
     
-    /// Output tree
-    TTree *outTree;
+    /// PF jet ID to be evaluated
+    PFJetID jetID;
     
-    /**
-     * \brief Buffer to store jets
-     * 
-     * Bit flags in the objects show if the jet is matched to a generator-level jet (always set to
-     * false in real data) and include user-defined selections. Generator-level properties are not
-     * filled when running on data.
-     */
-    std::vector<pec::Jet> storeJets;
+    // MET corrections to undo when computing uncorrected METs
+    std::vector<edm::EDGetTokenT<CorrMETData>> metCorrectorTokens;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    std::vector<pec::Jet> *storeJetsPointer;
-        
-    /**
-     * \brief Buffer to store MET
-     * 
-     * Includes the nominal given MET as well as various its corrections and/or systematical
-     * variations. Cosult the source code to find the corresponding indices. MET is  stored as an
-     * instance of pec::Candidate, but pseudorapidity and mass are set to zeros, which allows them
-     * to be compressed efficiently.
-     */
-    std::vector<pec::Candidate> storeMETs;
+    /// Positions of properties in jets of the input collection
+    JetLayout jetLayout;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    std::vector<pec::Candidate> *storeMETsPointer;
+    /// Tables of JEC uncertainty sources; null if bins in them are not to be stored
+    std::unique_ptr<JECUncertaintyTable> jecUncTable;
     
     /**
-     * \brief Buffer to store uncorrected MET
-     * 
-     * Includes raw and partly uncorrected MET. When jet-related MET corrections are undone, the
-     * fully corrected MET is used as the starting point, and only corrections induced by saved
-     * jets are undone. These partly uncorrected METs are useful to reapply jet corrections over
-     * PEC tuples.
+     * \brief Buffers with pt, and differences in rapidity and azimuthal angle with respect to
+     * the jet axis for constituents of the current jet
      * 
-     * Consult the source code for details. MET is  stored as an instance of pec::Candidate, but
-     * its pseudorapidity and mass are set to zeros, which allows them to be compressed
-     * efficiently.
+     * Used to compute the jet pull angle. Kept as data members to avoid memory allocations.
      */
-    std::vector<pec::Candidate> storeUncorrMETs;
+    std::vector<float> constituentPt, constituentDY, constituentDPhi;
     
     /**
-     * \brief An auxiliary pointer
+     * \brief Handles to value maps with JEC uncertainties and JER factors, to maps with
+     * real-valued jet ID, and to MET correctors in the current event
      * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
+     * Sized in the constructor to match the corresponding tokens and kept as data members to
+     * avoid memory allocations in every event.
      */
-    std::vector<pec::Candidate> *storeUncorrMETsPointer;
+    std::vector<edm::Handle<edm::ValueMap<float>>> jercMaps, contIDMaps;
+    std::vector<edm::Handle<CorrMETData>> metCorrectors;
     
-    /// Buffer to store MET significance
-    Float_t storeMETSignificance;
+    /// Matching to trigger objects
+    TriggerMatcher triggerMatcher;
 };
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "CompiledCut.h"
+#include "TriggerMatcher.h"
+
+#include <FWCore/Framework/interface/stream/EDProducer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+#include <FWCore/Utilities/interface/Exception.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class PECLeptons
+ * \brief Common core of plugins that convert charged leptons into PEC format
+ *
+ * The class implements the loop over the source collection of leptons of type SrcLepton and
+ * fills properties shared by all leptons: four-momentum (the mass is always set to zero to
+ * facilitate file compression), charge, relative isolation, results of user-defined string-based
+ * selections, and the mask of matched trigger filters. The resulting collection of PECLepton is
+ * put into the event.
+ *
+ * Properties specific to a lepton flavour are filled by the derived class Derived (CRTP), which
+ * must implement the following non-virtual methods:
+ *   void ReadEvent(edm::Event const &event, edm::View<SrcLepton> const &leptons);
+ *   void ComputeIsolation(edm::View<SrcLepton> const &leptons, std::vector<float> &relIso);
+ *   void FillLepton(PECLepton &storeLepton, SrcLepton const &lepton, unsigned index);
+ *   void PutProducts(edm::Event &event);
+ * The first one is called once per event and can read additional inputs and prepare batched
+ * information for all leptons. The second one computes relative isolation for all leptons at
+ * once. The third one is called for each lepton. The last one is called after the collection of
+ * leptons has been put into the event and allows to put additional products filled in the loop
+ * over leptons; it can do nothing. The derived class must also define the number of
+ * bits in the bit field of CandidateWithID that it fills, as a static constant numReservedBits.
+ * Bits for the user-defined selections are allocated after them.
+ *
+ * Parameters "src", "selection", and "triggerMatching" are read by this class. They should be
+ * added to the description of the derived plugin with method AddCommonParameters.
+ */
+template<typename Derived, typename SrcLepton, typename PECLepton>
+class PECLeptons: public edm::stream::EDProducer<>
+{
+public:
+    /// Constructor
+    PECLeptons(edm::ParameterSet const &cfg);
+
+public:
+    /// Adds parameters read by this class to the given description
+    static void AddCommonParameters(edm::ParameterSetDescription &desc);
+
+    /// Converts leptons into PEC format and puts the resulting collection into the event
+    virtual void produce(edm::Event &event, edm::EventSetup const &) override final;
+
+private:
+    /// Source collection of leptons
+    edm::EDGetTokenT<edm::View<SrcLepton>> leptonToken;
+
+    /**
+     * \brief String-based selections
+     *
+     * These selections do not affect which leptons are stored in the output files. Instead, each
+     * string defines a selection that is evaluated and whose result is saved in the bit field of
+     * the CandidateWithID class.
+     *
+     * Details on implementation are documented in [1].
+     * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuidePhysicsCutParser
+     */
+    std::vector<CompiledCut<SrcLepton>> selectors;
+
+    /// Matching to trigger objects
+    TriggerMatcher triggerMatcher;
+
+    /// Buffer for relative isolation of all leptons in the current event
+    std::vector<float> relIso;
+};
+
+
+template<typename Derived, typename SrcLepton, typename PECLepton>
+PECLeptons<Derived, SrcLepton, PECLepton>::PECLeptons(edm::ParameterSet const &cfg):
+    triggerMatcher(cfg, consumesCollector())
+{
+    leptonToken = consumes<edm::View<SrcLepton>>(cfg.getParameter<edm::InputTag>("src"));
+
+    for (std::string const &selection: cfg.getParameter<std::vector<std::string>>("selection"))
+        selectors.emplace_back(selection);
+
+    if (Derived::numReservedBits + selectors.size() > PECLepton::maxIdBits)
+    {
+        cms::Exception excp("Configuration");
+        excp << "Number of lepton selections (" << selectors.size() << ") exceeds the number " <<
+          "of available ID bits (" << PECLepton::maxIdBits - Derived::numReservedBits << ").";
+        excp.raise();
+    }
+
+    produces<std::vector<PECLepton>>();
+}
+
+
+template<typename Derived, typename SrcLepton, typename PECLepton>
+void PECLeptons<Derived, SrcLepton, PECLepton>::AddCommonParameters(
+  edm::ParameterSetDescription &desc)
+{
+    desc.add<edm::InputTag>("src")->setComment("Source collection of leptons.");
+    desc.add<std::vector<std::string>>("selection", std::vector<std::string>())->
+      setComment("User-defined selections for leptons whose results will be stored in the "
+      "output tree.");
+    desc.add<edm::ParameterSetDescription>("triggerMatching", TriggerMatcher::GetDescription())->
+      setComment("Matching to trigger objects.");
+}
+
+
+template<typename Derived, typename SrcLepton, typename PECLepton>
+void PECLeptons<Derived, SrcLepton, PECLepton>::produce(edm::Event &event,
+  edm::EventSetup const &)
+{
+    Derived &derived = static_cast<Derived &>(*this);
+
+    edm::Handle<edm::View<SrcLepton>> srcLeptons;
+    event.getByToken(leptonToken, srcLeptons);
+    unsigned const nLeptons = srcLeptons->size();
+
+    derived.ReadEvent(event, *srcLeptons);
+    triggerMatcher.ReadEvent(event);
+
+    relIso.resize(nLeptons);
+    derived.ComputeIsolation(*srcLeptons, relIso);
+
+
+    // Loop through the collection and store relevant properties of leptons, filling the output
+    //elements in place
+    std::unique_ptr<std::vector<PECLepton>> storeLeptons(new std::vector<PECLepton>(nLeptons));
+
+    for (unsigned i = 0; i < nLeptons; ++i)
+    {
+        SrcLepton const &lepton = (*srcLeptons)[i];
+        PECLepton &storeLepton = (*storeLeptons)[i];
+
+        storeLepton.SetPt(lepton.pt());
+        storeLepton.SetEta(lepton.eta());
+        storeLepton.SetPhi(lepton.phi());
+        storeLepton.SetCharge(lepton.charge());
+        storeLepton.SetRelIso(relIso[i]);
+
+        derived.FillLepton(storeLepton, lepton, i);
+
+        for (unsigned iSel = 0; iSel < selectors.size(); ++iSel)
+            storeLepton.SetBit(Derived::numReservedBits + iSel, selectors[iSel](lepton));
+
+        storeLepton.SetTriggerMatches(triggerMatcher.Match(lepton));
+    }
+
+
+    event.put(std::move(storeLeptons));
+    derived.PutProducts(event);
+}
@@ -1,36 +1,39 @@
 #pragma once
 
+#include "PECLeptons.h"
+
 #include <Analysis/PECTuples/interface/Muon.h>
+#include <Analysis/PECTuples/interface/RecoContext.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
 #include <DataFormats/PatCandidates/interface/Muon.h>
-#include <DataFormats/VertexReco/interface/VertexFwd.h>
-#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
-
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
+#include <DataFormats/VertexReco/interface/Vertex.h>
 
 #include <vector>
 
 
 /**
  * \class PECMuons
- * \brief Stores muons
+ * \brief Converts muons into PEC format
  * 
- * The plugin stores basic properties of muons in the given collection. It saves their four-momenta,
- * isolation, quality flags, etc. The mass in the four-momentum is always set to zero
- * to facilitate file compression. Bit flags of stored objects include the flag for tight muon
- * according to the official definition and results of custom selections specifed by the user.
+ * The plugin extracts basic properties of muons in the given collection and puts them into the
+ * event as a collection of pec::Muon, which is expected to be written into a ROOT file with plugin
+ * PECWriter. It saves their four-momenta, isolation, quality flags, etc. The mass in the
+ * four-momentum is always set to zero to facilitate file compression. Bit flags of stored objects
+ * include the flag for tight muon according to the official definition and results of custom
+ * selections specifed by the user. If filters are listed in parameter set "triggerMatching",
+ * each muon is also matched to trigger objects (see class TriggerMatcher).
+ * 
+ * The loop over muons and the common properties of leptons are implemented in class PECLeptons.
  */
-class PECMuons: public edm::EDAnalyzer
+class PECMuons: public PECLeptons<PECMuons, pat::Muon, pec::Muon>
 {
+    friend PECLeptons<PECMuons, pat::Muon, pec::Muon>;
+    
 public:
     /**
      * \brief Constructor
@@ -43,50 +46,26 @@ public:
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates output tree
-    virtual void beginJob() override;
-    
-    /**
-     * \brief Analyses current event
-     * 
-     * Copies muons into the buffers, evaluates string-based selections, fills the output tree.
-     */
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
-    
 private:
-    /// Source collection of muons
-    edm::EDGetTokenT<edm::View<pat::Muon>> muonToken;
+    /// Computes relative isolation with delta-beta correction for all muons
+    void ComputeIsolation(edm::View<pat::Muon> const &muons, std::vector<float> &relIso);
     
-    /**
-     * \brief String-based selections for muons
-     * 
-     * These selections do not affect which muons are stored in the output files. Instead, each
-     * string defines a selection that is evaluated and whose result is saved in the bit field of
-     * the CandidateWithID class.
-     * 
-     * Details on implementation are documented in [1].
-     * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuidePhysicsCutParser
-     */
-    std::vector<StringCutObjectSelector<pat::Muon>> muSelectors;
-    
-    /// Collection of reconstructed primary vertices
-    edm::EDGetTokenT<reco::VertexCollection> primaryVerticesToken;
+    /// Sets muon ID bits
+    void FillLepton(pec::Muon &storeMuon, pat::Muon const &mu, unsigned index);
     
+    /// Does nothing since no additional products are created
+    void PutProducts(edm::Event &event);
     
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Reads the first primary vertex
+    void ReadEvent(edm::Event const &event, edm::View<pat::Muon> const &muons);
     
+private:
+    /// Number of bits in the bit field set by this class
+    static unsigned const numReservedBits = 3;
     
-    /// Output tree
-    TTree *outTree;
-    
-    /// Buffer to store muons
-    std::vector<pec::Muon> storeMuons;
+    /// Event-level reconstructed information, which provides the first primary vertex
+    edm::EDGetTokenT<pec::RecoContext> contextToken;
     
-    /**
-     * \brief An auxiliary pointer
-     * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
-     */
-    std::vector<pec::Muon> *storeMuonsPointer;
+    /// First primary vertex in the current event; only its position is set
+    reco::Vertex firstPV;
 };
@@ -1,13 +1,17 @@
 #include "PECPileUp.h"
 
-#include <DataFormats/VertexReco/interface/Vertex.h>
-
 #include <FWCore/Framework/interface/EventSetup.h>
-#include <FWCore/Utilities/interface/EDMException.h>
 #include <FWCore/Utilities/interface/InputTag.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/ParameterSet/interface/FileInPath.h>
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <TFile.h>
+#include <TH1.h>
 
 #include <algorithm>
+#include <cmath>
+#include <memory>
 
 
 using namespace edm;
@@ -16,30 +20,53 @@ using namespace std;
 
 PECPileUp::PECPileUp(ParameterSet const &cfg):
     runOnData(cfg.getParameter<bool>("runOnData")),
-    saveMaxPtHat(cfg.getParameter<bool>("saveMaxPtHat"))
+    saveMaxPtHat(cfg.getParameter<bool>("saveMaxPtHat")),
+    computeWeights(cfg.exists("weights")),
+    tableMin(0.), tableMax(0.), tableBinWidth(1.)
 {
     if (runOnData)
+    {
         saveMaxPtHat = false;
+        computeWeights = false;
+    }
+    
+    if (computeWeights)
+    {
+        ParameterSet const &weightsCfg = cfg.getParameter<ParameterSet>("weights");
+        
+        // Resolve paths as for a FileInPath so that the files are found on the grid, where the
+        //package directory is included in the sandbox
+        for (auto const &path: weightsCfg.getParameter<vector<string>>("dataProfiles"))
+            dataProfileFiles.emplace_back(FileInPath(path).fullPath());
+        
+        histogramName = weightsCfg.getParameter<string>("histogramName");
+        mcProfile = weightsCfg.getParameter<vector<double>>("mcProfile");
+        
+        if (dataProfileFiles.size() != 1 and dataProfileFiles.size() != 3)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Either one or three files with data pileup profiles must be given, while " <<
+              dataProfileFiles.size() << " are provided.";
+            excp.raise();
+        }
+    }
     
     
     // Register required input data
-    primaryVerticesToken =
-      consumes<reco::VertexCollection>(cfg.getParameter<InputTag>("primaryVertices"));
+    contextToken = consumes<pec::RecoContext>(cfg.getParameter<InputTag>("recoContext"));
     puSummaryToken = consumes<View<PileupSummaryInfo>>(cfg.getParameter<InputTag>("puInfo"));
-    rhoToken = consumes<double>(cfg.getParameter<InputTag>("rho"));
-    rhoCentralToken = consumes<double>(cfg.getParameter<InputTag>("rhoCentral"));
+    
+    
+    produces<pec::PileUpInfo>();
 }
 
 
 void PECPileUp::fillDescriptions(ConfigurationDescriptions &descriptions)
 {
     ParameterSetDescription desc;
-    desc.add<InputTag>("primaryVertices")->
-      setComment("Collection of reconstructed primary vertices.");
-    desc.add<InputTag>("rho", InputTag("fixedGridRhoFastjetAll"))->
-      setComment("Rho (mean angular pt density).");
-    desc.add<InputTag>("rhoCentral", InputTag("fixedGridRhoFastjetCentral"))->
-      setComment("Rho in the central region.");
+    desc.add<InputTag>("recoContext", InputTag("recoContext"))->
+      setComment("Event-level reconstructed information, which provides the number of good "
+      "primary vertices and rho.");
     desc.add<bool>("runOnData")->
       setComment("Indicates whether data or simulation is being processed.");
     desc.add<InputTag>("puInfo", InputTag("addPileupInfo"))->
@@ -48,47 +75,149 @@ void PECPileUp::fillDescriptions(ConfigurationDescriptions &descriptions)
     desc.add<bool>("saveMaxPtHat", false)->
       setComment("Indicates whether largest ptHat in in-time pile-up should be stored.");
     
+    ParameterSetDescription weightsDesc;
+    weightsDesc.add<vector<string>>("dataProfiles")->
+      setComment("Files with data pileup profiles for the nominal case and, optionally, the up "
+      "and down variations. Paths are resolved as for a FileInPath.");
+    weightsDesc.add<string>("histogramName", "pileup")->
+      setComment("Name of the histogram with the profile in the data files.");
+    weightsDesc.add<vector<double>>("mcProfile")->
+      setComment("Probabilities of the true number of interactions in simulation, in unit bins "
+      "starting from zero.");
+    desc.addOptional<ParameterSetDescription>("weights", weightsDesc)->
+      setComment("Configuration to compute pileup weights. If omitted, weights are not "
+      "computed.");
+    
     descriptions.add("pileUp", desc);
 }
 
 
 void PECPileUp::beginJob()
 {
-    outTree = fileService->make<TTree>("PileUp", "Information about pile-up");
+    if (not computeWeights)
+        return;
     
-    puInfoPointer = &puInfo;
-    outTree->Branch("puInfo", &puInfoPointer);
-}
-
-
-void PECPileUp::analyze(Event const &event, EventSetup const &)
-{
-    // Reset the buffer from the previous event
-    puInfo.Reset();
     
+    // Read data profiles and check that they share the same uniform binning
+    vector<vector<double>> dataProfiles;
+    
+    for (auto const &fileName: dataProfileFiles)
+    {
+        unique_ptr<TFile> file(TFile::Open(fileName.c_str()));
+        
+        if (not file or file->IsZombie())
+        {
+            cms::Exception excp("Configuration");
+            excp << "Cannot open file \"" << fileName << "\" with data pileup profile.";
+            excp.raise();
+        }
+        
+        TH1 *hist = dynamic_cast<TH1 *>(file->Get(histogramName.c_str()));
+        
+        if (not hist or hist->GetXaxis()->GetXbins()->GetSize() != 0)
+        {
+            cms::Exception excp("Configuration");
+            excp << "File \"" << fileName << "\" does not contain a histogram \"" <<
+              histogramName << "\" with uniform binning.";
+            excp.raise();
+        }
+        
+        TAxis const *axis = hist->GetXaxis();
+        
+        if (dataProfiles.empty())
+        {
+            tableMin = axis->GetXmin();
+            tableMax = axis->GetXmax();
+            tableBinWidth = (tableMax - tableMin) / axis->GetNbins();
+        }
+        else if (axis->GetXmin() != tableMin or axis->GetXmax() != tableMax or
+          unsigned(axis->GetNbins()) != dataProfiles.front().size())
+        {
+            cms::Exception excp("Configuration");
+            excp << "Binning of the data pileup profile in file \"" << fileName << "\" differs " <<
+              "from that in file \"" << dataProfileFiles.front() << "\".";
+            excp.raise();
+        }
+        
+        vector<double> profile(axis->GetNbins());
+        double integral = 0.;
+        
+        for (unsigned bin = 0; bin < profile.size(); ++bin)
+        {
+            profile[bin] = hist->GetBinContent(bin + 1);
+            integral += profile[bin];
+        }
+        
+        for (auto &p: profile)
+            p /= integral;
+        
+        dataProfiles.emplace_back(move(profile));
+    }
+    
+    unsigned const numBins = dataProfiles.front().size();
     
-    // Save the number of primary vertices
-    Handle<reco::VertexCollection> vertices;
-    event.getByToken(primaryVerticesToken, vertices);
     
-    if (vertices->size() == 0)
+    // Compute the profile in simulation in the same bins, treating the probability density as
+    //constant within each unit bin of the original profile
+    vector<double> mcBinned(numBins, 0.);
+    double mcIntegral = 0.;
+    
+    for (unsigned bin = 0; bin < numBins; ++bin)
+    {
+        double const lo = tableMin + bin * tableBinWidth;
+        double const hi = lo + tableBinWidth;
+        
+        for (int k = max(int(floor(lo)), 0); k < int(ceil(hi)) and k < int(mcProfile.size()); ++k)
+        {
+            double const overlap = min(hi, k + 1.) - max(lo, double(k));
+            
+            if (overlap > 0.)
+                mcBinned[bin] += mcProfile[k] * overlap;
+        }
+        
+        mcIntegral += mcBinned[bin];
+    }
+    
+    if (mcIntegral <= 0.)
     {
-        Exception excp(errors::LogicError);
-        excp << "Event contains zero good primary vertices.\n";
+        cms::Exception excp("Configuration");
+        excp << "Pileup profile in simulation vanishes in the range of the data profiles.";
         excp.raise();
     }
     
-    puInfo.SetNumPV(vertices->size());
     
+    // Tabulate the weights. Up and down variations are copied from the nominal weights if not
+    //provided.
+    weightTable.assign(numBins, {{0.f, 0.f, 0.f}});
+    
+    for (unsigned bin = 0; bin < numBins; ++bin)
+    {
+        double const mc = mcBinned[bin] / mcIntegral;
+        
+        if (mc <= 0.)
+            continue;
+        
+        for (unsigned v = 0; v < 3; ++v)
+        {
+            auto const &dataProfile = dataProfiles[min<unsigned>(v, dataProfiles.size() - 1)];
+            weightTable[bin][v] = dataProfile[bin] / mc;
+        }
+    }
+}
+
+
+void PECPileUp::produce(StreamID, Event &event, EventSetup const &) const
+{
+    unique_ptr<pec::PileUpInfo> puInfo(new pec::PileUpInfo);
     
-    // Save rho
-    Handle<double> rho, rhoCentral;
     
-    event.getByToken(rhoToken, rho);
-    puInfo.SetRho(*rho);
+    // Save the number of good primary vertices and rho
+    Handle<pec::RecoContext> context;
+    event.getByToken(contextToken, context);
     
-    event.getByToken(rhoCentralToken, rhoCentral);
-    puInfo.SetRhoCentral(*rhoCentral);
+    puInfo->SetNumPV(context->NumGoodPV());
+    puInfo->SetRho(context->Rho());
+    puInfo->SetRhoCentral(context->RhoCentral());
     
     
     // Save pile-up information as simulated
@@ -97,22 +226,36 @@ void PECPileUp::analyze(Event const &event, EventSetup const &)
         Handle<View<PileupSummaryInfo>> puSummary;
         event.getByToken(puSummaryToken, puSummary);
         
-        puInfo.SetTrueNumPU(puSummary->front().getTrueNumInteractions());
+        float const trueNumPU = puSummary->front().getTrueNumInteractions();
+        puInfo->SetTrueNumPU(trueNumPU);
         //^ The "true" number of interactions is same for all bunch crossings
         
+        if (computeWeights)
+        {
+            if (trueNumPU >= tableMin and trueNumPU < tableMax)
+            {
+                unsigned const bin = min<unsigned>((trueNumPU - tableMin) / tableBinWidth,
+                  weightTable.size() - 1);
+                auto const &weights = weightTable[bin];
+                puInfo->SetWeights(weights[0], weights[1], weights[2]);
+            }
+            else
+                puInfo->SetWeights(0.f, 0.f, 0.f);
+        }
+        
         for (unsigned i = 0; i < puSummary->size(); ++i)
             if (puSummary->at(i).getBunchCrossing() == 0)
             {
-                puInfo.SetInTimePU(puSummary->at(i).getPU_NumInteractions());
+                puInfo->SetInTimePU(puSummary->at(i).getPU_NumInteractions());
                 
                 if (saveMaxPtHat)
                 {
                     auto const &ptHats = puSummary->at(i).getPU_pT_hats();
                     
                     if (ptHats.size() > 0)
-                        puInfo.SetMaxPtHat(*max_element(ptHats.begin(), ptHats.end()));
+                        puInfo->SetMaxPtHat(*max_element(ptHats.begin(), ptHats.end()));
                     else
-                        puInfo.SetMaxPtHat(0.);
+                        puInfo->SetMaxPtHat(0.);
                 }
                 
                 break;
@@ -120,8 +263,8 @@ void PECPileUp::analyze(Event const &event, EventSetup const &)
     }
     
     
-    // Fill the output tree
-    outTree->Fill();
+    // Put the pile-up information into the event
+    event.put(move(puInfo));
 }
 
 
@@ -1,32 +1,45 @@
 #pragma once
 
 #include <Analysis/PECTuples/interface/PileUpInfo.h>
+#include <Analysis/PECTuples/interface/RecoContext.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/global/EDProducer.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
 
-#include <DataFormats/VertexReco/interface/VertexFwd.h>
 #include <SimDataFormats/PileupSummaryInfo/interface/PileupSummaryInfo.h>
 
-#include <FWCore/ServiceRegistry/interface/Service.h>
-#include <CommonTools/UtilAlgos/interface/TFileService.h>
-
-#include <TTree.h>
-
+#include <array>
+#include <string>
 #include <vector>
 
 
 /**
  * \class PECPileUp
- * \brief Stores information related to pile-up
+ * \brief Puts information related to pile-up into the event
  * 
- * Main properties are the number of primary vertices and the density rho. In case of simulation,
- * the number of additional pp collisions is also stored.
+ * Main properties are the number of good primary vertices and the density rho, which are read from
+ * pec::RecoContext. In case of simulation, the number of additional pp collisions is also stored.
+ * The information is put into the event as an instance of pec::PileUpInfo, which is expected to be
+ * written into a ROOT file with plugin PECWriter. Fields that correspond to simulation truth are
+ * not filled when running over data.
+ * 
+ * If parameter set "weights" is given, pileup weights are also computed for simulation. It
+ * provides a list of one or three ROOT files with data pileup profiles, for the nominal case and
+ * the up and down variations, as produced by pileupCalc.py (paths are resolved as for a
+ * FileInPath, and the name of the histogram is given by parameter "histogramName"), and the
+ * profile in simulation as a vector of probabilities for unit bins in the true number of
+ * interactions starting from zero ("mcProfile"), as given in the configuration of the mixing
+ * module. At the beginning of the job, all profiles are
+ * normalized to unit integral, and the weights are tabulated in the bins of the data profiles,
+ * which must be uniform and shared by all files. Then the weights for an event are obtained by a
+ * single lookup with the index computed from the true number of interactions. Events outside of
+ * the range of the data profiles get null weights. If only one file is given, the up and down
+ * weights are equal to the nominal one. Weights are not computed for data.
  */
-class PECPileUp: public edm::EDAnalyzer
+class PECPileUp: public edm::global::EDProducer<>
 {
 public:
     /// Constructor
@@ -36,18 +49,16 @@ public:
     /// Verifies configuration of the plugin
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
-    /// Creates output tree
+    /// Builds the table of pileup weights if requested
     virtual void beginJob() override;
     
-    /// Writes information about pile-up into buffers and fills the output tree
-    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+    /// Puts information about pile-up into the event
+    virtual void produce(edm::StreamID, edm::Event &event, edm::EventSetup const &) const
+      override;
     
 private:
-    /// Collection of reconstructed primary vertices
-    edm::EDGetTokenT<reco::VertexCollection> primaryVerticesToken;
-    
-    /// Rho (mean angular pt density)
-    edm::EDGetTokenT<double> rhoToken, rhoCentralToken;
+    /// Event-level reconstructed information, which provides the number of vertices and rho
+    edm::EDGetTokenT<pec::RecoContext> contextToken;
     
     /// Indicates whether an event is data or simulation
     bool const runOnData;
@@ -62,26 +73,25 @@ private:
     /// Flag showing whether largest ptHat in pile-up should be stored
     bool saveMaxPtHat;
     
+    /// Indicates whether pileup weights are computed
+    bool computeWeights;
     
-    /// An object to handle the output ROOT file
-    edm::Service<TFileService> fileService;
+    /// Files with data pileup profiles for the nominal case and the up and down variations
+    std::vector<std::string> dataProfileFiles;
     
+    /// Name of the histogram with the pileup profile in the data files
+    std::string histogramName;
     
-    /// Output tree
-    TTree *outTree;
+    /// Probabilities of the true number of interactions in simulation, in unit bins from zero
+    std::vector<double> mcProfile;
     
-    /**
-     * \brief Buffer to store pile-up information
-     * 
-     * In this object, fields that correspond to simulation truth are not filled when running over
-     * data.
-     */
-    pec::PileUpInfo puInfo;
+    /// Range and width of bins of the table of weights
+    double tableMin, tableMax, tableBinWidth;
     
     /**
-     * \brief An auxiliary pointer
+     * \brief Table of weights for the nominal data profile and its up and down variations
      * 
-     * ROOT needs a variable with a pointer to an object to store the object in a tree.
+     * Indexed by the bin of the true number of interactions.
      */
-    pec::PileUpInfo *puInfoPointer;
+    std::vector<std::array<float, 3>> weightTable;
 };
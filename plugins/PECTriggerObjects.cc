@@ -1,6 +1,7 @@
 #include "PECTriggerObjects.h"
 
 #include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/Exception.h>
 
 
 PECTriggerObjects::FilterBuffer::FilterBuffer(std::string const &name_):
@@ -9,8 +10,16 @@ PECTriggerObjects::FilterBuffer::FilterBuffer(std::string const &name_):
 {}
 
 
-PECTriggerObjects::PECTriggerObjects(edm::ParameterSet const &cfg)
+PECTriggerObjects::PECTriggerObjects(edm::ParameterSet const &cfg):
+    packFilters(cfg.getParameter<bool>("packFilters")),
+    packedObjectsPointer(&packedObjects),
+    filterBitsPointer(&filterBits),
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings")),
+    clusterStart(0)
 {
+    usesResource("TFileService");
+    
+    
     triggerObjectsToken = consumes<edm::View<pat::TriggerObjectStandAlone>>(
       cfg.getParameter<edm::InputTag>("triggerObjects"));
     triggerResToken =
@@ -22,7 +31,18 @@ PECTriggerObjects::PECTriggerObjects(edm::ParameterSet const &cfg)
     //^ This is important in order to set up pointers in FilterBuffer properly
     
     for (auto const filterName: filterNames)
+    {
+        filterIndices.emplace(filterName, buffers.size());
         buffers.emplace_back(filterName);
+    }
+    
+    if (packFilters and buffers.size() > 64)
+    {
+        cms::Exception excp("Configuration");
+        excp << "Requested " << buffers.size() << " filters while at maximum 64 filters are " <<
+          "supported when packFilters is true.";
+        excp.raise();
+    }
 }
 
 
@@ -31,6 +51,9 @@ void PECTriggerObjects::analyze(edm::Event const &event, edm::EventSetup const &
     for (auto &buffer: buffers)
         buffer.objects.clear();
     
+    packedObjects.clear();
+    filterBits.clear();
+    
     
     edm::Handle<edm::View<pat::TriggerObjectStandAlone>> triggerObjects;
     event.getByToken(triggerObjectsToken, triggerObjects);
@@ -40,16 +63,42 @@ void PECTriggerObjects::analyze(edm::Event const &event, edm::EventSetup const &
     
     for (auto const &obj: *triggerObjects)
     {
+        // Find which of the selected filters the object has passed
+        ULong64_t mask = 0;
+        std::vector<unsigned> passedFilters;
+        
+        for (auto const &label: obj.filterLabels())
+        {
+            auto const res = filterIndices.find(label);
+            
+            if (res == filterIndices.end())
+                continue;
+            
+            if (packFilters)
+                mask |= ULong64_t(1) << res->second;
+            else
+                passedFilters.emplace_back(res->second);
+        }
+        
+        if (mask == 0 and passedFilters.empty())
+            continue;
+        
+        
         pec::Candidate cand;
         cand.SetPt(obj.pt());
         cand.SetEta(obj.eta());
         cand.SetPhi(obj.phi());
         cand.SetM(obj.mass());
         
-        for (auto &buffer: buffers)
+        if (packFilters)
+        {
+            packedObjects.emplace_back(cand);
+            filterBits.emplace_back(mask);
+        }
+        else
         {
-            if (obj.hasFilterLabel(buffer.name))
-                buffer.objects.emplace_back(cand);
+            for (unsigned const index: passedFilters)
+                buffers[index].objects.emplace_back(cand);
         }
     }
     
@@ -61,8 +110,41 @@ void PECTriggerObjects::beginJob()
 {
     outTree = fileService->make<TTree>("TriggerObjects", "Trigger objects by filters");
     
-    for (auto &buffer: buffers)
-        outTree->Branch(buffer.name.c_str(), &buffer.objectsPointer);
+    if (packFilters)
+    {
+        outTree->Branch("objects", &packedObjectsPointer);
+        outTree->Branch("filterBits", &filterBitsPointer);
+        
+        
+        // Store names of the filters in the order of their bits
+        TTree *namesTree = fileService->make<TTree>("FilterNames", "Names of filters");
+        std::vector<std::string> names;
+        
+        for (auto const &buffer: buffers)
+            names.emplace_back(buffer.name);
+        
+        namesTree->Branch("names", &names);
+        namesTree->Fill();
+        namesTree->ResetBranchAddresses();
+    }
+    else
+    {
+        for (auto &buffer: buffers)
+            outTree->Branch(buffer.name.c_str(), &buffer.objectsPointer);
+    }
+    
+    treeSettings.Apply(outTree);
+}
+
+
+void PECTriggerObjects::beginLuminosityBlock(edm::LuminosityBlock const &,
+  edm::EventSetup const &)
+{}
+
+
+void PECTriggerObjects::endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{
+    treeSettings.EndLuminosityBlock(outTree, clusterStart);
 }
 
 
@@ -73,6 +155,10 @@ void PECTriggerObjects::fillDescriptions(edm::ConfigurationDescriptions &descrip
       setComment("Trigger results.");
     desc.add<edm::InputTag>("triggerObjects")->setComment("PAT trigger objects.");
     desc.add<std::vector<std::string>>("filters")->setComment("Filters to be stored.");
+    desc.add<bool>("packFilters", false)->setComment(
+      "Indicates whether each object should be stored once with a bit mask of passed filters.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output tree.");
     descriptions.add("triggerObjects", desc);
 }
 
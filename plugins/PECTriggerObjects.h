@@ -1,12 +1,15 @@
 #pragma once
 
+#include "TreeSettings.h"
+
 #include <Analysis/PECTuples/interface/Candidate.h>
 
 #include <DataFormats/Common/interface/TriggerResults.h>
 #include <DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h>
 
-#include <FWCore/Framework/interface/EDAnalyzer.h>
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
@@ -16,6 +19,7 @@
 
 #include <TTree.h>
 
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -26,8 +30,20 @@
  * 
  * For each selected HLT filter stores a vector of trigger objects that pass it. Tree branches are
  * named after the filters, trigger objects are stored as instances of pec::Candidate.
+ * 
+ * If parameter packFilters is set to true, each trigger object that passes at least one of the
+ * selected filters is stored only once, in branch "objects". The parallel branch "filterBits"
+ * contains for each object a bit mask of filters it has passed. Bit i corresponds to the filter
+ * with index i in the configuration; names of the filters in this order are saved in branch
+ * "names" of an additional tree "FilterNames" with a single entry. Up to 64 filters are supported
+ * in this mode. Since lepton legs of different triggers usually share objects, this reduces the
+ * size of the output.
+ * 
+ * In both modes, filter labels of each trigger object are looked up in a hash map built from the
+ * selected filters, so that each label is checked only once.
  */
-class PECTriggerObjects: public edm::EDAnalyzer
+class PECTriggerObjects: public edm::one::EDAnalyzer<edm::one::SharedResources,
+  edm::one::WatchLuminosityBlocks>
 {
 private:
     /// Auxiliary structure to aggregate information about an HLT filter
@@ -61,6 +77,14 @@ public:
     /// Creates the output tree
     virtual void beginJob() override;
     
+    /// Does nothing
+    virtual void beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+    
+    /// Closes the current cluster of the output tree if requested
+    virtual void endLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+    
 public:
     /// A method to verify plugin's configuration
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
@@ -75,6 +99,36 @@ private:
     /// Buffers to store trigger objects that pass selected filters
     std::vector<FilterBuffer> buffers;
     
+    /// Map from names of selected filters to their indices in vector buffers
+    std::unordered_map<std::string, unsigned> filterIndices;
+    
+    /// Specifies whether each trigger object is stored once with a bit mask of passed filters
+    bool const packFilters;
+    
+    /**
+     * \brief Buffer with trigger objects that pass at least one of the filters
+     * 
+     * Used only if packFilters is true.
+     */
+    std::vector<pec::Candidate> packedObjects;
+    
+    /**
+     * \brief Bit masks of filters passed by trigger objects in packedObjects
+     * 
+     * Used only if packFilters is true.
+     */
+    std::vector<ULong64_t> filterBits;
+    
+    /// Pointers to packedObjects and filterBits, which ROOT needs to store the vectors in a tree
+    std::vector<pec::Candidate> *packedObjectsPointer;
+    std::vector<ULong64_t> *filterBitsPointer;
+    
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+    
+    /// Number of entries in the output tree at the previous flush forced at the end of a lumi
+    Long64_t clusterStart;
+    
     /// An object to handle the output ROOT file
     edm::Service<TFileService> fileService;
     
@@ -0,0 +1,392 @@
+#include "PECWriter.h"
+
+#include <Analysis/PECTuples/interface/Candidate.h>
+#include <Analysis/PECTuples/interface/Electron.h>
+#include <Analysis/PECTuples/interface/GeneratorInfo.h>
+#include <Analysis/PECTuples/interface/GenJet.h>
+#include <Analysis/PECTuples/interface/GenParticle.h>
+#include <Analysis/PECTuples/interface/GenParticleRecord.h>
+#include <Analysis/PECTuples/interface/Jet.h>
+#include <Analysis/PECTuples/interface/MET.h>
+#include <Analysis/PECTuples/interface/Muon.h>
+#include <Analysis/PECTuples/interface/PileUpInfo.h>
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <algorithm>
+
+
+PECWriter::PECWriter(edm::ParameterSet const &cfg):
+    treeName(cfg.getParameter<std::string>("treeName")),
+    treeTitle(cfg.getParameter<std::string>("treeTitle")),
+    flat(cfg.getParameter<bool>("flat")),
+    reorderBufferSize(cfg.getParameter<unsigned>("reorderBufferSize")),
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings")),
+    clusterStart(0),
+    saveLumiRanges(cfg.getParameter<bool>("saveLumiRanges")),
+    lumiRangesTree(nullptr),
+    lumiFirstEntry(0),
+    outTree(nullptr)
+{
+    usesResource("TFileService");
+
+    for (auto const &branchCfg: cfg.getParameter<std::vector<edm::ParameterSet>>("branches"))
+    {
+        std::string const name = branchCfg.getParameter<std::string>("name");
+        std::string const type = branchCfg.getParameter<std::string>("type");
+        AddBranch(name, type, branchCfg.getParameter<edm::InputTag>("src"));
+
+        auto const names = branchCfg.getParameter<std::vector<std::string>>("valueNames");
+        unsigned const numBits = branchCfg.getParameter<unsigned>("quantizationBits");
+
+        if ((not names.empty() and type != "Floats" and type != "UShorts") or
+          (numBits > 0 and type != "UShorts") or numBits > 16)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Branch \"" << name << "\" of type \"" << type << "\" is given " <<
+              names.size() << " names of values and " << numBits << " quantization bits. " <<
+              "Names are only supported for types \"Floats\" and \"UShorts\", and up to 16 " <<
+              "bits for the latter type.";
+            excp.raise();
+        }
+
+        if (not names.empty())
+            valueNames.emplace_back(name, names, numBits);
+
+        auto const bitNames = branchCfg.getParameter<std::vector<std::string>>("idBitNames");
+
+        if (bitNames.empty())
+            continue;
+
+        // Branches of type "UInt" can store bit masks, such as decisions of ChannelPreselection
+        unsigned const maxIdBits = (type == "UInt") ? 32 : pec::CandidateWithID::maxIdBits;
+
+        if (type != "Electrons" and type != "Muons" and type != "Jets" and type != "UInt")
+        {
+            cms::Exception excp("Configuration");
+            excp << "Names of ID flags are given for branch \"" << name << "\" of type \"" <<
+              type << "\", which does not store ID flags.";
+            excp.raise();
+        }
+
+        if (bitNames.size() > maxIdBits)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Number of names of ID flags given for branch \"" << name << "\" (" <<
+              bitNames.size() << ") exceeds the number of available bits (" << maxIdBits << ").";
+            excp.raise();
+        }
+
+        idBitNames.emplace_back(name, bitNames);
+    }
+
+    for (auto const &branchCfg: cfg.getParameter<std::vector<edm::ParameterSet>>("branches"))
+    {
+        if (branchCfg.getParameter<std::string>("type") == "CompactEventID" and
+          not saveLumiRanges)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Branch \"" << branchCfg.getParameter<std::string>("name") << "\" stores " <<
+              "event IDs in the compact form, which requires that saveLumiRanges is set.";
+            excp.raise();
+        }
+    }
+}
+
+
+void PECWriter::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription branchDesc;
+    branchDesc.add<std::string>("name")->setComment("Name of the branch.");
+    branchDesc.add<std::string>("type")->setComment("Label of the type of the product.");
+    branchDesc.add<edm::InputTag>("src")->setComment("Product to be stored.");
+    branchDesc.add<std::vector<std::string>>("idBitNames", std::vector<std::string>())->
+      setComment("Names of ID flags of stored objects, in the order of their indices.");
+    branchDesc.add<std::vector<std::string>>("valueNames", std::vector<std::string>())->
+      setComment("Names of values stored for each object, for types \"Floats\" and "
+      "\"UShorts\".");
+    branchDesc.add<unsigned>("quantizationBits", 0)->
+      setComment("Number of bits of the codes stored in a branch of type \"UShorts\".");
+
+    edm::ParameterSetDescription desc;
+    desc.add<std::string>("treeName")->setComment("Name of the output tree.");
+    desc.add<std::string>("treeTitle", "")->setComment("Title of the output tree.");
+    desc.add<bool>("flat", false)->setComment(
+      "Indicates whether collections should be stored using the flat layout.");
+    desc.addVPSet("branches", branchDesc)->setComment("Descriptions of branches.");
+    desc.add<unsigned>("reorderBufferSize", 0)->setComment(
+      "Maximal number of events buffered in order to write them sorted by ID within each "
+      "luminosity block. Zero disables reordering.");
+    desc.add<bool>("saveLumiRanges", false)->setComment(
+      "Indicates whether ranges of entries for luminosity blocks should be saved.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output tree.");
+
+    descriptions.add("pecWriter", desc);
+}
+
+
+void PECWriter::beginJob()
+{
+    outTree = fileService->make<TTree>(treeName.c_str(), treeTitle.c_str());
+
+    for (auto &branch: branches)
+        branch->Book(outTree);
+
+    treeSettings.Apply(outTree);
+
+    if (not idBitNames.empty())
+        WriteIDBitNames();
+
+    if (not valueNames.empty())
+        WriteValueNames();
+
+    if (saveLumiRanges)
+    {
+        lumiRangesTree = fileService->make<TTree>("LumiRanges",
+          "Ranges of entries for luminosity blocks");
+        lumiRangesTree->Branch("run", &rangeRun);
+        lumiRangesTree->Branch("lumi", &rangeLumi);
+        lumiRangesTree->Branch("numEntries", &rangeNumEntries);
+    }
+}
+
+
+void PECWriter::analyze(edm::Event const &event, edm::EventSetup const &)
+{
+    if (reorderBufferSize == 0)
+    {
+        for (auto &branch: branches)
+            branch->Read(event);
+
+        outTree->Fill();
+        return;
+    }
+
+    for (auto &branch: branches)
+        branch->Stash(event);
+
+    bufferedEvents.emplace_back(event.id(), bufferedEvents.size());
+
+    if (bufferedEvents.size() >= reorderBufferSize)
+        FlushBufferedEvents();
+}
+
+
+void PECWriter::beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+{
+    lumiFirstEntry = outTree->GetEntries();
+}
+
+
+void PECWriter::endLuminosityBlock(edm::LuminosityBlock const &lumi, edm::EventSetup const &)
+{
+    if (not bufferedEvents.empty())
+        FlushBufferedEvents();
+
+    for (auto &branch: branches)
+        branch->EndLuminosityBlock();
+
+    treeSettings.EndLuminosityBlock(outTree, clusterStart);
+
+    if (saveLumiRanges)
+    {
+        rangeNumEntries = outTree->GetEntries() - lumiFirstEntry;
+
+        if (rangeNumEntries > 0)
+        {
+            rangeRun = lumi.run();
+            rangeLumi = lumi.luminosityBlock();
+            lumiRangesTree->Fill();
+        }
+    }
+}
+
+
+void PECWriter::FlushBufferedEvents()
+{
+    std::sort(bufferedEvents.begin(), bufferedEvents.end());
+
+    for (auto const &e: bufferedEvents)
+    {
+        for (auto &branch: branches)
+            branch->Unstash(e.second);
+
+        outTree->Fill();
+    }
+
+    for (auto &branch: branches)
+        branch->ClearStash();
+
+    bufferedEvents.clear();
+}
+
+
+PECWriter::CompactEventIDBranch::CompactEventIDBranch(std::string const &name_,
+  edm::EDGetTokenT<pec::EventID> &&token_):
+    name(name_),
+    token(token_),
+    eventDelta(0),
+    bunchCrossing(0),
+    previousEvent(0)
+{}
+
+
+void PECWriter::CompactEventIDBranch::Book(TTree *tree)
+{
+    tree->Branch((name + "_eventDelta").c_str(), &eventDelta);
+    tree->Branch((name + "_bunchCrossing").c_str(), &bunchCrossing);
+}
+
+
+void PECWriter::CompactEventIDBranch::Read(edm::Event const &event)
+{
+    edm::Handle<pec::EventID> handle;
+    event.getByToken(token, handle);
+    Encode(*handle);
+}
+
+
+void PECWriter::CompactEventIDBranch::Stash(edm::Event const &event)
+{
+    edm::Handle<pec::EventID> handle;
+    event.getByToken(token, handle);
+    stash.emplace_back(*handle);
+}
+
+
+void PECWriter::CompactEventIDBranch::Unstash(unsigned index)
+{
+    Encode(stash[index]);
+}
+
+
+void PECWriter::CompactEventIDBranch::ClearStash()
+{
+    stash.clear();
+}
+
+
+void PECWriter::CompactEventIDBranch::EndLuminosityBlock()
+{
+    previousEvent = 0;
+}
+
+
+void PECWriter::CompactEventIDBranch::Encode(pec::EventID const &id)
+{
+    // The difference is computed in unsigned arithmetic and then reinterpreted, which gives the
+    //correct signed value when events are not sorted
+    ULong64_t const event = id.EventNumber();
+    eventDelta = Long64_t(event - previousEvent);
+    previousEvent = event;
+    bunchCrossing = id.BunchCrossing();
+}
+
+
+void PECWriter::WriteIDBitNames() const
+{
+    TTree *tree = fileService->make<TTree>("IDBits", "Names of ID flags");
+
+    std::string branchName, bitName;
+    UInt_t bit;
+    tree->Branch("branch", &branchName);
+    tree->Branch("bit", &bit);
+    tree->Branch("name", &bitName);
+
+    for (auto const &entry: idBitNames)
+    {
+        branchName = entry.first;
+
+        for (bit = 0; bit < entry.second.size(); ++bit)
+        {
+            bitName = entry.second[bit];
+            tree->Fill();
+        }
+    }
+
+    // The tree must not refer to the local buffers after this method exits
+    tree->ResetBranchAddresses();
+}
+
+
+void PECWriter::WriteValueNames() const
+{
+    TTree *tree = fileService->make<TTree>("ValueNames", "Names of values stored per object");
+
+    std::string branchName, valueName;
+    UInt_t index, numBits;
+    tree->Branch("branch", &branchName);
+    tree->Branch("index", &index);
+    tree->Branch("name", &valueName);
+    tree->Branch("numBits", &numBits);
+
+    for (auto const &entry: valueNames)
+    {
+        branchName = std::get<0>(entry);
+        auto const &names = std::get<1>(entry);
+        numBits = std::get<2>(entry);
+
+        for (index = 0; index < names.size(); ++index)
+        {
+            valueName = names[index];
+            tree->Fill();
+        }
+    }
+
+    // The tree must not refer to the local buffers after this method exits
+    tree->ResetBranchAddresses();
+}
+
+
+void PECWriter::AddBranch(std::string const &name, std::string const &type,
+  edm::InputTag const &src)
+{
+    if (type == "Candidates")
+        AddFlattenable<std::vector<pec::Candidate>>(name, src);
+    else if (type == "Electrons")
+        AddFlattenable<std::vector<pec::Electron>>(name, src);
+    else if (type == "Muons")
+        AddFlattenable<std::vector<pec::Muon>>(name, src);
+    else if (type == "Jets")
+        AddFlattenable<std::vector<pec::Jet>>(name, src);
+    else if (type == "GenParticles")
+        AddFlattenable<std::vector<pec::GenParticle>>(name, src);
+    else if (type == "GenJets")
+        AddFlattenable<std::vector<pec::GenJet>>(name, src);
+    else if (type == "EventID")
+        AddFlattenable<pec::EventID>(name, src);
+    else if (type == "CompactEventID")
+        branches.emplace_back(new CompactEventIDBranch(name, consumes<pec::EventID>(src)));
+    else if (type == "MET")
+        AddFlattenable<pec::MET>(name, src);
+    else if (type == "PileUpInfo")
+        AddFlattenable<pec::PileUpInfo>(name, src);
+    else if (type == "GeneratorInfo")
+        AddFlattenable<pec::GeneratorInfo>(name, src);
+    else if (type == "GenParticleRecord")
+        branches.emplace_back(new Branch<pec::GenParticleRecord>(name,
+          consumes<pec::GenParticleRecord>(src)));
+    else if (type == "UInt")
+        branches.emplace_back(new Branch<unsigned>(name, consumes<unsigned>(src)));
+    else if (type == "Float")
+        branches.emplace_back(new Branch<float>(name, consumes<float>(src)));
+    else if (type == "Double")
+        branches.emplace_back(new Branch<double>(name, consumes<double>(src)));
+    else if (type == "Floats")
+        branches.emplace_back(new Branch<std::vector<float>>(name,
+          consumes<std::vector<float>>(src)));
+    else if (type == "UShorts")
+        branches.emplace_back(new Branch<std::vector<unsigned short>>(name,
+          consumes<std::vector<unsigned short>>(src)));
+    else
+    {
+        cms::Exception excp("Configuration");
+        excp << "Branch \"" << name << "\" has unsupported type \"" << type << "\".";
+        excp.raise();
+    }
+}
+
+
+DEFINE_FWK_MODULE(PECWriter);
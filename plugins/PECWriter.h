@@ -0,0 +1,522 @@
+#pragma once
+
+#include "FlatColumns.h"
+#include "TreeSettings.h"
+
+#include <Analysis/PECTuples/interface/EventID.h>
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+#include <DataFormats/Provenance/interface/EventID.h>
+
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+#include <TTree.h>
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * \class PECWriter
+ * \brief Copies PEC objects from the event into an output tree
+ *
+ * Conversion of reconstructed and generator-level objects into PEC classes is performed by stream
+ * producers such as PECJetMET or PECElectrons, which put the resulting collections into the event.
+ * This plugin only reads these products and fills the output tree with them. Since it accesses
+ * TFileService, it is serialized by the framework, but the work done here is kept minimal.
+ *
+ * The output tree is described with its name, title, and a vector of parameter sets, one per
+ * branch. Each of them provides the name of the branch, the input tag of the product to store, and
+ * a label of the product type. Supported types are listed in the documentation for method
+ * AddBranch. The tree is created in the directory given by the module label, so the layout of
+ * the output file is the same as when the tree was filled by a dedicated plugin.
+ *
+ * A single instance of this plugin can store products of all PEC producers in one tree. Then all
+ * objects of an event share the same entry and the same clusters of the tree, and a reader only
+ * needs to open a single tree (and a single TTreeCache) to access them.
+ *
+ * If parameter "flat" is set to true, collections of PEC objects are stored using a flat columnar
+ * layout instead of streaming std::vector<T> through the dictionary. Each collection is then
+ * represented by a counter branch and a set of branches with arrays of fundamental types, one per
+ * property of the objects, as described in the documentation for class FlatTable. A reader can
+ * access only the properties it needs without deserializing full objects. Products of types
+ * "EventID", "MET", "PileUpInfo", and "GeneratorInfo", which contain a single object per event,
+ * are then stored as groups of branches "<name>_<property>" with fundamental types (see class
+ * FlatRecord). Other products are stored in the same way regardless of this parameter.
+ *
+ * For collections of objects derived from pec::CandidateWithID, the parameter set of a branch can
+ * include a vector of strings "idBitNames" with names of the ID flags, in the order of their
+ * indices. If any names are given, they are saved in an additional tree "IDBits" in the same
+ * directory, with one entry per flag and branches "branch" (name of the branch the flag refers
+ * to), "bit" (index of the flag), and "name". The tree is filled once at the beginning of the job.
+ * Names can also be given for branches of type "UInt" that store bit masks, such as the decisions
+ * of plugin ChannelPreselection.
+ *
+ * Branches of types "Floats" and "UShorts" store a fixed number of values per object of some
+ * collection, such as real-valued electron IDs (see plugin PECElectrons). Their parameter sets can
+ * include a vector of strings "valueNames" with names of the values in the order in which they
+ * follow for each object, and, for the latter type, "quantizationBits" with the number of bits
+ * of the codes (as produced by pec::minifloat::Quantize in the range [-1, 1]). If names are given,
+ * they are saved in an additional tree "ValueNames" with one entry per value and branches
+ * "branch", "index", "name", and "numBits" (zero for values stored exactly). A reader obtains the
+ * number of values per object from this tree.
+ *
+ * When several streams are used, events reach this plugin in an order that depends on scheduling.
+ * If parameter "reorderBufferSize" is positive, products are not written immediately but copied
+ * into a buffer. At the end of each luminosity block, buffered events are sorted by their IDs
+ * and written, so that the order of entries in the output tree does not depend on scheduling,
+ * and trees filled by different instances of this plugin stay aligned. The parameter limits the
+ * number of buffered events and thus the memory used. If the limit is reached before the end of
+ * a luminosity block, the buffered events are written at that point, and the order is only
+ * deterministic within such chunks. The limit should therefore exceed the number of selected
+ * events in a luminosity block. Trees filled by other plugins, such as SlimTriggerResults or
+ * EventWeights, are not reordered and are then no longer aligned with the output tree. They
+ * must be matched by event ID instead (see parameter saveEventID of SlimTriggerResults), or their
+ * content must be written with this plugin.
+ *
+ * If parameter "saveLumiRanges" is set to true, a tree "LumiRanges" is written in the same
+ * directory. It contains one entry per processed luminosity block with at least one written event
+ * and branches "run", "lumi", and "numEntries". Entries of the output tree that belong to
+ * consecutive luminosity blocks follow in the same order, so the first entry of each block is given
+ * by the cumulative sum of numEntries. This remains valid when files are merged, since both trees
+ * are concatenated in the same order. Together with the alignment of clusters with luminosity
+ * blocks (see class TreeSettings), this allows a reader to skip masked luminosity blocks cluster
+ * by cluster.
+ *
+ * Event IDs can be stored in a compact form with the type label "CompactEventID", which requires
+ * that saveLumiRanges is set. Run and luminosity block numbers are then only stored in tree
+ * "LumiRanges", and the branch is replaced by two branches "<name>_eventDelta" (Long64_t) and
+ * "<name>_bunchCrossing" (UShort_t). The former contains the difference between the event number
+ * and the one in the previous entry within the same luminosity block, or the full event number
+ * for the first entry of the block, which compresses much better than full IDs. Standalone class
+ * pecreader::EventIDDecoder restores objects pec::EventID from this representation.
+ */
+class PECWriter: public edm::one::EDAnalyzer<edm::one::SharedResources,
+  edm::one::WatchLuminosityBlocks>
+{
+private:
+    /// Abstract interface for a branch of the output tree
+    class BranchBase
+    {
+    public:
+        /// Virtual destructor
+        virtual ~BranchBase() = default;
+
+    public:
+        /// Creates the branch in the given tree
+        virtual void Book(TTree *tree) = 0;
+
+        /// Reads the product from the event and copies it into the buffer
+        virtual void Read(edm::Event const &event) = 0;
+
+        /// Reads the product from the event and appends a copy of it to the stash
+        virtual void Stash(edm::Event const &event) = 0;
+
+        /// Moves the stashed product with the given index into the buffer
+        virtual void Unstash(unsigned index) = 0;
+
+        /// Discards all stashed products
+        virtual void ClearStash() = 0;
+
+        /// Notifies the branch that all events of the current luminosity block have been written
+        virtual void EndLuminosityBlock()
+        {}
+    };
+
+
+    /**
+     * \brief A branch that stores an object of type T
+     *
+     * Fundamental types are stored as leaves of the corresponding type, while for classes the
+     * split mode is used, as in the plugins that fill trees directly.
+     */
+    template<typename T>
+    class Branch: public BranchBase
+    {
+    public:
+        /// Constructor
+        Branch(std::string const &name, edm::EDGetTokenT<T> &&token);
+
+    public:
+        /// Creates the branch in the given tree
+        virtual void Book(TTree *tree) override;
+
+        /// Reads the product from the event and copies it into the buffer
+        virtual void Read(edm::Event const &event) override;
+
+        /// Reads the product from the event and appends a copy of it to the stash
+        virtual void Stash(edm::Event const &event) override;
+
+        /// Moves the stashed product with the given index into the buffer
+        virtual void Unstash(unsigned index) override;
+
+        /// Discards all stashed products
+        virtual void ClearStash() override;
+
+    private:
+        /// Name of the branch
+        std::string name;
+
+        /// Token to read the product
+        edm::EDGetTokenT<T> token;
+
+        /// Buffer to store the product
+        T buffer;
+
+        /// Products of buffered events, used when events are reordered
+        std::vector<T> stash;
+
+        /**
+         * \brief An auxiliary pointer
+         *
+         * ROOT needs a variable with a pointer to an object to store the object in a tree.
+         */
+        T *bufferPointer;
+    };
+
+
+    /// Type of the flat table or record that stores a product of type T
+    template<typename T>
+    struct FlatStorage
+    {
+        using type = FlatRecord<T>;
+    };
+
+    template<typename T>
+    struct FlatStorage<std::vector<T>>
+    {
+        using type = FlatTable<T>;
+    };
+
+
+    /**
+     * \brief A group of branches that stores a product of type T using the flat layout
+     *
+     * T must be an std::vector of PEC objects or a single PEC object, for which columns of a flat
+     * table or record respectively are defined in FlatColumns.h.
+     */
+    template<typename T>
+    class FlatBranch: public BranchBase
+    {
+    public:
+        /// Constructor
+        FlatBranch(std::string const &name, edm::EDGetTokenT<T> &&token);
+
+    public:
+        /// Creates the branches in the given tree
+        virtual void Book(TTree *tree) override;
+
+        /// Reads the product from the event and copies it into the buffers
+        virtual void Read(edm::Event const &event) override;
+
+        /// Reads the product from the event and appends a copy of it to the stash
+        virtual void Stash(edm::Event const &event) override;
+
+        /// Copies the stashed product with the given index into the buffers
+        virtual void Unstash(unsigned index) override;
+
+        /// Discards all stashed products
+        virtual void ClearStash() override;
+
+    private:
+        /// Token to read the product
+        edm::EDGetTokenT<T> token;
+
+        /// Table or record that manages the branches and their buffers
+        typename FlatStorage<T>::type table;
+
+        /// Products of buffered events, used when events are reordered
+        std::vector<T> stash;
+    };
+
+
+    /**
+     * \brief A group of branches that stores event IDs in the compact form
+     *
+     * See the documentation for class PECWriter.
+     */
+    class CompactEventIDBranch: public BranchBase
+    {
+    public:
+        /// Constructor
+        CompactEventIDBranch(std::string const &name, edm::EDGetTokenT<pec::EventID> &&token);
+
+    public:
+        /// Creates the branches in the given tree
+        virtual void Book(TTree *tree) override;
+
+        /// Reads the product from the event and encodes it into the buffers
+        virtual void Read(edm::Event const &event) override;
+
+        /// Reads the product from the event and appends a copy of it to the stash
+        virtual void Stash(edm::Event const &event) override;
+
+        /// Encodes the stashed product with the given index into the buffers
+        virtual void Unstash(unsigned index) override;
+
+        /// Discards all stashed products
+        virtual void ClearStash() override;
+
+        /// Resets the reference event number
+        virtual void EndLuminosityBlock() override;
+
+    private:
+        /// Encodes the given ID into the buffers
+        void Encode(pec::EventID const &id);
+
+    private:
+        /// Name of the branch
+        std::string name;
+
+        /// Token to read the product
+        edm::EDGetTokenT<pec::EventID> token;
+
+        /// Buffers for the branches
+        Long64_t eventDelta;
+        UShort_t bunchCrossing;
+
+        /// Event number in the previous entry of the current luminosity block
+        ULong64_t previousEvent;
+
+        /// Products of buffered events, used when events are reordered
+        std::vector<pec::EventID> stash;
+    };
+
+public:
+    /// Constructor
+    PECWriter(edm::ParameterSet const &cfg);
+
+public:
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+    /// Creates the output tree
+    virtual void beginJob() override;
+
+    /// Copies products into the buffers and fills the output tree or buffers the event
+    virtual void analyze(edm::Event const &event, edm::EventSetup const &) override;
+
+    /// Remembers the number of entries written before the luminosity block
+    virtual void beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+
+    /// Writes buffered events, closes the cluster if requested, and saves the range of entries
+    virtual void endLuminosityBlock(edm::LuminosityBlock const &lumi, edm::EventSetup const &)
+      override;
+
+private:
+    /**
+     * \brief Registers a new branch
+     *
+     * Supported values of the type label and the corresponding C++ types are:
+     *   "Candidates"    std::vector<pec::Candidate>,
+     *   "Electrons"     std::vector<pec::Electron>,
+     *   "Muons"         std::vector<pec::Muon>,
+     *   "Jets"          std::vector<pec::Jet>,
+     *   "GenParticles"  std::vector<pec::GenParticle>,
+     *   "GenJets"       std::vector<pec::GenJet>,
+     *   "EventID"       pec::EventID,
+     *   "CompactEventID" pec::EventID (stored in the compact form),
+     *   "MET"           pec::MET,
+     *   "PileUpInfo"    pec::PileUpInfo,
+     *   "GeneratorInfo" pec::GeneratorInfo,
+     *   "GenParticleRecord" pec::GenParticleRecord,
+     *   "UInt"          unsigned,
+     *   "Float"         float,
+     *   "Double"        double,
+     *   "Floats"        std::vector<float>,
+     *   "UShorts"       std::vector<unsigned short>.
+     * Throws an exception if the type label is not known.
+     */
+    void AddBranch(std::string const &name, std::string const &type, edm::InputTag const &src);
+
+    /// Writes names of ID flags into a dedicated tree
+    void WriteIDBitNames() const;
+
+    /// Writes names of values stored in branches of types "Floats" and "UShorts"
+    void WriteValueNames() const;
+
+    /**
+     * \brief Registers a new branch for a collection of PEC objects or for a single PEC object
+     *
+     * Depending on the configuration, the product will be stored as is or using the flat layout.
+     */
+    template<typename T>
+    void AddFlattenable(std::string const &name, edm::InputTag const &src);
+
+    /// Sorts buffered events by their IDs, writes them into the output tree, and clears the buffer
+    void FlushBufferedEvents();
+
+private:
+    /// Name of the output tree
+    std::string const treeName;
+
+    /// Title of the output tree
+    std::string const treeTitle;
+
+    /// Indicates whether collections are stored using the flat layout
+    bool const flat;
+
+    /// Branches of the output tree
+    std::vector<std::unique_ptr<BranchBase>> branches;
+
+    /// Names of ID flags for each branch for which they have been provided
+    std::vector<std::pair<std::string, std::vector<std::string>>> idBitNames;
+
+    /// Names of values and the number of bits of their codes for each branch that provides them
+    std::vector<std::tuple<std::string, std::vector<std::string>, unsigned>> valueNames;
+
+    /// Maximal number of buffered events; zero means that events are not reordered
+    unsigned const reorderBufferSize;
+
+    /// IDs of buffered events and their indices in the stashes of the branches
+    std::vector<std::pair<edm::EventID, unsigned>> bufferedEvents;
+
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+
+    /// Number of entries in the output tree at the previous flush forced at the end of a lumi
+    Long64_t clusterStart;
+
+    /// Indicates whether ranges of entries for luminosity blocks should be saved
+    bool const saveLumiRanges;
+
+    /// Tree with ranges of entries for luminosity blocks; managed by fileService
+    TTree *lumiRangesTree;
+
+    /// Number of entries in the output tree at the beginning of the current luminosity block
+    Long64_t lumiFirstEntry;
+
+    /// Buffers for lumiRangesTree
+    UInt_t rangeRun, rangeLumi;
+    Long64_t rangeNumEntries;
+
+    /// An object to handle the output ROOT file
+    edm::Service<TFileService> fileService;
+
+    /**
+     * \brief Output tree
+     *
+     * Managed by the fileService object.
+     */
+    TTree *outTree;
+};
+
+
+template<typename T>
+PECWriter::Branch<T>::Branch(std::string const &name_, edm::EDGetTokenT<T> &&token_):
+    name(name_),
+    token(token_),
+    bufferPointer(&buffer)
+{}
+
+
+template<typename T>
+void PECWriter::Branch<T>::Book(TTree *tree)
+{
+    if constexpr (std::is_arithmetic<T>::value)
+        tree->Branch(name.c_str(), &buffer);
+    else
+        tree->Branch(name.c_str(), &bufferPointer);
+}
+
+
+template<typename T>
+void PECWriter::Branch<T>::Read(edm::Event const &event)
+{
+    edm::Handle<T> handle;
+    event.getByToken(token, handle);
+    buffer = *handle;
+}
+
+
+template<typename T>
+void PECWriter::Branch<T>::Stash(edm::Event const &event)
+{
+    edm::Handle<T> handle;
+    event.getByToken(token, handle);
+    stash.emplace_back(*handle);
+}
+
+
+template<typename T>
+void PECWriter::Branch<T>::Unstash(unsigned index)
+{
+    buffer = std::move(stash[index]);
+}
+
+
+template<typename T>
+void PECWriter::Branch<T>::ClearStash()
+{
+    stash.clear();
+}
+
+
+template<typename T>
+PECWriter::FlatBranch<T>::FlatBranch(std::string const &name, edm::EDGetTokenT<T> &&token_):
+    token(token_),
+    table(name)
+{
+    flatcolumns::Define(table);
+}
+
+
+template<typename T>
+void PECWriter::FlatBranch<T>::Book(TTree *tree)
+{
+    table.Book(tree);
+}
+
+
+template<typename T>
+void PECWriter::FlatBranch<T>::Read(edm::Event const &event)
+{
+    edm::Handle<T> handle;
+    event.getByToken(token, handle);
+    table.Fill(*handle);
+}
+
+
+template<typename T>
+void PECWriter::FlatBranch<T>::Stash(edm::Event const &event)
+{
+    edm::Handle<T> handle;
+    event.getByToken(token, handle);
+    stash.emplace_back(*handle);
+}
+
+
+template<typename T>
+void PECWriter::FlatBranch<T>::Unstash(unsigned index)
+{
+    table.Fill(stash[index]);
+}
+
+
+template<typename T>
+void PECWriter::FlatBranch<T>::ClearStash()
+{
+    stash.clear();
+}
+
+
+template<typename T>
+void PECWriter::AddFlattenable(std::string const &name, edm::InputTag const &src)
+{
+    if (flat)
+        branches.emplace_back(new FlatBranch<T>(name, consumes<T>(src)));
+    else
+        branches.emplace_back(new Branch<T>(name, consumes<T>(src)));
+}
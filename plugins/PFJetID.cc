@@ -0,0 +1,147 @@
+#include "PFJetID.h"
+
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <cmath>
+#include <sstream>
+
+
+PFJetID::PFJetID(std::vector<edm::ParameterSet> const &regionsCfg)
+{
+    // Region indices are stored as 8-bit integers, and the maximal value is reserved
+    if (regionsCfg.size() >= 255)
+    {
+        cms::Exception excp("Configuration");
+        excp << "Too many regions (" << regionsCfg.size() << ") in the definition of jet ID.";
+        excp.raise();
+    }
+
+    for (auto const &regionCfg: regionsCfg)
+    {
+        Region region;
+        region.maxAbsEta = regionCfg.getParameter<double>("maxAbsEta");
+
+        if (not regions.empty() and region.maxAbsEta <= regions.back().maxAbsEta)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Regions in the definition of jet ID are not ordered in |eta|.";
+            excp.raise();
+        }
+
+        for (auto const &cutText: regionCfg.getParameter<std::vector<std::string>>("cuts"))
+            region.cuts.emplace_back(ParseCut(cutText));
+
+        regions.emplace_back(std::move(region));
+    }
+}
+
+
+edm::ParameterSetDescription PFJetID::GetRegionDescription()
+{
+    edm::ParameterSetDescription desc;
+    desc.add<double>("maxAbsEta")->setComment("Inclusive upper boundary of the region in |eta|.");
+    desc.add<std::vector<std::string>>("cuts")->
+      setComment("Cuts to be applied, such as \"NHF < 0.9\".");
+
+    return desc;
+}
+
+
+std::vector<std::uint8_t> const &PFJetID::Evaluate(edm::View<pat::Jet> const &jets)
+{
+    unsigned const nJets = jets.size();
+
+    for (auto &column: values)
+        column.resize(nJets);
+
+    regionIndices.resize(nJets);
+    decisions.assign(nJets, 1);
+
+
+    // Copy properties of jets into the arrays and find their regions
+    for (unsigned i = 0; i < nJets; ++i)
+    {
+        pat::Jet const &j = jets[i];
+
+        values[CHF][i] = j.chargedHadronEnergyFraction();
+        values[NHF][i] = j.neutralHadronEnergyFraction();
+        values[CEF][i] = j.chargedEmEnergyFraction();
+        values[NEF][i] = j.neutralEmEnergyFraction();
+        values[MUF][i] = j.muonEnergyFraction();
+        values[CHM][i] = j.chargedMultiplicity();
+        values[NM][i] = j.neutralMultiplicity();
+        values[NumConst][i] = j.chargedMultiplicity() + j.neutralMultiplicity();
+        values[NumDaughters][i] = j.numberOfDaughters();
+
+        float const absEta = std::abs(j.eta());
+        unsigned iRegion = 0;
+
+        while (iRegion < regions.size() and absEta > regions[iRegion].maxAbsEta)
+            ++iRegion;
+
+        if (iRegion == regions.size())
+        {
+            decisions[i] = 0;
+            iRegion = 255;
+        }
+
+        regionIndices[i] = iRegion;
+    }
+
+
+    // Apply cuts from all regions to all jets. A cut does not affect a jet from another region.
+    for (unsigned iRegion = 0; iRegion < regions.size(); ++iRegion)
+    {
+        for (auto const &cut: regions[iRegion].cuts)
+        {
+            float const *v = values[cut.variable].data();
+            std::uint8_t const *r = regionIndices.data();
+            std::uint8_t *d = decisions.data();
+            float const threshold = cut.threshold;
+
+            if (cut.isLowerBound)
+                for (unsigned i = 0; i < nJets; ++i)
+                    d[i] &= (r[i] != iRegion) | (v[i] > threshold);
+            else
+                for (unsigned i = 0; i < nJets; ++i)
+                    d[i] &= (r[i] != iRegion) | (v[i] < threshold);
+        }
+    }
+
+    return decisions;
+}
+
+
+PFJetID::Cut PFJetID::ParseCut(std::string const &text)
+{
+    std::istringstream stream(text);
+    std::string name, op;
+    float threshold;
+    stream >> name >> op >> threshold;
+
+    if (stream.fail() or not (stream >> std::ws).eof() or (op != "<" and op != ">"))
+    {
+        cms::Exception excp("Configuration");
+        excp << "Failed to parse cut \"" << text << "\" in the definition of jet ID.";
+        excp.raise();
+    }
+
+    return {ParseVariable(name), op == ">", threshold};
+}
+
+
+PFJetID::Variable PFJetID::ParseVariable(std::string const &name)
+{
+    static std::array<std::string, numVariables> const names{{"CHF", "NHF", "CEF", "NEF", "MUF",
+      "CHM", "NM", "NumConst", "NumDaughters"}};
+
+    for (unsigned i = 0; i < names.size(); ++i)
+        if (names[i] == name)
+            return Variable(i);
+
+    cms::Exception excp("Configuration");
+    excp << "Variable \"" << name << "\" is not supported in the definition of jet ID.";
+    excp.raise();
+
+    return numVariables;  // never reached
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <DataFormats/PatCandidates/interface/Jet.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class PFJetID
+ * \brief Evaluates PF jet ID defined by a table of thresholds
+ *
+ * The ID is described by a vector of parameter sets, each of which defines a region in |eta| and
+ * the cuts to be applied to jets in that region. Regions are given in the order of increasing
+ * upper boundary "maxAbsEta", which is inclusive; a jet belongs to the first region whose boundary
+ * is not smaller than its |eta|, and jets outside of all regions fail the ID. Each cut is a string
+ * of the form "<variable> <op> <threshold>", where the operation is "<" or ">" (both are strict).
+ * Supported variables are listed in the documentation for method ParseVariable. New versions of
+ * the ID thus only require a new table in the configuration, as done in ObjectsDefinitions_cff.py.
+ *
+ * Jets of an event are evaluated in a batch. Their properties are first copied into contiguous
+ * arrays, one per variable, and then each cut is applied to all jets at once in a loop without
+ * branches, which the compiler is able to vectorize. The arrays are kept between events to avoid
+ * memory allocations.
+ */
+class PFJetID
+{
+private:
+    /// Supported variables
+    enum Variable: unsigned
+    {
+        CHF,
+        NHF,
+        CEF,
+        NEF,
+        MUF,
+        CHM,
+        NM,
+        NumConst,
+        NumDaughters,
+        numVariables
+    };
+
+    /// A single cut
+    struct Cut
+    {
+        /// Variable to which the cut is applied
+        Variable variable;
+
+        /// Indicates whether the value must be above (true) or below (false) the threshold
+        bool isLowerBound;
+
+        /// Threshold
+        float threshold;
+    };
+
+    /// A region in |eta| with a set of cuts
+    struct Region
+    {
+        /// Inclusive upper boundary of the region
+        float maxAbsEta;
+
+        /// Cuts applied to jets in this region
+        std::vector<Cut> cuts;
+    };
+
+public:
+    /// Constructor from a vector of parameter sets that describe regions
+    PFJetID(std::vector<edm::ParameterSet> const &regionsCfg);
+
+public:
+    /// Returns description of a parameter set that defines a region
+    static edm::ParameterSetDescription GetRegionDescription();
+
+    /**
+     * \brief Evaluates the ID for all given jets
+     *
+     * The result for jet i is stored in the i-th element of the returned vector, which remains
+     * valid until the next call to this method.
+     */
+    std::vector<std::uint8_t> const &Evaluate(edm::View<pat::Jet> const &jets);
+
+    /// Checks if the ID is enabled, i.e. if at least one region has been defined
+    bool IsEnabled() const
+    {
+        return not regions.empty();
+    }
+
+private:
+    /// Parses a cut of the form "<variable> <op> <threshold>"
+    static Cut ParseCut(std::string const &text);
+
+    /**
+     * \brief Returns a variable with the given name
+     *
+     * Supported names are "CHF", "NHF", "CEF", "NEF", and "MUF" for energy fractions of charged
+     * and neutral hadrons, charged and neutral EM particles, and muons; "CHM" and "NM" for charged
+     * and neutral multiplicities; "NumConst" for the sum of these multiplicities; "NumDaughters"
+     * for the number of daughters of the jet. Energy fractions take into account JEC as done in
+     * accessors of pat::Jet. Throws an exception if the name is not known.
+     */
+    static Variable ParseVariable(std::string const &name);
+
+private:
+    /// Regions with cuts, ordered in |eta|
+    std::vector<Region> regions;
+
+    /// Values of all variables for jets in the current batch
+    std::array<std::vector<float>, numVariables> values;
+
+    /// Indices of regions to which jets in the current batch belong
+    std::vector<std::uint8_t> regionIndices;
+
+    /// Results of the evaluation for jets in the current batch
+    std::vector<std::uint8_t> decisions;
+};
@@ -0,0 +1,298 @@
+#include "PerfMonitor.h"
+
+#include <FWCore/ServiceRegistry/interface/ServiceMaker.h>
+#include <FWCore/ServiceRegistry/interface/ModuleCallingContext.h>
+#include <FWCore/ServiceRegistry/interface/PathContext.h>
+#include <FWCore/ServiceRegistry/interface/ProcessContext.h>
+#include <FWCore/ServiceRegistry/interface/StreamContext.h>
+#include <FWCore/ServiceRegistry/interface/SystemBounds.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+#include <FWCore/Utilities/interface/EDMException.h>
+#include <DataFormats/Common/interface/HLTPathStatus.h>
+#include <DataFormats/Provenance/interface/ModuleDescription.h>
+
+#include <TBranch.h>
+#include <TDirectory.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include <set>
+
+
+PerfMonitor::PerfMonitor(edm::ParameterSet const &, edm::ActivityRegistry &registry):
+    numStreams(1)
+{
+    registry.watchPreallocate(this, &PerfMonitor::Preallocate);
+    registry.watchPreModuleConstruction(this, &PerfMonitor::PreModuleConstruction);
+    registry.watchPreBeginJob(this, &PerfMonitor::PreBeginJob);
+    registry.watchPostBeginJob(this, &PerfMonitor::PostBeginJob);
+    registry.watchPreModuleEvent(this, &PerfMonitor::PreModuleEvent);
+    registry.watchPostModuleEvent(this, &PerfMonitor::PostModuleEvent);
+    registry.watchPostPathEvent(this, &PerfMonitor::PostPathEvent);
+    registry.watchPostEndJob(this, &PerfMonitor::PostEndJob);
+}
+
+
+void PerfMonitor::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription desc;
+    descriptions.add("PerfMonitor", desc);
+}
+
+
+void PerfMonitor::Preallocate(edm::service::SystemBounds const &bounds)
+{
+    numStreams = bounds.maxNumberOfStreams();
+}
+
+
+void PerfMonitor::PreModuleConstruction(edm::ModuleDescription const &description)
+{
+    unsigned const id = description.id();
+
+    if (id >= moduleNames.size())
+        moduleNames.resize(id + 1);
+
+    moduleNames[id] = {description.moduleLabel(), description.moduleName()};
+}
+
+
+void PerfMonitor::PreBeginJob(edm::PathsAndConsumesOfModulesBase const &pathsAndConsumes,
+  edm::ProcessContext const &)
+{
+    auto const &pathNames = pathsAndConsumes.paths();
+
+    for (unsigned iPath = 0; iPath < pathNames.size(); ++iPath)
+    {
+        auto const &modules = pathsAndConsumes.modulesOnPath(iPath);
+        std::set<unsigned> idsOnPath;
+
+        for (auto const *module: modules)
+            idsOnPath.insert(module->id());
+
+        auto &descriptions = pathModules[pathNames[iPath]];
+        descriptions.resize(modules.size());
+
+        for (unsigned i = 0; i < modules.size(); ++i)
+        {
+            descriptions[i].label = modules[i]->moduleLabel();
+
+
+            // Follow consumed products recursively through modules that are not on the path,
+            //such as unscheduled producers
+            std::set<unsigned> visited{modules[i]->id()};
+            std::vector<unsigned> queue{modules[i]->id()};
+
+            while (not queue.empty())
+            {
+                unsigned const id = queue.back();
+                queue.pop_back();
+
+                for (auto const *producer: pathsAndConsumes.modulesWhoseProductsAreConsumedBy(id))
+                {
+                    if (not visited.insert(producer->id()).second)
+                        continue;
+
+                    if (idsOnPath.count(producer->id()) > 0)
+                        descriptions[i].dependencies.emplace_back(producer->moduleLabel());
+                    else
+                        queue.emplace_back(producer->id());
+                }
+            }
+        }
+    }
+}
+
+
+void PerfMonitor::PostBeginJob()
+{
+    if (not fileService.isAvailable())
+    {
+        edm::Exception excp(edm::errors::Configuration);
+        excp << "PerfMonitor requires TFileService.";
+        excp.raise();
+    }
+
+    moduleCounters.assign(numStreams, std::vector<ModuleCounters>(moduleNames.size()));
+}
+
+
+void PerfMonitor::PreModuleEvent(edm::StreamContext const &streamContext,
+  edm::ModuleCallingContext const &moduleContext)
+{
+    // Different modules in the same stream can run concurrently, but each of them uses its own
+    //counters
+    moduleCounters[streamContext.streamID().value()][moduleContext.moduleDescription()->id()]
+      .start = std::chrono::steady_clock::now();
+}
+
+
+void PerfMonitor::PostModuleEvent(edm::StreamContext const &streamContext,
+  edm::ModuleCallingContext const &moduleContext)
+{
+    ModuleCounters &counters =
+      moduleCounters[streamContext.streamID().value()][moduleContext.moduleDescription()->id()];
+    counters.time += std::chrono::steady_clock::now() - counters.start;
+    ++counters.numEvents;
+}
+
+
+void PerfMonitor::PostPathEvent(edm::StreamContext const &, edm::PathContext const &pathContext,
+  edm::HLTPathStatus const &status)
+{
+    std::lock_guard<std::mutex> lock(pathMutex);
+    auto &counters = pathCounters[pathContext.pathName()];
+    ++counters.first;
+
+    if (status.accept())
+        ++counters.second;
+    else if (status.state() == edm::hlt::Fail)
+    {
+        // The index of the status refers to the last module run, which rejected the event
+        auto &modules = pathModules[pathContext.pathName()];
+
+        if (status.index() < modules.size())
+            ++modules[status.index()].numRejected;
+    }
+}
+
+
+void PerfMonitor::PostEndJob()
+{
+    // Sizes of branches are collected before new trees are created
+    TFile &file = fileService->file();
+    std::vector<BranchSizes> branchSizes;
+    CollectBranchSizes(&file, "", branchSizes);
+
+
+    // Trees are created in a dedicated directory and will be written when TFileService closes
+    //the file
+    TDirectory::TContext context(file.mkdir("Perf"));
+
+    std::string label, type;
+    ULong64_t numEvents;
+    Double_t realTime;
+
+    TTree *modulesTree = new TTree("Modules", "Counters for modules");
+    modulesTree->Branch("label", &label);
+    modulesTree->Branch("type", &type);
+    modulesTree->Branch("events", &numEvents);
+    modulesTree->Branch("realTime", &realTime);
+
+    for (unsigned id = 0; id < moduleNames.size(); ++id)
+    {
+        if (moduleNames[id].first.empty())
+            continue;
+
+        label = moduleNames[id].first;
+        type = moduleNames[id].second;
+        numEvents = 0;
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+
+        for (auto const &streamCounters: moduleCounters)
+        {
+            numEvents += streamCounters[id].numEvents;
+            time += streamCounters[id].time;
+        }
+
+        realTime = std::chrono::duration<double>(time).count();
+        modulesTree->Fill();
+    }
+
+    modulesTree->ResetBranchAddresses();
+
+
+    std::string pathName;
+    ULong64_t numAccepted;
+
+    TTree *pathsTree = new TTree("Paths", "Counters for paths");
+    pathsTree->Branch("name", &pathName);
+    pathsTree->Branch("events", &numEvents);
+    pathsTree->Branch("accepted", &numAccepted);
+
+    for (auto const &p: pathCounters)
+    {
+        pathName = p.first;
+        numEvents = p.second.first;
+        numAccepted = p.second.second;
+        pathsTree->Fill();
+    }
+
+    pathsTree->ResetBranchAddresses();
+
+
+    UInt_t index;
+    ULong64_t numRejected;
+    std::vector<std::string> dependencies;
+
+    TTree *pathModulesTree = new TTree("PathModules", "Modules on paths");
+    pathModulesTree->Branch("path", &pathName);
+    pathModulesTree->Branch("index", &index);
+    pathModulesTree->Branch("label", &label);
+    pathModulesTree->Branch("rejected", &numRejected);
+    pathModulesTree->Branch("dependencies", &dependencies);
+
+    for (auto const &p: pathModules)
+    {
+        pathName = p.first;
+
+        for (index = 0; index < p.second.size(); ++index)
+        {
+            auto const &module = p.second[index];
+            label = module.label;
+            numRejected = module.numRejected;
+            dependencies = module.dependencies;
+            pathModulesTree->Fill();
+        }
+    }
+
+    pathModulesTree->ResetBranchAddresses();
+
+
+    std::string treeName, branchName;
+    Long64_t totBytes, zipBytes;
+
+    TTree *branchesTree = new TTree("Branches", "Sizes of branches in the output file");
+    branchesTree->Branch("tree", &treeName);
+    branchesTree->Branch("branch", &branchName);
+    branchesTree->Branch("totBytes", &totBytes);
+    branchesTree->Branch("zipBytes", &zipBytes);
+
+    for (auto const &sizes: branchSizes)
+    {
+        treeName = sizes.treeName;
+        branchName = sizes.branchName;
+        totBytes = sizes.totBytes;
+        zipBytes = sizes.zipBytes;
+        branchesTree->Fill();
+    }
+
+    branchesTree->ResetBranchAddresses();
+}
+
+
+void PerfMonitor::CollectBranchSizes(TDirectory *directory, std::string const &path,
+  std::vector<BranchSizes> &sizes)
+{
+    for (TObject *obj: *directory->GetList())
+    {
+        if (auto *tree = dynamic_cast<TTree *>(obj))
+        {
+            // Write baskets that are still in memory, so that compressed sizes are known
+            tree->FlushBaskets();
+            std::string const treeName(path + tree->GetName());
+
+            for (TObject *branchObj: *tree->GetListOfBranches())
+            {
+                auto *branch = static_cast<TBranch *>(branchObj);
+                sizes.push_back({treeName, branch->GetName(), branch->GetTotBytes("*"),
+                  branch->GetZipBytes("*")});
+            }
+        }
+        else if (auto *subdirectory = dynamic_cast<TDirectory *>(obj))
+            CollectBranchSizes(subdirectory, path + subdirectory->GetName() + "/", sizes);
+    }
+}
+
+
+DEFINE_FWK_SERVICE(PerfMonitor);
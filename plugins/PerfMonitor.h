@@ -0,0 +1,148 @@
+#pragma once
+
+#include <FWCore/ServiceRegistry/interface/ActivityRegistry.h>
+#include <FWCore/ServiceRegistry/interface/PathsAndConsumesOfModulesBase.h>
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+class TDirectory;
+
+
+/**
+ * \class PerfMonitor
+ * \brief A service that saves cheap performance counters into the output file of TFileService
+ *
+ * For each module in the job, the service records the number of events for which the module has
+ * been run and the total wall time spent in it. For each path, the number of processed and
+ * accepted events is recorded. Counters are accumulated independently in each stream and
+ * combined at the end of the job. After all modules have finished their endJob, the service
+ * flushes all trees in the output file and records compressed and uncompressed sizes of their
+ * top-level branches, including sub-branches.
+ *
+ * The results are stored in three trees in directory "Perf" of the output file. Tree "Modules"
+ * contains branches "label", "type", "events", and "realTime" (in seconds); tree "Paths" contains
+ * branches "name", "events", and "accepted"; tree "Branches" contains branches "tree" (including
+ * the directory), "branch", "totBytes", and "zipBytes". Each entry describes a single module,
+ * path, or branch in a single job, so the trees from different jobs can be merged with hadd and
+ * aggregated afterwards (see script mergeCrabRes.py).
+ *
+ * In addition, tree "PathModules" describes every module on every path, in the order in which they
+ * are run. It contains branches "path", "index" (position in the path), "label", "rejected"
+ * (number of events rejected by this module in this path), and "dependencies". The last one lists
+ * labels of preceding or following modules on the same path whose products the module consumes,
+ * directly or through modules that are not on the path. These counters are used to choose the
+ * order of filters (see method PathManager.reorder in Utils_cff.py) and document the order used.
+ */
+class PerfMonitor
+{
+private:
+    /// Counters for a single module in a single stream
+    struct ModuleCounters
+    {
+        /// Start time of the current call
+        std::chrono::steady_clock::time_point start;
+
+        /// Number of events processed
+        unsigned long long numEvents = 0;
+
+        /// Total wall time
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::duration::zero();
+    };
+
+    /// Description of and counters for a module on a path
+    struct PathModule
+    {
+        std::string label;
+
+        /// Labels of modules on the same path on which this module depends
+        std::vector<std::string> dependencies;
+
+        /// Number of events rejected by the module
+        unsigned long long numRejected = 0;
+    };
+
+    /// Sizes of a branch
+    struct BranchSizes
+    {
+        std::string treeName, branchName;
+        Long64_t totBytes, zipBytes;
+    };
+
+public:
+    /// Constructor
+    PerfMonitor(edm::ParameterSet const &, edm::ActivityRegistry &registry);
+
+public:
+    /// Verifies configuration of the service
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+private:
+    /// Records the number of streams
+    void Preallocate(edm::service::SystemBounds const &bounds);
+
+    /// Records label and type of a module
+    void PreModuleConstruction(edm::ModuleDescription const &description);
+
+    /// Records modules on all paths and dependencies between them
+    void PreBeginJob(edm::PathsAndConsumesOfModulesBase const &pathsAndConsumes,
+      edm::ProcessContext const &);
+
+    /// Allocates counters for all streams and modules and checks that TFileService is available
+    void PostBeginJob();
+
+    /// Records the start time of a call to a module
+    void PreModuleEvent(edm::StreamContext const &streamContext,
+      edm::ModuleCallingContext const &moduleContext);
+
+    /// Updates counters of a module
+    void PostModuleEvent(edm::StreamContext const &streamContext,
+      edm::ModuleCallingContext const &moduleContext);
+
+    /// Updates counters of a path
+    void PostPathEvent(edm::StreamContext const &, edm::PathContext const &pathContext,
+      edm::HLTPathStatus const &status);
+
+    /// Writes all counters into the output file
+    void PostEndJob();
+
+    /// Flushes all trees in the given directory and its subdirectories and records their sizes
+    static void CollectBranchSizes(TDirectory *directory, std::string const &path,
+      std::vector<BranchSizes> &sizes);
+
+private:
+    /// An object to handle the output ROOT file
+    edm::Service<TFileService> fileService;
+
+    /// Number of streams in the job
+    unsigned numStreams;
+
+    /// Labels and types of modules, indexed with their IDs
+    std::vector<std::pair<std::string, std::string>> moduleNames;
+
+    /// Counters for all modules in all streams; indexed as [stream][module ID]
+    std::vector<std::vector<ModuleCounters>> moduleCounters;
+
+    /**
+     * \brief Numbers of processed and accepted events for each path
+     *
+     * Updated for all streams at once under a lock since paths finish rarely compared to calls
+     * to modules.
+     */
+    std::map<std::string, std::pair<unsigned long long, unsigned long long>> pathCounters;
+
+    /// Modules on each path, indexed with names of the paths; protected by pathMutex
+    std::map<std::string, std::vector<PathModule>> pathModules;
+
+    /// Mutex to protect pathCounters and pathModules
+    std::mutex pathMutex;
+};
@@ -0,0 +1,45 @@
+#include "PhiloxRandom.h"
+
+#include <cmath>
+
+
+PhiloxRandom::PhiloxRandom(std::uint64_t key_):
+    key{{std::uint32_t(key_), std::uint32_t(key_ >> 32)}}
+{}
+
+
+PhiloxRandom::Counter PhiloxRandom::Generate(Counter counter) const
+{
+    // Multipliers and Weyl increments of the key, as in the reference implementation
+    std::uint32_t const m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+    std::uint32_t const w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+
+    std::uint32_t k0 = key[0], k1 = key[1];
+
+    for (unsigned round = 0; round < 10; ++round)
+    {
+        std::uint64_t const p0 = std::uint64_t(m0) * counter[0];
+        std::uint64_t const p1 = std::uint64_t(m1) * counter[2];
+
+        counter = {{std::uint32_t(p1 >> 32) ^ counter[1] ^ k0, std::uint32_t(p1),
+          std::uint32_t(p0 >> 32) ^ counter[3] ^ k1, std::uint32_t(p0)}};
+
+        k0 += w0;
+        k1 += w1;
+    }
+
+    return counter;
+}
+
+
+double PhiloxRandom::Gauss(Counter const &counter) const
+{
+    Counter const words = Generate(counter);
+
+    // Uniform numbers in the open interval (0, 1), each built from 32 random bits
+    double const scale = 1. / 4294967296.;
+    double const u1 = (words[0] + 0.5) * scale;
+    double const u2 = (words[1] + 0.5) * scale;
+
+    return std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+
+/**
+ * \class PhiloxRandom
+ * \brief Counter-based random-number generator Philox4x32-10
+ *
+ * The generator maps a 128-bit counter and a 64-bit key to four pseudorandom 32-bit words [1].
+ * There is no internal state: the same counter and key always produce the same numbers, and
+ * different counters give statistically independent numbers. This allows to derive random numbers
+ * from identifiers of the object for which they are needed, e.g. the event ID and the index of a
+ * jet, so that they do not depend on the order in which objects are processed.
+ *
+ * [1] J. K. Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11,
+ * doi:10.1145/2063384.2063405
+ */
+class PhiloxRandom
+{
+public:
+    using Counter = std::array<std::uint32_t, 4>;
+
+public:
+    /// Constructor from a key, which plays the role of the seed
+    PhiloxRandom(std::uint64_t key);
+
+public:
+    /// Returns four random words for the given counter
+    Counter Generate(Counter counter) const;
+
+    /**
+     * \brief Returns a random number distributed according to the standard normal distribution
+     *
+     * The number is computed from the given counter with the Box-Muller transform.
+     */
+    double Gauss(Counter const &counter) const;
+
+private:
+    std::array<std::uint32_t, 2> key;
+};
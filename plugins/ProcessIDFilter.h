@@ -1,12 +1,11 @@
 #pragma once
 
-#include <FWCore/Framework/interface/EDFilter.h>
+#include <FWCore/Framework/interface/global/EDFilter.h>
 #include <FWCore/Framework/interface/Event.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 
-#include <SimDataFormats/GeneratorProducts/interface/GenEventInfoProduct.h>
-#include <SimDataFormats/GeneratorProducts/interface/LHEEventProduct.h>
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
 
 #include <vector>
 
@@ -15,11 +14,11 @@
  * \class ProcessIDFilter
  * \brief Performs filtering based on process ID
  * 
- * Process ID is read from either LHE or HepMC record, depending on which of the two supported
- * input tag parameters is provided. The other input tag must not be set. Accepted are events whose
- * process IDs are found in the provided list.
+ * Process ID is read from pec::GeneratorContext, which is produced by plugin
+ * GeneratorContextProducer. The latter reads it from the LHE record if available and from the
+ * HepMC record otherwise. Accepted are events whose process IDs are found in the provided list.
  */
-class ProcessIDFilter: public edm::EDFilter
+class ProcessIDFilter: public edm::global::EDFilter<>
 {
 public:
     /// Constructor
@@ -30,17 +29,11 @@ public:
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
     /// Checks if the event stems from a process with allowed ID
-    virtual bool filter(edm::Event &event, edm::EventSetup const &) override;
+    virtual bool filter(edm::StreamID, edm::Event &event, edm::EventSetup const &) const override;
     
 private:
-    /// Token to access global generator information
-    edm::EDGetTokenT<GenEventInfoProduct> generatorToken;
-    
-    /// Token to access LHE event record
-    edm::EDGetTokenT<LHEEventProduct> lheEventInfoToken;
-    
-    /// Indicates whether process ID should be read from LHE or HepMC record
-    bool useLHEInfo;
+    /// Token to access generator-level information
+    edm::EDGetTokenT<pec::GeneratorContext> contextToken;
     
     /**
      * \brief Process IDs to be selected by this filter
@@ -0,0 +1,71 @@
+#include "ProvenanceWriter.h"
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+#include <FWCore/ParameterSet/interface/Registry.h>
+#include <FWCore/Utilities/interface/Digest.h>
+
+#include <TTree.h>
+
+#include <algorithm>
+#include <vector>
+
+
+ProvenanceWriter::ProvenanceWriter(edm::ParameterSet const &cfg):
+    configHash(cfg.getParameter<std::string>("configHash")),
+    packageVersion(cfg.getParameter<std::string>("packageVersion"))
+{
+    usesResource("TFileService");
+}
+
+
+void ProvenanceWriter::beginJob()
+{
+    // Input files are read from the configuration of the source, which is stored in the parameter
+    //set of the process under a reserved name
+    edm::ParameterSet const &processCfg =
+      edm::getProcessParameterSetContainingModule(moduleDescription());
+    std::vector<std::string> inputFiles;
+
+    if (processCfg.existsAs<edm::ParameterSet>("@main_input", true))
+        inputFiles = processCfg.getParameterSet("@main_input").
+          getUntrackedParameter<std::vector<std::string>>("fileNames", {});
+
+
+    // The hash of input files should not depend on their order
+    std::vector<std::string> sortedFiles(inputFiles);
+    std::sort(sortedFiles.begin(), sortedFiles.end());
+    cms::Digest digest;
+
+    for (auto const &name: sortedFiles)
+        digest.append(name + "\n");
+
+    std::string inputHash(digest.digest().toString());
+
+
+    TTree *tree = fileService->make<TTree>("Provenance", "Configuration and inputs of the job");
+    tree->Branch("configHash", &configHash);
+    tree->Branch("packageVersion", &packageVersion);
+    tree->Branch("inputFiles", &inputFiles);
+    tree->Branch("inputHash", &inputHash);
+    tree->Fill();
+
+    // The tree must not refer to the local buffers after this method exits
+    tree->ResetBranchAddresses();
+}
+
+
+void ProvenanceWriter::analyze(edm::Event const &, edm::EventSetup const &)
+{}
+
+
+void ProvenanceWriter::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
+{
+    edm::ParameterSetDescription desc;
+    desc.add<std::string>("configHash")->setComment("Hash of the expanded configuration.");
+    desc.add<std::string>("packageVersion", "")->setComment("Version of the package.");
+    descriptions.add("provenanceWriter", desc);
+}
+
+
+DEFINE_FWK_MODULE(ProvenanceWriter);
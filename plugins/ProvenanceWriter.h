@@ -0,0 +1,58 @@
+#pragma once
+
+#include <FWCore/Framework/interface/one/EDAnalyzer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+
+#include <FWCore/ServiceRegistry/interface/Service.h>
+#include <CommonTools/UtilAlgos/interface/TFileService.h>
+
+#include <string>
+
+
+/**
+ * \class ProvenanceWriter
+ * \brief Records which configuration, version of the package, and input files were used
+ *
+ * The plugin writes a tree "Provenance" with a single entry and the following branches:
+ *   "configHash"      hash of the expanded configuration, as given by parameter "configHash",
+ *   "packageVersion"  version of the package, as given by parameter "packageVersion",
+ *   "inputFiles"      names of all input files of the job (std::vector<std::string>),
+ *   "inputHash"       MD5 hash of the sorted list of input files.
+ * The configuration hash must be computed when the configuration is constructed, since the
+ * framework does not provide a hash that is independent from per-job settings such as the name of
+ * the output file; function add_provenance_writer in Utils_cff does this. The list of input files
+ * is read from the configuration of the source when the job starts, so it reflects changes made
+ * by the submission system after the configuration has been constructed.
+ *
+ * When output files are merged, the tree gets one entry per job. Scripts crabSubmit.py and
+ * mergeCrabRes.py use it to find input files that have already been processed with the same
+ * configuration and version, and reuse the corresponding outputs.
+ */
+class ProvenanceWriter: public edm::one::EDAnalyzer<edm::one::SharedResources>
+{
+public:
+    /// Constructor
+    ProvenanceWriter(edm::ParameterSet const &cfg);
+
+public:
+    /// Writes the tree
+    virtual void beginJob() override;
+
+    /// Does nothing
+    virtual void analyze(edm::Event const &, edm::EventSetup const &) override;
+
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+
+private:
+    /// Hash of the expanded configuration
+    std::string configHash;
+
+    /// Version of the package
+    std::string packageVersion;
+
+    /// An object to handle the output ROOT file
+    edm::Service<TFileService> fileService;
+};
@@ -0,0 +1,96 @@
+#include "RecoContextProducer.h"
+
+#include <Analysis/PECTuples/interface/RecoContext.h>
+
+#include <FWCore/Framework/interface/MakerMacros.h>
+#include <FWCore/Utilities/interface/EDMException.h>
+#include <FWCore/Utilities/interface/InputTag.h>
+
+#include <memory>
+#include <string>
+
+
+using namespace edm;
+using namespace std;
+
+
+RecoContextProducer::RecoContextProducer(ParameterSet const &cfg):
+    vertexSelector(cfg.getParameter<string>("vertexSelection"))
+{
+    primaryVerticesToken =
+      consumes<reco::VertexCollection>(cfg.getParameter<InputTag>("primaryVertices"));
+    rhoToken = consumes<double>(cfg.getParameter<InputTag>("rho"));
+    rhoCentralToken = consumes<double>(cfg.getParameter<InputTag>("rhoCentral"));
+    
+    produces<pec::RecoContext>();
+}
+
+
+void RecoContextProducer::fillDescriptions(ConfigurationDescriptions &descriptions)
+{
+    ParameterSetDescription desc;
+    desc.add<InputTag>("primaryVertices", InputTag("offlineSlimmedPrimaryVertices"))->
+      setComment("Collection of reconstructed primary vertices.");
+    desc.add<string>("vertexSelection",
+      "!isFake & ndof >= 4. & abs(z) < 24. & position.Rho < 2.")->
+      setComment("Selection for good primary vertices.");
+    desc.add<InputTag>("rho", InputTag("fixedGridRhoFastjetAll"))->
+      setComment("Rho (mean angular pt density).");
+    desc.add<InputTag>("rhoCentral", InputTag("fixedGridRhoFastjetCentral"))->
+      setComment("Rho in the central region.");
+    
+    descriptions.add("recoContext", desc);
+}
+
+
+void RecoContextProducer::produce(Event &event, EventSetup const &)
+{
+    unique_ptr<pec::RecoContext> context(new pec::RecoContext);
+    
+    
+    // Primary vertices
+    Handle<reco::VertexCollection> vertices;
+    event.getByToken(primaryVerticesToken, vertices);
+    
+    if (vertices->size() == 0)
+    {
+        Exception excp(errors::LogicError);
+        excp << "Event must contain at least one primary vertex.\n";
+        excp.raise();
+    }
+    
+    unsigned numGoodPV = 0;
+    bool firstPVGood = false;
+    
+    for (unsigned i = 0; i < vertices->size(); ++i)
+    {
+        bool const isGood = vertexSelector((*vertices)[i]);
+        
+        if (isGood)
+            ++numGoodPV;
+        
+        if (i == 0)
+            firstPVGood = isGood;
+    }
+    
+    context->SetNumPV(vertices->size(), numGoodPV);
+    
+    auto const &position = vertices->front().position();
+    context->SetFirstPV(position.x(), position.y(), position.z(), firstPVGood);
+    
+    
+    // Rho
+    Handle<double> rho, rhoCentral;
+    
+    event.getByToken(rhoToken, rho);
+    context->SetRho(*rho);
+    
+    event.getByToken(rhoCentralToken, rhoCentral);
+    context->SetRhoCentral(*rhoCentral);
+    
+    
+    event.put(move(context));
+}
+
+
+DEFINE_FWK_MODULE(RecoContextProducer);
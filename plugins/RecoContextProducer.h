@@ -0,0 +1,55 @@
+#pragma once
+
+#include <FWCore/Framework/interface/stream/EDProducer.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <DataFormats/VertexReco/interface/VertexFwd.h>
+#include <DataFormats/VertexReco/interface/Vertex.h>
+#include <CommonTools/Utils/interface/StringCutObjectSelector.h>
+
+
+/**
+ * \class RecoContextProducer
+ * \brief Puts event-level reconstructed quantities shared by several plugins into the event
+ * 
+ * Reads the collection of primary vertices and two versions of rho and puts into the event an
+ * object of type pec::RecoContext. A string-based selection is evaluated for every vertex. The
+ * context contains the numbers of all and of selected vertices, the position of the first vertex,
+ * and the result of the selection applied to it. An exception is thrown if the collection of
+ * vertices is empty.
+ * 
+ * Plugins FirstVertexFilter, PECElectrons, PECMuons, PECPileUp, and JERCJetSelector read this
+ * product instead of accessing the vertices and rho directly, so that the lookups and the
+ * selection of vertices are done only once per event.
+ */
+class RecoContextProducer: public edm::stream::EDProducer<>
+{
+public:
+    /// Constructor
+    RecoContextProducer(edm::ParameterSet const &cfg);
+    
+public:
+    /// Verifies configuration of the plugin
+    static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
+    
+    /// Puts reconstructed event-level information into the event
+    virtual void produce(edm::Event &event, edm::EventSetup const &) override;
+    
+private:
+    /// Collection of reconstructed primary vertices
+    edm::EDGetTokenT<reco::VertexCollection> primaryVerticesToken;
+    
+    /// Rho (mean angular pt density)
+    edm::EDGetTokenT<double> rhoToken, rhoCentralToken;
+    
+    /**
+     * \brief Selection for good primary vertices
+     * 
+     * String-based selectors are described in [1].
+     * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuidePhysicsCutParser
+     */
+    StringCutObjectSelector<reco::Vertex> const vertexSelector;
+};
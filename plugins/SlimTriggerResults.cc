@@ -1,21 +1,18 @@
 #include "SlimTriggerResults.h"
+#include "TriggerBasename.h"
 
 #include <FWCore/Utilities/interface/EDMException.h>
 #include <FWCore/Common/interface/TriggerResultsByName.h>
 #include <DataFormats/Common/interface/HLTPathStatus.h>
 #include <FWCore/Framework/interface/MakerMacros.h>
 
-#include <boost/algorithm/string/predicate.hpp>
-
-#include <vector>
+#include <algorithm>
 
 
 using namespace std;
 
 
 TriggerState::TriggerState():
-    inMenu(false),
-    index(0),
     wasRun(false),
     accept(false),
     prescale(0)
@@ -24,10 +21,22 @@ TriggerState::TriggerState():
 
 SlimTriggerResults::SlimTriggerResults(edm::ParameterSet const &cfg):
     filterOn(cfg.getParameter<bool>("filter")),
-    savePrescales(cfg.getParameter<bool>("savePrescales"))
+    savePrescales(cfg.getParameter<bool>("savePrescales")),
+    packBits(cfg.getParameter<bool>("packBits")),
+    saveCounters(cfg.getParameter<bool>("saveCounters")),
+    countersPerLumi(cfg.getParameter<bool>("countersPerLumi")),
+    prescalesPerLumi(cfg.getParameter<bool>("prescalesPerLumi")),
+    saveEventID(cfg.getParameter<bool>("saveEventID")),
+    treeSettings(cfg.getParameter<edm::ParameterSet>("treeSettings")),
+    clusterStart(0),
+    prescalesTree(nullptr)
 {
-    // Push trigger names provided by the user into a map
+    usesResource("TFileService");
+    
+    
+    // Push trigger names provided by the user into a vector
     auto const &triggerNames = cfg.getParameter<vector<string>>("triggers");
+    vector<string> basenames;
     
     for (auto const &name: triggerNames)
     {
@@ -43,8 +52,40 @@ SlimTriggerResults::SlimTriggerResults(edm::ParameterSet const &cfg):
         }
         
         
-        // Finally, insert the basename in the map
-        triggers[basename];
+        basenames.emplace_back(basename);
+    }
+    
+    
+    // Sort the basenames, remove duplicates, and create state structures for them
+    sort(basenames.begin(), basenames.end());
+    basenames.erase(unique(basenames.begin(), basenames.end()), basenames.end());
+    triggers.reserve(basenames.size());
+    
+    for (auto const &basename: basenames)
+        triggers.emplace_back(basename, TriggerState());
+    
+    menuCache.reset(new TriggerMenuCache(basenames, GetTriggerBasename));
+    
+    
+    if (packBits)
+    {
+        unsigned const nWords = max<unsigned>((triggers.size() + 63) / 64, 1);
+        wasRunBits.resize(nWords);
+        acceptBits.resize(nWords);
+        
+        if (savePrescales)
+            prescales.resize(triggers.size());
+    }
+    
+    if (saveCounters)
+        counters.resize(triggers.size());
+    
+    if (prescalesPerLumi and not savePrescales)
+    {
+        edm::Exception excp(edm::errors::Configuration);
+        excp << "Prescales are requested to be stored per luminosity block, but they are not "
+          "saved.";
+        excp.raise();
     }
     
     
@@ -64,15 +105,56 @@ void SlimTriggerResults::beginJob()
     // Create the output tree
     triggerTree = fileService->make<TTree>("TriggerInfo", "States of selected triggers");
     
+    if (saveEventID)
+    {
+        triggerTree->Branch("run", &eventRun);
+        triggerTree->Branch("lumi", &eventLumi);
+        triggerTree->Branch("event", &eventNumber);
+    }
+    
+    if (saveCounters)
+    {
+        // The tree is small, so the default I/O settings are used
+        countersTree = fileService->make<TTree>("TriggerCounters", "Counters of trigger decisions");
+        countersTree->Branch("run", &counterRun);
+        countersTree->Branch("lumi", &counterLumi);
+        countersTree->Branch("trigger", &counterTrigger);
+        countersTree->Branch("prescale", &counterBuffer.prescale);
+        countersTree->Branch("events", &counterBuffer.events);
+        countersTree->Branch("wasRun", &counterBuffer.wasRun);
+        countersTree->Branch("accept", &counterBuffer.accept);
+    }
+    
+    if (prescalesPerLumi)
+    {
+        // The tree is small, so the default I/O settings are used. Prescale branches are added
+        //below, in the same way as they would be added to the main tree.
+        prescalesTree = fileService->make<TTree>("Prescales", "Prescales of selected triggers");
+        prescalesTree->Branch("run", &prescaleRun);
+        prescalesTree->Branch("lumi", &prescaleLumi);
+        prescalesTree->Branch("event", &prescaleEvent);
+    }
+    
+    if (packBits)
+    {
+        BookPacked();
+        treeSettings.Apply(triggerTree);
+        return;
+    }
+    
     // Assign branches to it
+    TTree *prescalesTarget = (prescalesPerLumi) ? prescalesTree : triggerTree;
+    
     for (auto &t: triggers)
     {
         triggerTree->Branch((t.first + "__wasRun").c_str(), &t.second.wasRun);
         triggerTree->Branch((t.first + "__accept").c_str(), &t.second.accept);
         
         if (savePrescales)
-            triggerTree->Branch((t.first + "__prescale").c_str(), &t.second.prescale);
+            prescalesTarget->Branch((t.first + "__prescale").c_str(), &t.second.prescale);
     }
+    
+    treeSettings.Apply(triggerTree);
 }
 
 
@@ -83,22 +165,28 @@ bool SlimTriggerResults::filter(edm::Event &event, edm::EventSetup const &setup)
     event.getByToken(triggerBitsToken, triggerBits);
     
     
-    // Check if the trigger configuration has changed and update trigger indices if needed
-    if (triggerBits->parameterSetID() != prevTriggerParameterSetID)
-    {
-        UpdateMenu(event.triggerNames(*triggerBits));
-        prevTriggerParameterSetID = triggerBits->parameterSetID();
-    }
+    // Find indices of selected triggers in the current menu. They are only resolved when a menu
+    //is encountered for the first time
+    auto const &indices = menuCache->GetIndices(event, *triggerBits);
     
     
-    // Read prescales if needed
-    edm::Handle<pat::PackedTriggerPrescales> hltPrescales;
-    edm::Handle<pat::PackedTriggerPrescales> l1tPrescales;
+    // Prescales only change at boundaries of luminosity blocks, so they are computed for the first
+    //event of each block only
+    bool const newPrescales = (savePrescales and lumiPrescales.empty());
     
-    if (savePrescales)
+    if (newPrescales)
     {
+        edm::Handle<pat::PackedTriggerPrescales> hltPrescales;
+        edm::Handle<pat::PackedTriggerPrescales> l1tPrescales;
         event.getByToken(hltPrescalesToken, hltPrescales);
         event.getByToken(l1tPrescalesToken, l1tPrescales);
+        
+        lumiPrescales.resize(triggers.size());
+        
+        for (unsigned i = 0; i < triggers.size(); ++i)
+            lumiPrescales[i] = (indices[i] < 0) ? 0 :
+              hltPrescales->getPrescaleForIndex(indices[i]) *
+              l1tPrescales->getPrescaleForIndex(indices[i]);
     }
     
     
@@ -107,21 +195,56 @@ bool SlimTriggerResults::filter(edm::Event &event, edm::EventSetup const &setup)
     
     
     
+    // Reset packed decisions since only bits for triggers in the menu are set below
+    if (packBits)
+    {
+        fill(wasRunBits.begin(), wasRunBits.end(), 0);
+        fill(acceptBits.begin(), acceptBits.end(), 0);
+        fill(prescales.begin(), prescales.end(), 0);
+    }
+    
+    
     // Fill buffers for all selected triggers
-    for (auto &t: triggers)
+    for (unsigned i = 0; i < triggers.size(); ++i)
     {
-        // Continue to the next trigger if the current one is not in the current menu
-        if (not t.second.inMenu)
+        auto &t = triggers[i];
+        int const index = indices[i];
+        
+        // Reset the state and continue to the next trigger if the current one is not in the
+        //current menu
+        if (index < 0)
+        {
+            t.second.wasRun = false;
+            t.second.accept = false;
+            t.second.prescale = 0;
             continue;
+        }
         
         
         // Update state of the current trigger
-        t.second.wasRun = triggerBits->wasrun(t.second.index);
-        t.second.accept = triggerBits->accept(t.second.index);
+        t.second.wasRun = triggerBits->wasrun(index);
+        t.second.accept = triggerBits->accept(index);
         
         if (savePrescales)
-            t.second.prescale = hltPrescales->getPrescaleForIndex(t.second.index) *
-              l1tPrescales->getPrescaleForIndex(t.second.index);
+            t.second.prescale = lumiPrescales[i];
+        
+        if (saveCounters)
+            UpdateCounters(i, t.second);
+        
+        
+        if (packBits)
+        {
+            ULong64_t const mask = ULong64_t(1) << (i % 64);
+            
+            if (t.second.wasRun)
+                wasRunBits[i / 64] |= mask;
+            
+            if (t.second.accept)
+                acceptBits[i / 64] |= mask;
+            
+            if (savePrescales)
+                prescales[i] = t.second.prescale;
+        }
         
         
         if (t.second.wasRun and t.second.accept)
@@ -129,15 +252,64 @@ bool SlimTriggerResults::filter(edm::Event &event, edm::EventSetup const &setup)
     }
     
     
+    // Write prescales once per luminosity block, regardless of the filter decision
+    if (prescalesPerLumi and newPrescales)
+    {
+        edm::EventID const &id = event.id();
+        prescaleRun = id.run();
+        prescaleLumi = id.luminosityBlock();
+        prescaleEvent = id.event();
+        prescalesTree->Fill();
+    }
+    
+    
     // Fill the output tree if the event is accepted
     if (result or not filterOn)
+    {
+        if (saveEventID)
+        {
+            edm::EventID const &id = event.id();
+            eventRun = id.run();
+            eventLumi = id.luminosityBlock();
+            eventNumber = id.event();
+        }
+        
         triggerTree->Fill();
+    }
     
     
     return (filterOn) ? result : true;
 }
 
 
+void SlimTriggerResults::beginRun(edm::Run const &, edm::EventSetup const &)
+{}
+
+
+void SlimTriggerResults::endRun(edm::Run const &run, edm::EventSetup const &)
+{
+    if (saveCounters and not countersPerLumi)
+        WriteCounters(run.run(), 0);
+}
+
+
+void SlimTriggerResults::beginLuminosityBlock(edm::LuminosityBlock const &,
+  edm::EventSetup const &)
+{
+    lumiPrescales.clear();
+}
+
+
+void SlimTriggerResults::endLuminosityBlock(edm::LuminosityBlock const &lumi,
+  edm::EventSetup const &)
+{
+    if (saveCounters and countersPerLumi)
+        WriteCounters(lumi.run(), lumi.luminosityBlock());
+    
+    treeSettings.EndLuminosityBlock(triggerTree, clusterStart);
+}
+
+
 void SlimTriggerResults::fillDescriptions(edm::ConfigurationDescriptions &descriptions)
 {
     // Documentation for descriptions of the configuration is available in [1]
@@ -151,74 +323,93 @@ void SlimTriggerResults::fillDescriptions(edm::ConfigurationDescriptions &descri
       "rejected.");
     desc.add<bool>("savePrescales", true)->
       setComment("Specifies whether trigger prescales should be saved.");
+    desc.add<bool>("packBits", false)->
+      setComment("Specifies whether decisions for all triggers should be packed into bit fields.");
+    desc.add<bool>("saveCounters", false)->
+      setComment("Specifies whether counters of trigger decisions should be saved.");
+    desc.add<bool>("countersPerLumi", false)->
+      setComment("Specifies whether counters are saved per luminosity block instead of per run.");
+    desc.add<bool>("prescalesPerLumi", false)->
+      setComment("Specifies whether prescales are saved in a separate tree once per luminosity "
+      "block instead of in every event.");
+    desc.add<bool>("saveEventID", false)->
+      setComment("Specifies whether event IDs should be stored in the tree with decisions.");
     desc.add<edm::InputTag>("triggerBits", edm::InputTag("TriggerResults"))->
       setComment("Trigger decisions.");
     desc.add<edm::InputTag>("hltPrescales", edm::InputTag("patTrigger"))->
       setComment("Packed HLT prescales.");
     desc.add<edm::InputTag>("l1tPrescales", edm::InputTag("patTrigger", "l1min"))->
       setComment("Packed L1T trigger prescales.");
+    desc.add<edm::ParameterSetDescription>("treeSettings", TreeSettings::GetDescription())->
+      setComment("I/O settings for the output tree.");
     
     descriptions.add("triggerInfo", desc);
 }
 
 
-string SlimTriggerResults::GetTriggerBasename(string const &name)
+void SlimTriggerResults::BookPacked()
 {
-    // The name might (or might not) contain a prefix "HLT_" and/or a postfix with version
-    //number of the form "_v\d+", "_v*", or "_v". They are stripped off if found
-    string basename(name);
-    
-    // First, the prefix
-    if (boost::starts_with(basename, "HLT_"))
-        basename = basename.substr(4);
-    
-    // Now check the postfix
-    if (boost::ends_with(basename, "_v*"))
-        basename = basename.substr(0, basename.length() - 3);
-    else if (boost::ends_with(basename, "_v"))
-        basename = basename.substr(0, basename.length() - 2);
-    else
-    {
-        // Maybe, the full version was specified
-        int pos = basename.length() - 1;
-        
-        while (pos >= 0 and basename[pos] >= '0' and basename[pos] <= '9')
-            --pos;
-        
-        if (pos >= 2 and basename[pos] == 'v' and basename[pos - 1] == '_')
-            basename = basename.substr(0, pos - 1);
-    }
+    string const nWords(to_string(wasRunBits.size()));
+    triggerTree->Branch("wasRun", wasRunBits.data(), ("wasRun[" + nWords + "]/l").c_str());
+    triggerTree->Branch("accept", acceptBits.data(), ("accept[" + nWords + "]/l").c_str());
+    
+    if (savePrescales)
+        ((prescalesPerLumi) ? prescalesTree : triggerTree)->Branch("prescales", prescales.data(),
+          ("prescales[" + to_string(prescales.size()) + "]/i").c_str());
     
     
-    return basename;
+    // Store names of the triggers in the order of their bits
+    TTree *namesTree = fileService->make<TTree>("TriggerNames", "Names of triggers");
+    vector<string> names;
+    
+    for (auto const &t: triggers)
+        names.emplace_back(t.first);
+    
+    namesTree->Branch("names", &names);
+    namesTree->Fill();
+    namesTree->ResetBranchAddresses();
 }
 
 
-void SlimTriggerResults::UpdateMenu(edm::TriggerNames const &triggerNames)
+void SlimTriggerResults::UpdateCounters(unsigned index, TriggerState const &state)
 {
-    // Reset all trigger buffers
-    for (auto &t: triggers)
+    // The prescale rarely changes, so the search over the counters is short
+    auto &triggerCounters = counters[index];
+    auto res = find_if(triggerCounters.rbegin(), triggerCounters.rend(),
+      [&state](TriggerCounter const &c){return c.prescale == state.prescale;});
+    
+    if (res == triggerCounters.rend())
     {
-        t.second.inMenu = false;
-        t.second.index = 0;
-        t.second.wasRun = false;
-        t.second.accept = false;
-        t.second.prescale = 0;
+        triggerCounters.push_back({state.prescale, 0, 0, 0});
+        res = triggerCounters.rbegin();
     }
     
+    ++res->events;
+    
+    if (state.wasRun)
+        ++res->wasRun;
     
-    // Loop over names of all triggers in the menu
-    for (unsigned i = 0; i < triggerNames.size(); ++i)
+    if (state.accept)
+        ++res->accept;
+}
+
+
+void SlimTriggerResults::WriteCounters(UInt_t run, UInt_t lumi)
+{
+    counterRun = run;
+    counterLumi = lumi;
+    
+    for (unsigned i = 0; i < triggers.size(); ++i)
     {
-        // Update the full trigger name in the associated TriggerState object if the
-        //current trigger's name is among the names of selected triggers
-        auto res = triggers.find(GetTriggerBasename(triggerNames.triggerName(i)));
+        counterTrigger = triggers[i].first;
         
-        if (res != triggers.end())
+        for (auto const &c: counters[i])
         {
-            res->second.inMenu = true;
-            res->second.index = i;
+            counterBuffer = c;
+            countersTree->Fill();
         }
+        
+        counters[i].clear();
     }
 }
 
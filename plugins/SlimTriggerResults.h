@@ -1,11 +1,16 @@
 #pragma once
 
+#include "TreeSettings.h"
+#include "TriggerMenuCache.h"
+
 #include <DataFormats/Common/interface/TriggerResults.h>
 #include <FWCore/Common/interface/TriggerNames.h>
 #include <DataFormats/PatCandidates/interface/PackedTriggerPrescales.h>
 
-#include <FWCore/Framework/interface/EDFilter.h>
+#include <FWCore/Framework/interface/one/EDFilter.h>
 #include <FWCore/Framework/interface/Event.h>
+#include <FWCore/Framework/interface/LuminosityBlock.h>
+#include <FWCore/Framework/interface/Run.h>
 #include <FWCore/ParameterSet/interface/ParameterSet.h>
 #include <FWCore/ParameterSet/interface/ConfigurationDescriptions.h>
 #include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
@@ -15,33 +20,24 @@
 
 #include <TTree.h>
 
+#include <memory>
 #include <string>
-#include <map>
+#include <utility>
+#include <vector>
 
 
 /**
  * \struct TriggerState
  * \brief An auxiliary structure to represent a state of a trigger path in the current event
  * 
- * It contains a fully-qualified name of the trigger in the current menu, which can change over time
- * (due to the change in version number). The structure also host several buffers, which are used to
- * fill the output tree in the SlimTriggerResults class.
+ * The structure hosts several buffers, which are used to fill the output tree in the
+ * SlimTriggerResults class.
  */
 struct TriggerState
 {
     /// Default constructor
     TriggerState();
     
-    /**
-     * \brief Indicates if the trigger is present in the current menu
-     * 
-     * It might happen that some of triggers requested by user are missing in some of menus.
-     */
-    bool inMenu;
-    
-    /// Index of the trigger in the (current) menu
-    unsigned index;
-    
     /**
      * \brief A buffer to indicate whether the trigger was run in the current event
      * 
@@ -79,6 +75,13 @@ struct TriggerState
  * trigger: a boolean indicating if the trigger was executed in the current event, a boolean showing
  * if the current event was accepted by the trigger, and an integer with the trigger prescale.
  * 
+ * Alternatively, if parameter packBits is set to true, decisions for all triggers are packed into
+ * two fixed-size arrays of 64-bit words, "wasRun" and "accept", and prescales are stored in a
+ * single array "prescales". The trigger with index i corresponds to bit (i % 64) in the word with
+ * index (i / 64) and to element i of the array of prescales. Triggers are ordered alphabetically
+ * by their basenames, which are saved in branch "names" of an additional tree "TriggerNames"
+ * with a single entry. This layout makes the tree much smaller and faster to read.
+ * 
  * The prescale is computed as the product of the given L1T and HLT prescale factors. Since a single
  * HLT path can be seeded by multiple L1T bits, minimal and maximal prescales of the exploited
  * seeds are stored in MiniAOD [1]. User is normally expected to provide the tag of the collection
@@ -87,10 +90,45 @@ struct TriggerState
  * The plugin can be configured in such a way that it rejects an event if it is not accepted by any
  * of the selected triggers. The default behaviour is to reject no events.
  * 
+ * Entries of the tree follow the order in which events reach the plugin. If parameter saveEventID
+ * is true, branches "run", "lumi", and "event" are added to the tree, so that it can be matched by
+ * event ID to trees whose entries are written in a different order, e.g. by PECWriter with a
+ * reorder buffer.
+ * 
+ * If parameter saveCounters is true, the plugin also counts, for each run and trigger, events in
+ * which the trigger is present in the menu and in which it was run and accepted. All events seen
+ * by the plugin are counted, regardless of the filter decision. Counts are split by the prescale
+ * (set to 0 if prescales are not read). They are written into tree "TriggerCounters" at the end
+ * of each run, or of each luminosity block if parameter countersPerLumi is true, with one entry
+ * per combination of trigger and prescale. The tree contains branches "run", "lumi" (0 if
+ * counters are per run), "trigger" (basename), "prescale", "events", "wasRun", and "accept".
+ * Counters from different jobs can be combined exactly by summing entries with the same keys.
+ * 
+ * Prescale columns can only be switched at boundaries of luminosity blocks. For this reason
+ * prescales are computed for the first event of each luminosity block seen by the plugin and
+ * reused for the remaining events of the block. If parameter prescalesPerLumi is true, they are
+ * not stored in tree "TriggerInfo" but in a separate tree "Prescales", which has the same layout of
+ * prescale branches as would be used in "TriggerInfo" and additional branches "run", "lumi", and
+ * "event". Exactly one entry is written for every luminosity block (regardless of the filter
+ * decisions); branch "event" contains the number of the event for which prescales have been
+ * computed and is informational only. Prescales for a given event are found by its run and
+ * luminosity block numbers alone, which does not depend on the order in which luminosity blocks,
+ * files, or events are processed. If a luminosity block has been split between several jobs,
+ * merged files contain several identical entries for it, and any of them can be used.
+ * 
  * [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/WorkBookMiniAOD2015?rev=96#Trigger
  */
-class SlimTriggerResults: public edm::EDFilter
+class SlimTriggerResults: public edm::one::EDFilter<edm::one::SharedResources,
+  edm::one::WatchRuns, edm::one::WatchLuminosityBlocks>
 {
+private:
+    /// Event counts for a trigger with a given prescale
+    struct TriggerCounter
+    {
+        UInt_t prescale;
+        ULong64_t events, wasRun, accept;
+    };
+    
 public:
     /// Constructor from a configuration
     SlimTriggerResults(edm::ParameterSet const &cfg);
@@ -102,31 +140,43 @@ public:
     /// Fills the output tree for each event
     virtual bool filter(edm::Event &event, edm::EventSetup const &setup) override;
     
+    /// Does nothing
+    virtual void beginRun(edm::Run const &, edm::EventSetup const &) override;
+    
+    /// Writes trigger counters accumulated in the run if they are stored per run
+    virtual void endRun(edm::Run const &run, edm::EventSetup const &) override;
+    
+    /// Resets the stored prescales so that they are computed for the first event of the block
+    virtual void beginLuminosityBlock(edm::LuminosityBlock const &, edm::EventSetup const &)
+      override;
+    
+    /// Writes trigger counters if they are stored per lumi and closes the cluster if requested
+    virtual void endLuminosityBlock(edm::LuminosityBlock const &lumi, edm::EventSetup const &)
+      override;
+    
 public:
     /// A method to verify plugin's configuration
     static void fillDescriptions(edm::ConfigurationDescriptions &descriptions);
     
 private:
-    /// Strips the "HLT_" prefix and version postfix from a trigger name
-    static std::string GetTriggerBasename(std::string const &name);
+    /// Creates branches for the packed layout of the output tree and stores trigger names
+    void BookPacked();
     
-    /**
-     * \brief Updates indices of selected triggers in the menu
-     * 
-     * Should be called when the trigger menu changes as it might invalidate trigger indices. It is
-     * the only method that reads trigger names.
-     */
-    void UpdateMenu(edm::TriggerNames const &triggerNames);
+    /// Updates counters for the trigger with the given index in the current event
+    void UpdateCounters(unsigned index, TriggerState const &state);
+    
+    /// Writes accumulated counters into the tree and resets them
+    void WriteCounters(UInt_t run, UInt_t lumi);
     
 private:
     /**
-     * \brief Map from trigger basenames to associated state structures
+     * \brief Trigger basenames and associated state structures
      * 
-     * The "HLT_" prefix and the "_v*" postfix are stripped off of the trigger names. The map must
-     * not be modified after the beginJob method has run since it provides the output tree pointers
-     * to the map's elements
+     * The "HLT_" prefix and the "_v*" postfix are stripped off of the trigger names. The vector is
+     * sorted by the basenames and contains no duplicates. It must not be modified after the
+     * beginJob method has run since it provides the output tree pointers to its elements
      */
-    std::map<std::string, TriggerState> triggers;
+    std::vector<std::pair<std::string, TriggerState>> triggers;
     
     /// Token to access trigger decisions
     edm::EDGetTokenT<edm::TriggerResults> triggerBitsToken;
@@ -143,6 +193,41 @@ private:
     /// Specifies whether prescale column should be saved
     bool const savePrescales;
     
+    /// Specifies whether decisions are packed into bit fields
+    bool const packBits;
+    
+    /// Specifies whether trigger counters should be saved
+    bool const saveCounters;
+    
+    /// Specifies whether trigger counters are written per luminosity block instead of per run
+    bool const countersPerLumi;
+    
+    /// Specifies whether prescales are written into a separate tree when they change
+    bool const prescalesPerLumi;
+    
+    /// Specifies whether event IDs are stored in the main tree
+    bool const saveEventID;
+    
+    /**
+     * \brief Buffers for packed decisions
+     * 
+     * Used only if packBits is true.
+     */
+    std::vector<ULong64_t> wasRunBits, acceptBits;
+    
+    /**
+     * \brief Buffer for prescales in the packed layout
+     * 
+     * Used only if packBits is true.
+     */
+    std::vector<UInt_t> prescales;
+    
+    /// I/O settings for the output tree
+    TreeSettings const treeSettings;
+    
+    /// Number of entries in the output tree at the previous flush forced at the end of a lumi
+    Long64_t clusterStart;
+    
     /// An object to handle the output ROOT file
     edm::Service<TFileService> fileService;
     
@@ -153,10 +238,54 @@ private:
      */
     TTree *triggerTree;
     
+    /// Buffers for the event ID in the main tree; used only if saveEventID is true
+    UInt_t eventRun, eventLumi;
+    ULong64_t eventNumber;
+    
+    /**
+     * \brief Indices of selected triggers in trigger menus
+     * 
+     * Keys are trigger basenames, in the same order as in the vector triggers. It might happen
+     * that some of triggers requested by user are missing in some of menus.
+     */
+    std::unique_ptr<TriggerMenuCache> menuCache;
+    
+    /**
+     * \brief Counters accumulated since they were written last time
+     * 
+     * The outer vector is indexed in the same way as the vector triggers. The inner one contains
+     * an element for each prescale encountered. Used only if saveCounters is true.
+     */
+    std::vector<std::vector<TriggerCounter>> counters;
+    
+    /**
+     * \brief Output tree with trigger counters
+     * 
+     * Created only if saveCounters is true. Managed by the fileService object.
+     */
+    TTree *countersTree;
+    
+    /// Buffers to fill the tree with counters
+    UInt_t counterRun, counterLumi;
+    std::string counterTrigger;
+    TriggerCounter counterBuffer;
+    
+    /**
+     * \brief Output tree with prescales written when they change
+     * 
+     * Created only if prescalesPerLumi is true. Managed by the fileService object.
+     */
+    TTree *prescalesTree;
+    
+    /// Buffers for the event ID in prescalesTree
+    UInt_t prescaleRun, prescaleLumi;
+    ULong64_t prescaleEvent;
+    
     /**
-     * \brief ID of the previous trigger configuration
+     * \brief Prescales in the current luminosity block
      * 
-     * It is used to discover updates in the trigger menu.
+     * Indexed in the same way as the vector triggers. Empty before the first event of each
+     * luminosity block.
      */
-    edm::ParameterSetID prevTriggerParameterSetID;
+    std::vector<UInt_t> lumiPrescales;
 };
@@ -0,0 +1,142 @@
+#include "TreeSettings.h"
+
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <Compression.h>
+#include <RVersion.h>
+#include <TBranch.h>
+
+#include <algorithm>
+
+
+TreeSettings::TreeSettings(edm::ParameterSet const &cfg):
+    compressionSettings(-1),
+    basketSize(cfg.getParameter<int>("basketSize")),
+    autoFlush(cfg.getParameter<long long>("autoFlush")),
+    implicitMT(cfg.getParameter<bool>("implicitMT")),
+    lumiClusters(cfg.getParameter<bool>("lumiClusters")),
+    minClusterEntries(cfg.getParameter<unsigned>("minClusterEntries"))
+{
+    std::string const algorithmLabel(cfg.getParameter<std::string>("compressionAlgorithm"));
+    int const level = cfg.getParameter<int>("compressionLevel");
+
+    if (algorithmLabel != "")
+    {
+        ROOT::ECompressionAlgorithm algorithm;
+
+        if (algorithmLabel == "ZLIB")
+            algorithm = ROOT::kZLIB;
+        else if (algorithmLabel == "LZMA")
+            algorithm = ROOT::kLZMA;
+        else if (algorithmLabel == "LZ4")
+            algorithm = ROOT::kLZ4;
+        else if (algorithmLabel == "ZSTD")
+        {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6, 20, 0)
+            algorithm = ROOT::kZSTD;
+#else
+            cms::Exception excp("Configuration");
+            excp << "Compression algorithm \"ZSTD\" requires ROOT 6.20 or later, while the "
+              "current version is " << ROOT_RELEASE << ".";
+            excp.raise();
+#endif
+        }
+        else
+        {
+            cms::Exception excp("Configuration");
+            excp << "Unsupported compression algorithm \"" << algorithmLabel << "\".";
+            excp.raise();
+        }
+
+        if (level < 0 or level > 9)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Compression level " << level << " is outside of the allowed range [0, 9].";
+            excp.raise();
+        }
+
+        compressionSettings = ROOT::CompressionSettings(algorithm, level);
+    }
+
+    if (lumiClusters)
+    {
+#if ROOT_VERSION_CODE < ROOT_VERSION(6, 14, 0)
+        cms::Exception excp("Configuration");
+        excp << "Closing clusters at boundaries of luminosity blocks requires ROOT 6.14 or later, "
+          "while the current version is " << ROOT_RELEASE << ".";
+        excp.raise();
+#endif
+
+        // With an AutoFlush setting in bytes, each tree would start new clusters after a
+        //different number of entries
+        if (autoFlush <= 0)
+        {
+            cms::Exception excp("Configuration");
+            excp << "Closing clusters at boundaries of luminosity blocks requires that AutoFlush "
+              "is given as a number of entries, but the value " << autoFlush << " is given.";
+            excp.raise();
+        }
+    }
+}
+
+
+edm::ParameterSetDescription TreeSettings::GetDescription()
+{
+    edm::ParameterSetDescription desc;
+    desc.add<std::string>("compressionAlgorithm", "")->setComment(
+      "Compression algorithm: \"ZLIB\", \"LZMA\", \"LZ4\", or \"ZSTD\" (requires ROOT 6.20 or "
+      "later). If empty, the settings of the output file are used.");
+    desc.add<int>("compressionLevel", 4)->setComment("Compression level, from 0 to 9.");
+    desc.add<int>("basketSize", 0)->setComment(
+      "Basket size for all branches, in bytes. Zero means the ROOT default.");
+    desc.add<long long>("autoFlush", 0)->setComment(
+      "Number of entries (if positive) or number of bytes (if negative) in a cluster. Zero means "
+      "the ROOT default.");
+    desc.add<bool>("implicitMT", false)->setComment(
+      "Indicates whether baskets should be compressed in parallel using ROOT implicit "
+      "multithreading. If false, the ROOT default is kept.");
+    desc.add<bool>("lumiClusters", false)->setComment(
+      "Indicates whether clusters should be closed at boundaries of luminosity blocks. Requires "
+      "ROOT 6.14 or later and a positive autoFlush.");
+    desc.add<unsigned>("minClusterEntries", 1000)->setComment(
+      "Minimal number of entries in a cluster closed at the end of a luminosity block.");
+
+    return desc;
+}
+
+
+void TreeSettings::Apply(TTree *tree) const
+{
+    if (compressionSettings >= 0)
+    {
+        // The call is propagated to all sub-branches
+        for (auto *branch: *tree->GetListOfBranches())
+            static_cast<TBranch *>(branch)->SetCompressionSettings(compressionSettings);
+    }
+
+    if (basketSize > 0)
+        tree->SetBasketSize("*", basketSize);
+
+    if (autoFlush != 0)
+        tree->SetAutoFlush(autoFlush);
+
+    if (implicitMT)
+        tree->SetImplicitMT(true);
+}
+
+
+void TreeSettings::EndLuminosityBlock(TTree *tree, Long64_t &clusterStart) const
+{
+    if (not lumiClusters)
+        return;
+
+    Long64_t const numEntries = tree->GetEntries();
+
+    if (numEntries - clusterStart < std::max(minClusterEntries, Long64_t(1)))
+        return;
+
+    // Writes all baskets and, since ROOT 6.14, marks the end of a cluster. Older versions are
+    //refused in the constructor.
+    tree->FlushBaskets();
+    clusterStart = numEntries;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <TTree.h>
+
+#include <string>
+
+
+/**
+ * \class TreeSettings
+ * \brief I/O settings applied to output trees
+ *
+ * Plugins that write trees accept a parameter set "treeSettings", which is intended to be defined
+ * once for the whole job. It specifies the compression algorithm and level, the basket size for
+ * all branches, and the AutoFlush setting (which defines the size of clusters of the tree). A
+ * default value of each parameter means that the corresponding ROOT default is kept.
+ *
+ * Optionally, ROOT implicit multithreading can be enabled for the tree. Then baskets of different
+ * branches are compressed and written in parallel when the tree is flushed, i.e. at the
+ * boundaries of clusters defined by the AutoFlush setting. This requires that implicit
+ * multithreading is enabled globally, which in CMSSW is done by service InitRootHandlers.
+ *
+ * If flag "lumiClusters" is set, clusters are additionally closed at boundaries of luminosity
+ * blocks, so that a reader can skip masked luminosity blocks without decompressing their baskets.
+ * This requires that the plugin calls method EndLuminosityBlock for the tree. To avoid tiny
+ * clusters, the tree is only flushed if at least "minClusterEntries" entries have been filled since
+ * the previous flush forced by this class; otherwise the current cluster is extended into the next
+ * luminosity block. This requires ROOT 6.14 or later, in which TTree::FlushBaskets closes the
+ * current cluster. Also the AutoFlush setting must be given as a number of entries: with a
+ * setting in bytes, each tree would start new clusters after a different number of entries. With
+ * both conditions met, all decisions depend only on the numbers of entries, so trees filled for
+ * the same events get identical clusters. An exception is thrown at construction otherwise.
+ * Luminosity blocks must not be processed concurrently for the boundaries to be exact.
+ *
+ * The settings must be applied with method Apply after all branches of the tree have been created.
+ */
+class TreeSettings
+{
+public:
+    /// Constructor from a configuration
+    TreeSettings(edm::ParameterSet const &cfg);
+
+public:
+    /// Returns description of the parameter set that configures this class
+    static edm::ParameterSetDescription GetDescription();
+
+    /// Applies the settings to all branches of the given tree
+    void Apply(TTree *tree) const;
+
+    /**
+     * \brief Closes the current cluster of the tree at the end of a luminosity block if requested
+     *
+     * The argument clusterStart holds the number of entries in the tree at the previous forced
+     * flush and is updated when the tree is flushed. It must be zero-initialized by the caller.
+     */
+    void EndLuminosityBlock(TTree *tree, Long64_t &clusterStart) const;
+
+private:
+    /**
+     * \brief Compression settings in the format expected by ROOT
+     *
+     * Computed from the algorithm and the level. Set to (-1) if the default settings of the
+     * output file are to be used.
+     */
+    int compressionSettings;
+
+    /// Basket size for all branches, in bytes; zero means the ROOT default
+    int basketSize;
+
+    /**
+     * \brief Argument for TTree::SetAutoFlush
+     *
+     * Positive values give the number of entries in a cluster, negative ones its approximate size
+     * in bytes. Zero means the ROOT default.
+     */
+    long long autoFlush;
+
+    /// Indicates whether implicit multithreading should be enabled for the tree
+    bool implicitMT;
+
+    /// Indicates whether clusters should be closed at boundaries of luminosity blocks
+    bool lumiClusters;
+
+    /// Minimal number of entries in a cluster closed at the end of a luminosity block
+    Long64_t minClusterEntries;
+};
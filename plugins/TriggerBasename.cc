@@ -0,0 +1,34 @@
+#include "TriggerBasename.h"
+
+#include <boost/algorithm/string/predicate.hpp>
+
+
+std::string GetTriggerBasename(std::string const &name)
+{
+    // The name might (or might not) contain a prefix "HLT_" and/or a postfix with version
+    //number of the form "_v\d+", "_v*", or "_v". They are stripped off if found
+    std::string basename(name);
+
+    // First, the prefix
+    if (boost::starts_with(basename, "HLT_"))
+        basename = basename.substr(4);
+
+    // Now check the postfix
+    if (boost::ends_with(basename, "_v*"))
+        basename = basename.substr(0, basename.length() - 3);
+    else if (boost::ends_with(basename, "_v"))
+        basename = basename.substr(0, basename.length() - 2);
+    else
+    {
+        // Maybe, the full version was specified
+        int pos = basename.length() - 1;
+
+        while (pos >= 0 and basename[pos] >= '0' and basename[pos] <= '9')
+            --pos;
+
+        if (pos >= 2 and basename[pos] == 'v' and basename[pos - 1] == '_')
+            basename = basename.substr(0, pos - 1);
+    }
+
+    return basename;
+}
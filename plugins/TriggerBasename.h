@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+
+/**
+ * \brief Strips the "HLT_" prefix and version postfix from a trigger name
+ *
+ * The postfix can have the form "_v\d+", "_v*", or "_v". Both the prefix and the postfix are
+ * optional, and parts that are not found are left intact.
+ */
+std::string GetTriggerBasename(std::string const &name);
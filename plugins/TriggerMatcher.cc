@@ -0,0 +1,101 @@
+#include "TriggerMatcher.h"
+
+#include <DataFormats/Math/interface/deltaR.h>
+#include <FWCore/Utilities/interface/Exception.h>
+
+#include <cmath>
+
+
+TriggerMatcher::TriggerMatcher(edm::ParameterSet const &cfg,
+  edm::ConsumesCollector &&consumesCollector):
+    objectGrid(
+      cfg.getParameter<edm::ParameterSet>("triggerMatching").getParameter<double>("maxDR"))
+{
+    auto const &matchingCfg = cfg.getParameter<edm::ParameterSet>("triggerMatching");
+    auto const &filterNames = matchingCfg.getParameter<std::vector<std::string>>("filters");
+
+    if (filterNames.size() > 32)
+    {
+        cms::Exception excp("Configuration");
+        excp << "Requested " << filterNames.size() << " filters for trigger matching while " <<
+          "at maximum 32 filters are supported.";
+        excp.raise();
+    }
+
+    for (unsigned i = 0; i < filterNames.size(); ++i)
+        filterIndices.emplace(filterNames[i], i);
+
+    double const maxDR = matchingCfg.getParameter<double>("maxDR");
+    maxDR2 = maxDR * maxDR;
+
+    if (IsEnabled())
+        triggerObjectsToken = consumesCollector.consumes<edm::View<pat::TriggerObjectStandAlone>>(
+          matchingCfg.getParameter<edm::InputTag>("triggerObjects"));
+}
+
+
+edm::ParameterSetDescription TriggerMatcher::GetDescription()
+{
+    edm::ParameterSetDescription desc;
+    desc.add<edm::InputTag>("triggerObjects", edm::InputTag("slimmedPatTrigger"))->
+      setComment("PAT trigger objects.");
+    desc.add<std::vector<std::string>>("filters", std::vector<std::string>())->
+      setComment("HLT filters whose objects are matched. If empty, the matching is disabled.");
+    desc.add<double>("maxDR", 0.1)->setComment("Maximal angular distance for the matching.");
+
+    return desc;
+}
+
+
+unsigned TriggerMatcher::Match(reco::Candidate const &cand) const
+{
+    unsigned mask = 0;
+    double const eta = cand.eta(), phi = cand.phi();
+
+    objectGrid.ForEachNear(eta, phi, std::sqrt(maxDR2),
+      [&](unsigned index)
+      {
+          Object const &obj = objects[index];
+
+          // Skip the object if it cannot change the result
+          if ((obj.mask & ~mask) == 0)
+              return;
+
+          if (reco::deltaR2(eta, phi, obj.eta, obj.phi) < maxDR2)
+              mask |= obj.mask;
+      });
+
+    return mask;
+}
+
+
+void TriggerMatcher::ReadEvent(edm::Event const &event)
+{
+    objects.clear();
+    objectGrid.Clear();
+
+    if (not IsEnabled())
+        return;
+
+    edm::Handle<edm::View<pat::TriggerObjectStandAlone>> triggerObjects;
+    event.getByToken(triggerObjectsToken, triggerObjects);
+
+    for (auto const &obj: *triggerObjects)
+    {
+        unsigned mask = 0;
+
+        for (auto const &label: obj.filterLabels())
+        {
+            auto const res = filterIndices.find(label);
+
+            if (res != filterIndices.end())
+                mask |= 1u << res->second;
+        }
+
+        if (mask != 0)
+        {
+            objects.push_back({obj.eta(), obj.phi(), mask});
+            objectGrid.Insert(obj.eta(), obj.phi());
+        }
+    }
+}
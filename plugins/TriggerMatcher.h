@@ -0,0 +1,80 @@
+#pragma once
+
+#include "EtaPhiGrid.h"
+
+#include <DataFormats/Candidate/interface/Candidate.h>
+#include <DataFormats/PatCandidates/interface/TriggerObjectStandAlone.h>
+#include <FWCore/Framework/interface/ConsumesCollector.h>
+#include <FWCore/Framework/interface/Event.h>
+#include <FWCore/ParameterSet/interface/ParameterSet.h>
+#include <FWCore/ParameterSet/interface/ParameterSetDescription.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * \class TriggerMatcher
+ * \brief Matches reconstructed objects to trigger objects of selected filters
+ *
+ * The class is configured with a parameter set "triggerMatching", which provides a collection of
+ * trigger objects, a list of HLT filters, and the maximal angular distance for the matching. For
+ * each reconstructed candidate it computes a bit mask of filters such that at least one of
+ * objects that have passed the filter lies within the given distance from the candidate. Bit i
+ * corresponds to the filter with index i in the configuration; up to 32 filters are supported. If
+ * the list of filters is empty, the matching is disabled.
+ *
+ * Method ReadEvent must be called for each event before any candidates are matched. It selects
+ * trigger objects that have passed at least one of the filters and stores them in a spatial index
+ * (class EtaPhiGrid), so that only objects close to a candidate are checked when matching it.
+ */
+class TriggerMatcher
+{
+private:
+    /// Trigger object that has passed some of the selected filters
+    struct Object
+    {
+        /// Pseudorapidity and azimuthal angle of the object
+        double eta, phi;
+
+        /// Bit mask of selected filters passed by the object
+        unsigned mask;
+    };
+
+public:
+    /// Constructor from the configuration of the hosting plugin
+    TriggerMatcher(edm::ParameterSet const &cfg, edm::ConsumesCollector &&consumesCollector);
+
+public:
+    /// Returns description of the parameter set that configures this class
+    static edm::ParameterSetDescription GetDescription();
+
+    /// Checks if the matching is enabled
+    bool IsEnabled() const
+    {
+        return not filterIndices.empty();
+    }
+
+    /// Computes the bit mask of matched filters for the given candidate
+    unsigned Match(reco::Candidate const &cand) const;
+
+    /// Reads trigger objects from the current event
+    void ReadEvent(edm::Event const &event);
+
+private:
+    /// Map from names of selected filters to their indices
+    std::unordered_map<std::string, unsigned> filterIndices;
+
+    /// Squared maximal angular distance for the matching
+    double maxDR2;
+
+    /// Token to access trigger objects
+    edm::EDGetTokenT<edm::View<pat::TriggerObjectStandAlone>> triggerObjectsToken;
+
+    /// Trigger objects in the current event that have passed some of the selected filters
+    std::vector<Object> objects;
+
+    /// Spatial index of objects in the current event
+    EtaPhiGrid objectGrid;
+};
@@ -0,0 +1,58 @@
+#include "TriggerMenuCache.h"
+
+#include <FWCore/Common/interface/TriggerNames.h>
+
+#include <unordered_map>
+#include <utility>
+
+
+TriggerMenuCache::TriggerMenuCache(std::vector<std::string> const &keys_,
+  KeyFunction keyFunction_):
+    keys(keys_),
+    keyFunction(keyFunction_),
+    lastIndices(nullptr)
+{}
+
+
+std::vector<int> const &TriggerMenuCache::GetIndices(edm::Event const &event,
+  edm::TriggerResults const &results)
+{
+    // The common case: the menu has not changed since the previous call
+    if (lastIndices and results.parameterSetID() == lastMenuID)
+        return *lastIndices;
+
+    lastMenuID = results.parameterSetID();
+    auto res = cache.find(lastMenuID);
+
+    if (res != cache.end())
+    {
+        lastIndices = &res->second;
+        return *lastIndices;
+    }
+
+
+    // This menu has not been seen before. Resolve the indices. The same key might have been
+    //given several times.
+    std::unordered_map<std::string, std::vector<unsigned>> keyPositions;
+
+    for (unsigned i = 0; i < keys.size(); ++i)
+        keyPositions[keys[i]].emplace_back(i);
+
+    std::vector<int> indices(keys.size(), -1);
+    edm::TriggerNames const &names = event.triggerNames(results);
+
+    for (unsigned i = 0; i < names.size(); ++i)
+    {
+        auto const &name = names.triggerName(i);
+        auto const keyIt = keyPositions.find((keyFunction) ? keyFunction(name) : name);
+
+        if (keyIt != keyPositions.end())
+        {
+            for (unsigned const pos: keyIt->second)
+                indices[pos] = i;
+        }
+    }
+
+    lastIndices = &(cache[lastMenuID] = std::move(indices));
+    return *lastIndices;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <DataFormats/Common/interface/TriggerResults.h>
+#include <DataFormats/Provenance/interface/ParameterSetID.h>
+#include <FWCore/Framework/interface/Event.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/**
+ * \class TriggerMenuCache
+ * \brief Memoizes indices of selected paths in trigger menus
+ *
+ * The class is constructed from a list of keys that identify selected paths (or flags). For each
+ * menu, identified by the ParameterSetID of a TriggerResults object, it finds indices of the
+ * selected paths, i.e. paths whose names are mapped to the given keys by the key function. The
+ * resolved indices are stored, so that when a menu is encountered again (as happens when files
+ * from different runs are chained), only a single lookup is needed.
+ */
+class TriggerMenuCache
+{
+public:
+    /// Type of a function that maps a name of a path in the menu to a key
+    using KeyFunction = std::function<std::string(std::string const &)>;
+
+public:
+    /**
+     * \brief Constructor from keys and a function to map names of paths to keys
+     *
+     * By default, names of paths are used as keys directly.
+     */
+    TriggerMenuCache(std::vector<std::string> const &keys, KeyFunction keyFunction = nullptr);
+
+public:
+    /**
+     * \brief Returns indices of selected paths in the menu of the given TriggerResults object
+     *
+     * Indices are given in the same order as the keys provided to the constructor. If a key is not
+     * found in the menu, the corresponding index is set to (-1). If several paths are mapped to
+     * the same key, the last one is used.
+     */
+    std::vector<int> const &GetIndices(edm::Event const &event,
+      edm::TriggerResults const &results);
+
+private:
+    /// Keys that identify selected paths
+    std::vector<std::string> keys;
+
+    /// Function to map names of paths to keys
+    KeyFunction keyFunction;
+
+    /// Resolved indices for all menus encountered so far
+    std::map<edm::ParameterSetID, std::vector<int>> cache;
+
+    /// ID of the menu for which indices have been requested last time
+    edm::ParameterSetID lastMenuID;
+
+    /**
+     * \brief Indices for the last menu
+     *
+     * Points to an element of the cache. Null if no menu has been encountered yet.
+     */
+    std::vector<int> const *lastIndices;
+};
@@ -52,7 +52,7 @@ def apply_event_filters(
         TriggerResultsTag = cms.InputTag('TriggerResults', '', processName)
     )
     
-    paths.append(process.applyEmulatedMETFilters)
+    paths.append(process.applyEmulatedMETFilters, reorderable=True)
 
 
     # An additional filter needs to be applied for 2017 and 2018 [1]
@@ -80,5 +80,5 @@ def apply_event_filters(
             debug = cms.bool(False)
         )
 
-        paths.append(process.ecalBadCalibReducedMINIAODFilter)
+        paths.append(process.ecalBadCalibReducedMINIAODFilter, reorderable=True)
 
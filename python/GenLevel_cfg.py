@@ -0,0 +1,353 @@
+"""Configuration for cmsRun to produce generator-level PEC tuples.
+
+This is a fast alternative to MiniAOD_cfg.py for studies of simulated
+samples that only need generator-level information, such as evaluation
+of generator systematic uncertainties.  It runs the event counter and
+the writers for global generator properties, generator-level particles,
+and generator-level jets and MET, but none of the reconstruction chain:
+no electron and photon preconditions, jet energy corrections, event
+selection, or event filters.  Every event is stored.
+
+Input files can be given in the MiniAOD (option inputTier=MINIAOD) or
+GEN (inputTier=GEN) data tiers.  In the latter case the full record of
+generator-level particles and jets clustered from it are used.  GEN
+inputs do not contain pat::MET, so generator-level MET is not stored,
+and jet constituents are not linked to the pruned record used to count
+heavy-flavour hadrons, so these counters are not filled.  Only products
+consumed by the job are read from the input files (see prune_input in
+Utils_cff.py), unless option pruneInput is switched off.
+
+The output has the same trees as the corresponding part of the output
+of MiniAOD_cfg.py, including tree pecEventID/EventID, which can be used
+to align with it.  Behaviour can be controlled using a number of
+command-line options (see their list in the code below).  Options that
+are also defined in MiniAOD_cfg.py have the same meaning.
+"""
+
+import random
+import string
+
+import FWCore.ParameterSet.Config as cms
+
+
+# Create a process
+process = cms.Process('GenLevel')
+
+
+# Enable MessageLogger and reduce its verbosity
+process.load('FWCore.MessageLogger.MessageLogger_cfi')
+process.MessageLogger.cerr.FwkReport.reportEvery = 10000
+
+
+# Ask to print a summary in the log
+process.options = cms.untracked.PSet(
+    wantSummary = cms.untracked.bool(True)
+)
+
+
+# Parse command-line options.  In addition to the options defined below,
+# use several standard ones: inputFiles, outputFile, maxEvents.
+from FWCore.ParameterSet.VarParsing import VarParsing
+options = VarParsing('analysis')
+
+options.register(
+    'inputTier', 'MINIAOD', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Data tier of the input files: MINIAOD or GEN'
+)
+options.register(
+    'processIDs', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Comma-separated list of process IDs to select'
+)
+options.register(
+    'saveAltLHEWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save alternative LHE-level event weights'
+)
+options.register(
+    'quantizeAltLHEWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store alternative LHE weights as quantized ratios to the nominal weight'
+)
+options.register(
+    'labelLHEEventProduct', 'externalLHEProducer', VarParsing.multiplicity.singleton,
+    VarParsing.varType.string, 'Label to access LHEEventProduct'
+)
+options.register(
+    'saveGenParticles', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save information about the hard(est) interaction and certain particles'
+)
+options.register(
+    'saveGenParticleRecord', False, VarParsing.multiplicity.singleton,
+    VarParsing.varType.bool, 'Save full record of generator-level particles in a compact form'
+)
+options.register(
+    'saveGenJets', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save information about generator-level jets'
+)
+options.register(
+    'compactMET', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store generator-level MET in a compact form'
+)
+options.register(
+    'numThreads', 1, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+    'Number of threads (and streams) to use'
+)
+options.register(
+    'singleTree', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store all PEC objects in a single tree pecEvents/Events'
+)
+options.register(
+    'flatTrees', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store collections of PEC objects using flat columnar layout'
+)
+options.register(
+    'compression', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Compression algorithm and level for output trees'
+)
+options.register(
+    'pruneInput', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Read only the consumed products from the input files'
+)
+options.register(
+    'saveProvenance', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save the provenance of the output file'
+)
+
+# Override defaults for automatically defined options
+options.setDefault('maxEvents', 100)
+options.setType('outputFile', VarParsing.varType.string)
+options.setDefault('outputFile', 'sample.root')
+
+options.parseArguments()
+
+
+if options.inputTier not in ['MINIAOD', 'GEN']:
+    raise RuntimeError(
+        'Data tier "{}" is not supported.'.format(options.inputTier)
+    )
+
+if options.numThreads > 1:
+    process.options.numberOfThreads = cms.untracked.uint32(options.numThreads)
+    process.options.numberOfStreams = cms.untracked.uint32(0)
+
+
+# Labels of generator-level collections in the input data tier
+if options.inputTier == 'MINIAOD':
+    genParticlesTag = cms.InputTag('prunedGenParticles')
+    genJetsTag = cms.InputTag('slimmedGenJets')
+    genMETTag = cms.InputTag('slimmedMETs')
+    puInfoTag = cms.InputTag('slimmedAddPileupInfo')
+else:
+    genParticlesTag = cms.InputTag('genParticles')
+    genJetsTag = cms.InputTag('ak4GenJetsNoNu')
+    genMETTag = None
+    puInfoTag = None
+
+
+# Specify the input files
+if len(options.inputFiles) == 0:
+    raise RuntimeError('No input file is provided')
+
+process.source = cms.Source('PoolSource',
+    fileNames = cms.untracked.vstring(options.inputFiles),
+    inputCommands = cms.untracked.vstring('keep *', 'drop LHERunInfoProduct_*_*_*')
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+
+# Indices of alternative generator-level weights to be stored, chosen as
+# in MiniAOD_cfg.py
+if options.saveAltLHEWeights:
+    alt_lhe_weight_indices = cms.vint32(1, 8)
+else:
+    alt_lhe_weight_indices = cms.vint32()
+
+alt_ps_weight_indices = cms.vint32(6, 9)
+
+
+# Create the processing path
+process.genLevelPath = cms.Path()
+
+from Analysis.PECTuples.Utils_cff import PathManager
+paths = PathManager(process.genLevelPath)
+
+
+# Generator-level information shared by several plugins below
+process.generatorContext = cms.EDProducer('GeneratorContextProducer',
+    generator = cms.InputTag('generator'),
+    lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
+    computeAltLHEWeights = cms.bool(len(alt_lhe_weight_indices) > 0)
+)
+process.genLevelTask = cms.Task(process.generatorContext)
+
+
+# Apply filtering on process IDs
+if options.processIDs:
+    process.processIDFilter = cms.EDFilter('ProcessIDFilter',
+        generatorContext = cms.InputTag('generatorContext'),
+        processIDs = cms.vint32([int(i) for i in options.processIDs.split(',')])
+    )
+    paths.append(process.processIDFilter)
+
+
+# Event counter.  Pileup profiles are only available in MiniAOD.
+process.eventCounter = cms.EDAnalyzer('EventCounter',
+    generatorContext = cms.InputTag('generatorContext'),
+    saveAltLHEWeights = alt_lhe_weight_indices,
+    saveAltPSWeights = alt_ps_weight_indices,
+    saveLumiSummaries = cms.bool(True)
+)
+
+if puInfoTag is not None:
+    process.eventCounter.puInfo = puInfoTag
+
+paths.append(process.eventCounter)
+
+
+# Conversion into PEC format.  As in MiniAOD_cfg.py, descriptions of the
+# output trees are collected in the list below, and the writers are
+# created at the end.
+from Analysis.PECTuples.Utils_cff import make_pec_writer
+pecTrees = []
+
+process.pecEventIDProducer = cms.EDProducer('PECEventID')
+pecTrees.append((
+    'pecEventID', 'EventID', 'Event ID',
+    [('eventId', 'EventID', 'pecEventIDProducer')]
+))
+
+process.pecGeneratorProducer = cms.EDProducer('PECGenerator',
+    generatorContext = cms.InputTag('generatorContext'),
+    saveAltLHEWeights = alt_lhe_weight_indices,
+    altLHEWeightRatioRange = cms.vdouble(-2., 4.) if options.quantizeAltLHEWeights \
+        else cms.vdouble(),
+    saveAltPSWeights = alt_ps_weight_indices
+)
+pecTrees.append((
+    'pecGenerator', 'Generator', 'Global generator-level properties',
+    [('generator', 'GeneratorInfo', 'pecGeneratorProducer')]
+))
+process.genLevelTask.add(process.pecEventIDProducer, process.pecGeneratorProducer)
+
+if options.saveGenParticles or options.saveGenParticleRecord:
+    process.pecGenParticlesProducer = cms.EDProducer('PECGenParticles',
+        genParticles = genParticlesTag,
+        saveExtraParticles = cms.vuint32(6, 23, 24, 25),
+        saveFullRecord = cms.bool(options.saveGenParticleRecord)
+    )
+    process.genLevelTask.add(process.pecGenParticlesProducer)
+
+    if options.saveGenParticles:
+        pecTrees.append((
+            'pecGenParticles', 'HardInteraction',
+            'Tree contrains generator-level particles from the hard interaction',
+            [('particles', 'GenParticles', 'pecGenParticlesProducer')]
+        ))
+
+    if options.saveGenParticleRecord:
+        pecTrees.append((
+            'pecGenParticleRecord', 'GenParticleRecord',
+            'Full record of generator-level particles in a compact form',
+            [('genRecord', 'GenParticleRecord', 'pecGenParticlesProducer:fullRecord')]
+        ))
+
+if options.saveGenJets:
+    process.pecGenJetMETProducer = cms.EDProducer('PECGenJetMET',
+        jets = genJetsTag,
+        cut = cms.string('pt > 8.'),
+        saveFlavourCounters = cms.bool(options.inputTier == 'MINIAOD'),
+        compactMET = cms.bool(options.compactMET)
+    )
+    genJetMETBranches = [
+        ('genJets' if options.singleTree else 'jets', 'GenJets', 'pecGenJetMETProducer')
+    ]
+
+    if genMETTag is not None:
+        process.pecGenJetMETProducer.met = genMETTag
+        genJetMETBranches.append(
+            ('genMET', 'MET', 'pecGenJetMETProducer:MET') if options.compactMET else
+            ('genMETs' if options.singleTree else 'METs', 'Candidates',
+                'pecGenJetMETProducer:METs')
+        )
+
+    pecTrees.append((
+        'pecGenJetMET', 'GenJetMET', 'Properties of generator-level jets and generator-level MET',
+        genJetMETBranches
+    ))
+    process.genLevelTask.add(process.pecGenJetMETProducer)
+
+
+# Create writers for PEC objects
+if options.singleTree:
+    allBranches = []
+
+    for label, treeName, treeTitle, branches in pecTrees:
+        allBranches.extend(branches)
+
+    process.pecEvents = make_pec_writer(
+        'Events', 'PEC objects', allBranches, flat=options.flatTrees
+    )
+    paths.append(process.pecEvents)
+else:
+    for label, treeName, treeTitle, branches in pecTrees:
+        writer = make_pec_writer(treeName, treeTitle, branches, flat=options.flatTrees)
+        setattr(process, label, writer)
+        paths.append(writer)
+
+paths.associate(process.genLevelTask)
+
+
+# I/O settings for all output trees, as in MiniAOD_cfg.py
+compressionLevels = {'ZLIB': 4, 'LZMA': 9, 'LZ4': 4, 'ZSTD': 5}
+
+if options.compression:
+    if ':' in options.compression:
+        compressionAlgorithm, compressionLevel = options.compression.split(':')
+        compressionLevel = int(compressionLevel)
+    else:
+        compressionAlgorithm = options.compression
+        compressionLevel = compressionLevels.get(compressionAlgorithm, 4)
+else:
+    compressionAlgorithm, compressionLevel = '', 4
+
+from Analysis.PECTuples.Utils_cff import apply_tree_settings
+apply_tree_settings(process, cms.PSet(
+    compressionAlgorithm = cms.string(compressionAlgorithm),
+    compressionLevel = cms.int32(compressionLevel),
+    basketSize = cms.int32(32000),
+    autoFlush = cms.int64(-30000000),
+    implicitMT = cms.bool(False),
+    lumiClusters = cms.bool(False),
+    minClusterEntries = cms.uint32(1000)
+))
+
+
+# Restrict products read from the input to the ones consumed.  This must
+# be done after all modules have been defined.  Flavour counters of
+# generator-level jets are evaluated from their constituents, which are
+# stored in a collection not referred to in the configuration.
+if options.pruneInput:
+    from Analysis.PECTuples.Utils_cff import prune_input
+    extraKeep = []
+    
+    if options.saveGenJets and process.pecGenJetMETProducer.saveFlavourCounters.value():
+        extraKeep.append('packedGenParticles')
+    
+    prune_input(process, extra_keep=extraKeep, verbose=True)
+
+
+# The output file for the analyzers
+postfix = '_' + string.join([random.choice(string.letters) for i in range(3)], '')
+
+if options.outputFile.endswith('.root'):
+    outputBaseName = options.outputFile[:-5]
+else:
+    outputBaseName = options.outputFile
+
+process.TFileService = cms.Service('TFileService',
+    fileName = cms.string(outputBaseName + postfix + '.root'))
+
+
+# Provenance of the output file.  This must be done last.
+if options.saveProvenance:
+    from Analysis.PECTuples.Utils_cff import add_provenance_writer
+    add_provenance_writer(process, paths)
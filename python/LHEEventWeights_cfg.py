@@ -35,6 +35,10 @@ options.register(
     'storeWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
     'Enables storing of event weights in a ROOT tree.'
 )
+options.register(
+    'storeWeightRatios', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store alternative weights as quantized ratios to the nominal weight.'
+)
 options.register(
     'labelLHEInfoProduct', 'externalLHEProducer', VarParsing.multiplicity.singleton,
     VarParsing.varType.string, 'Label to access LHEEventProduct'
@@ -71,16 +75,24 @@ if options.storeWeights:
         fileName = cms.string(outputBaseName + postfix + '.root'))
 
 
+# Generator-level information, which includes rescaled LHE weights
+process.generatorContext = cms.EDProducer('GeneratorContextProducer',
+    generator = cms.InputTag('generator'),
+    lheEventProduct = cms.InputTag(options.labelLHEInfoProduct),
+    rescaleLHEWeights = cms.bool(True)
+)
+
+
 # The plugin to read and store weights
 process.lheEventWeights = cms.EDAnalyzer('LHEEventWeights',
     lheRunInfoProduct = cms.InputTag(options.labelLHEInfoProduct),
     lheEventInfoProduct = cms.InputTag(options.labelLHEInfoProduct),
-    generator = cms.InputTag('generator'),
+    generatorContext = cms.InputTag('generatorContext'),
     weightsHeaderTag = cms.string('initrwgt'),
-    rescaleLHEWeights = cms.bool(True),
     computeMeanWeights = cms.bool(True),
     storeWeights = cms.bool(options.storeWeights),
+    altWeightRatioRange = cms.vdouble(-2., 4.) if options.storeWeightRatios else cms.vdouble(),
     printToFiles = cms.bool(True)
 )
 
-process.p = cms.Path(process.lheEventWeights)
+process.p = cms.Path(process.lheEventWeights, cms.Task(process.generatorContext))
@@ -11,8 +11,19 @@ EventFilters_cff.
 
 After reconstructed objects are defined and the loose event selection is
 performed, relevant reconstructed objects as well as some generator-
-level properties are saved in a ROOT file with the help of a set of
-dedicated EDAnalyzers.  The job does not produce any EDM output.
+level properties are converted into PEC format by dedicated producers
+and saved in a ROOT file with the help of a set of EDAnalyzers.  The
+job does not produce any EDM output.  It can be run with several
+threads (option numThreads).  By default each group of PEC objects is
+stored in a dedicated tree, but all of them can also be written into a
+single tree (option singleTree).  Collections of PEC objects, as well
+as event IDs, MET, and pile-up and generator information, can be stored
+using a flat columnar layout (option flatTrees).  The compression
+algorithm for all output trees is chosen with option compression.
+Timing of all modules and sizes of all output branches can be saved in
+the output file (option savePerf).  For quick checks, the PEC objects
+can be summarized in a set of histograms instead of being written into
+trees (option quickLook).
 
 Behaviour can be controlled using a number of command-line options (see
 their list in the code below).
@@ -63,6 +74,18 @@ options.register(
     'processIDs', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
     'Comma-separated list of process IDs to select in simulation'
 )
+# File with IDs of events to be processed.  It is a text file in the
+# format "run:lumi:event", a ROOT file produced by the pre-pass
+# configuration SkimPrepass_cfg.py, or a binary file (extension ".evl")
+# produced by script convertEventList.py.  The path is resolved as for a
+# FileInPath.  Only the listed events are kept, and only luminosity
+# sections that contain them are read.  In simulation, the event counter
+# then only sees the listed events, and the normalization must be taken
+# from the lumi summaries produced by the pre-pass.
+options.register(
+    'eventList', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'File with a list of events to process'
+)
 options.register(
     'runOnData', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
     'Indicates whether the job processes data or simulation'
@@ -83,10 +106,21 @@ options.register(
     'triggerProcessName', 'HLT', VarParsing.multiplicity.singleton,
     VarParsing.varType.string, 'Name of the process that evaluated trigger decisions'
 )
+options.register(
+    'packTriggerBits', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Pack trigger decisions into bit fields'
+)
 options.register(
     'saveAltLHEWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
     'Save alternative LHE-level event weights'
 )
+# Ratios are encoded in the range [-2, 4), which includes negative values
+# found in NLO samples.  Ratios outside of it are clipped, and their
+# number is reported at the end of the job.
+options.register(
+    'quantizeAltLHEWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store alternative LHE weights as quantized ratios to the nominal weight'
+)
 options.register(
     'labelLHEEventProduct', 'externalLHEProducer', VarParsing.multiplicity.singleton,
     VarParsing.varType.string, 'Label to access LHEEventProduct'
@@ -95,10 +129,158 @@ options.register(
     'saveGenParticles', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
     'Save information about the hard(est) interaction and certain particles'
 )
+options.register(
+    'saveGenParticleRecord', False, VarParsing.multiplicity.singleton,
+    VarParsing.varType.bool, 'Save full record of generator-level particles in a compact form'
+)
 options.register(
     'saveGenJets', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
     'Save information about generator-level jets'
 )
+options.register(
+    'saveJetPull', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Compute and save jet pull angles'
+)
+options.register(
+    'numThreads', 1, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+    'Number of threads (and streams) to use'
+)
+options.register(
+    'singleTree', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store all PEC objects in a single tree pecEvents/Events'
+)
+options.register(
+    'flatTrees', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store collections of PEC objects using flat columnar layout'
+)
+# Compression for all output trees, given in the form "algorithm" or
+# "algorithm:level".  The algorithm is one of "ZLIB", "LZMA", "LZ4",
+# and "ZSTD" (only available with ROOT 6.20 or later).  If empty, the
+# default settings of the file are used.
+options.register(
+    'compression', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Compression algorithm and level for output trees'
+)
+# Buffer events in the writers and write them sorted by event ID within
+# each luminosity section.  This makes the output independent of the
+# scheduling in multithreaded jobs.  The tree pecTrigger/TriggerInfo is
+# not reordered and then stores event IDs for matching.
+options.register(
+    'deterministicOrder', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Write events in a deterministic order'
+)
+# Derive random numbers for JER smearing of jets from the event ID and
+# the index of the jet instead of drawing them from the random-number
+# service.  The smearing then does not depend on the number of threads
+# or the set of processed events.
+options.register(
+    'deterministicJER', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Use reproducible random numbers for JER smearing'
+)
+# Close clusters of all output trees at boundaries of luminosity
+# sections (requires ROOT 6.14 or later) and save ranges of entries for
+# each luminosity section in tree pecEventID/LumiRanges
+# (pecEvents/LumiRanges in the single-tree mode).  Masked luminosity
+# sections can then be skipped cluster by cluster.
+options.register(
+    'lumiClusters', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Align clusters of output trees with luminosity sections'
+)
+# Read from the input files only products consumed by modules in the
+# process (see prune_input in Utils_cff.py).  This reduces the amount of
+# data decompressed and, for remote files, transferred.
+options.register(
+    'pruneInput', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Read only the consumed products from the input files'
+)
+# File with sources of JEC uncertainty, given relative to the search
+# path of FileInPath.  If provided, each jet stores indices of its bin
+# in the tables of the sources, and the tables are saved in directory
+# jecUncertaintyTables.
+options.register(
+    'jecUncSources', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'File with sources of JEC uncertainty to be tabulated'
+)
+# Save trigger prescales in a separate tree pecTrigger/Prescales, which
+# receives one entry per luminosity section, instead of storing them for
+# every event in pecTrigger/TriggerInfo.  Entries are looked up by
+# (run, lumi).
+options.register(
+    'prescalesPerLumi', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store trigger prescales once per luminosity section'
+)
+# Store event IDs in the compact form (see PECWriter.h): run and
+# luminosity section numbers are only saved in the tree LumiRanges,
+# which is then written, and event numbers are delta-coded.  The IDs
+# can be restored with class pecreader::EventIDDecoder.
+options.register(
+    'compactEventID', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store event IDs in the compact form'
+)
+# Store reconstructed and generator-level MET with all its variations as
+# a single object pec::MET (branches MET and genMET) instead of vectors
+# of pec::Candidate
+options.register(
+    'compactMET', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store MET and its variations in a compact form'
+)
+# Store real-valued electron IDs in a separate branch electronContIDs,
+# with exactly as many values per electron as there are IDs in the
+# configuration, instead of the fixed-size array in pec::Electron.  A
+# positive number of bits enables quantization in the range [-1, 1].
+# Names of the IDs are saved in tree pecElectrons/ValueNames.
+options.register(
+    'separateContIDs', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Store real-valued electron IDs in a separate branch'
+)
+options.register(
+    'contIDBits', 0, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+    'Number of bits to quantize separately stored real-valued electron IDs, or 0'
+)
+# Instead of writing PEC objects into trees, fill a predefined set of
+# weighted histograms of their properties, stored in directory
+# pecHistograms.  Outputs of different jobs are merged by summing the
+# histograms.  Trees with trigger decisions, event counts, and
+# additional weights are still written.
+options.register(
+    'quickLook', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Fill histograms of PEC objects instead of trees'
+)
+# Record in tree provenance/Provenance a hash of the configuration, the
+# version of the package, and the list of input files.  This allows to
+# reuse outputs of earlier jobs in crabSubmit.py and mergeCrabRes.py.
+options.register(
+    'saveProvenance', True, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save the provenance of the output file'
+)
+# Compute pileup weights in simulation and store them in pec::PileUpInfo.
+# The option gives a comma-separated list of one or three ROOT files
+# with data pileup profiles (nominal, up, down), as produced by
+# pileupCalc.py.  Paths are resolved as for a FileInPath, so that files
+# placed in the data directory of a package are shipped with CRAB jobs.
+# The profile in simulation is taken from the mixing module of the given
+# period.
+options.register(
+    'puProfiles', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Data pileup profiles to compute pileup weights'
+)
+options.register(
+    'rootIMT', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Compress baskets of output trees in parallel using ROOT implicit multithreading'
+)
+options.register(
+    'savePerf', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save per-module timing and sizes of output branches in directory Perf'
+)
+# Reorder filters in the path based on their costs and rejection rates
+# measured in a calibration run with option savePerf (see method
+# PathManager.reorder in Utils_cff.py).  Files produced in that run are
+# given as a comma-separated list.  Counters of PerfMonitor are then
+# saved as with option savePerf, which records the order used.
+options.register(
+    'filterOrder', '', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Calibration files to choose the order of filters'
+)
 
 # Override defaults for automatically defined options
 options.setDefault('maxEvents', 100)
@@ -116,6 +298,14 @@ if options.period not in ['2016', '2017']:
     )
 
 
+# Enable multithreading.  All PEC plugins are thread-friendly: writers
+# are one-modules that share the TFileService resource, while filters
+# are stream or global modules.
+if options.numThreads > 1:
+    process.options.numberOfThreads = cms.untracked.uint32(options.numThreads)
+    process.options.numberOfStreams = cms.untracked.uint32(0)
+
+
 # Make shortcuts to access some of the configuration options easily
 runOnData = options.runOnData
 elChan = (options.channels.find('e') != -1)
@@ -184,6 +374,12 @@ else:
 # Set a specific event range here (useful for debugging)
 # process.source.eventsToProcess = cms.untracked.VEventRange('1:5')
 
+# Restrict the input to luminosity sections that contain events from
+# the given list
+if options.eventList:
+    from Analysis.PECTuples.Utils_cff import get_lumis_from_event_list
+    process.source.lumisToProcess = get_lumis_from_event_list(options.eventList)
+
 # Set the maximum number of events to process for a local run (it is overiden by CRAB)
 process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
 
@@ -251,53 +447,88 @@ process.load('Configuration.Geometry.GeometryRecoDB_cff')
 process.load('Configuration.StandardSequences.MagneticField_cff')
 
 
-# Create processing paths.  There is one path per each channel (electron
-# or muon).
-process.elPath = cms.Path()
-process.muPath = cms.Path()
+# Create the processing path.  All requested channels (electron and
+# muon) are selected in a single pass by module channelPreselection
+# defined below.
+process.analysisPath = cms.Path()
 
 from Analysis.PECTuples.Utils_cff import PathManager
-paths = PathManager(process.elPath, process.muPath)
+paths = PathManager(process.analysisPath)
+
+
+# Keep only events from the given list
+if options.eventList:
+    process.eventIDFilter = cms.EDFilter('EventIDFilter',
+        eventListFile = cms.FileInPath(options.eventList),
+        rejectKnownEvents = cms.bool(False)
+    )
+    paths.append(process.eventIDFilter, reorderable=True)
+
+
+# Generator-level information shared by several plugins below.  It is
+# produced once per event and attached to the analysis task.
+if not runOnData:
+    process.generatorContext = cms.EDProducer('GeneratorContextProducer',
+        generator = cms.InputTag('generator'),
+        lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
+        computeAltLHEWeights = cms.bool(len(alt_lhe_weight_indices) > 0)
+    )
 
 
 # Apply filtering on process IDs
 if not runOnData and options.processIDs:
     process.processIDFilter = cms.EDFilter('ProcessIDFilter',
-        lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
+        generatorContext = cms.InputTag('generatorContext'),
         processIDs = cms.vint32([int(i) for i in options.processIDs.split(',')])
     )
-    paths.append(process.processIDFilter)
+    paths.append(process.processIDFilter, reorderable=True)
 
 
 # Include an event counter before any selection is applied.  It is only
-# needed for simulation.
+# needed for simulation.  Event counts and sums of weights are also saved
+# per luminosity block, so that normalization can be recomputed for any
+# subset of them.
 if not runOnData:
     process.eventCounter = cms.EDAnalyzer('EventCounter',
-        generator = cms.InputTag('generator'),
+        generatorContext = cms.InputTag('generatorContext'),
         saveAltLHEWeights = alt_lhe_weight_indices,
-        lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
         saveAltPSWeights = alt_ps_weight_indices,
-        puInfo = cms.InputTag('slimmedAddPileupInfo')
+        puInfo = cms.InputTag('slimmedAddPileupInfo'),
+        saveLumiSummaries = cms.bool(True)
     )
     paths.append(process.eventCounter)
 
 
+# Reconstructed event-level quantities shared by several plugins below:
+# properties of primary vertices and rho.  They are computed once per
+# event, and the producer is attached to the analysis task.
+process.recoContext = cms.EDProducer('RecoContextProducer',
+    primaryVertices = cms.InputTag('offlineSlimmedPrimaryVertices'),
+    vertexSelection = cms.string('!isFake & ndof > 4. & abs(z) < 24. & position.rho < 2.'),
+    rho = cms.InputTag('fixedGridRhoFastjetAll'),
+    rhoCentral = cms.InputTag('fixedGridRhoFastjetCentral')
+)
+
+
 # Filter on properties of the first vertex
 process.goodOfflinePrimaryVertices = cms.EDFilter('FirstVertexFilter',
-    src = cms.InputTag('offlineSlimmedPrimaryVertices'),
-    cut = cms.string('!isFake & ndof > 4. & abs(z) < 24. & position.rho < 2.')
+    recoContext = cms.InputTag('recoContext')
 )
 
-paths.append(process.goodOfflinePrimaryVertices)
+paths.append(process.goodOfflinePrimaryVertices, reorderable=True)
 
 
 # Define basic reconstructed objects.  Non-standard producers are
 # attached to a task.
 from Analysis.PECTuples.ObjectsDefinitions_cff import (
     setup_egamma_preconditions,
-    define_electrons, define_muons, define_jets, define_METs
+    define_electrons, define_muons, define_jets, define_METs,
+    get_pf_jet_id
 )
-process.analysisTask = cms.Task()
+process.analysisTask = cms.Task(process.recoContext)
+
+if not runOnData:
+    process.analysisTask.add(process.generatorContext)
 
 setup_egamma_preconditions(process, process.analysisTask, options.period)
 ele_quality_cuts, ele_embedded_cut_based_id_labels, \
@@ -311,24 +542,43 @@ recorrectedJetsLabel, jetQualityCuts = define_jets(
 metTag = cms.InputTag('slimmedMETs')
 
 
-# The loose event selection
-process.countTightPatElectrons = cms.EDFilter('PATCandViewCountFilter',
-    src = cms.InputTag('patElectronsForEventSelection'),
-    minNumber = cms.uint32(1), maxNumber = cms.uint32(999)
-)
-process.countTightPatMuons = cms.EDFilter('PATCandViewCountFilter',
-    src = cms.InputTag('patMuonsForEventSelection'),
-    minNumber = cms.uint32(1), maxNumber = cms.uint32(999)
-)
+# The loose event selection.  An event is accepted if it passes the
+# selection in at least one of the requested channels.  Decisions for
+# individual channels are stored as a bit mask, in which bits follow the
+# order of the channels below.  Names of the channels are saved as names
+# of the bits in tree IDBits next to the tree with event IDs.
+channelSelections = []
+channelNames = []
+
 if elChan:
-    process.elPath += process.countTightPatElectrons
+    channelNames.append('e')
+    channelSelections.append(cms.PSet(
+        leptons = cms.InputTag('patElectronsForEventSelection'),
+        minLeptons = cms.uint32(1), maxLeptons = cms.uint32(999)
+    ))
 if muChan:
-    process.muPath += process.countTightPatMuons
+    channelNames.append('m')
+    channelSelections.append(cms.PSet(
+        leptons = cms.InputTag('patMuonsForEventSelection'),
+        minLeptons = cms.uint32(1), maxLeptons = cms.uint32(999)
+    ))
+
+process.channelPreselection = cms.EDFilter('ChannelPreselection',
+    channels = cms.VPSet(*channelSelections)
+)
+paths.append(process.channelPreselection, reorderable=True)
 
 if options.jetSel:
     from Analysis.PECTuples.Utils_cff import add_jet_selection
     add_jet_selection(options.jetSel, process, paths, runOnData)
 
+if options.deterministicJER:
+    for label, seed in [('analysisPatJets', 372), ('jetsForEventSelection', 3631)]:
+        if hasattr(process, label):
+            module = getattr(process, label)
+            module.deterministicSmearing = cms.bool(True)
+            module.seed = cms.uint32(seed)
+
 
 # Apply event filters recommended for analyses involving MET
 from Analysis.PECTuples.EventFilters_cff import apply_event_filters
@@ -341,53 +591,18 @@ apply_event_filters(
 # Save decisions of selected triggers.  Events that are not accepted by
 # any of the considered triggers are rejected unless the dedicated
 # command line option prevents this.
-if options.period == '2017':
-    # The list is based on menu [1], which was used for the
-    # RunIIFall17MiniAOD campaign.
-    # [1] /frozen/2017/2e34/v4.0/HLT/V5
-    triggerNames = [
-        # Single-lepton paths
-        'Mu50', 'Mu55',
-        'IsoMu20', 'IsoMu24', 'IsoMu27', 'IsoMu30',
-        'Ele27_WPTight_Gsf', 'Ele32_WPTight_Gsf', 'Ele35_WPTight_Gsf', 'Ele38_WPTight_Gsf',
-        # Dilepton paths
-        'Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass8',
-        'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL', 'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
-        'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL',
-        'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
-        'Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ',
-        # Cross-triggers
-        'Ele28_eta2p1_WPTight_Gsf_HT150', 'Ele30_eta2p1_WPTight_Gsf_CentralPFJet35_EleCleaned'
-    ]
-
-elif options.period == '2016':
-    # The list is based on menu [1], which was used in the re-HLT
-    # campaign with RunIISpring16MiniAODv2
-    # [1] /frozen/2016/25ns10e33/v2.1/HLT/V3
-    triggerNames = [
-        # Single-lepton paths
-        'Mu45_eta2p1', 'Mu50', 'Mu55',
-        'IsoMu20', 'IsoTkMu20', 'IsoMu22', 'IsoTkMu22', 'IsoMu22_eta2p1', 'IsoTkMu22_eta2p1',
-        'IsoMu24', 'IsoTkMu24', 'IsoMu27', 'IsoTkMu27',
-        'Ele23_WPLoose_Gsf', 'Ele24_eta2p1_WPLoose_Gsf',
-        'Ele25_WPTight_Gsf', 'Ele25_eta2p1_WPLoose_Gsf', 'Ele25_eta2p1_WPTight_Gsf',
-        'Ele27_WPLoose_Gsf', 'Ele27_WPTight_Gsf',
-        'Ele27_eta2p1_WPLoose_Gsf', 'Ele27_eta2p1_WPTight_Gsf',
-        'Ele32_eta2p1_WPTight_Gsf', 'Ele35_WPLoose_Gsf',
-        # Dilepton paths
-        'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL',
-        'Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL',
-        'Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ', 'Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ',
-        'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
-        # Cross-triggers
-        'Ele27_eta2p1_WPLoose_Gsf_HT200'
-    ]
+from Analysis.PECTuples.Utils_cff import get_trigger_names
+triggerNames = get_trigger_names(options.period)
 
 if runOnData:
     process.pecTrigger = cms.EDFilter('SlimTriggerResults',
         triggers = cms.vstring(triggerNames),
         filter = cms.bool(not options.disableTriggerFilter),
         savePrescales = cms.bool(True),
+        prescalesPerLumi = cms.bool(options.prescalesPerLumi),
+        packBits = cms.bool(options.packTriggerBits),
+        saveCounters = cms.bool(True),
+        saveEventID = cms.bool(options.deterministicOrder),
         triggerBits = cms.InputTag('TriggerResults', processName=options.triggerProcessName),
         hltPrescales = cms.InputTag('patTrigger'),
         l1tPrescales = cms.InputTag('patTrigger', 'l1min')
@@ -397,6 +612,9 @@ else:
         triggers = cms.vstring(triggerNames),
         filter = cms.bool(not options.disableTriggerFilter),
         savePrescales = cms.bool(False),
+        packBits = cms.bool(options.packTriggerBits),
+        saveCounters = cms.bool(True),
+        saveEventID = cms.bool(options.deterministicOrder),
         triggerBits = cms.InputTag('TriggerResults', processName=options.triggerProcessName)
     )
 
@@ -412,21 +630,29 @@ if not runOnData and options.period in ['2016', '2017']:
         DataEra = '2016BtoH' if options.period == '2016' else '2017BtoF',
         SkipWarnings = False
     )
-    process.eventWeights = cms.EDAnalyzer('EventWeights',
-        sources = cms.VInputTag(
-            'prefiringWeight:nonPrefiringProb',
-            'prefiringWeight:nonPrefiringProbUp',
-            'prefiringWeight:nonPrefiringProbDown'
-        ),
-        storeNames = cms.vstring(
-            'prefiring_nominal', 'prefiring_up', 'prefiring_down'
-        )
-    )
-    paths.append(process.prefiringWeight, process.eventWeights)
+    paths.append(process.prefiringWeight)
+    prefiringWeightBranches = [
+        ('prefiring_nominal', 'Double', 'prefiringWeight:nonPrefiringProb'),
+        ('prefiring_up', 'Double', 'prefiringWeight:nonPrefiringProbUp'),
+        ('prefiring_down', 'Double', 'prefiringWeight:nonPrefiringProbDown')
+    ]
 
+    # In the single-tree mode the weights are stored by the common writer
+    # defined below.  This is also done with option deterministicOrder,
+    # so that they are reordered together with other PEC objects.
+    if not options.singleTree and not options.deterministicOrder:
+        process.eventWeights = cms.EDAnalyzer('EventWeights',
+            sources = cms.VInputTag(
+                'prefiringWeight:nonPrefiringProb',
+                'prefiringWeight:nonPrefiringProbUp',
+                'prefiringWeight:nonPrefiringProbDown'
+            ),
+            storeNames = cms.vstring(
+                'prefiring_nominal', 'prefiring_up', 'prefiring_down'
+            )
+        )
+        paths.append(process.eventWeights)
 
-# Save event ID and basic event content
-process.pecEventID = cms.EDAnalyzer('PECEventID')
 
 effAreasTemplate = 'RecoEgamma/ElectronIdentification/data/{}/effAreaElectrons_cone03_pfNeuHadronsAndPhotons_{}.txt'
 
@@ -437,75 +663,284 @@ elif options.period == '2016':
 else:
     effAreas = ''
 
-process.pecElectrons = cms.EDAnalyzer('PECElectrons',
+# Conversion of objects into PEC format is done by stream and global
+# producers, which are run unscheduled.  The resulting collections are
+# then saved by (lightweight) PECWriter modules.  Descriptions of the
+# output trees are collected in the list below, and the writers are
+# created at the end of the configuration.  Each entry consists of the
+# label of the writer, the name and title of the tree, and the list of
+# branches.
+from Analysis.PECTuples.Utils_cff import make_pec_writer
+pecTrees = []
+
+
+# Save event ID and basic event content
+process.pecEventIDProducer = cms.EDProducer('PECEventID')
+pecTrees.append((
+    'pecEventID', 'EventID', 'Event ID',
+    [
+        ('eventId', 'CompactEventID' if options.compactEventID else 'EventID',
+            'pecEventIDProducer'),
+        ('channelDecisions', 'UInt', 'channelPreselection', channelNames)
+    ]
+))
+
+process.pecElectronsProducer = cms.EDProducer('PECElectrons',
     src = cms.InputTag('analysisPatElectrons'),
-    rho = cms.InputTag('fixedGridRhoFastjetAll'),
+    recoContext = cms.InputTag('recoContext'),
     effAreas = cms.FileInPath(effAreas),
-    primaryVertices = cms.InputTag('offlineSlimmedPrimaryVertices'),
     embeddedBoolIDs = cms.vstring(ele_embedded_cut_based_id_labels),
     boolIDMaps = cms.VInputTag(ele_cut_based_id_maps),
     embeddedContIDs = cms.vstring(ele_embedded_mva_id_labels),
     contIDMaps = cms.VInputTag(ele_mva_id_maps),
+    separateContIDs = cms.bool(options.separateContIDs),
+    contIDBits = cms.uint32(options.contIDBits),
     selection = ele_quality_cuts
 )
-
-process.pecMuons = cms.EDAnalyzer('PECMuons',
+pecTrees.append((
+    'pecElectrons', 'Electrons', 'Properties of selected electrons',
+    [(
+        'electrons', 'Electrons', 'pecElectronsProducer',
+        ['passIPCuts'] + list(ele_quality_cuts)
+    )] + ([(
+        'electronContIDs', 'UShorts' if options.contIDBits > 0 else 'Floats',
+        'pecElectronsProducer:contIDs',
+        list(ele_embedded_mva_id_labels) + [
+            t.getProductInstanceLabel() or t.getModuleLabel() for t in ele_mva_id_maps
+        ],
+        options.contIDBits
+    )] if options.separateContIDs else [])
+))
+
+process.pecMuonsProducer = cms.EDProducer('PECMuons',
     src = cms.InputTag('analysisPatMuons'),
     selection = muQualityCuts,
-    primaryVertices = cms.InputTag('offlineSlimmedPrimaryVertices')
+    recoContext = cms.InputTag('recoContext')
 )
-
-process.pecJetMET = cms.EDAnalyzer('PECJetMET',
+pecTrees.append((
+    'pecMuons', 'Muons', 'Properties of selected muons',
+    [(
+        'muons', 'Muons', 'pecMuonsProducer',
+        ['isLooseMuon', 'isMediumMuon', 'isTightMuon'] + list(muQualityCuts)
+    )]
+))
+
+process.pecJetMETProducer = cms.EDProducer('PECJetMET',
     runOnData = cms.bool(runOnData),
     jets = cms.InputTag('analysisPatJets'),
+    jercMaps = cms.string('analysisPatJets'),
     jetSelection = jetQualityCuts,
-    jetIDVersion = cms.string(options.period),
-    met = metTag
+    jetID = get_pf_jet_id(options.period),
+    computePullAngle = cms.bool(options.saveJetPull),
+    met = metTag,
+    compactMET = cms.bool(options.compactMET)
     # metCorrToUndo = cms.VInputTag(cms.InputTag('patPFMetT1T2Corr', 'type1'))
 )
+pecTrees.append((
+    'pecJetMET', 'JetMET', 'Properties of reconstructed jets and MET',
+    [
+        (
+            'jets', 'Jets', 'pecJetMETProducer',
+            ['hasGenMatch', 'passPFID'] + list(jetQualityCuts)
+        ),
+        ('METSignificance', 'Float', 'pecJetMETProducer:METSignificance')
+    ] + (
+        [('MET', 'MET', 'pecJetMETProducer:MET')] if options.compactMET else [
+            ('METs', 'Candidates', 'pecJetMETProducer:METs'),
+            ('uncorrMETs', 'Candidates', 'pecJetMETProducer:uncorrMETs')
+        ]
+    )
+))
 
-process.pecPileUp = cms.EDAnalyzer('PECPileUp',
-    primaryVertices = cms.InputTag('goodOfflinePrimaryVertices'),
-    rho = cms.InputTag('fixedGridRhoFastjetAll'),
-    rhoCentral = cms.InputTag('fixedGridRhoFastjetCentral'),
+if options.jecUncSources:
+    process.pecJetMETProducer.jecUncertaintySources = cms.FileInPath(options.jecUncSources)
+    process.jecUncertaintyTables = cms.EDAnalyzer('JECUncertaintyTables',
+        jecUncertaintySources = cms.FileInPath(options.jecUncSources)
+    )
+    paths.append(process.jecUncertaintyTables)
+
+process.pecPileUpProducer = cms.EDProducer('PECPileUp',
+    recoContext = cms.InputTag('recoContext'),
     runOnData = cms.bool(runOnData),
     puInfo = cms.InputTag('slimmedAddPileupInfo')
 )
 
-paths.append(process.pecEventID, process.pecElectrons, process.pecMuons, process.pecJetMET,
-    process.pecPileUp)
+if options.puProfiles and not runOnData:
+    if options.period == '2016':
+        from SimGeneral.MixingModule.mix_2016_25ns_Moriond17MC_PoissonOOTPU_cfi import mix
+    else:
+        from SimGeneral.MixingModule.mix_2017_25ns_WinterMC_PUScenarioV1_PoissonOOTPU_cfi \
+            import mix
+
+    process.pecPileUpProducer.weights = cms.PSet(
+        dataProfiles = cms.vstring(options.puProfiles.split(',')),
+        mcProfile = mix.input.nbPileupEvents.probValue
+    )
+
+pecTrees.append((
+    'pecPileUp', 'PileUp', 'Information about pile-up',
+    [('puInfo', 'PileUpInfo', 'pecPileUpProducer')]
+))
+
+process.analysisTask.add(
+    process.pecEventIDProducer, process.pecElectronsProducer, process.pecMuonsProducer,
+    process.pecJetMETProducer, process.pecPileUpProducer
+)
 
 
 # Save global generator information
 if not runOnData:
-    process.pecGenerator = cms.EDAnalyzer('PECGenerator',
-        generator = cms.InputTag('generator'),
+    process.pecGeneratorProducer = cms.EDProducer('PECGenerator',
+        generatorContext = cms.InputTag('generatorContext'),
         saveAltLHEWeights = alt_lhe_weight_indices,
-        lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
+        altLHEWeightRatioRange = cms.vdouble(-2., 4.) if options.quantizeAltLHEWeights \
+            else cms.vdouble(),
         saveAltPSWeights = alt_ps_weight_indices
     )
-    paths.append(process.pecGenerator)
-
-
-# Save information about the hard interaction and selected particles
-if not runOnData and options.saveGenParticles:
-    process.pecGenParticles = cms.EDAnalyzer('PECGenParticles',
+    pecTrees.append((
+        'pecGenerator', 'Generator', 'Global generator-level properties',
+        [('generator', 'GeneratorInfo', 'pecGeneratorProducer')]
+    ))
+    process.analysisTask.add(process.pecGeneratorProducer)
+
+
+# Save information about the hard interaction and selected particles.
+# The full pruned record of particles is stored in a separate tree if
+# requested.
+if not runOnData and (options.saveGenParticles or options.saveGenParticleRecord):
+    process.pecGenParticlesProducer = cms.EDProducer('PECGenParticles',
         genParticles = cms.InputTag('prunedGenParticles'),
-        saveExtraParticles = cms.vuint32(6, 23, 24, 25)
+        saveExtraParticles = cms.vuint32(6, 23, 24, 25),
+        saveFullRecord = cms.bool(options.saveGenParticleRecord)
     )
-    paths.append(process.pecGenParticles)
+    process.analysisTask.add(process.pecGenParticlesProducer)
+
+    if options.saveGenParticles:
+        pecTrees.append((
+            'pecGenParticles', 'HardInteraction',
+            'Tree contrains generator-level particles from the hard interaction',
+            [('particles', 'GenParticles', 'pecGenParticlesProducer')]
+        ))
+
+    if options.saveGenParticleRecord:
+        pecTrees.append((
+            'pecGenParticleRecord', 'GenParticleRecord',
+            'Full record of generator-level particles in a compact form',
+            [('genRecord', 'GenParticleRecord', 'pecGenParticlesProducer:fullRecord')]
+        ))
 
 
 # Save information on generator-level jets and MET
 if not runOnData and options.saveGenJets:
-    process.pecGenJetMET = cms.EDAnalyzer('PECGenJetMET',
+    process.pecGenJetMETProducer = cms.EDProducer('PECGenJetMET',
         jets = cms.InputTag('slimmedGenJets'),
         cut = cms.string('pt > 8.'),
         # ^The pt cut above is the same as in JME-13-005
         saveFlavourCounters = cms.bool(True),
-        met = metTag
+        met = metTag,
+        compactMET = cms.bool(options.compactMET)
     )
-    paths.append(process.pecGenJetMET)
+    # In case of a single tree, names of the branches are changed in
+    # order not to clash with reconstructed jets and MET
+    pecTrees.append((
+        'pecGenJetMET', 'GenJetMET', 'Properties of generator-level jets and generator-level MET',
+        [
+            ('genJets' if options.singleTree or options.quickLook else 'jets', 'GenJets',
+                'pecGenJetMETProducer'),
+            ('genMET', 'MET', 'pecGenJetMETProducer:MET') if options.compactMET else
+            ('genMETs' if options.singleTree or options.quickLook else 'METs', 'Candidates',
+                'pecGenJetMETProducer:METs')
+        ]
+    ))
+    process.analysisTask.add(process.pecGenJetMETProducer)
+
+
+# Create writers for PEC objects.  They are placed after all filters, so
+# every writer is run for exactly the same set of events, and entries in
+# different trees are aligned.  The same holds for the tree with trigger
+# decisions (pecTrigger/TriggerInfo), which is filled only for events
+# accepted by all filters; it can be used as a friend tree of any of them.
+# In the single-tree mode all PEC objects, including the pre-firing
+# weights, are stored in the tree pecEvents/Events.  With option
+# deterministicOrder, the writers buffer selected events of each
+# luminosity section, up to the given limit, and write them sorted.  The
+# pre-firing weights are then written by a writer as well, in the tree
+# eventWeights/EventWeights with the same branches.  The tree
+# pecTrigger/TriggerInfo is not reordered and is therefore not aligned
+# with the other trees; it stores event IDs instead, by which it must be
+# matched.  In the quick-look mode, all PEC objects are read by a
+# single module that fills histograms instead.
+reorderBufferSize = 100000 if options.deterministicOrder else 0
+
+if options.quickLook:
+    from Analysis.PECTuples.Utils_cff import make_pec_histograms
+    quickLookHistograms = [
+        ('NumJets', 'n_jets', (20, 0., 20.)),
+        ('JetPt', 'jets_pt', (100, 0., 500.)),
+        ('JetEta', 'jets_eta', (50, -5., 5.)),
+        ('JetEtaPhi', 'jets_eta', (50, -5., 5.), 'jets_phi', (64, -3.2, 3.2)),
+        ('NumElectrons', 'n_electrons', (5, 0., 5.)),
+        ('ElectronPt', 'electrons_pt', (100, 0., 500.)),
+        ('ElectronEta', 'electrons_eta', (50, -2.5, 2.5)),
+        ('NumMuons', 'n_muons', (5, 0., 5.)),
+        ('MuonPt', 'muons_pt', (100, 0., 500.)),
+        ('MuonEta', 'muons_eta', (48, -2.4, 2.4)),
+        ('METSignificance', 'METSignificance', (50, 0., 50.))
+    ]
+
+    # The nominal MET is the first element of collection METs unless the
+    # compact layout is used
+    quickLookHistograms.append(
+        ('MET', 'MET_pt' if options.compactMET else 'METs[0]_pt', (100, 0., 500.))
+    )
+
+    allBranches = []
+
+    for label, treeName, treeTitle, branches in pecTrees:
+        allBranches.extend(branches)
+
+    process.pecHistograms = make_pec_histograms(
+        allBranches, quickLookHistograms,
+        generator=('pecGeneratorProducer' if hasattr(process, 'pecGeneratorProducer') else None),
+        weights=(
+            ['prefiringWeight:nonPrefiringProb'] if hasattr(process, 'prefiringWeight') else []
+        )
+    )
+    paths.append(process.pecHistograms)
+elif options.singleTree:
+    allBranches = []
+
+    for label, treeName, treeTitle, branches in pecTrees:
+        allBranches.extend(branches)
+
+    if hasattr(process, 'prefiringWeight'):
+        allBranches.extend(prefiringWeightBranches)
+
+    process.pecEvents = make_pec_writer(
+        'Events', 'PEC objects', allBranches, flat=options.flatTrees,
+        reorder_buffer_size=reorderBufferSize,
+        save_lumi_ranges=(options.lumiClusters or options.compactEventID)
+    )
+    paths.append(process.pecEvents)
+else:
+    if options.deterministicOrder and hasattr(process, 'prefiringWeight'):
+        pecTrees.append((
+            'eventWeights', 'EventWeights', 'Event weights', prefiringWeightBranches
+        ))
+
+    for label, treeName, treeTitle, branches in pecTrees:
+        writer = make_pec_writer(
+            treeName, treeTitle, branches, flat=options.flatTrees,
+            reorder_buffer_size=reorderBufferSize,
+            save_lumi_ranges=(
+                (options.lumiClusters or options.compactEventID) and label == 'pecEventID'
+            )
+        )
+        setattr(process, label, writer)
+        paths.append(writer)
+
+if options.filterOrder:
+    paths.reorder(options.filterOrder.split(','))
 
 
 # Associate with the paths the analysis-specific task and the task
@@ -516,12 +951,67 @@ from PhysicsTools.PatAlgos.tools.helpers import getPatAlgosToolsTask
 paths.associate(getPatAlgosToolsTask(process))
 
 
-# If one of possible channels has not been requested by the user, clear
-# the corresponding path
-if not elChan:
-    process.elPath = cms.Path()
-if not muChan:
-    process.muPath = cms.Path()
+# I/O settings for all output trees.  LZ4 is fast and suits
+# intermediate skims, while LZMA (or ZSTD, where available) gives
+# smaller final tuples.
+# The AutoFlush setting given in bytes (negative value) gives clusters
+# of a similar size in bytes, which therefore contain different numbers
+# of entries in different trees.  With implicit multithreading, baskets
+# of all branches of a tree are compressed in parallel when the tree is
+# flushed at the end of each cluster.  With option lumiClusters,
+# clusters are also closed at the ends of luminosity sections, provided
+# that they contain at least the given number of entries, and AutoFlush
+# is given as a number of entries common to all trees.  Since all
+# decisions then depend only on the number of entries, aligned trees get
+# the same clusters.  This requires ROOT 6.14 or later and that
+# luminosity sections are processed one at a time.
+compressionLevels = {'ZLIB': 4, 'LZMA': 9, 'LZ4': 4, 'ZSTD': 5}
+
+if options.compression:
+    if ':' in options.compression:
+        compressionAlgorithm, compressionLevel = options.compression.split(':')
+        compressionLevel = int(compressionLevel)
+    else:
+        compressionAlgorithm = options.compression
+        compressionLevel = compressionLevels.get(compressionAlgorithm, 4)
+else:
+    compressionAlgorithm, compressionLevel = '', 4
+
+from Analysis.PECTuples.Utils_cff import apply_tree_settings
+apply_tree_settings(process, cms.PSet(
+    compressionAlgorithm = cms.string(compressionAlgorithm),
+    compressionLevel = cms.int32(compressionLevel),
+    basketSize = cms.int32(32000),
+    autoFlush = cms.int64(10000 if options.lumiClusters else -30000000),
+    implicitMT = cms.bool(options.rootIMT),
+    lumiClusters = cms.bool(options.lumiClusters),
+    minClusterEntries = cms.uint32(1000)
+))
+
+if options.lumiClusters or options.compactEventID:
+    process.options.numberOfConcurrentLuminosityBlocks = cms.untracked.uint32(1)
+
+if options.rootIMT:
+    process.InitRootHandlers = cms.Service('InitRootHandlers',
+        EnableIMT = cms.untracked.bool(True)
+    )
+
+
+# Restrict products read from the input to the ones consumed.  This must
+# be done after all modules have been defined.  Products listed
+# explicitly are consumed through default values of parameters of PEC
+# plugins, which are not visible in the configuration.  Flavour counters
+# of generator-level jets are evaluated from their constituents, which
+# are stored in a collection not referred to in the configuration.
+if options.pruneInput:
+    from Analysis.PECTuples.Utils_cff import prune_input
+    extraKeep = ['TriggerResults', 'patTrigger', 'slimmedPatTrigger']
+    
+    if hasattr(process, 'pecGenJetMETProducer') and \
+        process.pecGenJetMETProducer.saveFlavourCounters.value():
+        extraKeep.append('packedGenParticles')
+    
+    prune_input(process, extra_keep=extraKeep, verbose=True)
 
 
 # The output file for the analyzers
@@ -534,3 +1024,16 @@ else:
 
 process.TFileService = cms.Service('TFileService',
     fileName = cms.string(outputBaseName + postfix + '.root'))
+
+
+# Performance counters.  They are written into the same output file.
+if options.savePerf or options.filterOrder:
+    process.PerfMonitor = cms.Service('PerfMonitor')
+
+
+# Provenance of the output file.  The hash of the configuration is
+# computed from all other modules and services, so this must be done
+# last.
+if options.saveProvenance:
+    from Analysis.PECTuples.Utils_cff import add_provenance_writer
+    add_provenance_writer(process, paths)
@@ -268,7 +268,12 @@ def define_jets(process, task, reapplyJEC=False, runOnData=False):
     
     Create the following jet collections:
         analysisPatJets: Jets with up-to-date JEC and a loose quality
-            selection to be used in an analysis.
+            selection to be used in an analysis.  It is a PtrVector
+            accompanied by value maps with JEC uncertainties and JER
+            factors.
+    
+    The jet selector reads rho from module recoContext of type
+    RecoContextProducer, which must be defined in the process.
     """
     
     # Reapply JEC [1] if requested.  The corrections are read from the
@@ -302,7 +307,8 @@ def define_jets(process, task, reapplyJEC=False, runOnData=False):
         minPt = cms.double(15.),
         includeJERCVariations = cms.bool(not runOnData),
         genJets = cms.InputTag('slimmedGenJets'),
-        rho = cms.InputTag('fixedGridRhoFastjetAll')
+        recoContext = cms.InputTag('recoContext'),
+        lightOutput = cms.bool(True)
     )
     
     
@@ -317,6 +323,52 @@ def define_jets(process, task, reapplyJEC=False, runOnData=False):
     return recorrectedJetsLabel, jetQualityCuts
 
 
+def get_pf_jet_id(period):
+    """Construct definition of PF jet ID for given period.
+    
+    The definition is a table of regions in |eta| with cuts on energy
+    fractions and multiplicities, in the format expected by the C++
+    class PFJetID.  Both for 2016 and 2017 the tight working point is
+    used, with the lepton veto in case of 2017 [1-3].
+    [1] https://twiki.cern.ch/twiki/bin/view/CMS/JetID13TeVRun2016?rev=1
+    [2] https://twiki.cern.ch/twiki/bin/view/CMS/JetID13TeVRun2017?rev=6
+    [3] https://hypernews.cern.ch/HyperNews/CMS/get/jet-algorithms/462/3/1.html
+    
+    Arguments:
+        period: Data-taking period, '2016' or '2017'.
+    
+    Return value:
+        VPSet with the definition of the jet ID.
+    """
+    
+    # Upper boundary for the last region, which must cover all jets
+    maxAbsEta = 10.
+    
+    if period == '2016':
+        commonCuts = ['NHF < 0.99', 'NEF < 0.99', 'NumConst > 1']
+        regions = [
+            (2.4, commonCuts + ['CHF > 0', 'CHM > 0', 'CEF < 0.99']),
+            (2.7, commonCuts),
+            (3., ['NM > 2', 'NHF < 0.98', 'NEF > 0.01']),
+            (maxAbsEta, ['NM > 10', 'NEF < 0.9'])
+        ]
+    elif period == '2017':
+        commonCuts = ['NHF < 0.9', 'NEF < 0.9', 'MUF < 0.8', 'NumDaughters > 1']
+        regions = [
+            (2.4, commonCuts + ['CHF > 0', 'CHM > 0', 'CEF < 0.8']),
+            (2.7, commonCuts),
+            (3., ['NM > 2', 'NEF < 0.99', 'NEF > 0.02']),
+            (maxAbsEta, ['NM > 10', 'NEF < 0.9', 'NHF > 0.02'])
+        ]
+    else:
+        raise RuntimeError('Jet ID for period "{}" is not defined.'.format(period))
+    
+    return cms.VPSet(
+        [cms.PSet(maxAbsEta = cms.double(eta), cuts = cms.vstring(cuts))
+         for eta, cuts in regions]
+    )
+
+
 def define_METs(process, task, runOnData=False):
     """Define reconstructed MET.
     
@@ -0,0 +1,193 @@
+"""Configuration for cmsRun to select events for the main configuration.
+
+This is a fast pre-pass over MiniAOD, intended for selections that reject
+the vast majority of events.  It only evaluates the trigger selection and
+a loose requirement on the presence of a charged lepton, both of which
+are looser than or equal to the ones applied in the main configuration
+MiniAOD_cfg.py.  No energy corrections, identification, or jet
+reconstruction are run.  IDs of selected events are saved in a ROOT file
+in the format read by plugin EventIDFilter (tree "EventID").
+
+The resulting file is then given to the main configuration with option
+eventList.  It keeps only the listed events and restricts the input to
+luminosity sections that contain them, so that the expensive processing
+is run over a small fraction of the input and can be repeated cheaply,
+e.g. when calibrations change.
+
+For simulation, an event counter is run before any selection, as in the
+main configuration.  Its per-luminosity-block summaries (tree
+"eventCounter/LumiSummaries" in the output file) include all generated
+events and should be used for normalization, since the event counter in
+the main configuration is only run over the listed events.
+
+Behaviour can be controlled using a number of command-line options (see
+their list in the code below).
+"""
+
+import FWCore.ParameterSet.Config as cms
+
+
+# Create a process
+process = cms.Process('SkimPrepass')
+
+
+# Enable MessageLogger and reduce its verbosity
+process.load('FWCore.MessageLogger.MessageLogger_cfi')
+process.MessageLogger.cerr.FwkReport.reportEvery = 10000
+
+
+# Ask to print a summary in the log
+process.options = cms.untracked.PSet(
+    wantSummary = cms.untracked.bool(True)
+)
+
+
+# Parse command-line options.  In addition to the options defined below,
+# use several standard ones: inputFiles, outputFile, maxEvents.  The
+# meaning of the options is the same as in MiniAOD_cfg.py.
+from FWCore.ParameterSet.VarParsing import VarParsing
+options = VarParsing('analysis')
+
+options.register(
+    'channels', 'em', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Leptonic channels to process'
+)
+options.register(
+    'period', '2017', VarParsing.multiplicity.singleton, VarParsing.varType.string,
+    'Data-taking period'
+)
+options.register(
+    'disableTriggerFilter', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Switch off filtering on selected triggers'
+)
+options.register(
+    'triggerProcessName', 'HLT', VarParsing.multiplicity.singleton,
+    VarParsing.varType.string, 'Name of the process that evaluated trigger decisions'
+)
+options.register(
+    'runOnData', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Indicates whether the job processes data or simulation'
+)
+options.register(
+    'saveAltLHEWeights', False, VarParsing.multiplicity.singleton, VarParsing.varType.bool,
+    'Save alternative LHE-level event weights'
+)
+options.register(
+    'labelLHEEventProduct', 'externalLHEProducer', VarParsing.multiplicity.singleton,
+    VarParsing.varType.string, 'Label of the LHEEventProduct'
+)
+options.register(
+    'numThreads', 1, VarParsing.multiplicity.singleton, VarParsing.varType.int,
+    'Number of threads (and streams) to use'
+)
+
+# Override defaults for automatically defined options
+options.setType('outputFile', VarParsing.varType.string)
+options.setDefault('outputFile', 'eventList.root')
+
+options.parseArguments()
+
+
+if options.numThreads > 1:
+    process.options.numberOfThreads = cms.untracked.uint32(options.numThreads)
+    process.options.numberOfStreams = cms.untracked.uint32(0)
+
+
+# Specify the input files
+if len(options.inputFiles) == 0:
+    raise RuntimeError('No input file is provided')
+
+process.source = cms.Source('PoolSource',
+    fileNames = cms.untracked.vstring(options.inputFiles)
+)
+
+process.maxEvents = cms.untracked.PSet(input = cms.untracked.int32(options.maxEvents))
+
+
+# Create the processing path
+process.prepassPath = cms.Path()
+process.prepassTask = cms.Task()
+
+
+# Count events in simulation before any selection is applied.  The setup
+# of the event counter and alternative weights to be saved is the same as
+# in the main configuration, so that lumi summaries from the two are
+# interchangeable.
+if not options.runOnData:
+    process.generatorContext = cms.EDProducer('GeneratorContextProducer',
+        generator = cms.InputTag('generator'),
+        lheEventProduct = cms.InputTag(options.labelLHEEventProduct),
+        computeAltLHEWeights = cms.bool(options.saveAltLHEWeights)
+    )
+    process.prepassTask.add(process.generatorContext)
+
+    process.eventCounter = cms.EDAnalyzer('EventCounter',
+        generatorContext = cms.InputTag('generatorContext'),
+        saveAltLHEWeights = cms.vint32(1, 8) if options.saveAltLHEWeights else cms.vint32(),
+        saveAltPSWeights = cms.vint32(6, 9),
+        puInfo = cms.InputTag('slimmedAddPileupInfo'),
+        saveLumiSummaries = cms.bool(True)
+    )
+    process.prepassPath += process.eventCounter
+
+
+# Selection on triggers.  The list of triggers is the same as in the main
+# configuration.  Their decisions are also stored in the output file,
+# which is convenient for cross-checks.
+from Analysis.PECTuples.Utils_cff import get_trigger_names
+
+process.pecTrigger = cms.EDFilter('SlimTriggerResults',
+    triggers = cms.vstring(get_trigger_names(options.period)),
+    filter = cms.bool(not options.disableTriggerFilter),
+    savePrescales = cms.bool(False),
+    packBits = cms.bool(True),
+    triggerBits = cms.InputTag('TriggerResults', processName=options.triggerProcessName)
+)
+process.prepassPath += process.pecTrigger
+
+
+# Loose selection on leptons.  Only kinematic cuts are applied, and
+# they are looser than in collections patElectronsForEventSelection and
+# patMuonsForEventSelection (see ObjectsDefinitions_cff.py) to allow for
+# energy corrections applied in the main configuration, which can
+# increase the transverse momentum of a lepton.
+channelSelections = []
+
+if 'e' in options.channels:
+    process.prepassElectrons = cms.EDFilter('PATElectronSelector',
+        src = cms.InputTag('slimmedElectrons'),
+        cut = cms.string('pt > 20. & (abs(eta) < 2.5 | abs(superCluster.eta) < 2.5)')
+    )
+    process.prepassTask.add(process.prepassElectrons)
+    channelSelections.append(cms.PSet(
+        leptons = cms.InputTag('prepassElectrons')
+    ))
+
+if 'm' in options.channels:
+    process.prepassMuons = cms.EDFilter('PATMuonSelector',
+        src = cms.InputTag('slimmedMuons'),
+        cut = cms.string('pt > 18. & abs(eta) < 2.5')
+    )
+    process.prepassTask.add(process.prepassMuons)
+    channelSelections.append(cms.PSet(
+        leptons = cms.InputTag('prepassMuons')
+    ))
+
+process.channelPreselection = cms.EDFilter('ChannelPreselection',
+    channels = cms.VPSet(*channelSelections)
+)
+process.prepassPath += process.channelPreselection
+
+
+# Save IDs of selected events
+process.eventListWriter = cms.EDAnalyzer('EventListWriter')
+process.prepassPath += process.eventListWriter
+
+process.prepassPath.associate(process.prepassTask)
+
+
+# The output file.  Contrary to the main configuration, no random
+# postfix is added, so that the file can be referred to directly.
+process.TFileService = cms.Service('TFileService',
+    fileName = cms.string(options.outputFile)
+)
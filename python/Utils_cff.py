@@ -1,18 +1,32 @@
 """Utility classes and functions used in the main configuration."""
 
 from __future__ import print_function
+import hashlib
+import os
 import re
+import subprocess
 
 import FWCore.ParameterSet.Config as cms
 
 
 class PathManager:
-    """A class to work with multiple CMS paths simultaneuosly."""
+    """A class to work with multiple CMS paths simultaneuosly.
+    
+    Modules appended to the paths can be marked as reorderable.  These
+    are filters that only make a decision and have no other side
+    effects, so that they can be run in any order allowed by the data
+    dependencies between them.  Method reorder chooses the order based
+    on measured costs and rejection rates.
+    """
     
     def __init__(self, *paths):
         """Construct from an arbitrary number of cms.Path."""
         
         self.paths = list(paths)
+        
+        # All appended modules in their order, with flags showing
+        # whether they can be reordered
+        self.modules = []
     
     
     def associate(self, *tasks):
@@ -22,12 +36,144 @@ class PathManager:
             p.associate(*tasks)
     
     
-    def append(self, *modules):
-        """Append one or more modules to each path."""
+    def append(self, *modules, **kwargs):
+        """Append one or more modules to each path.
+        
+        If keyword argument reorderable is set to True, the modules are
+        marked as reorderable filters.
+        """
+        
+        reorderable = kwargs.get('reorderable', False)
         
         for p in self.paths:
             for m in modules:
                 p += m
+        
+        for m in modules:
+            self.modules.append((m, reorderable))
+    
+    
+    def reorder(self, calibrationFiles, verbose=True):
+        """Reorder filters based on measurements in calibration files.
+        
+        The calibration files are produced by service PerfMonitor with
+        the original order of modules.  For each reorderable filter,
+        they give its mean time per event, c, and the fraction of
+        visited events that it rejects, r.  Within each contiguous group
+        of reorderable filters, the filters are sorted in the order of
+        increasing c / r, which minimizes the expected time when the
+        decisions are independent.  A filter is never moved before a
+        module on the same path whose products it consumes, directly or
+        through unscheduled producers.  Filters for which there are no
+        measurements are kept at their positions and split the groups.
+        
+        Arguments:
+            calibrationFiles: List of ROOT files with directory Perf
+                written by PerfMonitor.
+            verbose: Flag that controls print-out of the new order.
+        
+        Return value:
+            None.
+        
+        This method must be called after all modules have been appended.
+        """
+        
+        import ROOT
+        
+        # Aggregate measurements from all files, combining all paths
+        numEvents, realTime, numRejected, dependencies = {}, {}, {}, {}
+        
+        for fileName in calibrationFiles:
+            f = ROOT.TFile(fileName)
+            modulesTree = f.Get('Perf/Modules')
+            pathModulesTree = f.Get('Perf/PathModules')
+            
+            if not modulesTree or not pathModulesTree:
+                raise RuntimeError(
+                    'File "{}" does not contain counters of PerfMonitor.'.format(fileName)
+                )
+            
+            for entry in modulesTree:
+                label = str(entry.label)
+                numEvents[label] = numEvents.get(label, 0) + entry.events
+                realTime[label] = realTime.get(label, 0.) + entry.realTime
+            
+            for entry in pathModulesTree:
+                label = str(entry.label)
+                numRejected[label] = numRejected.get(label, 0) + entry.rejected
+                dependencies.setdefault(label, set()).update(str(d) for d in entry.dependencies)
+            
+            f.Close()
+        
+        
+        def rank(label):
+            if numRejected[label] == 0:
+                return float('inf')
+            
+            return realTime[label] / numRejected[label]
+        
+        
+        # Split the modules into groups of reorderable filters with
+        # measurements and reorder each group
+        newModules = []
+        group = []
+        
+        for m, reorderable in self.modules + [(None, False)]:
+            if m is not None and reorderable and numEvents.get(m.label_(), 0) > 0 and \
+                    m.label_() in numRejected:
+                group.append(m)
+                continue
+            
+            # A filter is ready when it does not depend on any filter
+            # of the group that has not been placed yet.  The original
+            # order is kept in case of circular dependencies.
+            remaining = list(group)
+            
+            while remaining:
+                remainingLabels = set(n.label_() for n in remaining)
+                ready = [
+                    n for n in remaining
+                    if not (dependencies[n.label_()] & (remainingLabels - {n.label_()}))
+                ]
+                
+                if not ready:
+                    ready = remaining[:1]
+                
+                chosen = min(ready, key=lambda n: rank(n.label_()))
+                remaining.remove(chosen)
+                newModules.append((chosen, True))
+            
+            group = []
+            
+            if m is not None:
+                newModules.append((m, reorderable))
+        
+        
+        # Rebuild the paths.  Associated tasks are not affected.
+        for p in self.paths:
+            for m, _ in self.modules:
+                p.remove(m)
+            
+            for m, _ in newModules:
+                p += m
+        
+        self.modules = newModules
+        
+        if verbose:
+            print('Modules on paths after reordering:')
+            
+            for m, reorderable in self.modules:
+                label = m.label_()
+                
+                if reorderable and label in numRejected:
+                    print(
+                        '  {} ({:.3g} ms per event, rejects {:.3g}% of visited events)'.format(
+                            label, 1e3 * realTime[label] / numEvents[label],
+                            1e2 * numRejected[label] / numEvents[label]
+                        )
+                    )
+                else:
+                    print('  ' + label)
 
 
 def add_jet_selection(selection, process, paths, runOnData, src='analysisPatJets', verbose=True):
@@ -58,6 +204,9 @@ def add_jet_selection(selection, process, paths, runOnData, src='analysisPatJets
     
     Return value:
         None.
+    
+    The jet selector reads rho from module recoContext of type
+    RecoContextProducer, which must be defined in the process.
     """
     
     if not selection:
@@ -124,10 +273,11 @@ def add_jet_selection(selection, process, paths, runOnData, src='analysisPatJets
             minPt = cms.double(minPt),
             includeJERCVariations = cms.bool(not runOnData),
             genJets = cms.InputTag('slimmedGenJets'),
-            rho = cms.InputTag('fixedGridRhoFastjetAll'),
-            minNum = cms.uint32(minNumJets)
+            recoContext = cms.InputTag('recoContext'),
+            minNum = cms.uint32(minNumJets),
+            lightOutput = cms.bool(True)
         )
-        paths.append(process.jetsForEventSelection)
+        paths.append(process.jetsForEventSelection, reorderable=True)
     
     
     # Selection based on b-tags
@@ -155,12 +305,151 @@ def add_jet_selection(selection, process, paths, runOnData, src='analysisPatJets
             minNumber = cms.uint32(minBTags), maxNumber = cms.uint32(9999)
         )
         
-        paths.append(process.countBTaggedJets)
+        paths.append(process.countBTaggedJets, reorderable=True)
         
         producers = cms.Task(process.bTaggedJetsForEventSelection)
         paths.associate(producers)
 
 
+def make_pec_writer(
+    tree_name, tree_title, branches, flat=False, reorder_buffer_size=0,
+    save_lumi_ranges=False
+):
+    """Construct a module to write PEC objects into a tree.
+    
+    The module is an instance of plugin PECWriter.  It copies products
+    created by PEC producers (such as PECJetMET) into the output tree.
+    The tree is placed in the directory named after the label under
+    which the module is added to the process.
+    
+    Arguments:
+        tree_name: Name for the output tree.
+        tree_title: Title for the output tree.
+        branches: Iterable with descriptions of branches.  Each element
+            is a tuple (name, type, src) or (name, type, src, idBits),
+            where name is the name of the branch, type is a label of
+            the type of the product as understood by PECWriter (e.g.
+            'Jets'), src is the input tag of the product, and idBits is
+            a list of names of ID flags of the stored objects (or of
+            bits of a mask stored with type 'UInt'), which are saved
+            in tree IDBits.  For types 'Floats' and 'UShorts', the
+            fourth element is instead a list of names of the values
+            stored for each object, which are saved in tree
+            ValueNames, and it can be followed by the number of bits
+            of the codes for the latter type.
+        flat: Indicates whether collections of PEC objects should be
+            stored using the flat columnar layout, with one branch per
+            property of the objects.  Event IDs, MET, and pile-up and
+            generator information are then also stored with one branch
+            per property.
+        reorder_buffer_size: Maximal number of events buffered in order
+            to write them sorted by event ID within each luminosity
+            section.  Zero disables the reordering.
+        save_lumi_ranges: Indicates whether ranges of entries for
+            luminosity sections should be saved in tree LumiRanges.
+    
+    Return value:
+        Configured module.
+    """
+    
+    branchPSets = []
+    
+    for branch in branches:
+        pset = cms.PSet(
+            name = cms.string(branch[0]),
+            type = cms.string(branch[1]),
+            src = cms.InputTag(branch[2])
+        )
+        
+        if branch[1] in ('Floats', 'UShorts'):
+            pset.valueNames = cms.vstring(branch[3] if len(branch) > 3 else [])
+            pset.quantizationBits = cms.uint32(branch[4] if len(branch) > 4 else 0)
+        else:
+            pset.idBitNames = cms.vstring(branch[3] if len(branch) > 3 else [])
+        
+        branchPSets.append(pset)
+    
+    return cms.EDAnalyzer('PECWriter',
+        treeName = cms.string(tree_name),
+        treeTitle = cms.string(tree_title),
+        flat = cms.bool(flat),
+        reorderBufferSize = cms.uint32(reorder_buffer_size),
+        saveLumiRanges = cms.bool(save_lumi_ranges),
+        branches = cms.VPSet(branchPSets)
+    )
+
+
+def make_pec_histograms(branches, histograms, generator=None, weights=[]):
+    """Construct a module to fill histograms of PEC objects.
+    
+    The module is an instance of plugin PECHistograms and can be used
+    instead of writers created with make_pec_writer for quick checks.
+    It reads the same products and fills histograms of their
+    properties, which are stored in the directory named after the
+    label of the module.
+    
+    Arguments:
+        branches: Descriptions of branches in the format understood by
+            make_pec_writer.  Branches of types not supported by
+            PECHistograms are skipped.
+        histograms: Iterable with descriptions of histograms.  Each
+            element is a tuple (name, x, binningX) or (name, x,
+            binningX, y, binningY), where name is the name of the
+            histogram, x and y are names of variables as understood by
+            PECHistograms (e.g. 'jets_pt' or 'n_jets'), and binnings
+            are tuples (numBins, min, max).
+        generator: Input tag of pec::GeneratorInfo that provides the
+            nominal event weight, or None.
+        weights: Input tags of additional event weights.
+    
+    Return value:
+        Configured module.
+    """
+    
+    supportedTypes = [
+        'Candidates', 'Electrons', 'Muons', 'Jets', 'GenParticles', 'GenJets', 'MET',
+        'UInt', 'Float', 'Double'
+    ]
+    histPSets = []
+    
+    for hist in histograms:
+        pset = cms.PSet(
+            name = cms.string(hist[0]),
+            x = cms.string(hist[1]),
+            binsX = cms.uint32(hist[2][0]),
+            minX = cms.double(hist[2][1]),
+            maxX = cms.double(hist[2][2])
+        )
+        
+        if len(hist) > 3:
+            pset.title = cms.string(';{};{}'.format(hist[1], hist[3]))
+            pset.y = cms.string(hist[3])
+            pset.binsY = cms.uint32(hist[4][0])
+            pset.minY = cms.double(hist[4][1])
+            pset.maxY = cms.double(hist[4][2])
+        else:
+            pset.title = cms.string(';{}'.format(hist[1]))
+        
+        histPSets.append(pset)
+    
+    module = cms.EDAnalyzer('PECHistograms',
+        branches = cms.VPSet([
+            cms.PSet(
+                name = cms.string(branch[0]),
+                type = cms.string(branch[1]),
+                src = cms.InputTag(branch[2])
+            ) for branch in branches if branch[1] in supportedTypes
+        ]),
+        histograms = cms.VPSet(histPSets),
+        weights = cms.VInputTag(weights)
+    )
+    
+    if generator is not None:
+        module.generator = cms.InputTag(generator)
+    
+    return module
+
+
 def get_task(process, taskName):
     """Find and return a task with the given name.
     
@@ -180,3 +469,410 @@ def get_task(process, taskName):
         task = getattr(process, taskName)
     
     return task
+
+
+def apply_tree_settings(process, settings):
+    """Set I/O parameters for all trees written in the process.
+    
+    The given settings are assigned to parameter treeSettings of every
+    module that writes a tree with the help of TFileService.  This
+    allows to choose the compression algorithm, basket size, AutoFlush
+    setting, and alignment of clusters with luminosity sections
+    consistently for the whole job.
+    
+    Arguments:
+        process: Process whose modules are to be updated.
+        settings: PSet with parameters understood by class
+            TreeSettings: compressionAlgorithm, compressionLevel,
+            basketSize, autoFlush, implicitMT, lumiClusters, and
+            minClusterEntries.
+    
+    Return value:
+        None.
+    """
+    
+    plugins = {
+        'EventCounter', 'EventFlags', 'EventWeights', 'LHEEventWeights',
+        'PECTriggerObjects', 'PECWriter', 'SlimTriggerResults'
+    }
+    modules = list(process.analyzers_().values()) + list(process.filters_().values())
+    
+    for module in modules:
+        if module.type_() in plugins:
+            module.treeSettings = settings.clone()
+
+
+def get_lumis_from_event_list(fileName):
+    """Construct list of luminosity sections containing given events.
+    
+    The events are read from a file in one of the formats understood by
+    plugin EventIDFilter: a text file with one ID "run:lumi:event" per
+    line, a ROOT file with tree "EventID", such as the one produced by
+    the pre-pass configuration SkimPrepass_cfg.py, or a binary file
+    with extension ".evl" (see class MappedEventList).  The
+    returned value is intended to be used as parameter lumisToProcess
+    of the source, so that luminosity sections (and thus clusters of
+    input files) that contain none of the listed events are skipped
+    completely.  Consecutive sections in a run are merged into ranges.
+    
+    Arguments:
+        fileName: Path to the file with event IDs.  If it is not
+            an existing file, it is looked up in directories listed in
+            environment variable CMSSW_SEARCH_PATH, as in FileInPath.
+    
+    Return value:
+        Untracked VLuminosityBlockRange.
+    """
+    
+    if not os.path.isfile(fileName):
+        for directory in os.environ.get('CMSSW_SEARCH_PATH', '').split(':'):
+            candidate = os.path.join(directory, fileName)
+            
+            if os.path.isfile(candidate):
+                fileName = candidate
+                break
+        else:
+            raise RuntimeError('Cannot find file "{}".'.format(fileName))
+    
+    lumis = set()
+    
+    if fileName.endswith('.evl'):
+        # Only the directory of the binary file needs to be read
+        import struct
+        
+        with open(fileName, 'rb') as f:
+            magic, numLumis = struct.unpack('<8sQ', f.read(16))
+            
+            if magic != b'PECEVL01':
+                raise RuntimeError('File "{}" is not a binary event list.'.format(fileName))
+            
+            for i in range(numLumis):
+                key = struct.unpack('<QQQQ', f.read(32))[0]
+                lumis.add((key >> 32, key & 0xFFFFFFFF))
+    elif fileName.endswith('.root'):
+        import ROOT
+        
+        eventListFile = ROOT.TFile.Open(fileName)
+        tree = eventListFile.Get('EventID')
+        
+        if not tree:
+            raise RuntimeError('File "{}" contains no tree "EventID".'.format(fileName))
+        
+        tree.SetBranchStatus('*', False)
+        tree.SetBranchStatus('run', True)
+        tree.SetBranchStatus('lumi', True)
+        
+        for entry in tree:
+            lumis.add((entry.run, entry.lumi))
+        
+        eventListFile.Close()
+    else:
+        with open(fileName) as f:
+            for line in f:
+                line = line.strip()
+                
+                if not line:
+                    break
+                
+                run, lumi, event = line.split(':')
+                lumis.add((int(run), int(lumi)))
+    
+    
+    # Merge consecutive luminosity sections
+    ranges = []
+    
+    for run, lumi in sorted(lumis):
+        if ranges and ranges[-1][0] == run and ranges[-1][2] == lumi - 1:
+            ranges[-1][2] = lumi
+        else:
+            ranges.append([run, lumi, lumi])
+    
+    return cms.untracked.VLuminosityBlockRange(
+        ['{0}:{1}-{0}:{2}'.format(*r) for r in ranges]
+    )
+
+
+def prune_input(process, extra_keep=[], verbose=False):
+    """Read from the input only the products consumed in the process.
+    
+    Parameters of all modules in the process are inspected recursively
+    (including nested PSets and VPSets), and values of type InputTag or
+    VInputTag are collected.  Tags that refer to modules defined in the
+    process (and not to an earlier process by an explicit process name)
+    are internal.  All other tags refer to products read from the input,
+    and only products with their module labels are kept in the source.
+    Drop commands already present in parameter inputCommands of the
+    source are preserved.  Since products in MiniAOD descend from RECO
+    products that are not stored, dropping of descendants is switched
+    off.
+    
+    Only tags given explicitly in the configuration are seen.  Products
+    consumed through defaults of parameters defined in fillDescriptions
+    or through non-tag parameters must be listed in extra_keep.  If a
+    module requires a product, its absence results in an exception in
+    the first event.  However, modules that consume a product optionally
+    (i.e. check whether the handle is valid after reading it) silently
+    lose the information instead.  Modules from CMSSW sometimes do this,
+    so with the verbose flag the labels of products that are present in
+    the first input file but dropped are printed as well.  This is only
+    done for local files, which can be inspected cheaply when the
+    configuration is loaded.
+    
+    Arguments:
+        process: Process whose source is to be updated.
+        extra_keep: Module labels of additional products to be kept.
+        verbose: Flag that controls print-out of the kept labels and of
+            products dropped from the first input file.
+    
+    Return value:
+        List of kept module labels.
+    """
+    
+    internalLabels = set(process.producers_()) | set(process.filters_()) | \
+        set(process.analyzers_()) | set(process.aliases_())
+    
+    if hasattr(process, 'switchProducers_'):
+        internalLabels |= set(process.switchProducers_())
+    
+    keptLabels = set(extra_keep)
+    
+    def add_tag(tag):
+        if isinstance(tag, str):
+            tag = cms.InputTag(tag)
+        
+        label = tag.getModuleLabel()
+        processName = tag.getProcessName()
+        
+        if not label:
+            return
+        
+        if label not in internalLabels or \
+                processName not in ('', process.name_(), '@currentProcess'):
+            keptLabels.add(label)
+    
+    def collect(pset):
+        for name in pset.parameterNames_():
+            value = getattr(pset, name)
+            
+            if isinstance(value, cms.InputTag):
+                add_tag(value)
+            elif isinstance(value, cms.VInputTag):
+                for tag in value:
+                    add_tag(tag)
+            elif isinstance(value, cms.PSet):
+                collect(value)
+            elif isinstance(value, cms.VPSet):
+                for p in value:
+                    collect(p)
+    
+    modules = list(process.producers_().values()) + list(process.filters_().values()) + \
+        list(process.analyzers_().values())
+    
+    for module in modules:
+        collect(module)
+    
+    
+    # Construct the new commands.  Drop commands given above are kept so
+    # that explicitly excluded products are still not read.
+    oldCommands = getattr(process.source, 'inputCommands', [])
+    commands = ['drop *'] + ['keep *_{}_*_*'.format(label) for label in sorted(keptLabels)]
+    commands += [c for c in oldCommands if c.strip().startswith('drop') and c.strip() != 'drop *']
+    
+    process.source.inputCommands = cms.untracked.vstring(commands)
+    process.source.dropDescendantsOfDroppedBranches = cms.untracked.bool(False)
+    
+    if verbose:
+        print('Products read from the input:', ', '.join(sorted(keptLabels)))
+        fileNames = getattr(process.source, 'fileNames', [])
+        
+        if fileNames:
+            droppedLabels = get_input_labels(fileNames[0])
+            
+            if droppedLabels is None:
+                print(
+                    'Products dropped from the input are not listed since file "{}" is not '
+                    'local.'.format(fileNames[0])
+                )
+            else:
+                droppedLabels -= keptLabels
+                print(
+                    'Products dropped from the input (check that they are not consumed '
+                    'optionally):', ', '.join(sorted(droppedLabels))
+                )
+    
+    return sorted(keptLabels)
+
+
+def get_input_labels(fileName):
+    """Find module labels of products stored in an EDM file.
+    
+    Branches of tree Events are named according to the convention
+    "type_label_instance_process.", and the labels are extracted from
+    these names.
+    
+    Arguments:
+        fileName: Name of the file as given to PoolSource.  Only local
+            files (with or without prefix "file:") are inspected.
+    
+    Return value:
+        Set of module labels, or None if the file is not local.
+    """
+    
+    if fileName.startswith('file:'):
+        fileName = fileName[len('file:'):]
+    
+    if not os.path.isfile(fileName):
+        return None
+    
+    import ROOT
+    inputFile = ROOT.TFile(fileName)
+    tree = inputFile.Get('Events')
+    labels = set()
+    
+    if tree:
+        for branch in tree.GetListOfBranches():
+            fields = branch.GetName().split('_')
+            
+            if len(fields) == 4:
+                labels.add(fields[1])
+    
+    inputFile.Close()
+    return labels
+
+
+def get_package_version():
+    """Return a string that identifies the version of this package.
+    
+    The string combines the version of CMSSW and the description of
+    the current commit in the git repository of the package, with a
+    suffix if there are uncommitted changes.  If the package is not
+    under git, only the version of CMSSW is returned.
+    """
+    
+    cmsswVersion = os.environ.get('CMSSW_VERSION', '')
+    packageDir = os.path.join(os.environ.get('CMSSW_BASE', ''), 'src/Analysis/PECTuples')
+    
+    try:
+        with open(os.devnull, 'w') as devnull:
+            commit = subprocess.check_output(
+                ['git', 'describe', '--always', '--dirty'], cwd=packageDir, stderr=devnull
+            ).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return cmsswVersion
+    
+    return cmsswVersion + ':' + commit
+
+
+def add_provenance_writer(process, paths, label='provenance'):
+    """Add a module that records the provenance of the output file.
+    
+    The module is an instance of plugin ProvenanceWriter.  It is given
+    a hash of the full expanded configuration, in which the settings
+    specific to a job (input files, number of events, and name of the
+    output file) are omitted, and the version of the package.  The
+    function must therefore be called after all other modules and
+    services have been added to the process.
+    
+    Arguments:
+        process: The process.
+        paths: PathManager to which the module is appended.
+        label: Label for the module.
+    
+    Return value:
+        Hash of the configuration.
+    """
+    
+    module = cms.EDAnalyzer('ProvenanceWriter',
+        configHash = cms.string(''),
+        packageVersion = cms.string(get_package_version())
+    )
+    setattr(process, label, module)
+    paths.append(module)
+    
+    
+    # Temporarily remove the settings specific to a job
+    jobSettings = [
+        (getattr(process, 'source', None), 'fileNames'),
+        (getattr(process, 'source', None), 'lumisToProcess'),
+        (getattr(process, 'maxEvents', None), 'input'),
+        (getattr(process, 'TFileService', None), 'fileName')
+    ]
+    removedSettings = []
+    
+    for owner, name in jobSettings:
+        if owner is not None and hasattr(owner, name):
+            removedSettings.append((owner, name, getattr(owner, name)))
+            delattr(owner, name)
+    
+    try:
+        dump = process.dumpPython()
+    finally:
+        for owner, name, value in removedSettings:
+            setattr(owner, name, value)
+    
+    configHash = hashlib.sha1(dump).hexdigest()
+    module.configHash = configHash
+    return configHash
+
+
+def get_trigger_names(period):
+    """Return names of triggers considered in the analysis.
+    
+    The names are given without the "HLT_" prefix and version postfix,
+    as accepted by plugin SlimTriggerResults.  The list is shared by the
+    main configuration and the pre-pass configuration
+    SkimPrepass_cfg.py, so that both apply the same trigger selection.
+    
+    Arguments:
+        period: Data-taking period, '2016' or '2017'.
+    
+    Return value:
+        List of trigger names.
+    """
+    
+    if period == '2017':
+        # The list is based on menu [1], which was used for the
+        # RunIIFall17MiniAOD campaign.
+        # [1] /frozen/2017/2e34/v4.0/HLT/V5
+        triggerNames = [
+            # Single-lepton paths
+            'Mu50', 'Mu55',
+            'IsoMu20', 'IsoMu24', 'IsoMu27', 'IsoMu30',
+            'Ele27_WPTight_Gsf', 'Ele32_WPTight_Gsf', 'Ele35_WPTight_Gsf', 'Ele38_WPTight_Gsf',
+            # Dilepton paths
+            'Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass8',
+            'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL', 'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
+            'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL',
+            'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
+            'Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ',
+            # Cross-triggers
+            'Ele28_eta2p1_WPTight_Gsf_HT150', 'Ele30_eta2p1_WPTight_Gsf_CentralPFJet35_EleCleaned'
+        ]
+    
+    elif period == '2016':
+        # The list is based on menu [1], which was used in the re-HLT
+        # campaign with RunIISpring16MiniAODv2
+        # [1] /frozen/2016/25ns10e33/v2.1/HLT/V3
+        triggerNames = [
+            # Single-lepton paths
+            'Mu45_eta2p1', 'Mu50', 'Mu55',
+            'IsoMu20', 'IsoTkMu20', 'IsoMu22', 'IsoTkMu22', 'IsoMu22_eta2p1', 'IsoTkMu22_eta2p1',
+            'IsoMu24', 'IsoTkMu24', 'IsoMu27', 'IsoTkMu27',
+            'Ele23_WPLoose_Gsf', 'Ele24_eta2p1_WPLoose_Gsf',
+            'Ele25_WPTight_Gsf', 'Ele25_eta2p1_WPLoose_Gsf', 'Ele25_eta2p1_WPTight_Gsf',
+            'Ele27_WPLoose_Gsf', 'Ele27_WPTight_Gsf',
+            'Ele27_eta2p1_WPLoose_Gsf', 'Ele27_eta2p1_WPTight_Gsf',
+            'Ele32_eta2p1_WPTight_Gsf', 'Ele35_WPLoose_Gsf',
+            # Dilepton paths
+            'Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL',
+            'Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL',
+            'Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ', 'Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ',
+            'Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ',
+            # Cross-triggers
+            'Ele27_eta2p1_WPLoose_Gsf_HT200'
+        ]
+    
+    else:
+        raise RuntimeError('Data-taking period "{}" is not supported.'.format(period))
+    
+    return triggerNames
@@ -0,0 +1,449 @@
+#include "BulkReader.h"
+
+#include <TBranch.h>
+#include <TFile.h>
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+
+using namespace pecreader;
+
+
+namespace
+{
+/// Returns name of the ROOT type that corresponds to the given type code of a leaf
+std::string TypeName(char typeCode)
+{
+    switch (typeCode)
+    {
+        case 'F':
+            return "Float_t";
+        
+        case 'D':
+            return "Double_t";
+        
+        case 'S':
+            return "Short_t";
+        
+        case 's':
+            return "UShort_t";
+        
+        case 'b':
+            return "UChar_t";
+        
+        case 'I':
+            return "Int_t";
+        
+        case 'i':
+            return "UInt_t";
+        
+        case 'L':
+            return "Long64_t";
+        
+        case 'l':
+            return "ULong64_t";
+        
+        case 'O':
+            return "Bool_t";
+        
+        default:
+            return "";
+    }
+}
+}  // anonymous namespace
+
+
+CollectionView::CollectionView(unsigned size_, std::vector<float const *> &&floats_,
+  std::vector<int const *> &&ints_):
+    size(size_),
+    floats(std::move(floats_)), ints(std::move(ints_))
+{}
+
+
+CollectionView Block::GetCollection(unsigned collection, unsigned entry) const
+{
+    Collection const &c = collections[collection];
+    std::uint32_t const offset = c.offsets[entry];
+    std::vector<float const *> floats;
+    std::vector<int const *> ints;
+    
+    for (auto const &column: c.floatColumns)
+        floats.emplace_back(column.values.data() + offset * column.width);
+    
+    for (auto const &column: c.intColumns)
+        ints.emplace_back(column.values.data() + offset * column.width);
+    
+    return CollectionView(c.offsets[entry + 1] - offset, std::move(floats), std::move(ints));
+}
+
+
+BulkReader::BulkReader(std::string const &fileName, std::string const &treeName,
+  unsigned numPrefetched_):
+    numPrefetched(std::max(numPrefetched_, 1u)),
+    started(false),
+    finished(false), stopRequested(false)
+{
+    // The file will be read from a different thread
+    ROOT::EnableThreadSafety();
+    
+    file.reset(TFile::Open(fileName.c_str()));
+    
+    if (not file or file->IsZombie())
+        throw std::runtime_error("BulkReader::BulkReader: Cannot open file \"" + fileName +
+          "\".");
+    
+    tree = dynamic_cast<TTree *>(file->Get(treeName.c_str()));
+    
+    if (not tree)
+        throw std::runtime_error("BulkReader::BulkReader: File \"" + fileName +
+          "\" contains no tree \"" + treeName + "\".");
+    
+    numEntries = tree->GetEntries();
+    tree->SetBranchStatus("*", false);
+}
+
+
+BulkReader::~BulkReader() noexcept
+{
+    if (readingThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        
+        cv.notify_all();
+        readingThread.join();
+    }
+}
+
+
+unsigned BulkReader::AddCollection(std::string const &prefix,
+  std::vector<std::string> const &floatColumns, std::vector<std::string> const &intColumns)
+{
+    CheckNotStarted();
+    
+    CollectionSource source;
+    source.counter = GetBranch("n_" + prefix, 'I');
+    
+    for (auto const &name: floatColumns)
+    {
+        ColumnSource column;
+        column.branch = GetBranch(prefix + "_" + name, 'F', &column.width);
+        source.floatColumns.emplace_back(column);
+    }
+    
+    for (auto const &name: intColumns)
+    {
+        ColumnSource column;
+        column.branch = GetBranch(prefix + "_" + name, 'I', &column.width);
+        source.intColumns.emplace_back(column);
+    }
+    
+    collectionSources.emplace_back(source);
+    return collectionSources.size() - 1;
+}
+
+
+unsigned BulkReader::AddScalar(std::string const &name)
+{
+    CheckNotStarted();
+    
+    TBranch *branch = tree->GetBranch(name.c_str());
+    
+    if (not branch or branch->GetListOfLeaves()->GetEntries() != 1 or
+      static_cast<TLeaf *>(branch->GetListOfLeaves()->At(0))->GetLeafCount())
+        throw std::runtime_error("BulkReader::AddScalar: Tree contains no scalar branch \"" +
+          name + "\".");
+    
+    std::string const typeName =
+      static_cast<TLeaf *>(branch->GetListOfLeaves()->At(0))->GetTypeName();
+    
+    for (char const typeCode: {'F', 'D', 'S', 's', 'b', 'I', 'i', 'L', 'l', 'O'})
+    {
+        if (typeName == TypeName(typeCode))
+        {
+            unsigned width;
+            GetBranch(name, typeCode, &width);
+            scalarSources.push_back({branch, typeCode, width});
+            return scalarSources.size() - 1;
+        }
+    }
+    
+    throw std::runtime_error("BulkReader::AddScalar: Branch \"" + name + "\" has unsupported "
+      "type \"" + typeName + "\".");
+}
+
+
+std::shared_ptr<Block const> BulkReader::NextBlock()
+{
+    if (not started)
+    {
+        started = true;
+        readingThread = std::thread(&BulkReader::ReadLoop, this);
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]{return not queue.empty() or finished;});
+    
+    if (queue.empty())
+    {
+        if (error)
+            std::rethrow_exception(error);
+        
+        return nullptr;
+    }
+    
+    auto block = queue.front();
+    queue.pop_front();
+    lock.unlock();
+    cv.notify_all();
+    
+    return block;
+}
+
+
+TBranch *BulkReader::GetBranch(std::string const &name, char typeCode, unsigned *width) const
+{
+    TBranch *branch = tree->GetBranch(name.c_str());
+    
+    if (not branch)
+        throw std::runtime_error("BulkReader::GetBranch: Tree contains no branch \"" + name +
+          "\".");
+    
+    TLeaf *leaf = static_cast<TLeaf *>(branch->GetListOfLeaves()->At(0));
+    
+    if (TypeName(typeCode) != leaf->GetTypeName())
+        throw std::runtime_error("BulkReader::GetBranch: Branch \"" + name + "\" has type \"" +
+          leaf->GetTypeName() + "\" while \"" + TypeName(typeCode) + "\" is expected.");
+    
+    if (width)
+        *width = leaf->GetLenStatic();
+    
+    tree->SetBranchStatus(name.c_str(), true);
+    return branch;
+}
+
+
+void BulkReader::CheckNotStarted() const
+{
+    if (started)
+        throw std::logic_error("BulkReader: Branches cannot be added after reading has started.");
+}
+
+
+void BulkReader::ReadLoop()
+{
+    try
+    {
+        // Restrict the cache to the registered branches
+        tree->SetCacheSize(64 * 1024 * 1024);
+        
+        for (auto const &source: collectionSources)
+        {
+            tree->AddBranchToCache(source.counter);
+            
+            for (auto const &column: source.floatColumns)
+                tree->AddBranchToCache(column.branch);
+            
+            for (auto const &column: source.intColumns)
+                tree->AddBranchToCache(column.branch);
+        }
+        
+        for (auto const &source: scalarSources)
+            tree->AddBranchToCache(source.branch);
+        
+        tree->StopCacheLearningPhase();
+        
+        
+        // Read the tree cluster by cluster
+        auto clusterIt = tree->GetClusterIterator(0);
+        Long64_t begin;
+        
+        while ((begin = clusterIt()) < numEntries)
+        {
+            Long64_t const end = std::min(clusterIt.GetNextEntry(), numEntries);
+            auto block = ReadBlock(begin, end);
+            
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]{return queue.size() < numPrefetched or stopRequested;});
+            
+            if (stopRequested)
+                return;
+            
+            queue.emplace_back(std::move(block));
+            lock.unlock();
+            cv.notify_all();
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+    
+    cv.notify_all();
+}
+
+
+std::shared_ptr<Block> BulkReader::ReadBlock(Long64_t begin, Long64_t end)
+{
+    auto block = std::make_shared<Block>();
+    unsigned const n = end - begin;
+    block->firstEntry = begin;
+    block->numEntries = n;
+    
+    
+    // Read collections. Sizes of the collections are read first, which gives positions of all
+    //entries in the concatenated arrays
+    block->collections.resize(collectionSources.size());
+    
+    for (unsigned iCol = 0; iCol < collectionSources.size(); ++iCol)
+    {
+        CollectionSource const &source = collectionSources[iCol];
+        Block::Collection &collection = block->collections[iCol];
+        
+        collection.offsets.resize(n + 1);
+        collection.offsets[0] = 0;
+        Int_t count;
+        source.counter->SetAddress(&count);
+        
+        for (unsigned i = 0; i < n; ++i)
+        {
+            source.counter->GetEntry(begin + i);
+            collection.offsets[i + 1] = collection.offsets[i] + count;
+        }
+        
+        collection.floatColumns.resize(source.floatColumns.size());
+        
+        for (unsigned iColumn = 0; iColumn < source.floatColumns.size(); ++iColumn)
+            ReadColumn(source.floatColumns[iColumn], begin, collection.offsets,
+              collection.floatColumns[iColumn]);
+        
+        collection.intColumns.resize(source.intColumns.size());
+        
+        for (unsigned iColumn = 0; iColumn < source.intColumns.size(); ++iColumn)
+            ReadColumn(source.intColumns[iColumn], begin, collection.offsets,
+              collection.intColumns[iColumn]);
+    }
+    
+    
+    // Read scalar branches
+    block->scalars.resize(scalarSources.size());
+    
+    for (unsigned iScalar = 0; iScalar < scalarSources.size(); ++iScalar)
+    {
+        ScalarSource const &source = scalarSources[iScalar];
+        Block::ScalarColumn &column = block->scalars[iScalar];
+        
+        switch (source.typeCode)
+        {
+            case 'F':
+                ReadScalar<Float_t>(source, begin, n, column);
+                break;
+            
+            case 'D':
+                ReadScalar<Double_t>(source, begin, n, column);
+                break;
+            
+            case 'S':
+                ReadScalar<Short_t>(source, begin, n, column);
+                break;
+            
+            case 's':
+                ReadScalar<UShort_t>(source, begin, n, column);
+                break;
+            
+            case 'b':
+                ReadScalar<UChar_t>(source, begin, n, column);
+                break;
+            
+            case 'I':
+                ReadScalar<Int_t>(source, begin, n, column);
+                break;
+            
+            case 'i':
+                ReadScalar<UInt_t>(source, begin, n, column);
+                break;
+            
+            case 'L':
+                ReadScalar<Long64_t>(source, begin, n, column);
+                break;
+            
+            case 'l':
+                ReadScalar<ULong64_t>(source, begin, n, column);
+                break;
+            
+            case 'O':
+                ReadScalar<Bool_t>(source, begin, n, column);
+                break;
+        }
+    }
+    
+    return block;
+}
+
+
+template<typename V>
+void BulkReader::ReadColumn(ColumnSource const &source, Long64_t begin,
+  std::vector<std::uint32_t> const &offsets, Block::Column<V> &column)
+{
+    column.width = source.width;
+    column.values.resize(offsets.back() * column.width);
+    
+    
+    // Values of each entry are read directly into their final position. Entries with empty
+    //collections are skipped altogether
+    for (unsigned i = 0; i + 1 < offsets.size(); ++i)
+    {
+        if (offsets[i + 1] == offsets[i])
+            continue;
+        
+        source.branch->SetAddress(column.values.data() + offsets[i] * column.width);
+        source.branch->GetEntry(begin + i);
+    }
+}
+
+
+template<typename V>
+void BulkReader::ReadScalar(ScalarSource const &source, Long64_t begin, unsigned numEntries,
+  Block::ScalarColumn &column)
+{
+    column.typeCode = source.typeCode;
+    column.width = source.width;
+    
+    // Values of 64-bit integer types are kept exactly
+    bool constexpr wide = (std::is_integral<V>::value and sizeof(V) == 8);
+    
+    if (wide)
+        column.wideValues.resize(numEntries * column.width);
+    else
+        column.values.resize(numEntries * column.width);
+    
+    std::unique_ptr<V[]> buffer(new V[column.width]);
+    source.branch->SetAddress(buffer.get());
+    
+    for (unsigned i = 0; i < numEntries; ++i)
+    {
+        source.branch->GetEntry(begin + i);
+        
+        for (unsigned j = 0; j < column.width; ++j)
+        {
+            if constexpr (wide)
+                column.wideValues[i * column.width + j] = std::uint64_t(buffer[j]);
+            else
+                column.values[i * column.width + j] = buffer[j];
+        }
+    }
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <Rtypes.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class TBranch;
+class TFile;
+class TTree;
+
+
+/**
+ * \brief Standalone reader of PEC files
+ *
+ * Code in this namespace depends on ROOT only and does not need dictionaries for PEC classes. It
+ * is not built by scram and can be compiled into a shared library with, e.g.,
+ *   g++ -O2 -shared -fPIC -std=c++17 $(root-config --cflags --libs) BulkReader.cc \
+ *     -o libPECReader.so
+ */
+namespace pecreader
+{
+/**
+ * \class CollectionView
+ * \brief A view of a collection in a single event of a Block
+ *
+ * Provides pointers to values of the columns for the first object of the collection. Values of
+ * the following objects follow contiguously, with Width(column) values per object.
+ */
+class CollectionView
+{
+public:
+    /// Constructor
+    CollectionView(unsigned size, std::vector<float const *> &&floats,
+      std::vector<int const *> &&ints);
+
+public:
+    /// Returns the number of objects in the collection
+    unsigned Size() const
+    {
+        return size;
+    }
+    
+    /// Returns pointer to values of the float column with the given index
+    float const *Floats(unsigned column) const
+    {
+        return floats[column];
+    }
+    
+    /// Returns pointer to values of the integer column with the given index
+    int const *Ints(unsigned column) const
+    {
+        return ints[column];
+    }
+
+private:
+    unsigned size;
+    std::vector<float const *> floats;
+    std::vector<int const *> ints;
+};
+
+
+/**
+ * \class Block
+ * \brief Values of all requested branches for a range of entries, in the structure-of-arrays form
+ *
+ * A range normally corresponds to a cluster of the tree. For each collection, the block stores
+ * offsets of events in the concatenated arrays of objects and one array per column. Scalar
+ * branches are stored as arrays of doubles, which represent exactly values of all supported
+ * types except for 64-bit integers. The latter are stored as 64-bit unsigned integers, with signed
+ * values in the two's complement form.
+ */
+class Block
+{
+    friend class BulkReader;
+
+private:
+    /// Values of a column of a collection for all entries in the block
+    template<typename V>
+    struct Column
+    {
+        /// Number of values per object
+        unsigned width;
+        
+        /// Concatenated values for all objects in all entries
+        std::vector<V> values;
+    };
+    
+    /// Data for a collection
+    struct Collection
+    {
+        /**
+         * \brief Index of the first object of each entry in the concatenated arrays
+         *
+         * Contains (numEntries + 1) elements, the last one being the total number of objects.
+         */
+        std::vector<std::uint32_t> offsets;
+        
+        std::vector<Column<float>> floatColumns;
+        std::vector<Column<int>> intColumns;
+    };
+    
+    /// Values of a scalar branch for all entries in the block
+    struct ScalarColumn
+    {
+        /// Type code of the leaf
+        char typeCode;
+        
+        /// Number of values per entry
+        unsigned width;
+        
+        /// Concatenated values for all entries, unless the type is a 64-bit integer
+        std::vector<double> values;
+        
+        /// Concatenated values for all entries if the type is a 64-bit integer
+        std::vector<std::uint64_t> wideValues;
+    };
+
+public:
+    /// Returns index of the first entry in the block
+    Long64_t FirstEntry() const
+    {
+        return firstEntry;
+    }
+    
+    /// Returns number of entries in the block
+    unsigned NumEntries() const
+    {
+        return numEntries;
+    }
+    
+    /// Returns a view of the given collection in the entry with the given index within the block
+    CollectionView GetCollection(unsigned collection, unsigned entry) const;
+    
+    /// Returns offsets of entries in the concatenated arrays of the given collection
+    std::vector<std::uint32_t> const &Offsets(unsigned collection) const
+    {
+        return collections[collection].offsets;
+    }
+    
+    /// Returns concatenated values of a float column of the given collection for all entries
+    std::vector<float> const &FloatColumn(unsigned collection, unsigned column) const
+    {
+        return collections[collection].floatColumns[column].values;
+    }
+    
+    /// Returns concatenated values of an integer column of the given collection for all entries
+    std::vector<int> const &IntColumn(unsigned collection, unsigned column) const
+    {
+        return collections[collection].intColumns[column].values;
+    }
+    
+    /**
+     * \brief Returns value of the given scalar branch in the entry with the given index within the
+     * block
+     *
+     * For branches with fixed-size arrays, the index of the value within the array is given
+     * as well. Values of 64-bit integer types are rounded if they cannot be represented exactly
+     * as doubles; use method WideScalar to obtain them exactly.
+     */
+    double Scalar(unsigned scalar, unsigned entry, unsigned index = 0) const
+    {
+        ScalarColumn const &c = scalars[scalar];
+        unsigned const i = entry * c.width + index;
+        
+        if (c.typeCode == 'l')
+            return double(c.wideValues[i]);
+        else if (c.typeCode == 'L')
+            return double(std::int64_t(c.wideValues[i]));
+        else
+            return c.values[i];
+    }
+    
+    /**
+     * \brief Returns exact value of the given scalar branch of a 64-bit integer type
+     *
+     * Values of type Long64_t are returned in the two's complement form. Must not be called for
+     * other types.
+     */
+    std::uint64_t WideScalar(unsigned scalar, unsigned entry, unsigned index = 0) const
+    {
+        ScalarColumn const &c = scalars[scalar];
+        return c.wideValues[entry * c.width + index];
+    }
+    
+    /// Returns number of values per entry in the given scalar branch
+    unsigned ScalarWidth(unsigned scalar) const
+    {
+        return scalars[scalar].width;
+    }
+
+private:
+    Long64_t firstEntry;
+    unsigned numEntries;
+    std::vector<Collection> collections;
+    std::vector<ScalarColumn> scalars;
+};
+
+
+/**
+ * \class BulkReader
+ * \brief Reads a PEC tree block by block
+ *
+ * The reader is intended for trees written with the flat layout (see class FlatTable), in which
+ * collections are stored as arrays of fundamental types. The user registers collections, with
+ * their float and integer columns, and scalar branches to be read. All other branches are
+ * disabled. The tree is then read cluster by cluster: for each branch, the values for all entries
+ * of the cluster are read in a row directly into their final positions in contiguous arrays of a
+ * Block. This avoids per-event deserialization of objects and intermediate copies, and keeps
+ * access to the baskets of each branch sequential. A TTreeCache restricted to the registered
+ * branches is used.
+ *
+ * Reading is done by a dedicated thread, which prepares up to the given number of blocks in
+ * advance, so that I/O and decompression overlap with the processing of the current block. The
+ * file and the tree are accessed by this thread only once reading has started. Exceptions thrown
+ * in the reading thread are rethrown from method NextBlock.
+ *
+ * Typical usage:
+ *   BulkReader reader("file.root", "pecJetMET/JetMET");
+ *   unsigned const jets = reader.AddCollection("jets", {"pt", "eta"}, {"id"});
+ *
+ *   while (auto block = reader.NextBlock())
+ *       for (unsigned i = 0; i < block->NumEntries(); ++i)
+ *       {
+ *           auto const view = block->GetCollection(jets, i);
+ *           float const *pt = view.Floats(0);
+ *           ...
+ *       }
+ */
+class BulkReader
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * Opens the file and finds the tree. Throws an exception if this fails.
+     */
+    BulkReader(std::string const &fileName, std::string const &treeName,
+      unsigned numPrefetched = 2);
+    
+    BulkReader(BulkReader const &) = delete;
+    
+    /// Stops the reading thread and closes the file
+    ~BulkReader() noexcept;
+    
+    BulkReader &operator=(BulkReader const &) = delete;
+
+public:
+    /**
+     * \brief Registers a collection stored with the flat layout
+     *
+     * The collection is identified by the prefix of its branches. Returns the index of the
+     * collection, to be given to methods of Block. Columns are indexed in the order of the given
+     * vectors. Throws an exception if a branch is missing or has an unexpected type, or if
+     * reading has already started.
+     */
+    unsigned AddCollection(std::string const &prefix, std::vector<std::string> const &floatColumns,
+      std::vector<std::string> const &intColumns = {});
+    
+    /**
+     * \brief Registers a scalar branch
+     *
+     * The branch must contain a single value or an array with a fixed size of type Float_t,
+     * Double_t, Short_t, UShort_t, UChar_t, Int_t, UInt_t, Long64_t, ULong64_t, or Bool_t. Returns
+     * the index of the scalar, to be given to methods of Block. Throws an exception if the branch
+     * is not found or has an unsupported type, or if reading has already started.
+     */
+    unsigned AddScalar(std::string const &name);
+    
+    /// Returns total number of entries in the tree
+    Long64_t NumEntries() const
+    {
+        return numEntries;
+    }
+    
+    /**
+     * \brief Returns the next block
+     *
+     * The first call starts the reading thread. Returns a null pointer when all entries have been
+     * read.
+     */
+    std::shared_ptr<Block const> NextBlock();
+
+private:
+    /// Description of a column to read
+    struct ColumnSource
+    {
+        TBranch *branch;
+        unsigned width;
+    };
+    
+    /// Description of a collection to read
+    struct CollectionSource
+    {
+        TBranch *counter;
+        std::vector<ColumnSource> floatColumns, intColumns;
+    };
+    
+    /// Description of a scalar branch to read
+    struct ScalarSource
+    {
+        TBranch *branch;
+        char typeCode;
+        unsigned width;
+    };
+
+private:
+    /// Finds the branch with the given name and checks that it contains a leaf of the given type
+    TBranch *GetBranch(std::string const &name, char typeCode, unsigned *width = nullptr) const;
+    
+    /// Throws an exception if reading has already started
+    void CheckNotStarted() const;
+    
+    /// Reads all blocks; executed by the reading thread
+    void ReadLoop();
+    
+    /// Reads entries in the given range into a new block
+    std::shared_ptr<Block> ReadBlock(Long64_t begin, Long64_t end);
+    
+    /// Reads a column of a collection for all entries of a block
+    template<typename V>
+    void ReadColumn(ColumnSource const &source, Long64_t begin,
+      std::vector<std::uint32_t> const &offsets, Block::Column<V> &column);
+    
+    /// Reads a scalar branch for all entries of a block, using a buffer of type V
+    template<typename V>
+    void ReadScalar(ScalarSource const &source, Long64_t begin, unsigned numEntries,
+      Block::ScalarColumn &column);
+
+private:
+    std::unique_ptr<TFile> file;
+    TTree *tree;
+    Long64_t numEntries;
+    
+    std::vector<CollectionSource> collectionSources;
+    std::vector<ScalarSource> scalarSources;
+    
+    /// Maximal number of blocks read in advance
+    unsigned const numPrefetched;
+    
+    std::thread readingThread;
+    bool started;
+    
+    /// Synchronization between the reading thread and the user
+    std::mutex mutex;
+    std::condition_variable cv;
+    
+    /// Blocks read but not yet given to the user
+    std::deque<std::shared_ptr<Block>> queue;
+    
+    /// Flags indicating that all blocks have been read and that reading should be stopped
+    bool finished, stopRequested;
+    
+    /// Exception thrown in the reading thread
+    std::exception_ptr error;
+};
+}  // end of namespace pecreader
@@ -0,0 +1,107 @@
+#include "EventIDDecoder.h"
+
+#include <TBranch.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+using namespace pecreader;
+
+
+EventIDDecoder::EventIDDecoder(TTree *tree, TTree *lumiRangesTree, std::string const &name):
+    eventDelta(0), bunchCrossing(0),
+    curRange(0), lastEntry(-1), lastEvent(0)
+{
+    // Read the whole index of luminosity blocks and convert numbers of entries into positions
+    UInt_t run, lumi;
+    Long64_t numRangeEntries;
+    
+    if (lumiRangesTree->SetBranchAddress("run", &run) < 0 or
+      lumiRangesTree->SetBranchAddress("lumi", &lumi) < 0 or
+      lumiRangesTree->SetBranchAddress("numEntries", &numRangeEntries) < 0)
+        throw std::runtime_error("EventIDDecoder::EventIDDecoder: Tree \"" +
+          std::string(lumiRangesTree->GetName()) + "\" has unexpected structure.");
+    
+    numEntries = 0;
+    
+    for (Long64_t i = 0; i < lumiRangesTree->GetEntries(); ++i)
+    {
+        lumiRangesTree->GetEntry(i);
+        ranges.push_back({run, lumi, numEntries});
+        numEntries += numRangeEntries;
+    }
+    
+    lumiRangesTree->ResetBranchAddresses();
+    
+    if (numEntries != tree->GetEntries())
+        throw std::runtime_error("EventIDDecoder::EventIDDecoder: Tree \"" +
+          std::string(lumiRangesTree->GetName()) + "\" describes " + std::to_string(numEntries) +
+          " entries while tree \"" + tree->GetName() + "\" contains " +
+          std::to_string(tree->GetEntries()) + ".");
+    
+    
+    eventDeltaBranch = tree->GetBranch((name + "_eventDelta").c_str());
+    bunchCrossingBranch = tree->GetBranch((name + "_bunchCrossing").c_str());
+    
+    if (not eventDeltaBranch or not bunchCrossingBranch)
+        throw std::runtime_error("EventIDDecoder::EventIDDecoder: Tree \"" +
+          std::string(tree->GetName()) + "\" contains no event ID \"" + name +
+          "\" stored in the compact form.");
+    
+    eventDeltaBranch->SetAddress(&eventDelta);
+    bunchCrossingBranch->SetAddress(&bunchCrossing);
+}
+
+
+pec::EventID EventIDDecoder::Get(Long64_t entry)
+{
+    if (entry < 0 or entry >= numEntries)
+        throw std::out_of_range("EventIDDecoder::Get: Entry " + std::to_string(entry) +
+          " is out of range.");
+    
+    
+    // Find the luminosity block. The previous one is checked first as the access is normally
+    //sequential.
+    bool const sameRange = entry >= ranges[curRange].firstEntry and
+      (curRange + 1 == ranges.size() or entry < ranges[curRange + 1].firstEntry);
+    
+    if (not sameRange)
+    {
+        auto const next = std::upper_bound(ranges.begin(), ranges.end(), entry,
+          [](Long64_t e, Range const &r){return e < r.firstEntry;});
+        curRange = next - ranges.begin() - 1;
+    }
+    
+    
+    // Accumulate deltas starting from the last decoded entry if possible and from the start of
+    //the luminosity block otherwise
+    Long64_t start;
+    
+    if (sameRange and lastEntry >= ranges[curRange].firstEntry and lastEntry < entry)
+        start = lastEntry + 1;
+    else
+    {
+        start = ranges[curRange].firstEntry;
+        lastEvent = 0;
+    }
+    
+    for (Long64_t e = start; e <= entry; ++e)
+    {
+        eventDeltaBranch->GetEntry(e);
+        lastEvent += ULong64_t(eventDelta);
+    }
+    
+    bunchCrossingBranch->GetEntry(entry);
+    lastEntry = entry;
+    
+    
+    pec::EventID id;
+    id.SetRunNumber(ranges[curRange].run);
+    id.SetLumiSectionNumber(ranges[curRange].lumi);
+    id.SetEventNumber(lastEvent);
+    id.SetBunchCrossing(bunchCrossing);
+    
+    return id;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Analysis/PECTuples/interface/EventID.h>
+
+#include <Rtypes.h>
+
+#include <string>
+#include <vector>
+
+
+class TBranch;
+class TTree;
+
+
+namespace pecreader
+{
+/**
+ * \class EventIDDecoder
+ * \brief Restores event IDs stored in the compact form
+ *
+ * The IDs are written by PECWriter with the type label "CompactEventID": run and luminosity block
+ * numbers are taken from tree "LumiRanges" in the same directory, and event numbers are obtained
+ * by accumulating the deltas within each of its entries. Sequential access costs a single read of
+ * two small branches per entry; random access additionally requires reading the deltas from the
+ * start of the corresponding luminosity block. Only the branches of the event ID are read.
+ *
+ * Unlike the rest of the namespace, this class uses pec::EventID, and it must be compiled
+ * together with src/EventID.cc and with the directory containing the package in the include path.
+ */
+class EventIDDecoder
+{
+public:
+    /**
+     * \brief Constructor
+     *
+     * The trees are owned by the caller. Throws an exception if a branch is missing or if the
+     * numbers of entries in the two trees do not match.
+     */
+    EventIDDecoder(TTree *tree, TTree *lumiRangesTree, std::string const &name = "eventId");
+
+public:
+    /// Returns ID of the event with the given index in the tree
+    pec::EventID Get(Long64_t entry);
+
+private:
+    /// Luminosity block described by an entry of the tree LumiRanges
+    struct Range
+    {
+        UInt_t run, lumi;
+        
+        /// Index of the first entry of the range in the event tree
+        Long64_t firstEntry;
+    };
+
+private:
+    std::vector<Range> ranges;
+    Long64_t numEntries;
+    
+    TBranch *eventDeltaBranch, *bunchCrossingBranch;
+    Long64_t eventDelta;
+    UShort_t bunchCrossing;
+    
+    /// Index of the range and event number for the last decoded entry
+    unsigned curRange;
+    Long64_t lastEntry;
+    ULong64_t lastEvent;
+};
+}  // end of namespace pecreader
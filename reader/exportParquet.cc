@@ -0,0 +1,463 @@
+/**
+ * Exports a PEC tree written with the flat layout into a Parquet file.
+ *
+ * Usage:
+ *   exportParquet input.root treeName output.parquet [skippedBranch ...]
+ *
+ * Each collection found in the tree (i.e. each group of branches "n_<prefix>", "<prefix>_<column>"
+ * with float and integer columns, see class FlatTable) is mapped onto a column of type
+ * list<struct<...>>, with one field per column of the collection. Columns with several values per
+ * object, such as flavours of jets, become fixed-size lists. Scalar branches of fundamental types
+ * supported by BulkReader become plain columns, or fixed-size lists for arrays with a fixed size.
+ * This includes event IDs, MET, and pile-up and generator information stored with the flat layout
+ * (see class FlatRecord; alternative generator weights are stored as collections), decisions of
+ * individual triggers written by SlimTriggerResults, and packed trigger bits, which become lists
+ * of uint64. Other branches, such as objects stored with dictionaries, are not supported. If the
+ * tree contains such branches, the program fails and lists them, unless they are given as
+ * additional arguments, in which case they are skipped.
+ *
+ * The tree is read with BulkReader, and each of its clusters is written as a separate row group.
+ * Arrays of collections are passed to Arrow without copying. The program depends on ROOT and
+ * Apache Arrow with Parquet support only, and it can be compiled with, e.g.,
+ *   g++ -O2 -std=c++17 $(root-config --cflags --libs) $(pkg-config --cflags --libs parquet) \
+ *     BulkReader.cc exportParquet.cc -o exportParquet
+ *
+ * The program exits with a non-zero code in case of an error.
+ */
+
+#include "BulkReader.h"
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+
+#include <TBranch.h>
+#include <TFile.h>
+#include <TLeaf.h>
+#include <TObjArray.h>
+#include <TTree.h>
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+using namespace pecreader;
+
+
+/// Description of a collection found in the tree
+struct CollectionInfo
+{
+    std::string prefix;
+    std::vector<std::string> floatColumns, intColumns;
+    std::vector<unsigned> floatWidths, intWidths;
+};
+
+
+/// Description of a scalar branch found in the tree
+struct ScalarInfo
+{
+    std::string name;
+    char typeCode;
+    unsigned width;
+};
+
+
+/// Throws an exception if the given status indicates an error
+void Check(arrow::Status const &status)
+{
+    if (not status.ok())
+        throw std::runtime_error("Arrow error: " + status.ToString());
+}
+
+
+/// Returns the value held by the given result or throws an exception if it contains an error
+template<typename T>
+T Unwrap(arrow::Result<T> &&result)
+{
+    Check(result.status());
+    return std::move(result).ValueUnsafe();
+}
+
+
+/**
+ * \brief Returns the type code of the only leaf of the branch
+ *
+ * If the branch has several leaves or its leaf has an unsupported type, returns 0. The second
+ * returned value indicates whether the size of the array in the leaf is given by a counter.
+ */
+std::pair<char, bool> GetTypeCode(TBranch *branch, unsigned *width = nullptr)
+{
+    if (branch->GetListOfLeaves()->GetEntries() != 1)
+        return {0, false};
+    
+    TLeaf *leaf = static_cast<TLeaf *>(branch->GetListOfLeaves()->At(0));
+    std::string const typeName(leaf->GetTypeName());
+    
+    if (width)
+        *width = leaf->GetLenStatic();
+    
+    std::map<std::string, char> const codes{{"Float_t", 'F'}, {"Double_t", 'D'},
+      {"Short_t", 'S'}, {"UShort_t", 's'}, {"UChar_t", 'b'}, {"Int_t", 'I'}, {"UInt_t", 'i'},
+      {"Long64_t", 'L'}, {"ULong64_t", 'l'}, {"Bool_t", 'O'}};
+    auto const res = codes.find(typeName);
+    
+    return {(res == codes.end()) ? 0 : res->second, leaf->GetLeafCount() != nullptr};
+}
+
+
+/**
+ * \brief Finds collections and scalar branches in the tree
+ *
+ * Throws an exception if the tree contains unsupported branches that are not listed among the
+ * skipped ones. Names of skipped branches are printed to the standard error stream.
+ */
+void DiscoverBranches(std::string const &fileName, std::string const &treeName,
+  std::set<std::string> const &skippedBranches, std::vector<CollectionInfo> &collections,
+  std::vector<ScalarInfo> &scalars)
+{
+    std::unique_ptr<TFile> file(TFile::Open(fileName.c_str()));
+    
+    if (not file or file->IsZombie())
+        throw std::runtime_error("Failed to open file \"" + fileName + "\".");
+    
+    TTree *tree = dynamic_cast<TTree *>(file->Get(treeName.c_str()));
+    
+    if (not tree)
+        throw std::runtime_error("File \"" + fileName + "\" does not contain tree \"" +
+          treeName + "\".");
+    
+    
+    // Counters of collections are identified first, so that their columns can be recognized
+    std::vector<TBranch *> branches;
+    
+    for (TObject *obj: *tree->GetListOfBranches())
+        branches.emplace_back(static_cast<TBranch *>(obj));
+    
+    std::map<std::string, unsigned> collectionIndices;
+    
+    for (TBranch *branch: branches)
+    {
+        std::string const name(branch->GetName());
+        
+        if (name.compare(0, 2, "n_") == 0 and GetTypeCode(branch).first == 'I')
+        {
+            collectionIndices[name.substr(2)] = collections.size();
+            collections.emplace_back();
+            collections.back().prefix = name.substr(2);
+        }
+    }
+    
+    
+    std::vector<std::string> unsupportedBranches;
+    
+    for (TBranch *branch: branches)
+    {
+        std::string const name(branch->GetName());
+        
+        if (name.compare(0, 2, "n_") == 0 and collectionIndices.count(name.substr(2)) > 0)
+            continue;
+        
+        unsigned width;
+        auto const [typeCode, hasCounter] = GetTypeCode(branch, &width);
+        
+        
+        // Check if this is a column of a collection. The longest matching prefix is chosen
+        CollectionInfo *collection = nullptr;
+        std::string::size_type const underscore = name.find('_');
+        
+        for (auto pos = underscore; pos != std::string::npos; pos = name.find('_', pos + 1))
+        {
+            auto const res = collectionIndices.find(name.substr(0, pos));
+            
+            if (res != collectionIndices.end())
+                collection = &collections[res->second];
+        }
+        
+        if (collection and hasCounter and (typeCode == 'F' or typeCode == 'I'))
+        {
+            std::string const column(name.substr(collection->prefix.size() + 1));
+            
+            if (typeCode == 'F')
+            {
+                collection->floatColumns.emplace_back(column);
+                collection->floatWidths.emplace_back(width);
+            }
+            else
+            {
+                collection->intColumns.emplace_back(column);
+                collection->intWidths.emplace_back(width);
+            }
+        }
+        else if (not collection and not hasCounter and typeCode != 0)
+            scalars.push_back({name, typeCode, width});
+        else if (skippedBranches.count(name) > 0)
+            std::cerr << "Warning: Branch \"" << name << "\" has unsupported type and is " <<
+              "skipped.\n";
+        else
+            unsupportedBranches.emplace_back(name);
+    }
+    
+    if (not unsupportedBranches.empty())
+    {
+        std::string message("Tree \"" + treeName + "\" contains branches of unsupported types:");
+        
+        for (auto const &name: unsupportedBranches)
+            message += " \"" + name + "\"";
+        
+        message += ". Objects need to be stored with the flat layout. Give names of the branches "
+          "as additional arguments to skip them.";
+        throw std::runtime_error(message);
+    }
+}
+
+
+/// Returns Arrow type of a column of a collection with the given number of values per object
+std::shared_ptr<arrow::DataType> ColumnType(std::shared_ptr<arrow::DataType> const &valueType,
+  unsigned width)
+{
+    return (width == 1) ? valueType : arrow::fixed_size_list(valueType, width);
+}
+
+
+/// Wraps values of a column of a collection into an Arrow array without copying them
+template<typename ArrayType, typename V>
+std::shared_ptr<arrow::Array> MakeColumnArray(std::vector<V> const &values, unsigned width,
+  std::shared_ptr<arrow::DataType> const &type)
+{
+    auto const flatArray = std::make_shared<ArrayType>(values.size(),
+      arrow::Buffer::Wrap(values));
+    
+    if (width == 1)
+        return flatArray;
+    else
+        return std::make_shared<arrow::FixedSizeListArray>(type, values.size() / width,
+          flatArray);
+}
+
+
+/// Builds an Arrow array of the given size with values given by a function of their index
+template<typename Builder, typename Getter>
+std::shared_ptr<arrow::Array> BuildArray(unsigned size, Getter getter)
+{
+    Builder builder;
+    Check(builder.Reserve(size));
+    
+    for (unsigned i = 0; i < size; ++i)
+        builder.UnsafeAppend(getter(i));
+    
+    std::shared_ptr<arrow::Array> array;
+    Check(builder.Finish(&array));
+    return array;
+}
+
+
+/// Converts values of a scalar branch in a block into an Arrow array of the given type
+std::shared_ptr<arrow::Array> MakeScalarArray(Block const &block, unsigned scalar,
+  char typeCode, std::shared_ptr<arrow::DataType> const &type)
+{
+    unsigned const width = block.ScalarWidth(scalar);
+    unsigned const n = block.NumEntries() * width;
+    
+    // Values of all entries are indexed consecutively
+    auto const value = [&block, scalar, width](unsigned i)
+    {
+        return block.Scalar(scalar, i / width, i % width);
+    };
+    auto const wideValue = [&block, scalar, width](unsigned i)
+    {
+        return block.WideScalar(scalar, i / width, i % width);
+    };
+    
+    std::shared_ptr<arrow::Array> flatArray;
+    
+    switch (typeCode)
+    {
+        case 'F':
+            flatArray = BuildArray<arrow::FloatBuilder>(n,
+              [&value](unsigned i){return float(value(i));});
+            break;
+        
+        case 'D':
+            flatArray = BuildArray<arrow::DoubleBuilder>(n, value);
+            break;
+        
+        case 'S':
+            flatArray = BuildArray<arrow::Int16Builder>(n,
+              [&value](unsigned i){return std::int16_t(value(i));});
+            break;
+        
+        case 's':
+            flatArray = BuildArray<arrow::UInt16Builder>(n,
+              [&value](unsigned i){return std::uint16_t(value(i));});
+            break;
+        
+        case 'b':
+            flatArray = BuildArray<arrow::UInt8Builder>(n,
+              [&value](unsigned i){return std::uint8_t(value(i));});
+            break;
+        
+        case 'I':
+            flatArray = BuildArray<arrow::Int32Builder>(n,
+              [&value](unsigned i){return std::int32_t(value(i));});
+            break;
+        
+        case 'i':
+            flatArray = BuildArray<arrow::UInt32Builder>(n,
+              [&value](unsigned i){return std::uint32_t(value(i));});
+            break;
+        
+        case 'L':
+            flatArray = BuildArray<arrow::Int64Builder>(n,
+              [&wideValue](unsigned i){return std::int64_t(wideValue(i));});
+            break;
+        
+        case 'l':
+            flatArray = BuildArray<arrow::UInt64Builder>(n, wideValue);
+            break;
+        
+        case 'O':
+            flatArray = BuildArray<arrow::BooleanBuilder>(n,
+              [&value](unsigned i){return value(i) != 0.;});
+            break;
+    }
+    
+    if (width == 1)
+        return flatArray;
+    else
+        return std::make_shared<arrow::FixedSizeListArray>(type, block.NumEntries(), flatArray);
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: exportParquet input.root treeName output.parquet "
+          "[skippedBranch ...]\n";
+        return 2;
+    }
+    
+    std::string const inputFileName(argv[1]), treeName(argv[2]), outputFileName(argv[3]);
+    std::set<std::string> const skippedBranches(argv + 4, argv + argc);
+    
+    
+    try
+    {
+        std::vector<CollectionInfo> collections;
+        std::vector<ScalarInfo> scalars;
+        DiscoverBranches(inputFileName, treeName, skippedBranches, collections, scalars);
+        
+        BulkReader reader(inputFileName, treeName);
+        
+        
+        // Register the branches and construct the schema
+        std::vector<std::shared_ptr<arrow::Field>> fields;
+        std::vector<std::shared_ptr<arrow::DataType>> structTypes;
+        std::vector<std::vector<std::shared_ptr<arrow::DataType>>> columnTypes;
+        
+        for (auto const &collection: collections)
+        {
+            reader.AddCollection(collection.prefix, collection.floatColumns,
+              collection.intColumns);
+            
+            std::vector<std::shared_ptr<arrow::Field>> structFields;
+            columnTypes.emplace_back();
+            
+            for (unsigned i = 0; i < collection.floatColumns.size(); ++i)
+            {
+                columnTypes.back().emplace_back(ColumnType(arrow::float32(),
+                  collection.floatWidths[i]));
+                structFields.emplace_back(arrow::field(collection.floatColumns[i],
+                  columnTypes.back().back(), false));
+            }
+            
+            for (unsigned i = 0; i < collection.intColumns.size(); ++i)
+            {
+                columnTypes.back().emplace_back(ColumnType(arrow::int32(),
+                  collection.intWidths[i]));
+                structFields.emplace_back(arrow::field(collection.intColumns[i],
+                  columnTypes.back().back(), false));
+            }
+            
+            structTypes.emplace_back(arrow::struct_(structFields));
+            fields.emplace_back(arrow::field(collection.prefix,
+              arrow::list(arrow::field("item", structTypes.back(), false)), false));
+        }
+        
+        std::map<char, std::shared_ptr<arrow::DataType>> const scalarTypes{
+          {'F', arrow::float32()}, {'D', arrow::float64()}, {'S', arrow::int16()},
+          {'s', arrow::uint16()}, {'b', arrow::uint8()}, {'I', arrow::int32()},
+          {'i', arrow::uint32()}, {'L', arrow::int64()}, {'l', arrow::uint64()},
+          {'O', arrow::boolean()}};
+        auto const firstScalarField = fields.size();
+        
+        for (auto const &scalar: scalars)
+        {
+            reader.AddScalar(scalar.name);
+            fields.emplace_back(arrow::field(scalar.name,
+              ColumnType(scalarTypes.at(scalar.typeCode), scalar.width), false));
+        }
+        
+        auto const schema = arrow::schema(fields);
+        
+        
+        // Write the row groups
+        auto const outputFile = Unwrap(arrow::io::FileOutputStream::Open(outputFileName));
+        auto writer = Unwrap(parquet::arrow::FileWriter::Open(*schema,
+          arrow::default_memory_pool(), outputFile));
+        
+        while (auto block = reader.NextBlock())
+        {
+            std::vector<std::shared_ptr<arrow::Array>> arrays;
+            
+            for (unsigned iCol = 0; iCol < collections.size(); ++iCol)
+            {
+                auto const &collection = collections[iCol];
+                std::vector<std::shared_ptr<arrow::Array>> children;
+                unsigned iType = 0;
+                
+                for (unsigned i = 0; i < collection.floatColumns.size(); ++i)
+                    children.emplace_back(MakeColumnArray<arrow::FloatArray>(
+                      block->FloatColumn(iCol, i), collection.floatWidths[i],
+                      columnTypes[iCol][iType++]));
+                
+                for (unsigned i = 0; i < collection.intColumns.size(); ++i)
+                    children.emplace_back(MakeColumnArray<arrow::Int32Array>(
+                      block->IntColumn(iCol, i), collection.intWidths[i],
+                      columnTypes[iCol][iType++]));
+                
+                
+                // Offsets are stored as unsigned 32-bit integers and are reinterpreted as signed
+                //ones expected by Arrow, which is valid for blocks with less than 2^31 objects
+                auto const &offsets = block->Offsets(iCol);
+                auto const structArray = std::make_shared<arrow::StructArray>(
+                  structTypes[iCol], offsets.back(), children);
+                arrays.emplace_back(std::make_shared<arrow::ListArray>(fields[iCol]->type(),
+                  block->NumEntries(), arrow::Buffer::Wrap(offsets), structArray));
+            }
+            
+            for (unsigned i = 0; i < scalars.size(); ++i)
+                arrays.emplace_back(MakeScalarArray(*block, i, scalars[i].typeCode,
+                  fields[firstScalarField + i]->type()));
+            
+            auto const table = arrow::Table::Make(schema, arrays, block->NumEntries());
+            Check(writer->WriteTable(*table, block->NumEntries()));
+        }
+        
+        Check(writer->Close());
+        Check(outputFile->Close());
+    }
+    catch (std::exception const &e)
+    {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,333 @@
+#!/usr/bin/env python
+
+"""Benchmarks writing and reading of PEC files in different configurations.
+
+The script runs MiniAOD_cfg.py on the given MiniAOD sample for every
+combination of the requested layouts of collections (object or flat),
+organizations of trees (a tree per plugin or a single tree), compression
+settings, and quantization of alternative LHE weights with minifloats
+(requires a simulated sample).  Compression of kinematic properties of
+PEC candidates with minifloats is always applied and is not varied.
+Each job is run in a separate subdirectory of the working directory.
+
+For every configuration, the report contains the wall and CPU time of
+the job, the size of the output file and compressed and uncompressed
+sizes of every tree in it, and the read throughput for several typical
+access patterns:
+  allJets     all branches of the jet collection,
+  kinematics  only four-momenta of jets,
+  triggers    all branches of tree pecTrigger/TriggerInfo.
+Only the branches needed for an access pattern are enabled, and they
+are read with compiled code.  Each measurement is repeated and the best
+time is reported.  Files are read right after being written and are
+normally in the page cache, so the read measurements characterize
+decompression and deserialization rather than the storage.
+
+The report is written in JSON format.
+"""
+
+from __future__ import print_function
+import argparse
+from collections import OrderedDict
+import glob
+import itertools
+import json
+import os
+import resource
+import subprocess
+import sys
+import time
+
+import ROOT
+ROOT.PyConfig.IgnoreCommandLineOptions = True
+
+
+# Branches read for each access pattern, given separately for the
+# object and flat layouts.  Candidates in the object layout store
+# pseudorapidity and azimuthal angle encoded in data members etaCode and
+# phiCode (see Candidate.h).
+accessPatterns = OrderedDict([
+    ('allJets', {
+        'tree': 'pecJetMET/JetMET', 'singleTree': 'pecEvents/Events',
+        'object': ['jets*'], 'flat': ['n_jets', 'jets_*']
+    }),
+    ('kinematics', {
+        'tree': 'pecJetMET/JetMET', 'singleTree': 'pecEvents/Events',
+        'object': ['jets', 'jets.pt', 'jets.etaCode', 'jets.phiCode', 'jets.mass'],
+        'flat': ['n_jets', 'jets_pt', 'jets_eta', 'jets_phi', 'jets_mass']
+    }),
+    ('triggers', {
+        'tree': 'pecTrigger/TriggerInfo', 'singleTree': 'pecTrigger/TriggerInfo',
+        'object': ['*'], 'flat': ['*']
+    })
+])
+
+
+ROOT.gROOT.SetBatch(True)
+ROOT.gInterpreter.Declare("""
+#include <TFile.h>
+#include <TTree.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Reads all entries of the tree with only the given branches enabled.
+ *
+ * Returns the elapsed time in seconds.  Numbers of bytes read from the
+ * file and after decompression are written into the given array.
+ */
+double pecBenchmarkRead(TTree *tree, std::vector<std::string> const &patterns, double *bytes)
+{
+    tree->SetBranchStatus("*", false);
+    
+    for (auto const &pattern: patterns)
+        tree->SetBranchStatus(pattern.c_str(), true);
+    
+    TFile *file = tree->GetCurrentFile();
+    Long64_t const bytesReadStart = file->GetBytesRead();
+    Long64_t uncompressedBytes = 0;
+    
+    auto const start = std::chrono::steady_clock::now();
+    
+    for (Long64_t entry = 0; entry < tree->GetEntries(); ++entry)
+        uncompressedBytes += tree->GetEntry(entry);
+    
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+    
+    bytes[0] = file->GetBytesRead() - bytesReadStart;
+    bytes[1] = uncompressedBytes;
+    return elapsed.count();
+}
+""")
+
+
+def collect_trees(directory, path=''):
+    """Find all trees in the directory and its subdirectories.
+    
+    Return a list of pairs (path, tree).
+    """
+    
+    trees = []
+    
+    for key in directory.GetListOfKeys():
+        if key.GetClassName() == 'TTree':
+            trees.append((path + key.GetName(), key.ReadObj()))
+        elif key.GetClassName() == 'TDirectoryFile':
+            trees.extend(collect_trees(key.ReadObj(), path + key.GetName() + '/'))
+    
+    return trees
+
+
+def run_job(config, args, workDir):
+    """Produce PEC file for the given configuration.
+    
+    Return the path to the output file, the wall time, and the CPU time
+    of the job.
+    """
+    
+    cfgArgs = [
+        'inputFiles=' + args.input, 'maxEvents={}'.format(args.max_events),
+        'outputFile=pec.root', 'flatTrees={}'.format(config['layout'] == 'flat'),
+        'singleTree={}'.format(config['trees'] == 'single'),
+        'compression=' + config['compression']
+    ]
+    
+    if config['minifloat']:
+        cfgArgs += ['saveAltLHEWeights=True', 'quantizeAltLHEWeights=True']
+    elif args.run_on_data:
+        cfgArgs += ['runOnData=True']
+    else:
+        cfgArgs += ['saveAltLHEWeights=True']
+    
+    cfgArgs += args.cfg_args
+    
+    if not os.path.exists(workDir):
+        os.makedirs(workDir)
+    
+    for fileName in glob.glob(os.path.join(workDir, 'pec_*.root')):
+        os.remove(fileName)
+    
+    cpuStart = resource.getrusage(resource.RUSAGE_CHILDREN)
+    wallStart = time.time()
+    
+    with open(os.path.join(workDir, 'cmsRun.log'), 'w') as log:
+        exitCode = subprocess.call(
+            ['cmsRun', os.path.abspath(args.cfg)] + cfgArgs,
+            cwd=workDir, stdout=log, stderr=subprocess.STDOUT
+        )
+    
+    wallTime = time.time() - wallStart
+    cpuEnd = resource.getrusage(resource.RUSAGE_CHILDREN)
+    cpuTime = (cpuEnd.ru_utime - cpuStart.ru_utime) + (cpuEnd.ru_stime - cpuStart.ru_stime)
+    
+    outputFiles = glob.glob(os.path.join(workDir, 'pec_*.root'))
+    
+    if exitCode != 0 or len(outputFiles) != 1:
+        raise RuntimeError(
+            'Job in directory "{}" failed. See file cmsRun.log in it.'.format(workDir)
+        )
+    
+    return outputFiles[0], wallTime, cpuTime
+
+
+def measure_reads(fileName, config, numRepetitions):
+    """Measure read throughput for all access patterns."""
+    
+    results = OrderedDict()
+    inputFile = ROOT.TFile(fileName)
+    
+    for name, pattern in accessPatterns.items():
+        treeName = pattern['singleTree' if config['trees'] == 'single' else 'tree']
+        tree = inputFile.Get(treeName)
+        
+        if not tree:
+            raise RuntimeError(
+                'File "{}" does not contain tree "{}".'.format(fileName, treeName)
+            )
+        
+        branches = ROOT.std.vector('std::string')()
+        
+        for branch in pattern[config['layout']]:
+            branches.push_back(branch)
+        
+        bytes = ROOT.std.vector('double')(2)
+        bestTime = None
+        
+        for i in range(numRepetitions):
+            elapsed = ROOT.pecBenchmarkRead(tree, branches, bytes.data())
+            
+            if bestTime is None or elapsed < bestTime:
+                bestTime = elapsed
+        
+        numEntries = tree.GetEntries()
+        results[name] = OrderedDict([
+            ('tree', treeName), ('time', bestTime),
+            ('bytesRead', bytes[0]), ('uncompressedBytes', bytes[1]),
+            ('eventsPerSecond', numEntries / bestTime if bestTime > 0 else None),
+            ('uncompressedMBPerSecond', bytes[1] / 1e6 / bestTime if bestTime > 0 else None)
+        ])
+    
+    inputFile.Close()
+    return results
+
+
+if __name__ == '__main__':
+
+    argParser = argparse.ArgumentParser(
+        epilog=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    argParser.add_argument(
+        'input', metavar='miniaod.root',
+        help='Reference MiniAOD file, as understood by option inputFiles of MiniAOD_cfg.py.'
+    )
+    argParser.add_argument(
+        '-c', '--cfg', default=os.path.join(
+            os.environ.get('CMSSW_BASE', ''), 'src/Analysis/PECTuples/python/MiniAOD_cfg.py'
+        ),
+        help='Configuration file to run.'
+    )
+    argParser.add_argument(
+        '-n', '--max-events', type=int, default=10000,
+        help='Number of events to process.'
+    )
+    argParser.add_argument(
+        '--layouts', default='object,flat',
+        help='Comma-separated list of layouts of collections.'
+    )
+    argParser.add_argument(
+        '--trees', default='split,single',
+        help='Comma-separated list of organizations of trees: a tree per plugin (split) or a '
+        'single tree (single).'
+    )
+    argParser.add_argument(
+        '--compression', default='ZLIB:1,ZLIB:4,ZLIB:9,LZ4:1,LZ4:4,LZMA:4,LZMA:9',
+        help='Comma-separated list of compression settings in the format of option compression '
+        'of MiniAOD_cfg.py. ZSTD can be added with ROOT 6.20 or later.'
+    )
+    argParser.add_argument(
+        '--minifloat', default='off,on',
+        help='Comma-separated list of settings for quantization of alternative LHE weights.'
+    )
+    argParser.add_argument(
+        '--run-on-data', action='store_true',
+        help='The input sample is real data.  Quantization of LHE weights is then not varied.'
+    )
+    argParser.add_argument(
+        '-r', '--repeat', type=int, default=3,
+        help='Number of repetitions of each read measurement.'
+    )
+    argParser.add_argument(
+        '-w', '--work-dir', default='benchmark',
+        help='Directory for the jobs.'
+    )
+    argParser.add_argument(
+        '-o', '--output', default='benchmark.json',
+        help='Name for the output JSON file.'
+    )
+    argParser.add_argument(
+        'cfg_args', nargs='*', metavar='option=value',
+        help='Additional options for the configuration, given after "--".'
+    )
+    args = argParser.parse_args()
+    
+    ROOT.gSystem.Load('libAnalysisPECTuples.so')
+    
+    
+    minifloatSettings = [s == 'on' for s in args.minifloat.split(',')]
+    
+    if args.run_on_data:
+        minifloatSettings = [False]
+    
+    configs = []
+    
+    for layout, trees, compression, minifloat in itertools.product(
+        args.layouts.split(','), args.trees.split(','), args.compression.split(','),
+        minifloatSettings
+    ):
+        configs.append(OrderedDict([
+            ('layout', layout), ('trees', trees), ('compression', compression),
+            ('minifloat', minifloat)
+        ]))
+    
+    
+    report = OrderedDict([
+        ('input', args.input), ('maxEvents', args.max_events),
+        ('release', os.environ.get('CMSSW_VERSION', '')),
+        ('results', [])
+    ])
+    
+    for config in configs:
+        label = '{}_{}_{}_{}'.format(
+            config['layout'], config['trees'], config['compression'].replace(':', ''),
+            'minifloat' if config['minifloat'] else 'float'
+        )
+        print('Running configuration', label)
+        sys.stdout.flush()
+        
+        fileName, wallTime, cpuTime = run_job(
+            config, args, os.path.join(args.work_dir, label)
+        )
+        
+        result = OrderedDict([('label', label), ('config', config)])
+        result['write'] = OrderedDict([('wallTime', wallTime), ('cpuTime', cpuTime)])
+        result['fileSize'] = os.path.getsize(fileName)
+        
+        inputFile = ROOT.TFile(fileName)
+        result['trees'] = OrderedDict(
+            (path, OrderedDict([
+                ('entries', tree.GetEntries()), ('zipBytes', tree.GetZipBytes()),
+                ('totBytes', tree.GetTotBytes())
+            ]))
+            for path, tree in collect_trees(inputFile)
+        )
+        inputFile.Close()
+        
+        result['read'] = measure_reads(fileName, config, args.repeat)
+        report['results'].append(result)
+        
+        # Update the report after each configuration so that partial
+        # results survive interrupted runs
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2)
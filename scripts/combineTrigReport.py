@@ -2,8 +2,13 @@
 
 """Script to combine trigger reports from multiple CMSSW jobs.
 
-The script loops over all files CMSSW_*.stdout in the current directory
-and combines trigger reports found in them.
+If ROOT files are given as arguments, the script sums up counters of
+trigger decisions stored by plugin SlimTriggerResults (tree
+pecTrigger/TriggerCounters) in them and prints the totals for each
+trigger and prescale.  This is exact and does not depend on job logs.
+
+Otherwise, the script loops over all files CMSSW_*.stdout in the current
+directory and combines trigger reports found in them.
 """
 
 import os
@@ -11,6 +16,37 @@ import sys
 import re
 
 
+def combine_trigger_counters(fileNames, treeName='pecTrigger/TriggerCounters'):
+    """Sum up trigger counters from the given ROOT files.
+    
+    Return a dictionary that maps pairs (trigger, prescale) to lists
+    [events, wasRun, accept].
+    """
+    
+    import ROOT
+    counters = {}
+    
+    for fileName in fileNames:
+        f = ROOT.TFile(fileName)
+        tree = f.Get(treeName)
+        
+        if not tree:
+            raise RuntimeError(
+                'File "{}" does not contain requested tree "{}".'.format(fileName, treeName)
+            )
+        
+        for entry in tree:
+            key = (str(entry.trigger), entry.prescale)
+            c = counters.setdefault(key, [0, 0, 0])
+            c[0] += entry.events
+            c[1] += entry.wasRun
+            c[2] += entry.accept
+        
+        f.Close()
+    
+    return counters
+
+
 class Module:
     """ The class aggregates event counters for a single module
     """
@@ -50,6 +86,20 @@ class Path:
 
 
 if __name__ == '__main__':
+    # Use counters saved in ROOT files if they are given
+    rootFiles = [arg for arg in sys.argv[1:] if arg.endswith('.root')]
+    
+    if rootFiles:
+        counters = combine_trigger_counters(rootFiles)
+        print '     Events     WasRun     Accept   Prescale  Trigger'
+        
+        for key in sorted(counters):
+            c = counters[key]
+            print '{0:11d} {1:10d} {2:10d} {3:10d}  {4}'.format(c[0], c[1], c[2], key[1], key[0])
+        
+        sys.exit(0)
+    
+    
     # Define regular expressions to parse log files
     pathHeaderRegex = re.compile(r'^TrigReport.*Modules\W+in\W+Path:\W+(\w+)')
     moduleTableRegex = re.compile(r'^TrigReport\W+\d+\W+\d+\W+(\d+)\W+(\d+)\W+\d+\W+\d+\W+(\w+)')
@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+
+"""Converts event lists into the binary format read by EventIDFilter.
+
+The input list is read from a text file with one ID "run:lumi:event" per
+line or from a ROOT file with tree "EventID", as produced by the pre-pass
+configuration SkimPrepass_cfg.py.  Several input files can be given, and
+their union is written.  The binary format is documented in class
+MappedEventList.  Files in this format must have extension ".evl".
+"""
+
+from __future__ import print_function
+import argparse
+from collections import defaultdict
+import struct
+
+
+def read_events(fileName, events):
+    """Read event IDs from the given file.
+    
+    Arguments:
+        fileName: Name of a text or ROOT file with event IDs.
+        events: Dictionary in which event numbers are collected.  The
+            keys are pairs (run, lumi), and the values are sets of event
+            numbers.
+    
+    Return value:
+        None.
+    """
+    
+    if fileName.endswith('.root'):
+        import ROOT
+        ROOT.PyConfig.IgnoreCommandLineOptions = True
+        
+        inputFile = ROOT.TFile.Open(fileName)
+        tree = inputFile.Get('EventID')
+        
+        if not tree:
+            raise RuntimeError('File "{}" contains no tree "EventID".'.format(fileName))
+        
+        for entry in tree:
+            events[entry.run, entry.lumi].add(entry.event)
+        
+        inputFile.Close()
+    else:
+        with open(fileName) as f:
+            for line in f:
+                line = line.strip()
+                
+                if not line:
+                    break
+                
+                run, lumi, event = line.split(':')
+                events[int(run), int(lumi)].add(int(event))
+
+
+def encode_varint(value):
+    """Encode an unsigned integer as LEB128 varint."""
+    
+    encoded = bytearray()
+    
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        
+        if value:
+            encoded.append(byte | 0x80)
+        else:
+            encoded.append(byte)
+            return encoded
+
+
+if __name__ == '__main__':
+
+    argParser = argparse.ArgumentParser(
+        epilog=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    argParser.add_argument(
+        'inputFiles', metavar='events.txt', nargs='+',
+        help='Input event lists.'
+    )
+    argParser.add_argument(
+        '-o', '--output', metavar='events.evl', required=True,
+        help='Name for the output binary file.'
+    )
+    args = argParser.parse_args()
+    
+    if not args.output.endswith('.evl'):
+        raise RuntimeError('Name of the output file must have extension ".evl".')
+    
+    
+    events = defaultdict(set)
+    
+    for fileName in args.inputFiles:
+        read_events(fileName, events)
+    
+    
+    # Build the directory and the data part.  Each entry of the directory
+    # contains the key of the luminosity section, the first event number,
+    # the number of events, and the offset of the encoded differences.
+    directory = bytearray()
+    data = bytearray()
+    numEvents = 0
+    
+    for (run, lumi) in sorted(events):
+        eventNumbers = sorted(events[run, lumi])
+        directory += struct.pack(
+            '<QQQQ', (run << 32) | lumi, eventNumbers[0], len(eventNumbers), len(data)
+        )
+        
+        for previous, current in zip(eventNumbers[:-1], eventNumbers[1:]):
+            data += encode_varint(current - previous)
+        
+        numEvents += len(eventNumbers)
+    
+    with open(args.output, 'wb') as f:
+        f.write(b'PECEVL01')
+        f.write(struct.pack('<Q', len(events)))
+        f.write(directory)
+        f.write(data)
+    
+    print('Written {} events from {} luminosity sections, {} bytes of data.'.format(
+        numEvents, len(events), len(data)
+    ))
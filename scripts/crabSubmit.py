@@ -34,6 +34,41 @@ Multiline comments (/**/) are not supported.
 It is possible to submit only a subset of all tasks defined in the JSON
 file applying a selection with option "filter".
 
+If option "target-time" is given, the number of events per job is chosen
+for each task to match the given wall time, using splitting mode
+"EventAwareLumiBased".  This is not done for tasks that set
+Data.unitsPerJob explicitly.  The required throughput (events per
+second) is read from a cache file, where it is stored for each dataset
+and hash of the cmsRun configuration (content of JobType.psetName and
+the list JobType.pyCfgParams, excluding the output file).  If the
+throughput is not in the cache and option "calibrate" is given, it is
+measured by running the configuration locally over events from the first
+file of the dataset.  Two calibration jobs are run, over the given
+number of events and over a fifth of it.  The throughput is computed
+from the differences between their wall times and between their numbers
+of processed events, which are read with service PerfMonitor (cmsRun
+option savePerf), so that the start-up of the job and the processing of
+the first event do not bias it.  The result is added to the cache.
+Otherwise the splitting from the template is used.
+
+If option "reuse" is given, outputs of earlier submissions are looked up
+in subdirectory <name> of the given directory, which must be accessible
+locally.  Their provenance (tree provenance/Provenance written by plugin
+ProvenanceWriter) is compared to the configuration of the task, which
+is loaded and hashed in the same way as done by cmsRun.  Input files
+that have already been processed with the same configuration and the
+same version of the package are excluded, and only the remaining files
+of the dataset are processed, one file per job.  Tasks whose inputs have
+all been processed are not submitted.  Merge the new outputs together
+with the reused ones with script mergeCrabRes.py (option --reuse).
+Input files are compared as a whole, and this is only correct if every
+job processes its input files entirely.  With other splitting modes,
+such as "EventAwareLumiBased" used with option "target-time", a file
+can be shared among several jobs, and luminosity sections of failed
+jobs would be lost.  For this reason option "reuse" is only accepted for
+tasks with splitting "FileBased", and all submissions of a task,
+including the first one, must be done with it.
+
 [1] https://twiki.cern.ch/twiki/bin/view/CMSPublic/SWGuideCrab
 """
 
@@ -41,12 +76,18 @@ from __future__ import print_function
 import argparse
 from copy import deepcopy
 import fnmatch
+import glob
+import hashlib
 from httplib import HTTPException
 import imp
 import json
+import os
 import re
 import shutil
+import subprocess
 import sys
+import tempfile
+import time
 
 from CRABAPI.RawCommand import crabCommand
 from CRABClient.ClientExceptions import ClientException
@@ -115,6 +156,162 @@ def extract_sample_name(sample):
     raise ConfigInvariantError('No valid name')
 
 
+def config_hash(config):
+    """Compute hash of the cmsRun configuration of a task.
+    
+    The hash is computed from the content of the configuration file and
+    the list of its parameters, excluding the name of the output file.
+    """
+    
+    h = hashlib.sha1()
+    
+    with open(config.JobType.psetName) as f:
+        h.update(f.read())
+    
+    if hasattr(config.JobType, 'pyCfgParams'):
+        for param in sorted(config.JobType.pyCfgParams):
+            if not param.startswith('outputFile='):
+                h.update(param + '\n')
+    
+    return h.hexdigest()
+
+
+def measure_throughput(config, numEvents):
+    """Measure throughput of the cmsRun configuration of a task.
+    
+    Run the configuration over the given number of events from the
+    first file of the input dataset, and over a fifth of this number,
+    and return the number of events processed per second.  Wall times of
+    the whole jobs are used, so that overheads of the event loop outside
+    of modules are included, as they are in the grid jobs.  The start-up
+    of the job and the processing of the first event, which take a long
+    time independent of the number of events, cancel in the difference
+    between the two jobs.
+    """
+    
+    fileName = subprocess.check_output([
+        'dasgoclient', '-query', 'file dataset={}'.format(config.Data.inputDataset), '-limit', '1'
+    ]).strip()
+    
+    if not fileName:
+        raise RuntimeError('No files found for dataset "{}".'.format(config.Data.inputDataset))
+    
+    shortNumProcessed, shortTime = run_calibration_job(config, fileName, max(numEvents // 5, 1))
+    longNumProcessed, longTime = run_calibration_job(config, fileName, numEvents)
+    
+    if longNumProcessed <= shortNumProcessed or longTime <= shortTime:
+        raise RuntimeError(
+            'Calibration jobs over {} and {} events are too short to measure the throughput. '
+            'Increase the number of calibration events.'.format(shortNumProcessed, longNumProcessed)
+        )
+    
+    return float(longNumProcessed - shortNumProcessed) / (longTime - shortTime)
+
+
+def run_calibration_job(config, fileName, numEvents):
+    """Run the cmsRun configuration of a task locally.
+    
+    Process up to the given number of events from the given file.
+    Return the number of processed events, which is read from the
+    performance counters, and the wall time of the whole job in seconds.
+    """
+    
+    import ROOT
+    
+    workDir = tempfile.mkdtemp()
+    params = []
+    
+    if hasattr(config.JobType, 'pyCfgParams'):
+        params = [p for p in config.JobType.pyCfgParams if not p.startswith('outputFile=')]
+    
+    params += [
+        'inputFiles=root://cms-xrd-global.cern.ch/' + fileName,
+        'maxEvents={}'.format(numEvents), 'outputFile=' + workDir + '/calibration',
+        'savePerf=True'
+    ]
+    
+    with open(workDir + '/cmsRun.log', 'w') as log:
+        startTime = time.time()
+        res = subprocess.call(
+            ['cmsRun', os.path.abspath(config.JobType.psetName)] + params,
+            stdout=log, stderr=subprocess.STDOUT
+        )
+        totalTime = time.time() - startTime
+    
+    if res != 0:
+        raise RuntimeError('Calibration job failed. See log in "{}".'.format(workDir))
+    
+    outputFile = ROOT.TFile(glob.glob(workDir + '/calibration*.root')[0])
+    
+    # The number of processed events is given by the source, which is
+    # the same for all paths
+    numProcessed = max(entry.events for entry in outputFile.Get('Perf/Paths'))
+    outputFile.Close()
+    
+    shutil.rmtree(workDir)
+    return numProcessed, totalTime
+
+
+def config_provenance(config):
+    """Compute the provenance of the cmsRun configuration of a task.
+    
+    Load the configuration with its parameters, excluding the name of
+    the output file, and return the hash of the configuration and the
+    version of the package recorded in module ProvenanceWriter.
+    """
+    
+    params = []
+    
+    if hasattr(config.JobType, 'pyCfgParams'):
+        params = [p for p in config.JobType.pyCfgParams if not p.startswith('outputFile=')]
+    
+    # VarParsing reads the parameters from the command line
+    argv = sys.argv
+    sys.argv = ['cmsRun', config.JobType.psetName] + params
+    
+    try:
+        process = imp.load_source('pecConfig', config.JobType.psetName).process
+    finally:
+        sys.argv = argv
+    
+    if not hasattr(process, 'provenance'):
+        raise RuntimeError('Configuration "{}" does not save provenance.'.format(
+            config.JobType.psetName
+        ))
+    
+    return process.provenance.configHash.value(), process.provenance.packageVersion.value()
+
+
+def processed_input_files(directory, provenance):
+    """Find input files already processed with given configuration.
+    
+    Read the provenance from all ROOT files in the directory and its
+    subdirectories and return the set of input files used in jobs whose
+    configuration hash and version of the package are as given.
+    """
+    
+    import ROOT
+    
+    processed = set()
+    
+    for dirPath, dirNames, fileNames in os.walk(directory):
+        for fileName in fileNames:
+            if not fileName.endswith('.root'):
+                continue
+            
+            inputFile = ROOT.TFile(os.path.join(dirPath, fileName))
+            tree = inputFile.Get('provenance/Provenance')
+            
+            if tree:
+                for entry in tree:
+                    if (str(entry.configHash), str(entry.packageVersion)) == provenance:
+                        processed.update(str(name) for name in entry.inputFiles)
+            
+            inputFile.Close()
+    
+    return processed
+
+
 def json_byteify(data, ignoreDicts=False):
     """A JSON hook to convert strings from Unicode.
     
@@ -201,6 +398,25 @@ if __name__ == '__main__':
         help='Comma-separated list of masks to select tasks to be submitted. Unix-style ' \
             'wildcards are supported.'
     )
+    argParser.add_argument(
+        '--target-time', metavar='hours', type=float, default=None,
+        help='Target wall time of a job. If given, the number of events per job is chosen '
+            'based on the measured throughput.'
+    )
+    argParser.add_argument(
+        '--throughput-cache', metavar='throughput.json', default='throughput.json',
+        help='File with cached throughputs.'
+    )
+    argParser.add_argument(
+        '--calibrate', metavar='events', type=int, default=0,
+        help='Number of events in local calibration jobs run if the throughput is not cached.'
+    )
+    argParser.add_argument(
+        '--reuse', metavar='directory', default=None,
+        help='Directory with outputs of earlier submissions, one subdirectory per task. Input '
+            'files already processed with the same configuration are skipped. Requires '
+            'splitting FileBased for all submissions.'
+    )
     args = argParser.parse_args()
     
     if args.filter:
@@ -243,6 +459,14 @@ if __name__ == '__main__':
         )
     
     
+    # Read cached throughputs
+    throughputs = {}
+    
+    if args.target_time and os.path.exists(args.throughput_cache):
+        with open(args.throughput_cache) as f:
+            throughputs = json.load(f, object_hook=json_byteify)
+    
+    
     # Validate configurations for all parameter sets
     for index, parameterSet in enumerate(parameterSets):
         
@@ -353,6 +577,74 @@ if __name__ == '__main__':
             
             params.append('outputFile=' + name)
         
+        # Choose the number of events per job to match the target wall
+        # time
+        if args.target_time and 'Data.unitsPerJob' not in parameterSet.keys():
+            key = '{}|{}'.format(config.Data.inputDataset, config_hash(config))
+            
+            if key not in throughputs and args.calibrate > 0:
+                print('Measuring throughput for task "{}"...'.format(name))
+                
+                try:
+                    throughputs[key] = measure_throughput(config, args.calibrate)
+                except (RuntimeError, subprocess.CalledProcessError) as e:
+                    critical_error('{}', e)
+                
+                with open(args.throughput_cache, 'w') as f:
+                    json.dump(throughputs, f, indent=2, sort_keys=True)
+            
+            if key in throughputs:
+                config.Data.splitting = 'EventAwareLumiBased'
+                config.Data.unitsPerJob = max(
+                    int(throughputs[key] * args.target_time * 3600), 1
+                )
+                print('Using {} events per job ({:.1f} events/s).'.format(
+                    config.Data.unitsPerJob, throughputs[key]
+                ))
+            else:
+                print('Throughput for task "{}" is unknown. Splitting from the template is '
+                    'used.'.format(name))
+        
+        # Only process input files that are not covered by outputs of
+        # earlier submissions
+        if args.reuse:
+            if getattr(config.Data, 'splitting', None) != 'FileBased':
+                critical_error(
+                    'Task "{}" uses splitting "{}". Outputs can only be reused for tasks split '
+                    'by files.', name, getattr(config.Data, 'splitting', None)
+                )
+            
+            try:
+                provenance = config_provenance(config)
+                processed = processed_input_files(os.path.join(args.reuse, name), provenance)
+                datasetFiles = subprocess.check_output([
+                    'dasgoclient', '-query', 'file dataset={}'.format(config.Data.inputDataset)
+                ]).split()
+            except (RuntimeError, subprocess.CalledProcessError) as e:
+                critical_error('{}', e)
+            
+            missingFiles = [f for f in datasetFiles if f not in processed]
+            
+            if not missingFiles:
+                print('All {} input files of task "{}" have already been processed. The task is '
+                    'not submitted.'.format(len(datasetFiles), name))
+                print()
+                continue
+            
+            if len(missingFiles) < len(datasetFiles):
+                print('Reusing outputs for {} of {} input files.'.format(
+                    len(datasetFiles) - len(missingFiles), len(datasetFiles)
+                ))
+                config.Data.outputPrimaryDataset = config.Data.inputDataset.split('/')[1]
+                config.Data.userInputFiles = missingFiles
+                delattr(config.Data, 'inputDataset')
+                config.Data.splitting = 'FileBased'
+                config.Data.unitsPerJob = 1
+                
+                # Keep the CRAB project directory of the earlier
+                # submission
+                config.General.requestName += time.strftime('_delta%y%m%d%H%M')
+        
         if hasattr(config.Data, 'outLFNDirBase'):
             if config.Data.outLFNDirBase.endswith('/'):
                 config.Data.outLFNDirBase += name + '/'
@@ -8,14 +8,45 @@ into several larger files.  The grouping is done such that size of each
 produced file is close to a value specified by the user (2 GiB by
 default).
 
-Merging of ROOT files does not always work well for a large number of
-input files (hundreds), and for this reason the script does it in a
-recursive manner, limiting the total number of files that are merged in
-a single act.
+Each output file is produced in a single pass by program mergePECFiles
+(built from bin/mergePECFiles.cc), and different output files are merged
+in parallel.  The program copies compressed baskets of all trees without
+recompressing them and keeps trees that are aligned in input files
+aligned in the output.  It validates the result by comparing the number
+of entries in every tree to the total over input files, which only
+requires reading headers of the trees.
 
-The result of merging is validated by counting events in a given tree in
-the output files and comparing it to the total number of events in input
-files.
+Afterwards, an index is built for the same tree in each output file
+using event ID stored in it (run and event numbers) and saved together
+with the tree.  This allows to find an entry for a given event in
+logarithmic time, without scanning the tree, e.g.:
+  tree.GetEntryNumberWithIndex(run, event)
+No index is built if event IDs are stored in the compact form (option
+compactEventID of MiniAOD_cfg.py), which does not contain run and event
+numbers in the tree.  Random access is then provided by class
+pecreader::EventIDDecoder, which uses tree LumiRanges.  Outputs of the
+quick-look mode of MiniAOD_cfg.py contain only histograms and no trees
+with events.  They are detected by the presence of the directory with
+histograms, and events are neither counted nor indexed for them.
+
+Outputs of earlier submissions of the same task can be merged together
+with the files in the current directory (option --reuse), which is the
+case when only input files not processed before have been submitted
+with crabSubmit.py.  The given directory is searched recursively for
+ROOT files, which can be outputs of individual jobs or merged files.
+Their provenance, recorded in tree provenance/Provenance, is compared
+to that of the files in the current directory.  A file is reused if it
+was produced with the same configuration and version of the package and
+none of its input files has been processed again in the current
+directory.  Files all of whose inputs have been processed again are
+superseded and skipped.  Since input files are compared as a whole, this
+requires that every job has processed its input files entirely, which
+crabSubmit.py ensures by accepting option --reuse only for tasks split
+by files.
+
+If the jobs have been run with service PerfMonitor, per-module timing
+and sizes of branches can be aggregated over all jobs and printed (option
+--perf).
 """
 
 import argparse
@@ -41,76 +72,69 @@ class InputFile(object):
     # A static regular expression to parse the name of a source file
     nameRegex = re.compile(r'^.*_(\d+)\.root$')
     
-    def __init__(self, fileName, fileSize):
+    def __init__(self, fileName, fileSize, jobIndex=None):
+        """Construct from file name and size.
+        
+        If the job index is given, it is not extracted from the name.
+        """
+        
         self.name = fileName
         
-        res = InputFile.nameRegex.match(fileName)
-        if res is None:
-            raise RuntimeError(
-                'Failed to extract job index from CRAB output file name "{}".'.format(fileName)
-            )
+        if jobIndex is None:
+            res = InputFile.nameRegex.match(fileName)
+            if res is None:
+                raise RuntimeError(
+                    'Failed to extract job index from CRAB output file name "{}".'.format(
+                        fileName
+                    )
+                )
+            
+            jobIndex = int(res.group(1))
         
-        self.jobIndex = int(res.group(1))
+        self.jobIndex = jobIndex
         self.size = fileSize
 
 
 class Partitioner(object):
-    """Class to split a list of files into parts by size and length.
+    """Class to split a list of files into parts by size.
     
     Input files are grouped into "parts" such that the total size of
-    each part is close to the given target value.  Files assigned to
-    each part are further split into blocks such that number of files
-    in each block does not exceed the given limit.  Ordering of input
+    each part is close to the given target value.  Ordering of input
     files is preserved.
     """
     
-    def __init__(self, targetPartSize, maxBlockLength):
-        """Create new object giving target part size and block length.
+    def __init__(self, targetPartSize):
+        """Create new object giving target part size.
         
         The part size is given in bytes.
         """
         
         self.targetPartSize = targetPartSize
-        self.maxBlockLength = maxBlockLength
         
-        self.parts = [[[]]]
+        self.parts = [[]]
         self._curPart = self.parts[0]
         self._curPartSize = 0
-        self._curBlock = self._curPart[0]
-        self._curBlockLength = 0
     
     
     def _add_cur_part(self, inputFile):
-        """Add a file to the current part.
+        """Add a file to the current part."""
         
-        A new block is created in the current part if needed.
-        """
-        
-        if self._curBlockLength == self.maxBlockLength:
-            # Create a new block within the current part
-            self._curPart.append([])
-            self._curBlock = self._curPart[-1]
-            self._curBlockLength = 0
-        
-        self._curBlock.append(inputFile)
-        self._curBlockLength += 1
+        self._curPart.append(inputFile)
         self._curPartSize += inputFile.size
     
     
     def _close_part(self):
         """Close current part and add a new one."""
         
-        self.parts.append([[]])
+        self.parts.append([])
         self._curPart = self.parts[-1]
         self._curPartSize = 0
-        self._curBlock = self._curPart[0]
-        self._curBlockLength = 0
     
     
     def add(self, inputFile):
         """Add new input file.
         
-        New blocks and parts are created as necessary.
+        New parts are created as necessary.
         """
         
         newPartSize = self._curPartSize + inputFile.size
@@ -136,10 +160,9 @@ class Partitioner(object):
         
         # It is possible to have an empty part at the end.  Remove it
         # if present.
-        if len(self.parts[-1]) == 1 and len(self.parts[-1][0]) == 0:
+        if len(self.parts[-1]) == 0:
             del(self.parts[-1])
             self._curPart = None
-            self._curBlock = None
         
         return self.parts
 
@@ -164,6 +187,212 @@ def count_events(inputFiles, treeName):
     return counter
         
 
+def inspect_event_tree(fileName, treeName, branchName, histDirName='pecHistograms'):
+    """Determine how events are stored in the given file.
+    
+    Return 'quickLook' if the file does not contain the tree with
+    events but contains the directory with histograms filled in the
+    quick-look mode, 'compact' if the event ID is stored in the compact
+    form written by PECWriter (branch <branchName>_eventDelta), and
+    'full' otherwise.  Raise an exception if neither the tree nor the
+    directory with histograms is found.
+    """
+    
+    f = ROOT.TFile(fileName)
+    tree = f.Get(treeName)
+    
+    if not tree:
+        hasHistograms = bool(f.Get(histDirName))
+        f.Close()
+        
+        if hasHistograms:
+            return 'quickLook'
+        
+        raise RuntimeError(
+            'File "{}" does not contain requested tree "{}".'.format(fileName, treeName)
+        )
+    
+    if not tree.GetBranch(branchName) and tree.GetBranch(branchName + '_eventDelta'):
+        storage = 'compact'
+    else:
+        storage = 'full'
+    
+    f.Close()
+    return storage
+
+
+def build_index(fileName, treeName, branchName):
+    """Build and store an index of the tree based on event ID.
+    
+    The index is an instance of TTreeIndex, which sorts entries by run
+    number (major value) and event number (minor value).  It is written
+    into the file together with the tree.  Both the layout with objects
+    pec::EventID and the flat layout, in which the event ID is stored in
+    branches <branchName>_run, etc., are supported.
+    """
+    
+    f = ROOT.TFile(fileName, 'update')
+    tree = f.Get(treeName)
+    
+    if not tree:
+        raise RuntimeError(
+            'File "{}" does not contain requested tree "{}".'.format(fileName, treeName)
+        )
+    
+    separator = '_' if tree.GetBranch(branchName + '_run') else '.'
+    
+    if tree.BuildIndex(branchName + separator + 'run', branchName + separator + 'event') < 0:
+        raise RuntimeError('Failed to build index for tree "{}" in file "{}".'.format(
+            treeName, fileName
+        ))
+    
+    tree.GetDirectory().cd()
+    tree.Write('', ROOT.TObject.kOverwrite)
+    f.Close()
+
+
+def read_provenance(fileName):
+    """Read provenance of the given file.
+    
+    Return a list with one tuple (configHash, packageVersion,
+    inputFiles) for each job that contributed to the file.  The list is
+    empty if the file does not contain tree provenance/Provenance.
+    """
+    
+    f = ROOT.TFile(fileName)
+    tree = f.Get('provenance/Provenance')
+    records = []
+    
+    if tree:
+        for entry in tree:
+            records.append((
+                str(entry.configHash), str(entry.packageVersion),
+                set(str(name) for name in entry.inputFiles)
+            ))
+    
+    f.Close()
+    return records
+
+
+def find_reusable_files(directory, currentFileNames):
+    """Find earlier outputs that can be merged with the current ones.
+    
+    Search the directory recursively for ROOT files whose provenance
+    matches the configuration of the current files and whose input
+    files have not been processed again.  Return a list of InputFile
+    ordered by name.
+    """
+    
+    currentProvenance = set()
+    currentInputs = set()
+    
+    for fileName in currentFileNames:
+        records = read_provenance(fileName)
+        
+        if not records:
+            raise RuntimeError('File "{}" does not contain provenance.'.format(fileName))
+        
+        for configHash, packageVersion, inputs in records:
+            currentProvenance.add((configHash, packageVersion))
+            currentInputs.update(inputs)
+    
+    if len(currentProvenance) != 1:
+        raise RuntimeError(
+            'Files in the current directory have been produced with {} different '
+            'configurations.'.format(len(currentProvenance))
+        )
+    
+    reusableFiles = []
+    
+    for dirPath, dirNames, fileNames in os.walk(directory):
+        for fileName in fileNames:
+            if not fileName.endswith('.root'):
+                continue
+            
+            path = os.path.join(dirPath, fileName)
+            records = read_provenance(path)
+            
+            if not records or any(
+                (configHash, packageVersion) not in currentProvenance
+                for configHash, packageVersion, inputs in records
+            ):
+                continue
+            
+            inputs = set.union(*[r[2] for r in records])
+            overlap = inputs & currentInputs
+            
+            if overlap == inputs:
+                print 'File "{}" is superseded by the current outputs.'.format(path)
+                continue
+            elif overlap:
+                raise RuntimeError(
+                    'Input files of "{}" have been partly processed again in the current '
+                    'outputs.'.format(path)
+                )
+            
+            currentInputs.update(inputs)
+            reusableFiles.append(InputFile(path, os.stat(path).st_size, jobIndex=-1))
+    
+    reusableFiles.sort(key=attrgetter('name'))
+    return reusableFiles
+
+
+def summarize_perf(fileNames, maxEntries):
+    """Print aggregated performance counters saved by PerfMonitor.
+    
+    Counters from all given files are summed up for each module and for
+    each branch.  Modules are ordered by the total wall time and
+    branches by their compressed size.  Only the given number of
+    leading entries is printed in each case.
+    """
+    
+    moduleTimes, moduleEvents = {}, {}
+    branchZipBytes, branchTotBytes = {}, {}
+    
+    for fileName in fileNames:
+        f = ROOT.TFile(fileName)
+        modulesTree = f.Get('Perf/Modules')
+        branchesTree = f.Get('Perf/Branches')
+        
+        if not modulesTree or not branchesTree:
+            raise RuntimeError('File "{}" does not contain performance counters.'.format(
+                fileName
+            ))
+        
+        for entry in modulesTree:
+            key = (str(entry.label), str(entry.type))
+            moduleTimes[key] = moduleTimes.get(key, 0.) + entry.realTime
+            moduleEvents[key] = moduleEvents.get(key, 0) + entry.events
+        
+        for entry in branchesTree:
+            key = '{}/{}'.format(entry.tree, entry.branch)
+            branchZipBytes[key] = branchZipBytes.get(key, 0) + entry.zipBytes
+            branchTotBytes[key] = branchTotBytes.get(key, 0) + entry.totBytes
+        
+        f.Close()
+    
+    totalTime = sum(moduleTimes.itervalues())
+    print 'Modules with largest wall time (total {:.1f} s):'.format(totalTime)
+    
+    for key in sorted(moduleTimes, key=moduleTimes.get, reverse=True)[:maxEntries]:
+        print ' {:40} {:30} {:10.1f} s {:6.1f}% {:12d} events'.format(
+            key[0], key[1], moduleTimes[key], 100. * moduleTimes[key] / max(totalTime, 1e-9),
+            moduleEvents[key]
+        )
+    
+    totalZipBytes = sum(branchZipBytes.itervalues())
+    print 'Branches with largest compressed size (total {:.1f} MiB):'.format(
+        totalZipBytes / 1024.**2
+    )
+    
+    for key in sorted(branchZipBytes, key=branchZipBytes.get, reverse=True)[:maxEntries]:
+        print ' {:60} {:10.2f} MiB {:6.1f}% compression {:.2f}'.format(
+            key, branchZipBytes[key] / 1024.**2,
+            100. * branchZipBytes[key] / max(totalZipBytes, 1),
+            float(branchTotBytes[key]) / max(branchZipBytes[key], 1)
+        )
+
+
 def critical_error(formatString, *args, **kwargs):
     """Report a critical error.
     
@@ -176,25 +405,17 @@ def critical_error(formatString, *args, **kwargs):
     sys.exit(1)
 
 
-def merge_files(outputFileName, inputFiles):
+def merge_files(outputFileName, inputFiles, maxOpenFiles):
     """Merge provided ROOT files.
     
-    Perform the task by calling the hadd program from ROOT distribution.
-    Alternatively, could have used TFileMerger class, but it is not
-    clear if it can run in a multithread environment.
+    Perform the task by calling program mergePECFiles, which also
+    validates the result.  Raise an exception in case of a failure.
     """
     
-    # Make sure there is more than one source file
-    if len(inputFiles) > 1:
-        devnull = open('/dev/null', 'w')
-        res = call(['hadd', '-v0', outputFileName] + inputFiles,
-            stdout=devnull, stderr=devnull)
-        devnull.close()
-        
-        if res != 0:
-            raise RuntimeError('Call to hadd terminated with an error.')
-    else:
-        shutil.copyfile(inputFiles[0], outputFileName)
+    res = call(['mergePECFiles', '-n', str(maxOpenFiles), outputFileName] + inputFiles)
+    
+    if res != 0:
+        raise RuntimeError('Failed to merge files into "{}".'.format(outputFileName))
 
 
 
@@ -224,13 +445,32 @@ if __name__ == '__main__':
         type=int, default=5, dest='num_threads'
     )
     argParser.add_argument(
-        '--max-files-to-merge', help='Maximal number of files to be merged in a single act',
-        type=int, default=256, dest='max_files_to_merge'
+        '--max-open-files', help='Maximal number of input files opened simultaneously when '
+            'producing an output file',
+        type=int, default=256, dest='max_open_files'
     )
     argParser.add_argument(
         '-t', '--tree-name', help='Name of a tree to count events',
         default='pecEventID/EventID', dest='tree_name'
     )
+    argParser.add_argument(
+        '--id-branch', help='Name of the branch with event ID in the tree used to count events',
+        default='eventId', dest='id_branch'
+    )
+    argParser.add_argument(
+        '--no-index', help='Do not build index of the tree based on event ID',
+        action='store_true', dest='no_index'
+    )
+    argParser.add_argument(
+        '--perf', help='Print performance counters aggregated over all jobs. The argument is '
+            'the number of leading modules and branches to print',
+        type=int, default=0, metavar='N', dest='perf'
+    )
+    argParser.add_argument(
+        '--reuse', help='Directory with outputs of earlier submissions to be merged together '
+            'with the files in the current directory if their provenance matches',
+        default=None, dest='reuse'
+    )
     argParser.add_argument(
         '-k', '--keep-tmp-files', help='Do not delete temporary files',
         action='store_true', dest='keep_tmp_files'
@@ -265,49 +505,48 @@ if __name__ == '__main__':
     
     inputFiles.sort(key=attrgetter('jobIndex'))
     
+    # Deduce the base name of output ROOT files: everything before the
+    # job number.  It is used to name output files.
+    res = re.match(r'(.*)_\d+\.root', inputFiles[0].name)
+    baseOutputName = res.group(1)
+    numJobFiles = len(inputFiles)
+    
+    
+    # Add outputs of earlier submissions.  They precede the files from
+    # the current directory.
+    if args.reuse:
+        try:
+            reusableFiles = find_reusable_files(
+                args.reuse, [inputFile.name for inputFile in inputFiles]
+            )
+        except RuntimeError as e:
+            critical_error('{}', e)
+        
+        print 'Reusing {} files from directory "{}".'.format(len(reusableFiles), args.reuse)
+        inputFiles = reusableFiles + inputFiles
+    
     
     # Split the list of input files into parts such that the total size
-    # of each part is close to the given target.  Files assigned to each
-    # part are further split into blocks with the given maximal size (in
-    # terms of the number of files), which will be merged independently.
-    partitioner = Partitioner(args.target_size * 1024**3, args.max_files_to_merge)
+    # of each part is close to the given target
+    partitioner = Partitioner(args.target_size * 1024**3)
     for inputFile in inputFiles:
         partitioner.add(inputFile)
     
     parts = partitioner.get_partitioning()
     
     
-    # Prepare to merge files in the blocks.  First create a temporary
-    # output directory.
+    # Prepare to merge files.  First create a temporary output directory.
     outputDir = args.out_dir
     if not os.path.exists(outputDir):
         os.makedirs(outputDir)
     tmpDir = tempfile.mkdtemp(dir=outputDir)
     tmpDir += '/'
-        
-    # Deduce the base name of output ROOT files: everything before the
-    # job number.  It is used to name output files.
-    res = re.match(r'(.*)_\d+\.root', inputFiles[0].name)
-    baseOutputName = res.group(1)
-    
-    
-    # Merge files in the blocks
-    pool = Pool(processes=args.num_threads)
-    
-    for iPart, part in enumerate(parts):
-        for iBlock, block in enumerate(part):
-            outputName = tmpDir + '{baseName}_part{partNumber:d}_{blockNumber:d}.root'.format(
-                baseName=baseOutputName, partNumber=iPart + 1, blockNumber=iBlock + 1
-            )
-            pool.apply_async(merge_files, (outputName, [inputFile.name for inputFile in block]))
-    
-    pool.close()
-    pool.join()
     
     
-    # Now merge the blocks to produce final files
+    # Merge files in all parts in parallel
     partFileShortNames = []
     pool = Pool(processes=args.num_threads)
+    results = []
     
     for iPart, part in enumerate(parts):
         if len(parts) > 1:
@@ -318,21 +557,20 @@ if __name__ == '__main__':
             outputShortName = baseOutputName + '.root'
         
         partFileShortNames.append(outputShortName)
-        outputName = tmpDir + outputShortName
-        
-        blockFiles = []
-        for iBlock in range(len(part)):
-            blockFiles.append(
-                tmpDir + '{baseName}_part{partNumber:d}_{blockNumber:d}.root'.format(
-                    baseName=baseOutputName, partNumber=iPart + 1, blockNumber=iBlock + 1
-                )
-            )
-        
-        pool.apply_async(merge_files, (outputName, blockFiles))
+        results.append(pool.apply_async(merge_files, (
+            tmpDir + outputShortName, [inputFile.name for inputFile in part],
+            args.max_open_files
+        )))
     
     pool.close()
     pool.join()
     
+    for result in results:
+        try:
+            result.get()
+        except RuntimeError as e:
+            critical_error('{}', e)
+    
     
     # Move merged files to the output directory and delete the temporary
     # directory with all temporary files
@@ -349,21 +587,35 @@ if __name__ == '__main__':
     
     
     # Print out names of the final files
-    print 'Results of {} jobs have been merged into the following files:'.format(len(inputFiles))
+    print 'Results of {} jobs have been merged into the following files:'.format(numJobFiles)
     outputFiles = [outputDir + shortName for shortName in partFileShortNames]
     for fileName in outputFiles:
         print '', fileName
     
     
-    # Count events in input and processed files
-    nEventInput = count_events([inputFile.name for inputFile in inputFiles], args.tree_name)
-    nEventMerged = count_events(outputFiles, args.tree_name)
+    # Report the number of events.  Consistency with the input files has
+    # already been checked by mergePECFiles.  All files have been
+    # produced with the same configuration, so it is sufficient to
+    # inspect the first one.
+    try:
+        storage = inspect_event_tree(outputFiles[0], args.tree_name, args.id_branch)
+    except RuntimeError as e:
+        critical_error('{}', e)
     
-
-    if nEventInput != nEventMerged:
-        critical_error(
-            'Total number of events in input and merged files do not agree ({} vs {}).',
-            nEventInput, nEventMerged
-        )
+    if storage == 'quickLook':
+        print 'The files have been produced in the quick-look mode and contain no events.'
     else:
-        print 'Total number of events in these files:', nEventMerged
+        print 'Total number of events in these files:', count_events(outputFiles, args.tree_name)
+    
+    
+    # Build indices based on event ID
+    if storage == 'compact' and not args.no_index:
+        print 'Event IDs are stored in the compact form. No index is built.'
+    elif storage == 'full' and not args.no_index:
+        for fileName in outputFiles:
+            build_index(fileName, args.tree_name, args.id_branch)
+    
+    
+    # Print aggregated performance counters
+    if args.perf > 0:
+        summarize_perf(outputFiles, args.perf)
@@ -2,7 +2,10 @@
 
 """Converts PEC files into JSON format for release validation.
 
-Only a subset of properties are considered.
+Only a subset of properties are considered.  This event-by-event dump is
+only practical for a small number of events.  For large samples use the
+compiled program validatePECFiles, which compares productions with
+histograms and checks a sampled subset of events exactly.
 """
 
 from __future__ import print_function
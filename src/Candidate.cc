@@ -1,41 +1,51 @@
 #include <Analysis/PECTuples/interface/Candidate.h>
 
+#include <Analysis/PECTuples/interface/Minifloat.h>
+
+#include <cmath>
+
+
+using namespace pec::minifloat;
+
 
 pec::Candidate::Candidate() noexcept:
-    pt(0), eta(0), phi(0), mass(0)
+    pt(0),
+    etaCode(QuantizeGrid(0.f, -maxAbsEta, maxAbsEta, etaBits)),
+    phiCode(QuantizeGrid(0.f, -M_PI, M_PI, phiBits, true)),
+    mass(0)
 {}
 
 
 void pec::Candidate::Reset()
 {
     pt = 0;
-    eta = 0;
-    phi = 0;
+    etaCode = QuantizeGrid(0.f, -maxAbsEta, maxAbsEta, etaBits);
+    phiCode = QuantizeGrid(0.f, -M_PI, M_PI, phiBits, true);
     mass = 0;
 }
 
 
 void pec::Candidate::SetPt(float pt_)
 {
-    pt = pt_;
+    pt = RoundMantissa(pt_, ptMantissaBits);
 }
 
 
 void pec::Candidate::SetEta(float eta_)
 {
-    eta = eta_;
+    etaCode = QuantizeGrid(eta_, -maxAbsEta, maxAbsEta, etaBits);
 }
 
 
 void pec::Candidate::SetPhi(float phi_)
 {
-    phi = phi_;
+    phiCode = QuantizeGrid(phi_, -M_PI, M_PI, phiBits, true);
 }
 
 
 void pec::Candidate::SetM(float mass_)
 {
-    mass = mass_;
+    mass = RoundMantissa(mass_, massMantissaBits);
 }
 
 
@@ -47,13 +57,13 @@ float pec::Candidate::Pt() const
 
 float pec::Candidate::Eta() const
 {
-    return eta;
+    return DequantizeGrid(etaCode, -maxAbsEta, maxAbsEta, etaBits);
 }
 
 
 float pec::Candidate::Phi() const
 {
-    return phi;
+    return DequantizeGrid(phiCode, -M_PI, M_PI, phiBits);
 }
 
 
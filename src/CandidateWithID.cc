@@ -5,7 +5,8 @@
 
 pec::CandidateWithID::CandidateWithID() noexcept:
     Candidate(),
-    id(0)
+    id(0),
+    triggerMatches(0)
 {}
 
 
@@ -14,27 +15,56 @@ void pec::CandidateWithID::Reset()
     Candidate::Reset();
     
     id = 0;
+    triggerMatches = 0;
 }
 
 
 void pec::CandidateWithID::SetBit(unsigned index, bool value /*= true*/)
 {
-    if (index >= 8)
+    if (index >= maxIdBits)
         throw std::runtime_error("CandidateWithID::SetBit: Given index exceeds the maximal allowed "
          "value.");
     
     if (value)
-        id |= (1 << index);
+        id |= (IdBits_t(1) << index);
     else
-        id &= ~(1 << index);
+        id &= ~(IdBits_t(1) << index);
 }
 
 
 bool pec::CandidateWithID::TestBit(unsigned index) const
 {
-    if (index >= 8)
+    if (index >= maxIdBits)
         throw std::runtime_error("CandidateWithID::TestBit: Given index exceeds the maximal "
          "allowed value.");
     
-    return (id & (1 << index));
+    return (id & (IdBits_t(1) << index));
+}
+
+
+pec::CandidateWithID::IdBits_t pec::CandidateWithID::IdBits() const
+{
+    return id;
+}
+
+
+void pec::CandidateWithID::SetTriggerMatches(unsigned mask)
+{
+    triggerMatches = mask;
+}
+
+
+unsigned pec::CandidateWithID::TriggerMatches() const
+{
+    return triggerMatches;
+}
+
+
+bool pec::CandidateWithID::TestTriggerMatch(unsigned index) const
+{
+    if (index >= 32)
+        throw std::runtime_error("CandidateWithID::TestTriggerMatch: Given index exceeds the "
+         "maximal allowed value.");
+    
+    return (triggerMatches & (1u << index));
 }
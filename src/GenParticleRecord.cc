@@ -0,0 +1,104 @@
+#include <Analysis/PECTuples/interface/GenParticleRecord.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+
+pec::GenParticleRecord::GenParticleRecord() noexcept
+{}
+
+
+void pec::GenParticleRecord::Reset()
+{
+    pdgIdTable.clear();
+    pdgIdCodes.clear();
+    statuses.clear();
+    momenta.clear();
+    motherEnds.clear();
+    motherOffsets.clear();
+}
+
+
+unsigned pec::GenParticleRecord::AddParticle(int pdgId, int status, float pt, float eta,
+  float phi, float mass)
+{
+    if (pdgIdCodes.size() >= maxSize)
+        throw std::runtime_error("GenParticleRecord::AddParticle: Too many particles.");
+    
+    
+    // Find the code for the PDG ID. The table is short, so a linear search suffices
+    auto const res = std::find(pdgIdTable.begin(), pdgIdTable.end(), pdgId);
+    pdgIdCodes.push_back(res - pdgIdTable.begin());
+    
+    if (res == pdgIdTable.end())
+        pdgIdTable.push_back(pdgId);
+    
+    
+    statuses.push_back(std::min(std::max(status, 0), 255));
+    
+    momenta.emplace_back();
+    Candidate &p4 = momenta.back();
+    p4.SetPt(pt);
+    p4.SetEta(eta);
+    p4.SetPhi(phi);
+    p4.SetM(mass);
+    
+    motherEnds.push_back(motherOffsets.size());
+    
+    return pdgIdCodes.size() - 1;
+}
+
+
+void pec::GenParticleRecord::AddMother(unsigned motherIndex)
+{
+    if (pdgIdCodes.empty())
+        throw std::runtime_error("GenParticleRecord::AddMother: No particles in the record.");
+    
+    if (motherIndex >= maxSize)
+        throw std::runtime_error("GenParticleRecord::AddMother: Illegal index.");
+    
+    if (motherOffsets.size() >= maxSize)
+        throw std::runtime_error("GenParticleRecord::AddMother: Too many mothers.");
+    
+    unsigned const daughterIndex = pdgIdCodes.size() - 1;
+    motherOffsets.push_back((daughterIndex - motherIndex) & 0xFFFF);
+    ++motherEnds.back();
+}
+
+
+unsigned pec::GenParticleRecord::Size() const
+{
+    return pdgIdCodes.size();
+}
+
+
+int pec::GenParticleRecord::PdgId(unsigned index) const
+{
+    return pdgIdTable.at(pdgIdCodes.at(index));
+}
+
+
+int pec::GenParticleRecord::Status(unsigned index) const
+{
+    return statuses.at(index);
+}
+
+
+pec::Candidate const &pec::GenParticleRecord::Momentum(unsigned index) const
+{
+    return momenta.at(index);
+}
+
+
+unsigned pec::GenParticleRecord::NumMothers(unsigned index) const
+{
+    unsigned const begin = (index > 0) ? motherEnds.at(index - 1) : 0;
+    return motherEnds.at(index) - begin;
+}
+
+
+unsigned pec::GenParticleRecord::MotherIndex(unsigned index, unsigned iMother) const
+{
+    unsigned const begin = (index > 0) ? motherEnds.at(index - 1) : 0;
+    return (index - motherOffsets.at(begin + iMother)) & 0xFFFF;
+}
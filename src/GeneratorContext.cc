@@ -0,0 +1,129 @@
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
+
+#include <stdexcept>
+
+
+pec::GeneratorContext::GeneratorContext() noexcept:
+    processId(0),
+    nominalWeight(0.),
+    hasLhe(false),
+    lheNominalWeight(0.), lheRescaleFactor(1.),
+    hasPdf(false),
+    pdfX(), pdfId(),
+    pdfQScale(0.)
+{}
+
+
+void pec::GeneratorContext::SetProcessId(int processId_)
+{
+    processId = processId_;
+}
+
+
+void pec::GeneratorContext::SetNominalWeight(double weight)
+{
+    nominalWeight = weight;
+}
+
+
+void pec::GeneratorContext::SetLheNominalWeight(double weight, double rescaleFactor)
+{
+    hasLhe = true;
+    lheNominalWeight = weight;
+    lheRescaleFactor = rescaleFactor;
+}
+
+
+std::vector<double> &pec::GeneratorContext::AltLheWeights()
+{
+    return altLheWeights;
+}
+
+
+std::vector<double> &pec::GeneratorContext::AltPsWeights()
+{
+    return altPsWeights;
+}
+
+
+void pec::GeneratorContext::SetPdf(float x1, float x2, int id1, int id2, float qScale)
+{
+    hasPdf = true;
+    pdfX[0] = x1;
+    pdfX[1] = x2;
+    pdfId[0] = id1;
+    pdfId[1] = id2;
+    pdfQScale = qScale;
+}
+
+
+int pec::GeneratorContext::ProcessId() const
+{
+    return processId;
+}
+
+
+double pec::GeneratorContext::NominalWeight() const
+{
+    return nominalWeight;
+}
+
+
+bool pec::GeneratorContext::HasLhe() const
+{
+    return hasLhe;
+}
+
+
+double pec::GeneratorContext::LheNominalWeight() const
+{
+    return lheNominalWeight;
+}
+
+
+double pec::GeneratorContext::LheRescaleFactor() const
+{
+    return lheRescaleFactor;
+}
+
+
+std::vector<double> const &pec::GeneratorContext::AltLheWeights() const
+{
+    return altLheWeights;
+}
+
+
+std::vector<double> const &pec::GeneratorContext::AltPsWeights() const
+{
+    return altPsWeights;
+}
+
+
+bool pec::GeneratorContext::HasPdf() const
+{
+    return hasPdf;
+}
+
+
+float pec::GeneratorContext::PdfX(unsigned index) const
+{
+    if (index > 1)
+        throw std::logic_error("GeneratorContext::PdfX: Illegal parton index.");
+    
+    return pdfX[index];
+}
+
+
+int pec::GeneratorContext::PdfId(unsigned index) const
+{
+    if (index > 1)
+        throw std::logic_error("GeneratorContext::PdfId: Illegal parton index.");
+    
+    return pdfId[index];
+}
+
+
+float pec::GeneratorContext::PdfQScale() const
+{
+    return pdfQScale;
+}
@@ -1,4 +1,5 @@
 #include <Analysis/PECTuples/interface/GeneratorInfo.h>
+#include <Analysis/PECTuples/interface/Minifloat.h>
 
 #include <algorithm>
 #include <stdexcept>
@@ -7,6 +8,7 @@
 pec::GeneratorInfo::GeneratorInfo() noexcept:
     processId(0),
     nominalWeight(0),
+    altLheRatioMin(0.), altLheRatioMax(0.),
     pdfX(),  // the array is zeroed according to the C++03 standard
     pdfId(0),
     pdfQScale(0)
@@ -18,6 +20,8 @@ void pec::GeneratorInfo::Reset()
     processId = 0;
     nominalWeight = 0;
     altLheWeights.clear();
+    altLheRatioMin = altLheRatioMax = 0.;
+    altLheRatioCodes.clear();
     altPsWeights.clear();
     pdfId = 0;
     pdfX[0] = pdfX[1] = 0;
@@ -37,9 +41,54 @@ void pec::GeneratorInfo::SetNominalWeight(float weight)
 }
 
 
+void pec::GeneratorInfo::SetAltLheWeightRatioRange(float min, float max)
+{
+    if (not (min < max))
+        throw std::logic_error("GeneratorInfo::SetAltLheWeightRatioRange: Empty range.");
+    
+    if (not altLheWeights.empty() or not altLheRatioCodes.empty())
+        throw std::logic_error("GeneratorInfo::SetAltLheWeightRatioRange: Alternative LHE "
+         "weights have already been added.");
+    
+    altLheRatioMin = min;
+    altLheRatioMax = max;
+}
+
+
 void pec::GeneratorInfo::AddAltLheWeight(float weight)
 {
-    altLheWeights.emplace_back(weight);
+    if (not AltLheWeightsAsRatios())
+    {
+        altLheWeights.emplace_back(weight);
+        return;
+    }
+    
+    if (nominalWeight == 0.)
+        throw std::logic_error("GeneratorInfo::AddAltLheWeight: Cannot compute ratio to a zero "
+         "nominal weight.");
+    
+    altLheRatioCodes.emplace_back(minifloat::Quantize(weight / nominalWeight, altLheRatioMin,
+     altLheRatioMax, altLheRatioBits));
+}
+
+
+void pec::GeneratorInfo::SetAltLheWeights(float const *weights, unsigned size)
+{
+    if (not AltLheWeightsAsRatios())
+    {
+        altLheWeights.assign(weights, weights + size);
+        return;
+    }
+    
+    if (nominalWeight == 0.)
+        throw std::logic_error("GeneratorInfo::SetAltLheWeights: Cannot compute ratios to a zero "
+         "nominal weight.");
+    
+    altLheRatioCodes.resize(size);
+    
+    for (unsigned i = 0; i < size; ++i)
+        altLheRatioCodes[i] = minifloat::Quantize(weights[i] / nominalWeight, altLheRatioMin,
+         altLheRatioMax, altLheRatioBits);
 }
 
 
@@ -49,6 +98,12 @@ void pec::GeneratorInfo::AddAltPsWeight(float weight)
 }
 
 
+void pec::GeneratorInfo::SetAltPsWeights(float const *weights, unsigned size)
+{
+    altPsWeights.assign(weights, weights + size);
+}
+
+
 void pec::GeneratorInfo::SetPdfX(unsigned index, float x)
 {
     // Check the index
@@ -125,9 +180,40 @@ float pec::GeneratorInfo::NominalWeight() const
 }
 
 
-std::vector<Float_t> const &pec::GeneratorInfo::AltLheWeights() const
+std::vector<Float_t> pec::GeneratorInfo::AltLheWeights() const
+{
+    if (not AltLheWeightsAsRatios())
+        return altLheWeights;
+    
+    std::vector<Float_t> weights;
+    weights.reserve(altLheRatioCodes.size());
+    
+    for (unsigned i = 0; i < altLheRatioCodes.size(); ++i)
+        weights.emplace_back(AltLheWeight(i));
+    
+    return weights;
+}
+
+
+float pec::GeneratorInfo::AltLheWeight(unsigned index) const
+{
+    if (not AltLheWeightsAsRatios())
+        return altLheWeights.at(index);
+    
+    return nominalWeight * minifloat::Dequantize(altLheRatioCodes.at(index), altLheRatioMin,
+     altLheRatioMax, altLheRatioBits);
+}
+
+
+unsigned pec::GeneratorInfo::NumAltLheWeights() const
+{
+    return (AltLheWeightsAsRatios()) ? altLheRatioCodes.size() : altLheWeights.size();
+}
+
+
+bool pec::GeneratorInfo::AltLheWeightsAsRatios() const
 {
-    return altLheWeights;
+    return (altLheRatioMin < altLheRatioMax);
 }
 
 
@@ -15,7 +15,8 @@ pec::Jet::Jet() noexcept:
     area(0),
     charge(0),
     pullAngle(0),
-    flavours(0)
+    flavours(0),
+    jecEtaBin(0), jecPtNode(0)
 {}
 
 
@@ -33,6 +34,7 @@ void pec::Jet::Reset()
     charge = 0;
     pullAngle = 0;
     flavours = 0;
+    jecEtaBin = jecPtNode = 0;
 }
 
 
@@ -54,6 +56,16 @@ void pec::Jet::SetJERUncertainty(float jerUncertainty_)
 }
 
 
+void pec::Jet::SetJECUncBins(unsigned etaBin, unsigned ptNode)
+{
+    if (etaBin > 255 or ptNode > 255)
+        throw std::runtime_error("pec::Jet::SetJECUncBins: Given index exceeds 255.");
+    
+    jecEtaBin = etaBin;
+    jecPtNode = ptNode;
+}
+
+
 void pec::Jet::SetBTag(BTagAlgo algo, float value)
 {
     bTags[unsigned(algo)] = value;
@@ -173,6 +185,18 @@ float pec::Jet::JERUncertainty() const
 }
 
 
+unsigned pec::Jet::JECEtaBin() const
+{
+    return jecEtaBin;
+}
+
+
+unsigned pec::Jet::JECPtNode() const
+{
+    return jecPtNode;
+}
+
+
 float pec::Jet::BTag(BTagAlgo algo) const
 {
     return bTags[unsigned(algo)];
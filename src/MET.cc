@@ -0,0 +1,93 @@
+#include <Analysis/PECTuples/interface/MET.h>
+
+#include <Analysis/PECTuples/interface/Minifloat.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+using namespace pec::minifloat;
+
+
+pec::MET::MET() noexcept:
+    px(0), py(0),
+    shifts{}
+{}
+
+
+void pec::MET::Reset()
+{
+    px = 0;
+    py = 0;
+    std::fill(&shifts[0][0], &shifts[0][0] + 2 * numVariations, 0);
+}
+
+
+void pec::MET::SetP(float px_, float py_)
+{
+    px = RoundMantissa(px_, mantissaBits);
+    py = RoundMantissa(py_, mantissaBits);
+}
+
+
+void pec::MET::SetShiftedP(Variation var, float px_, float py_)
+{
+    unsigned const i = unsigned(var);
+    shifts[i][0] = EncodeShift(px_ - px);
+    shifts[i][1] = EncodeShift(py_ - py);
+}
+
+
+float pec::MET::Px() const
+{
+    return px;
+}
+
+
+float pec::MET::Py() const
+{
+    return py;
+}
+
+
+float pec::MET::Pt() const
+{
+    return std::hypot(px, py);
+}
+
+
+float pec::MET::Phi() const
+{
+    return std::atan2(py, px);
+}
+
+
+float pec::MET::Px(Variation var) const
+{
+    return px + shifts[unsigned(var)][0] * shiftUnit;
+}
+
+
+float pec::MET::Py(Variation var) const
+{
+    return py + shifts[unsigned(var)][1] * shiftUnit;
+}
+
+
+float pec::MET::Pt(Variation var) const
+{
+    return std::hypot(Px(var), Py(var));
+}
+
+
+float pec::MET::Phi(Variation var) const
+{
+    return std::atan2(Py(var), Px(var));
+}
+
+
+Short_t pec::MET::EncodeShift(float shift)
+{
+    float const code = std::round(shift / shiftUnit);
+    return Short_t(std::min(std::max(code, -32767.f), 32767.f));
+}
@@ -0,0 +1,77 @@
+#include <Analysis/PECTuples/interface/Minifloat.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+
+float pec::minifloat::RoundMantissa(float x, unsigned nBits)
+{
+    if (nBits >= 23)
+        return x;
+    
+    std::uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    
+    // Leave infinities and NaN intact
+    if ((bits & 0x7F800000) == 0x7F800000)
+        return x;
+    
+    unsigned const shift = 23 - nBits;
+    std::uint32_t const mask = (std::uint32_t(1) << shift) - 1;
+    
+    // Round to nearest, ties to even. A carry into the exponent produces the correctly rounded
+    //value.
+    bits += (mask >> 1) + ((bits >> shift) & 1);
+    bits &= ~mask;
+    
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+
+unsigned pec::minifloat::Quantize(float x, float min, float max, unsigned nBits)
+{
+    // NaN is mapped to the first bin
+    if (not (x >= min))
+        return 0;
+    
+    long const nBins = 1L << nBits;
+    long const code = std::lround(std::floor((x - min) / (max - min) * nBins));
+    
+    if (code < 0)
+        return 0;
+    else if (code >= nBins)
+        return nBins - 1;
+    else
+        return code;
+}
+
+
+float pec::minifloat::Dequantize(unsigned code, float min, float max, unsigned nBits)
+{
+    return min + (max - min) * (code + 0.5f) / (1L << nBits);
+}
+
+
+unsigned pec::minifloat::QuantizeGrid(float x, float min, float max, unsigned nBits,
+  bool periodic)
+{
+    // NaN is mapped to the first point
+    if (not (x >= min))
+        return 0;
+    
+    long const nBins = 1L << nBits;
+    long const code = std::lround((x - min) / (max - min) * nBins);
+    
+    if (code >= nBins)
+        return (periodic) ? 0 : nBins - 1;
+    else
+        return code;
+}
+
+
+float pec::minifloat::DequantizeGrid(unsigned code, float min, float max, unsigned nBits)
+{
+    return min + (max - min) * code / (1L << nBits);
+}
@@ -6,7 +6,8 @@ pec::PileUpInfo::PileUpInfo() noexcept:
     rho(0), rhoCentral(0),
     trueNumPU(0),
     inTimeNumPU(0),
-    maxPtHat(0)
+    maxPtHat(0),
+    weight(1), weightUp(1), weightDown(1)
 {}
 
 
@@ -18,6 +19,7 @@ void pec::PileUpInfo::Reset()
     trueNumPU = 0;
     inTimeNumPU = 0;
     maxPtHat = 0;
+    weight = weightUp = weightDown = 1;
 }
 
 
@@ -57,6 +59,14 @@ void pec::PileUpInfo::SetMaxPtHat(float maxPtHat_)
 }
 
 
+void pec::PileUpInfo::SetWeights(float nominal, float up, float down)
+{
+    weight = nominal;
+    weightUp = up;
+    weightDown = down;
+}
+
+
 unsigned pec::PileUpInfo::NumPV() const
 {
     return numPV;
@@ -91,3 +101,21 @@ float pec::PileUpInfo::MaxPtHat() const
 {
     return maxPtHat;
 }
+
+
+float pec::PileUpInfo::Weight() const
+{
+    return weight;
+}
+
+
+float pec::PileUpInfo::WeightDown() const
+{
+    return weightDown;
+}
+
+
+float pec::PileUpInfo::WeightUp() const
+{
+    return weightUp;
+}
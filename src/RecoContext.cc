@@ -0,0 +1,78 @@
+#include <Analysis/PECTuples/interface/RecoContext.h>
+
+#include <stdexcept>
+
+
+pec::RecoContext::RecoContext() noexcept:
+    numPV(0), numGoodPV(0),
+    firstPVGood(false),
+    firstPVPosition(),
+    rho(0.), rhoCentral(0.)
+{}
+
+
+void pec::RecoContext::SetNumPV(unsigned numPV_, unsigned numGoodPV_)
+{
+    numPV = numPV_;
+    numGoodPV = numGoodPV_;
+}
+
+
+void pec::RecoContext::SetFirstPV(double x, double y, double z, bool isGood)
+{
+    firstPVPosition[0] = x;
+    firstPVPosition[1] = y;
+    firstPVPosition[2] = z;
+    firstPVGood = isGood;
+}
+
+
+void pec::RecoContext::SetRho(double rho_)
+{
+    rho = rho_;
+}
+
+
+void pec::RecoContext::SetRhoCentral(double rhoCentral_)
+{
+    rhoCentral = rhoCentral_;
+}
+
+
+unsigned pec::RecoContext::NumPV() const
+{
+    return numPV;
+}
+
+
+unsigned pec::RecoContext::NumGoodPV() const
+{
+    return numGoodPV;
+}
+
+
+bool pec::RecoContext::IsFirstPVGood() const
+{
+    return firstPVGood;
+}
+
+
+double pec::RecoContext::FirstPVPosition(unsigned index) const
+{
+    if (index > 2)
+        throw std::logic_error("RecoContext::FirstPVPosition: Illegal coordinate index.");
+    
+    return firstPVPosition[index];
+}
+
+
+double pec::RecoContext::Rho() const
+{
+    return rho;
+}
+
+
+double pec::RecoContext::RhoCentral() const
+{
+    return rhoCentral;
+}
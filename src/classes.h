@@ -5,11 +5,17 @@
 #include <Analysis/PECTuples/interface/Electron.h>
 #include <Analysis/PECTuples/interface/Jet.h>
 #include <Analysis/PECTuples/interface/GenParticle.h>
+#include <Analysis/PECTuples/interface/GenParticleRecord.h>
 #include <Analysis/PECTuples/interface/GenJet.h>
+#include <Analysis/PECTuples/interface/MET.h>
 
 #include <Analysis/PECTuples/interface/EventID.h>
 #include <Analysis/PECTuples/interface/PileUpInfo.h>
 #include <Analysis/PECTuples/interface/GeneratorInfo.h>
+#include <Analysis/PECTuples/interface/GeneratorContext.h>
+#include <Analysis/PECTuples/interface/RecoContext.h>
+
+#include <DataFormats/Common/interface/Wrapper.h>
 
 #include <vector>
 
@@ -23,3 +29,22 @@ template class std::vector<pec::Electron>;
 template class std::vector<pec::Jet>;
 template class std::vector<pec::GenParticle>;
 template class std::vector<pec::GenJet>;
+
+
+// Wrappers for collections that are put into the event by PEC producers
+template class edm::Wrapper<std::vector<pec::Candidate>>;
+template class edm::Wrapper<std::vector<pec::Muon>>;
+template class edm::Wrapper<std::vector<pec::Electron>>;
+template class edm::Wrapper<std::vector<pec::Jet>>;
+template class edm::Wrapper<std::vector<pec::GenParticle>>;
+template class edm::Wrapper<std::vector<pec::GenJet>>;
+template class edm::Wrapper<pec::MET>;
+template class edm::Wrapper<pec::EventID>;
+template class edm::Wrapper<pec::PileUpInfo>;
+template class edm::Wrapper<pec::GeneratorInfo>;
+template class edm::Wrapper<pec::GenParticleRecord>;
+
+
+// Wrappers for auxiliary products that are only used within a job
+template class edm::Wrapper<pec::GeneratorContext>;
+template class edm::Wrapper<pec::RecoContext>;
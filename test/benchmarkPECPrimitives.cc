@@ -0,0 +1,397 @@
+/**
+ * Micro-benchmarks for primitives used in the hot loops of the package.
+ *
+ * Usage:
+ *   benchmarkPECPrimitives [--benchmark_filter=regex] [--benchmark_out=results.json]
+ *
+ * The benchmarks cover intervals of indices (IndexIntervals), compensated sums of event weights
+ * (CompensatedSums), the lookup in a large binary event list as done by EventIDFilter
+ * (MappedEventList), stripping of trigger names (GetTriggerBasename), and the round trip of
+ * collections of pec::Jet and pec::Electron through a TTree in memory. Inputs are synthetic and
+ * generated with fixed seeds, so results of different releases can be compared directly. Options
+ * are those of Google Benchmark.
+ *
+ * Plugin libraries cannot be linked against, so the sources of the standalone helper classes from
+ * the plugins directory are included and compiled into the program.
+ */
+
+#include <Analysis/PECTuples/plugins/CompensatedSums.cc>
+#include <Analysis/PECTuples/plugins/IndexIntervals.cc>
+#include <Analysis/PECTuples/plugins/MappedEventList.cc>
+#include <Analysis/PECTuples/plugins/TriggerBasename.cc>
+
+#include <Analysis/PECTuples/interface/Electron.h>
+#include <Analysis/PECTuples/interface/Jet.h>
+
+#include <benchmark/benchmark.h>
+
+#include <TMemFile.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace
+{
+/// Intervals of indices of the size typical for selections of LHE weights
+IndexIntervals MakeIntervals()
+{
+    std::vector<IndexIntervals::index_t> edges;
+
+    for (int first = 0; first < 1000; first += 50)
+    {
+        edges.emplace_back(first);
+        edges.emplace_back(first + 9);
+    }
+
+    return IndexIntervals(edges);
+}
+
+
+/**
+ * \brief Writes a synthetic binary event list with the given number of luminosity sections
+ *
+ * Each section contains eventsPerLumi events. The format is described in the documentation for
+ * class MappedEventList. Returns the keys of all sections.
+ */
+std::vector<std::uint64_t> WriteEventList(std::string const &fileName, unsigned numLumis,
+  unsigned eventsPerLumi)
+{
+    std::mt19937_64 generator(12345);
+    std::vector<MappedEventList::LumiEntry> directory;
+    std::vector<unsigned char> data;
+    std::vector<std::uint64_t> keys;
+
+    for (unsigned iLumi = 0; iLumi < numLumis; ++iLumi)
+    {
+        std::uint64_t const key =
+          (std::uint64_t(300000 + iLumi / 1000) << 32) | (iLumi % 1000 + 1);
+        keys.emplace_back(key);
+
+        std::uint64_t event = generator() % 1000000000;
+        directory.push_back({key, event, eventsPerLumi, data.size()});
+
+        // Differences between consecutive event numbers, encoded as LEB128 varints
+        for (unsigned iEvent = 1; iEvent < eventsPerLumi; ++iEvent)
+        {
+            std::uint64_t delta = 1 + generator() % 1000;
+            event += delta;
+
+            while (delta >= 0x80)
+            {
+                data.emplace_back((delta & 0x7F) | 0x80);
+                delta >>= 7;
+            }
+
+            data.emplace_back(delta);
+        }
+    }
+
+    std::ofstream file(fileName, std::ios::binary);
+    std::uint64_t const size = directory.size();
+    file.write("PECEVL01", 8);
+    file.write(reinterpret_cast<char const *>(&size), sizeof(size));
+    file.write(reinterpret_cast<char const *>(directory.data()),
+      directory.size() * sizeof(MappedEventList::LumiEntry));
+    file.write(reinterpret_cast<char const *>(data.data()), data.size());
+
+    return keys;
+}
+
+
+/// Synthetic trigger menu with realistic names of paths
+std::vector<std::string> MakeTriggerMenu()
+{
+    std::vector<std::string> const stems{"IsoMu24", "IsoTkMu24", "Mu50", "Ele32_WPTight_Gsf",
+      "Ele35_WPTight_Gsf", "Ele115_CaloIdVT_GsfTrkIdT", "PFJet450", "PFHT1050",
+      "Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8", "DiPFJetAve400",
+      "PFMETNoMu120_PFMHTNoMu120_IDTight", "Photon200"};
+    std::vector<std::string> menu;
+
+    for (unsigned i = 0; i < 600; ++i)
+    {
+        std::string name = "HLT_" + stems[i % stems.size()] + "_" + std::to_string(i / 7) +
+          "_v" + std::to_string(i % 23);
+
+        // Some names are given with a wildcard version, as in configurations
+        if (i % 5 == 0)
+            name = name.substr(0, name.rfind("_v")) + "_v*";
+
+        menu.emplace_back(name);
+    }
+
+    return menu;
+}
+
+
+/// Fills the given collection of jets as done by PECJetMET
+void FillJets(std::vector<pec::Jet> &jets, std::mt19937 &generator, unsigned size)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    jets.resize(size);
+
+    for (auto &jet: jets)
+    {
+        jet.Reset();
+        jet.SetPt(30.f + 200.f * uniform(generator));
+        jet.SetEta(-4.7f + 9.4f * uniform(generator));
+        jet.SetPhi(-3.14f + 6.28f * uniform(generator));
+        jet.SetM(10.f * uniform(generator));
+        jet.SetCorrFactor(1.f + 0.1f * uniform(generator));
+        jet.SetJECUncertainty(0.05f * uniform(generator));
+        jet.SetBTag(pec::Jet::BTagAlgo::CSV, uniform(generator));
+        jet.SetBTagDNN(uniform(generator), uniform(generator), uniform(generator),
+          uniform(generator), uniform(generator));
+        jet.SetArea(0.5f);
+        jet.SetFlavour(5, 5);
+    }
+}
+
+
+/// Fills the given collection of electrons as done by PECLeptons
+void FillElectrons(std::vector<pec::Electron> &electrons, std::mt19937 &generator, unsigned size)
+{
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    electrons.resize(size);
+
+    for (auto &electron: electrons)
+    {
+        electron.Reset();
+        electron.SetPt(20.f + 100.f * uniform(generator));
+        electron.SetEta(-2.5f + 5.f * uniform(generator));
+        electron.SetPhi(-3.14f + 6.28f * uniform(generator));
+        electron.SetCharge((uniform(generator) > 0.5f) ? 1 : -1);
+        electron.SetRelIso(0.2f * uniform(generator));
+        electron.SetEtaSC(electron.Eta());
+        electron.SetBooleanID(0);
+        electron.SetContinuousID(0, -1.f + 2.f * uniform(generator));
+    }
+}
+
+
+/**
+ * \brief Writes objects of the given type into a tree in memory and reads them back
+ *
+ * The number of events per iteration is given by the argument of the benchmark.
+ */
+template<typename T, typename F>
+void RoundTrip(benchmark::State &state, std::string const &branchName, unsigned size, F fill)
+{
+    unsigned const numEvents = state.range(0);
+    std::mt19937 generator(12345);
+    std::vector<T> objects, *readObjects = nullptr;
+
+    for (auto _: state)
+    {
+        TMemFile file("benchmark.root", "recreate");
+        TTree tree("Events", "");
+        tree.Branch(branchName.c_str(), &objects);
+
+        for (unsigned i = 0; i < numEvents; ++i)
+        {
+            fill(objects, generator, size);
+            tree.Fill();
+        }
+
+        tree.ResetBranchAddresses();
+        tree.SetBranchAddress(branchName.c_str(), &readObjects);
+
+        for (unsigned i = 0; i < numEvents; ++i)
+        {
+            tree.GetEntry(i);
+            benchmark::DoNotOptimize(readObjects->data());
+        }
+
+        tree.ResetBranchAddresses();
+    }
+
+    delete readObjects;
+    state.SetItemsProcessed(state.iterations() * numEvents);
+}
+}  // anonymous namespace
+
+
+static void BM_IndexIntervalsContain(benchmark::State &state)
+{
+    IndexIntervals const intervals = MakeIntervals();
+    int index = 0;
+
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(intervals.Contain(index));
+        index = (index + 7) % 1000;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_IndexIntervalsContain);
+
+
+static void BM_IndexIntervalsGetIndices(benchmark::State &state)
+{
+    IndexIntervals const intervals = MakeIntervals();
+
+    for (auto _: state)
+    {
+        int sum = 0;
+
+        for (auto const &index: intervals.GetIndices(0, 999))
+            sum += index;
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * intervals.NumberIndices(0, 999));
+}
+
+BENCHMARK(BM_IndexIntervalsGetIndices);
+
+
+static void BM_IndexIntervalsCompiled(benchmark::State &state)
+{
+    IndexIntervals const intervals = MakeIntervals();
+    IndexIntervals::Compiled compiled;
+    intervals.Compile(0, 999, compiled);
+
+    for (auto _: state)
+    {
+        int sum = 0;
+        compiled.ForEach([&sum](int index){sum += index;});
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * compiled.Size());
+}
+
+BENCHMARK(BM_IndexIntervalsCompiled);
+
+
+static void BM_CompensatedSumsFill(benchmark::State &state)
+{
+    unsigned const size = state.range(0);
+    CompensatedSums sums(size);
+    std::mt19937 generator(12345);
+    std::normal_distribution<double> normal(1., 2.);
+    std::vector<double> weights(size);
+
+    // Few sets of weights are cycled through so that the generation is not timed
+    std::vector<std::vector<double>> weightSets(16, weights);
+
+    for (auto &set: weightSets)
+        for (auto &w: set)
+            w = normal(generator);
+
+    unsigned iSet = 0;
+
+    for (auto _: state)
+    {
+        sums.Fill(weightSets[iSet].data());
+        iSet = (iSet + 1) % weightSets.size();
+    }
+
+    benchmark::DoNotOptimize(sums.GetSum(0));
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_CompensatedSumsFill)->Arg(10)->Arg(100)->Arg(1000);
+
+
+static void BM_EventListFindLumi(benchmark::State &state)
+{
+    std::string const fileName("benchmarkEventList_" + std::to_string(getpid()) + ".evl");
+    auto keys = WriteEventList(fileName, state.range(0), 100);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(12345));
+
+    MappedEventList const list(fileName);
+    std::vector<edm::EventNumber_t> decoded;
+    unsigned iKey = 0;
+
+    // As done at the beginning of each luminosity section by EventIDFilter
+    for (auto _: state)
+    {
+        auto const *entry = list.FindLumi(keys[iKey]);
+        list.Decode(*entry, decoded);
+        benchmark::DoNotOptimize(decoded.data());
+        iKey = (iKey + 1) % keys.size();
+    }
+
+    std::remove(fileName.c_str());
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EventListFindLumi)->Arg(1000)->Arg(100000);
+
+
+static void BM_EventListFindEvent(benchmark::State &state)
+{
+    std::string const fileName("benchmarkEventList_" + std::to_string(getpid()) + ".evl");
+    auto const keys = WriteEventList(fileName, 1, state.range(0));
+
+    MappedEventList const list(fileName);
+    std::vector<edm::EventNumber_t> decoded;
+    list.Decode(*list.FindLumi(keys.front()), decoded);
+
+    // Half of the looked up events are known
+    std::mt19937_64 generator(12345);
+    std::vector<edm::EventNumber_t> queries;
+
+    for (unsigned i = 0; i < 1024; ++i)
+        queries.emplace_back(decoded[generator() % decoded.size()] + i % 2);
+
+    unsigned iQuery = 0;
+
+    // As done for each event by EventIDFilter
+    for (auto _: state)
+    {
+        benchmark::DoNotOptimize(
+          std::binary_search(decoded.begin(), decoded.end(), queries[iQuery]));
+        iQuery = (iQuery + 1) % queries.size();
+    }
+
+    std::remove(fileName.c_str());
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_EventListFindEvent)->Arg(100)->Arg(10000);
+
+
+static void BM_GetTriggerBasename(benchmark::State &state)
+{
+    auto const menu = MakeTriggerMenu();
+
+    for (auto _: state)
+        for (auto const &name: menu)
+            benchmark::DoNotOptimize(GetTriggerBasename(name));
+
+    state.SetItemsProcessed(state.iterations() * menu.size());
+}
+
+BENCHMARK(BM_GetTriggerBasename);
+
+
+static void BM_JetRoundTrip(benchmark::State &state)
+{
+    RoundTrip<pec::Jet>(state, "jets", 8, FillJets);
+}
+
+BENCHMARK(BM_JetRoundTrip)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+
+static void BM_ElectronRoundTrip(benchmark::State &state)
+{
+    RoundTrip<pec::Electron>(state, "electrons", 2, FillElectrons);
+}
+
+BENCHMARK(BM_ElectronRoundTrip)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();